@@ -3,7 +3,8 @@
  ** Interface to loadable lexers.
  ** Maintains a list of lexer library paths and CreateLexer functions.
  ** If list changes then load all the lexer libraries and find the functions.
- ** When asked to create a lexer, call each function until one succeeds.
+ ** When asked to create a lexer, call the function of the library indexed for that name or,
+ ** if no library listed the name, each function until one succeeds.
  **/
 // Copyright 2019 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
@@ -13,6 +14,7 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <unordered_map>
 
 #if !defined(_WIN32)
 #include <dlfcn.h>
@@ -83,6 +85,15 @@ std::vector<LexLibrary> libraries;
 std::vector<std::string> lexers;
 std::vector<std::string> libraryProperties;
 
+// Index into libraries of the first library listing each lexer name, with and without the
+// library's namespace, built by Load so MakeLexer normally calls a single CreateLexer.
+std::unordered_map<std::string, size_t> libraryFromQualifiedName;
+std::unordered_map<std::string, size_t> libraryFromName;
+
+// Names found by NameFromID, empty when no library knows the identifier. There is no way to
+// list the identifiers of a library so this is filled as each is asked for and cleared by Load.
+std::unordered_map<int, std::string> nameFromIdentifier;
+
 Function FindSymbol(Module m, const char *symbol) noexcept {
 #if defined(_WIN32)
 	return ::GetProcAddress(m, symbol);
@@ -125,6 +136,9 @@ bool Lexilla::Load(std::string const& sharedLibraryPaths) {
 
 	std::string paths = sharedLibraryPaths;
 	lexers.clear();
+	libraryFromQualifiedName.clear();
+	libraryFromName.clear();
+	nameFromIdentifier.clear();
 
 	libraries.clear();
 	while (!paths.empty()) {
@@ -156,6 +170,13 @@ bool Lexilla::Load(std::string const& sharedLibraryPaths) {
 		Module lexillaDL = dlopen(path.c_str(), RTLD_LAZY);
 #endif
 		if (lexillaDL) {
+			GetNameSpaceFn fnGNS = FunctionPointer<GetNameSpaceFn>(
+				FindSymbol(lexillaDL, LEXILLA_GETNAMESPACE));
+			std::string nameSpace;
+			if (fnGNS) {
+				nameSpace = fnGNS();
+				nameSpace += LEXILLA_NAMESPACE_SEPARATOR;
+			}
 			GetLexerCountFn fnLexerCount = FunctionPointer<GetLexerCountFn>(
 				FindSymbol(lexillaDL, LEXILLA_GETLEXERCOUNT));
 			GetLexerNameFn fnLexerName = FunctionPointer<GetLexerNameFn>(
@@ -166,6 +187,11 @@ bool Lexilla::Load(std::string const& sharedLibraryPaths) {
 					char name[100] = "";
 					fnLexerName(i, name, sizeof(name));
 					lexers.push_back(name);
+					// emplace does not replace so earlier libraries win as when each is tried in turn
+					if (!nameSpace.empty()) {
+						libraryFromQualifiedName.emplace(nameSpace + name, libraries.size());
+					}
+					libraryFromName.emplace(name, libraries.size());
 				}
 			}
 			CreateLexerFn fnCL = FunctionPointer<CreateLexerFn>(
@@ -176,13 +202,6 @@ bool Lexilla::Load(std::string const& sharedLibraryPaths) {
 				FindSymbol(lexillaDL, LEXILLA_GETLIBRARYPROPERTYNAMES));
 			SetLibraryPropertyFn fnSLP = FunctionPointer<SetLibraryPropertyFn>(
 				FindSymbol(lexillaDL, LEXILLA_SETLIBRARYPROPERTY));
-			GetNameSpaceFn fnGNS = FunctionPointer<GetNameSpaceFn>(
-				FindSymbol(lexillaDL, LEXILLA_GETNAMESPACE));
-			std::string nameSpace;
-			if (fnGNS) {
-				nameSpace = fnGNS();
-				nameSpace += LEXILLA_NAMESPACE_SEPARATOR;
-			}
 			LexLibrary lexLib {
 				fnCL,
 				fnLNFI,
@@ -222,6 +241,28 @@ bool Lexilla::Load(std::string const& sharedLibraryPaths) {
 
 Scintilla::ILexer5 *Lexilla::MakeLexer(std::string const& languageName) {
 	std::string sLanguageName(languageName);	// Ensure NUL-termination
+	// Libraries that listed the name
+	std::unordered_map<std::string, size_t>::const_iterator it = libraryFromQualifiedName.find(sLanguageName);
+	if (it != libraryFromQualifiedName.end()) {
+		const LexLibrary &lexLib = libraries[it->second];
+		if (lexLib.fnCL) {
+			Scintilla::ILexer5 *pLexer = lexLib.fnCL(sLanguageName.substr(lexLib.nameSpace.size()).c_str());
+			if (pLexer) {
+				return pLexer;
+			}
+		}
+	}
+	it = libraryFromName.find(sLanguageName);
+	if (it != libraryFromName.end()) {
+		const LexLibrary &lexLib = libraries[it->second];
+		if (lexLib.fnCL) {
+			Scintilla::ILexer5 *pLexer = lexLib.fnCL(sLanguageName.c_str());
+			if (pLexer) {
+				return pLexer;
+			}
+		}
+	}
+	// Libraries may create lexers they do not list so try each of them.
 	// First, try to match namespace then name suffix
 	for (const LexLibrary &lexLib : libraries) {
 		if (lexLib.fnCL && !lexLib.nameSpace.empty()) {
@@ -259,15 +300,22 @@ std::vector<std::string> Lexilla::Lexers() {
 }
 
 std::string Lexilla::NameFromID(int identifier) {
+	std::unordered_map<int, std::string>::const_iterator it = nameFromIdentifier.find(identifier);
+	if (it != nameFromIdentifier.end()) {
+		return it->second;
+	}
+	std::string nameFound;
 	for (const LexLibrary &lexLib : libraries) {
 		if (lexLib.fnLNFI) {
 			const char *name = lexLib.fnLNFI(identifier);
 			if (name) {
-				return name;
+				nameFound = name;
+				break;
 			}
 		}
 	}
-	return std::string();
+	nameFromIdentifier.emplace(identifier, nameFound);
+	return nameFound;
 }
 
 std::vector<std::string> Lexilla::LibraryProperties() {
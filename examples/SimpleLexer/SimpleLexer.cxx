@@ -36,6 +36,8 @@ style.simple.1=fore:#FF0000
 
 #include "WordList.h"
 #include "PropSetSimple.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "StyleContext.h"
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <cstddef>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 #define wxSTC_LEX_TERMINAL 200
 
 #define wxSTC_TERMINAL_DEFAULT 0
@@ -31,6 +34,9 @@
 #define wxSTC_TERMINAL_ESCSEQ_UNKNOWN 24
 #define wxSTC_TERMINAL_GCC_EXCERPT 25
 #define wxSTC_TERMINAL_BASH 26
+/// A line ended by a '\r' alone, such as a progress bar redrawn by the next line, when
+/// lexer.terminal.overwritten.lines is set
+#define wxSTC_TERMINAL_OVERWRITTEN 27
 #define wxSTC_TERMINAL_ES_BLACK 40
 #define wxSTC_TERMINAL_ES_RED 41
 #define wxSTC_TERMINAL_ES_GREEN 42
@@ -49,6 +55,51 @@
 #define wxSTC_TERMINAL_ES_WHITE 55
 #define wxSTC_TERMINAL_GCC_WARNING 56
 #define wxSTC_TERMINAL_GCC_NOTE 57
+/// Styles allocated for combinations of SGR attributes when lexer.terminal.sgr.attributes is set
+#define wxSTC_TERMINAL_SGR_FIRST 64
+#define wxSTC_TERMINAL_SGR_LAST 255
+
+/// The file, line and column that a diagnostic such as a compiler error points at, found while styling its line
+struct DiagnosticLocation {
+    size_t line = 0;      // Line of the diagnostic, from GetLine
+    int style = 0;        // Style of the line, such as wxSTC_TERMINAL_GCC
+    size_t pathStart = 0; // The file's path is the text in [pathStart, pathEnd)
+    size_t pathEnd = 0;
+    int lineNumber = 0; // Line and column in the file, 0 when not given
+    int column = 0;
+};
+
+/// The attributes set by SGR escape sequences, packed into a key by Key(). Colours are indices of the 16 base
+/// colours, with 256-colour and 24-bit colours mapped to the nearest of them, or -1 for the default colour.
+/// With lexer.terminal.sgr.attributes set, text with attributes other than just a foreground colour is styled
+/// with the style returned by StyleForAttributes for the key, which the host gives the matching appearance
+struct TerminalAttributes {
+    int foreground = -1;
+    int background = -1;
+    bool bold = false;
+    bool italic = false;
+    bool underline = false;
+    bool inverse = false;
+
+    static constexpr int foregroundMask = 0x1f;
+
+    constexpr int Key() const noexcept
+    {
+        return (foreground + 1) | ((background + 1) << 5) | (bold ? 1 << 10 : 0) | (italic ? 1 << 11 : 0) |
+               (underline ? 1 << 12 : 0) | (inverse ? 1 << 13 : 0);
+    }
+    static constexpr TerminalAttributes FromKey(int key) noexcept
+    {
+        TerminalAttributes attributes;
+        attributes.foreground = (key & foregroundMask) - 1;
+        attributes.background = ((key >> 5) & 0x1f) - 1;
+        attributes.bold = (key & (1 << 10)) != 0;
+        attributes.italic = (key & (1 << 11)) != 0;
+        attributes.underline = (key & (1 << 12)) != 0;
+        attributes.inverse = (key & (1 << 13)) != 0;
+        return attributes;
+    }
+};
 
 class AccessorInterface
 {
@@ -59,9 +110,311 @@ public:
     virtual void StartAt(size_t start) = 0;
     virtual void StartSegment(size_t pos) = 0;
     virtual int GetPropertyInt(const std::string& name, int defaultVal = 0) const = 0;
+    // Value of a string property such as lexer.terminal.patterns.0, empty when it is not set. Hosts without
+    // string properties can keep this default
+    virtual std::string GetPropertyString(const std::string& /*name*/) const { return std::string(); }
+
+    // Copies length bytes starting at pos into buffer. Override this when the host can copy a whole range at once
+    virtual void GetCharRange(char* buffer, size_t pos, size_t length) const
+    {
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = (*this)[pos + i];
+        }
+    }
+
+    // Per-line state, used to carry the escape sequence colour from one line to the next so styling
+    // can restart at any line. Hosts that don't store line state can keep these defaults
+    virtual size_t GetLine(size_t /*pos*/) const { return 0; }
+    virtual int GetLineState(size_t /*line*/) const { return 0; }
+    virtual void SetLineState(size_t /*line*/, int /*state*/) {}
+
+    // Sets indicator to value over [start, end), used for the text of OSC 8 hyperlinks
+    virtual void IndicatorFill(size_t /*start*/, size_t /*end*/, int /*indicator*/, int /*value*/) {}
+
+    // Asked before styling the line starting at lineStart. Return true to stop there, for example when a time
+    // budget is spent: the text before lineStart is fully styled and styling can be resumed at lineStart later
+    virtual bool StopBefore(size_t /*lineStart*/) { return false; }
+
+    // Return true to have AddDiagnostic called for each diagnostic line styled, in document order, so a list of
+    // locations to jump to is built without parsing the output again
+    virtual bool CollectsDiagnostics() const { return false; }
+    virtual void AddDiagnostic(const DiagnosticLocation& /*location*/) {}
+
+    // The style for a TerminalAttributes key, in [wxSTC_TERMINAL_SGR_FIRST, wxSTC_TERMINAL_SGR_LAST], called
+    // with lexer.terminal.sgr.attributes set. Return -1, as by default, to use the foreground colour's style
+    virtual int StyleForAttributes(int /*key*/) { return -1; }
+
+    // Called with lexer.terminal.overwritten.lines set for each line in [start, end) ended by a '\r' alone, in
+    // document order. A terminal overwrites such a line with the next one, so the host can drop or collapse it.
+    // The lines of a redrawn progress bar are adjacent: merge ranges where start is the previous end
+    virtual void AddOverwritten(size_t /*start*/, size_t /*end*/) {}
+
+    // Called with lexer.terminal.utf8.validate set once [start, end) has been styled, with ascii true when every
+    // byte in it is below 0x80 and valid true when it is all valid UTF-8, so the host can skip checking it itself
+    // and take single byte paths for ASCII text
+    virtual void EncodingChecked(size_t /*start*/, size_t /*end*/, bool /*ascii*/, bool /*valid*/) {}
+};
+
+/// length bytes styled with style
+struct StyleRun {
+    size_t length;
+    int style;
+};
+
+/// Bulk accessor for hosts: text is read a range at a time, or directly when the host keeps it contiguous, and
+/// styles are written as runs instead of one call per segment.
+/// The lexer adapts it to AccessorInterface internally, so hosts implementing AccessorInterface keep working
+class AccessorInterfaceV2
+{
+public:
+    virtual ~AccessorInterfaceV2() = default;
+
+    virtual size_t Length() const = 0;
+    // Copies length bytes starting at start into buffer
+    virtual void GetRange(size_t start, size_t length, char* buffer) const = 0;
+    // Pointer to the whole text when the host holds it in one contiguous buffer, nullptr otherwise
+    virtual const char* RangePointer() const { return nullptr; }
+    // Styles count consecutive runs, the first one beginning at start
+    virtual void SetStyleRuns(size_t start, const StyleRun* runs, size_t count) = 0;
+    virtual int GetPropertyInt(const std::string& name, int defaultVal = 0) const = 0;
+    // Value of a string property such as lexer.terminal.patterns.0, empty when it is not set. Hosts without
+    // string properties can keep this default
+    virtual std::string GetPropertyString(const std::string& /*name*/) const { return std::string(); }
+
+    virtual size_t GetLine(size_t /*pos*/) const { return 0; }
+    virtual int GetLineState(size_t /*line*/) const { return 0; }
+    virtual void SetLineState(size_t /*line*/, int /*state*/) {}
+    virtual void IndicatorFill(size_t /*start*/, size_t /*end*/, int /*indicator*/, int /*value*/) {}
+    virtual bool StopBefore(size_t /*lineStart*/) { return false; }
+    virtual bool CollectsDiagnostics() const { return false; }
+    virtual void AddDiagnostic(const DiagnosticLocation& /*location*/) {}
+    virtual int StyleForAttributes(int /*key*/) { return -1; }
+    virtual void AddOverwritten(size_t /*start*/, size_t /*end*/) {}
+    virtual void EncodingChecked(size_t /*start*/, size_t /*end*/, bool /*ascii*/, bool /*valid*/) {}
+};
+
+/// Styles held as runs instead of one byte for each byte of text, so a headless host such as a log viewer or diff
+/// tool needs memory proportional to the number of style changes. Adjacent runs of the same style are merged as
+/// they are added. Each run is its length as a varint followed by its style, which is a byte as in Scintilla, so
+/// most runs take 2 bytes, and the start of every 64th run is kept to find runs by position. When styles change
+/// so often that the runs would take more memory than the text, the styles are held as one byte for each byte
+/// instead until they are cleared. Finding a run remembers it, so reading the styles in order is linear, and
+/// RunLengthStyles is not safe to read from several threads at once
+class RunLengthStyles
+{
+public:
+    /// The bytes from the end of the run before it up to, but not including, end are styled with style
+    struct Run {
+        size_t end;
+        int style;
+    };
+
+    /// Styles count consecutive runs, the first one beginning at start. Styles from start on are replaced and
+    /// any bytes between the end of the styles and start are styled 0
+    void SetStyleRuns(size_t start, const StyleRun* runs, size_t count);
+    /// Style of the byte at pos, 0 when it has not been styled
+    int StyleAt(size_t pos) const;
+    /// Index of the run holding pos, Count() when it has not been styled. Takes time proportional to pos when
+    /// the styles are held as bytes
+    size_t RunIndex(size_t pos) const;
+    /// Forgets the styles from pos on
+    void Truncate(size_t pos);
+    void Clear();
+
+    /// Number of runs
+    size_t Count() const { return m_count; }
+    /// The run at index, taking time proportional to its end when the styles are held as bytes
+    Run At(size_t index) const;
+    /// Bytes styled, all those before this are
+    size_t Length() const { return m_length; }
+    /// Whether the styles are held as one byte for each byte of text rather than as runs
+    bool Flat() const { return m_flat; }
+    size_t MemoryUse() const;
+
+private:
+    /// Where a run starts in the text and in m_runs
+    struct Cursor {
+        size_t index = 0;
+        size_t start = 0;
+        size_t offset = 0;
+    };
+    static constexpr size_t runsPerBlock = 64;
+    /// Below this many bytes styled the runs are kept however often the style changes
+    static constexpr size_t flatMinimum = 0x10000;
+
+    /// The run holding pos, which must be below m_length, when the styles are held as runs
+    Cursor Find(size_t pos) const;
+    /// Reads the run at cursor, returning its length and style and moving cursor to the next run
+    size_t Next(Cursor& cursor, int& style) const;
+    void Append(size_t end, int style);
+    void MakeFlat();
+
+    size_t m_count = 0;
+    size_t m_length = 0;
+    bool m_flat = false;
+    // Each run's length in 7 bit groups, the lowest first with the top bit set on all but the last, then its style
+    std::vector<unsigned char> m_runs;
+    // The start in the text and offset in m_runs of runs 0, runsPerBlock, 2 * runsPerBlock...
+    std::vector<Cursor> m_blocks;
+    // The last run, which grows when a run of the same style is appended
+    Cursor m_last;
+    int m_lastStyle = 0;
+    // The run found last, where the next search starts when it is for a later position
+    mutable Cursor m_hint;
+    // The style of each byte when m_flat is set
+    std::vector<unsigned char> m_bytes;
+};
+
+/// AccessorInterfaceV2 for lexing text held in one contiguous buffer, such as a mapped log file, without a
+/// document. Styles are recorded in a RunLengthStyles. Line states are not kept, so styling must start at the
+/// beginning of the text or of a line styled with the default colour
+class RunLengthAccessor final : public AccessorInterfaceV2
+{
+public:
+    RunLengthAccessor(const char* text, size_t length);
+
+    /// Sets a lexer.terminal.* property, such as "lexer.terminal.escape.sequences" to "1"
+    void SetProperty(const std::string& name, const std::string& value);
+    const RunLengthStyles& Styles() const { return m_styles; }
+    RunLengthStyles& Styles() { return m_styles; }
+
+    size_t Length() const override { return m_length; }
+    void GetRange(size_t start, size_t length, char* buffer) const override;
+    const char* RangePointer() const override { return m_text; }
+    void SetStyleRuns(size_t start, const StyleRun* runs, size_t count) override;
+    int GetPropertyInt(const std::string& name, int defaultVal = 0) const override;
+    std::string GetPropertyString(const std::string& name) const override;
+
+private:
+    const char* m_text;
+    size_t m_length;
+    std::map<std::string, std::string> m_properties;
+    RunLengthStyles m_styles;
+};
+
+/// A run of the text written by LexerTerminalStrip, length bytes from offset styled with style
+struct StrippedRun {
+    size_t offset;
+    size_t length;
+    int style;
+};
+
+/// What LexerTerminalStrip wrote
+struct StrippedText {
+    size_t length = 0; // Bytes of text left once escape sequences are removed
+    size_t runs = 0;   // Runs needed to style them, which may be more than were written
+};
+
+/// The lexer.terminal.* properties, read from a host when styling starts
+struct TerminalProperties {
+    bool valueSeparate = false;
+    bool escapeSequences = false;
+    int hyperlinkIndicator = -1;
+    bool sgrAttributes = false;
+    bool overwritten = false;
+    int threads = 0;
+    std::string patterns; // The definitions of lexer.terminal.patterns.<n>, one per line
+    bool utf8Validate = false;
+    int utf8Indicator = -1;
+    bool diagnostics = false; // Whether the host collects diagnostics
+};
+
+/// Styles terminal output that is only ever appended to, such as a build or terminal pane.
+/// Remembers where the last complete line ended and keeps the bytes of the trailing partial line, so each
+/// call only reads the newly appended text instead of restarting from the beginning of the range.
+/// A partial line is restyled by each call until it is longer than the limit for long lines, after which only
+/// the bytes appended to it are styled, so a long line arriving in many pieces is not styled again each time
+class TerminalStyler
+{
+public:
+    TerminalStyler();
+    ~TerminalStyler();
+    TerminalStyler(TerminalStyler&&) noexcept;
+    TerminalStyler& operator=(TerminalStyler&&) noexcept;
+
+    /// Style everything appended since the previous call, up to (but not including) endPos
+    void StyleTo(size_t endPos, AccessorInterface& styler);
+    void StyleTo(size_t endPos, AccessorInterfaceV2& styler);
+
+    /// Forget all state and restart at pos. Call this when the document is cleared or replaced, or when
+    /// lexer.terminal.* properties change
+    void Reset(size_t pos = 0);
+
+    /// Start of the trailing line that has not been terminated yet
+    size_t GetLineStart() const { return m_lineStart; }
+
+private:
+    struct LongLine;
+
+    size_t m_lineStart = 0;
+    size_t m_readEnd = 0;
+    // The bytes of the trailing partial line, only those not styled yet once it is long
+    std::string m_partialLine;
+    // Holds each range read from the document
+    std::string m_chunk;
+    // The colour active at the start of the partial line, or at its end once it is long
+    int m_lineStartColour = 0;
+    bool m_propertiesRead = false;
+    // Set while the trailing partial line is long
+    bool m_inLongLine = false;
+    TerminalProperties m_properties;
+    // Where a long partial line has been styled to, allocated for the first one
+    std::unique_ptr<LongLine> m_longLine;
+};
+
+/// Styles terminal output as it is read, before it is in any document, such as on the thread reading a pty, so
+/// the host can insert text and its styles together. Positions are offsets in the stream of bytes fed.
+/// Each line is styled once it is complete, so the bytes of the trailing partial line are held until its line
+/// end arrives or Flush is called.
+/// When host is not nullptr, lexer.terminal.* properties are read from it once, and StyleForAttributes,
+/// IndicatorFill, AddDiagnostic, AddOverwritten and EncodingChecked are called on it from the thread calling Feed,
+/// with lines counted from the start of the stream. Its text and styling methods are never called
+class TerminalTokenizer
+{
+public:
+    explicit TerminalTokenizer(AccessorInterfaceV2* host = nullptr);
+
+    /// Reads length bytes of output and appends to runs the styles of the lines they complete. The runs added
+    /// cover the bytes from the previous Styled() to the new one
+    void Feed(const char* data, size_t length, std::vector<StyleRun>& runs);
+
+    /// Styles the bytes held as a line of their own, as when output pauses without a line end. The bytes that
+    /// follow start a new line
+    void Flush(std::vector<StyleRun>& runs);
+
+    /// Forget all state and restart at offset 0, reading the properties again
+    void Reset();
+
+    /// Number of bytes styled so far
+    size_t Styled() const { return m_styled; }
+    /// Number of bytes fed but not styled yet
+    size_t Pending() const { return m_partialLine.length(); }
+
+private:
+    void ReadProperties();
+    void CompleteLine(std::vector<StyleRun>& runs);
+    void ReportEncoding(size_t styledFrom);
+
+    AccessorInterfaceV2* m_host;
+    size_t m_styled = 0;
+    size_t m_line = 0;
+    std::string m_partialLine;
+    int m_colour = 0;
+    TerminalProperties m_properties;
+    // What checking the lines completed since the last report found
+    bool m_checkedASCII = true;
+    bool m_checkedValid = true;
 };
 
 // API
 void* CreateExtraLexerTerminal();
 void FreeExtraLexer(void* lexer);
 void LexerTerminalStyle(size_t startPos, size_t length, AccessorInterface& styler);
+void LexerTerminalStyle(size_t startPos, size_t length, AccessorInterfaceV2& styler);
+/// Removes the escape sequences from the length bytes of terminal output at text in one pass, as the lexer
+/// interprets them, writing the rest to strippedText, which must have room for length bytes, and their styles to
+/// runs. Runs past runCapacity are counted but not written: a capacity of length is always enough. When host is
+/// not nullptr, lexer.terminal.* properties and StyleForAttributes are taken from it, otherwise the defaults are
+/// used. Escape sequences are always interpreted
+StrippedText LexerTerminalStrip(const char* text, size_t length, char* strippedText, StrippedRun* runs,
+                                size_t runCapacity, AccessorInterfaceV2* host = nullptr);
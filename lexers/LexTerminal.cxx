@@ -8,13 +8,21 @@
 
 #include "ExtraLexers.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 // clang-format off
 #include "ILexer.h"
@@ -22,10 +30,20 @@
 
 #include "InList.h"
 #include "WordList.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
+#include "LexArena.h"
+#include "LexLocations.h"
+#include "LexStyleTable.h"
+#include "LexInvalidation.h"
 #include "Accessor.h"
 #include "StyleContext.h"
+#include "LexScan.h"
 #include "LexCharacterSet.h"
+#include "EscapeSequenceParser.h"
+#include "LinePatterns.h"
+#include "LexUTF8.h"
 #include "LexerModule.h"
 #include "PropSetSimple.h"
 #include "LexerBase.h"
@@ -38,7 +56,10 @@ using namespace Lexilla;
 namespace
 {
 
-class NativeAccessor : public AccessorInterface
+/// Presents Scintilla's Accessor as an AccessorInterface. The lexer's core is a template on the styler type and
+/// this class is final, so the instance of the core for it calls Accessor directly and inlines operator[] and
+/// ColourTo. Other hosts share the instance for AccessorInterface
+class NativeAccessor final : public AccessorInterface
 {
 public:
     NativeAccessor(Accessor& accessor)
@@ -57,11 +78,234 @@ public:
     {
         return m_accessor.GetPropertyInt(name, defaultVal);
     };
+    std::string GetPropertyString(const std::string& name) const override { return m_accessor.pprops->Get(name); }
+    void GetCharRange(char* buffer, size_t pos, size_t length) const override
+    {
+        m_accessor.MultiByteAccess()->GetCharRange(buffer, pos, length);
+    }
+    size_t GetLine(size_t pos) const override { return m_accessor.GetLine(pos); }
+    int GetLineState(size_t line) const override { return m_accessor.GetLineState(line); }
+    void SetLineState(size_t line, int state) override { m_accessor.SetLineState(line, state); }
+    void IndicatorFill(size_t start, size_t end, int indicator, int value) override
+    {
+        m_accessor.IndicatorFill(start, end, indicator, value);
+    }
+    bool StopBefore(size_t lineStart) override { return m_accessor.BudgetSpent(lineStart); }
+    bool CollectsDiagnostics() const override { return m_accessor.Locations() != nullptr; }
+    void AddDiagnostic(const DiagnosticLocation& location) override
+    {
+        LexLocation lexLocation;
+        lexLocation.line = location.line;
+        lexLocation.style = location.style;
+        lexLocation.pathStart = location.pathStart;
+        lexLocation.pathEnd = location.pathEnd;
+        lexLocation.lineNumber = location.lineNumber;
+        lexLocation.column = location.column;
+        m_accessor.Locations()->Add(lexLocation);
+    }
+    int StyleForAttributes(int key) override
+    {
+        LexStyleTable* table = m_accessor.StyleTable();
+        if (!table) {
+            return -1;
+        }
+        table->SetRange(wxSTC_TERMINAL_SGR_FIRST, wxSTC_TERMINAL_SGR_LAST + 1 - wxSTC_TERMINAL_SGR_FIRST);
+        return table->StyleFor(key);
+    }
 
 private:
     Accessor& m_accessor;
 };
 
+/// Presents an AccessorInterfaceV2 host as an AccessorInterface. Text is read through the host's contiguous
+/// buffer when it has one, otherwise through a window refilled with GetRange. ColourTo calls are merged into
+/// runs and sent to the host in batches
+class BatchedAccessor final : public AccessorInterface
+{
+public:
+    explicit BatchedAccessor(AccessorInterfaceV2& host)
+        : m_host(host)
+        , m_length(host.Length())
+        , m_text(host.RangePointer())
+    {
+    }
+    ~BatchedAccessor() { Flush(); }
+
+    const char operator[](size_t index) const override
+    {
+        if (m_text) {
+            return m_text[index];
+        }
+        if ((index < m_windowStart) || (index >= m_windowStart + m_windowLength)) {
+            Fill(index);
+        }
+        return m_window[index - m_windowStart];
+    }
+    char SafeGetCharAt(size_t index, char chDefault = ' ') const override
+    {
+        return (index < m_length) ? (*this)[index] : chDefault;
+    }
+    void GetCharRange(char* buffer, size_t pos, size_t length) const override
+    {
+        if (m_text) {
+            memcpy(buffer, m_text + pos, length);
+        } else {
+            m_host.GetRange(pos, length, buffer);
+        }
+    }
+    void ColourTo(size_t pos, int style) override
+    {
+        if (pos < m_segmentStart) {
+            return;
+        }
+        const size_t length = pos + 1 - m_segmentStart;
+        if (!m_runs.empty() && (m_runs.back().style == style)) {
+            m_runs.back().length += length;
+        } else {
+            if (m_runs.size() == maxRuns) {
+                Flush();
+            }
+            m_runs.push_back({ length, style });
+        }
+        m_segmentStart = pos + 1;
+    }
+    void StartAt(size_t start) override
+    {
+        Flush();
+        m_runsStart = start;
+        m_segmentStart = start;
+    }
+    void StartSegment(size_t pos) override
+    {
+        if (pos != m_segmentStart) {
+            Flush();
+            m_runsStart = pos;
+            m_segmentStart = pos;
+        }
+    }
+    int GetPropertyInt(const std::string& name, int defaultVal = 0) const override
+    {
+        return m_host.GetPropertyInt(name, defaultVal);
+    }
+    std::string GetPropertyString(const std::string& name) const override { return m_host.GetPropertyString(name); }
+    size_t GetLine(size_t pos) const override { return m_host.GetLine(pos); }
+    int GetLineState(size_t line) const override { return m_host.GetLineState(line); }
+    void SetLineState(size_t line, int state) override { m_host.SetLineState(line, state); }
+    void IndicatorFill(size_t start, size_t end, int indicator, int value) override
+    {
+        m_host.IndicatorFill(start, end, indicator, value);
+    }
+    bool StopBefore(size_t lineStart) override { return m_host.StopBefore(lineStart); }
+    bool CollectsDiagnostics() const override { return m_host.CollectsDiagnostics(); }
+    void AddDiagnostic(const DiagnosticLocation& location) override { m_host.AddDiagnostic(location); }
+    int StyleForAttributes(int key) override { return m_host.StyleForAttributes(key); }
+    void AddOverwritten(size_t start, size_t end) override { m_host.AddOverwritten(start, end); }
+    void EncodingChecked(size_t start, size_t end, bool ascii, bool valid) override
+    {
+        m_host.EncodingChecked(start, end, ascii, valid);
+    }
+
+    void Flush()
+    {
+        if (m_runs.empty()) {
+            return;
+        }
+        m_host.SetStyleRuns(m_runsStart, m_runs.data(), m_runs.size());
+        m_runsStart = m_segmentStart;
+        m_runs.clear();
+    }
+
+private:
+    static constexpr size_t windowSize = 4000;
+    static constexpr size_t maxRuns = 1000;
+
+    void Fill(size_t index) const
+    {
+        // Keep a little text before index as the lexer looks back a few characters
+        m_windowStart = (index > windowSize / 8) ? index - windowSize / 8 : 0;
+        m_windowLength = std::min(windowSize, m_length - m_windowStart);
+        m_host.GetRange(m_windowStart, m_windowLength, m_window);
+    }
+
+    AccessorInterfaceV2& m_host;
+    const size_t m_length;
+    const char* m_text;
+    mutable char m_window[windowSize];
+    mutable size_t m_windowStart = 0;
+    mutable size_t m_windowLength = 0;
+    std::vector<StyleRun> m_runs;
+    size_t m_runsStart = 0;
+    size_t m_segmentStart = 0;
+};
+
+/// Host for LexerTerminalStrip: reads the caller's text in place and, as each run of styles arrives, copies the
+/// bytes not styled as escape sequences to the stripped text with runs giving their styles. Runs of the same
+/// style made adjacent by removing a sequence are merged
+class StrippingAccessor : public AccessorInterfaceV2
+{
+public:
+    StrippingAccessor(const char* text, size_t length, char* strippedText, StrippedRun* runs, size_t runCapacity,
+                      AccessorInterfaceV2* host)
+        : m_text(text)
+        , m_length(length)
+        , m_strippedText(strippedText)
+        , m_runs(runs)
+        , m_runCapacity(runCapacity)
+        , m_host(host)
+    {
+    }
+
+    size_t Length() const override { return m_length; }
+    void GetRange(size_t start, size_t length, char* buffer) const override { memcpy(buffer, m_text + start, length); }
+    const char* RangePointer() const override { return m_text; }
+    void SetStyleRuns(size_t start, const StyleRun* runs, size_t count) override
+    {
+        for (size_t i = 0; i < count; start += runs[i].length, i++) {
+            const int style = runs[i].style;
+            if ((style == wxSTC_TERMINAL_ESCSEQ) || (style == wxSTC_TERMINAL_ESCSEQ_UNKNOWN) || (runs[i].length == 0)) {
+                continue;
+            }
+            memcpy(m_strippedText + m_result.length, m_text + start, runs[i].length);
+            if ((m_result.runs > 0) && (m_lastStyle == style)) {
+                if (m_result.runs <= m_runCapacity) {
+                    m_runs[m_result.runs - 1].length += runs[i].length;
+                }
+            } else {
+                if (m_result.runs < m_runCapacity) {
+                    m_runs[m_result.runs] = { m_result.length, runs[i].length, style };
+                }
+                m_result.runs++;
+                m_lastStyle = style;
+            }
+            m_result.length += runs[i].length;
+        }
+    }
+    int GetPropertyInt(const std::string& name, int defaultVal = 0) const override
+    {
+        if (name == "lexer.terminal.escape.sequences") {
+            return 1;
+        }
+        return m_host ? m_host->GetPropertyInt(name, defaultVal) : defaultVal;
+    }
+    std::string GetPropertyString(const std::string& name) const override
+    {
+        return m_host ? m_host->GetPropertyString(name) : std::string();
+    }
+    int StyleForAttributes(int key) override { return m_host ? m_host->StyleForAttributes(key) : -1; }
+
+    StrippedText Result() const noexcept { return m_result; }
+
+private:
+    const char* m_text;
+    size_t m_length;
+    char* m_strippedText;
+    StrippedRun* m_runs;
+    size_t m_runCapacity;
+    AccessorInterfaceV2* m_host;
+    StrippedText m_result;
+    int m_lastStyle = -1;
+};
+
 bool strstart(const char* haystack, const char* needle) noexcept
 {
     return strncmp(haystack, needle, strlen(needle)) == 0;
@@ -71,11 +315,6 @@ constexpr bool Is0To9(char ch) noexcept { return (ch >= '0') && (ch <= '9'); }
 
 constexpr bool Is1To9(char ch) noexcept { return (ch >= '1') && (ch <= '9'); }
 
-bool AtEOL(AccessorInterface& styler, Sci_Position i)
-{
-    return (styler[i] == '\n') || ((styler[i] == '\r') && (styler.SafeGetCharAt(i + 1) != '\n'));
-}
-
 bool IsGccExcerpt(const char* s) noexcept
 {
     while (*s) {
@@ -90,21 +329,132 @@ bool IsGccExcerpt(const char* s) noexcept
     return true;
 }
 
-const std::string bashDiagnosticMark = ": line ";
-bool IsBashDiagnostic(std::string const& sv)
+/// Text that RecogniseErrorListLine looks for anywhere in a line
+enum Marker {
+    mkPythonFile,   // File "
+    mkPythonLine,   // , line
+    mkIn,           //  in
+    mkOnLine,       //  on line
+    mkAtBracket,    //  at (
+    mkBracketColon, // ) :
+    mkAtLine,       // at line
+    mkFile,         // file
+    mkAt,           //  at
+    mkLine,         //  line
+    mkDotNetLine,   // :line
+    mkCommaFile,    // , file
+    mkColumn,       //  column
+    mkOpenBracket,  // (
+    mkJava,         // .java:
+    mkWarningLnk,   // warning LNK
+    mkErrorLnk,     // error LNK
+    mkBashLine,     // : line
+    mkWarning,      // warning:
+    mkNote,         // note:
+    mkWarningC,     // : warning C
+    mkCount
+};
+
+/// Finds the first occurrence of every Marker in a single pass over the line, dispatching on the first byte of
+/// each marker. Like strstr, the scan stops at the first NUL
+class LineMarkers
+{
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit LineMarkers(const char* line) noexcept
+    {
+        std::fill(std::begin(m_first), std::end(m_first), npos);
+        for (size_t i = 0; line[i]; i++) {
+            const char* s = line + i;
+            switch (*s) {
+            case ' ':
+                Check(s, i, mkIn, " in ");
+                Check(s, i, mkOnLine, " on line ");
+                Check(s, i, mkAt, " at ");
+                Check(s, i, mkAtBracket, " at (");
+                Check(s, i, mkLine, " line ");
+                Check(s, i, mkColumn, " column ");
+                break;
+            case '(':
+                Check(s, i, mkOpenBracket, "(");
+                break;
+            case ')':
+                Check(s, i, mkBracketColon, ") : ");
+                break;
+            case ',':
+                Check(s, i, mkPythonLine, ", line ");
+                Check(s, i, mkCommaFile, ", file ");
+                break;
+            case '.':
+                Check(s, i, mkJava, ".java:");
+                break;
+            case ':':
+                Check(s, i, mkDotNetLine, ":line ");
+                Check(s, i, mkBashLine, ": line ");
+                Check(s, i, mkWarningC, ": warning C");
+                break;
+            case 'F':
+                Check(s, i, mkPythonFile, "File \"");
+                break;
+            case 'a':
+                Check(s, i, mkAtLine, "at line ");
+                break;
+            case 'e':
+                Check(s, i, mkErrorLnk, "error LNK");
+                break;
+            case 'f':
+                Check(s, i, mkFile, "file ");
+                break;
+            case 'n':
+                Check(s, i, mkNote, "note:");
+                break;
+            case 'w':
+                Check(s, i, mkWarningLnk, "warning LNK");
+                Check(s, i, mkWarning, "warning:");
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    bool Has(Marker marker) const noexcept { return m_first[marker] != npos; }
+    /// Position of the first occurrence of marker, npos when it is absent
+    size_t First(Marker marker) const noexcept { return m_first[marker]; }
+
+private:
+    void Check(const char* s, size_t pos, Marker marker, const char* text) noexcept
+    {
+        if (m_first[marker] != npos) {
+            return;
+        }
+        // The line is NUL terminated so a mismatch is always found before reading past its end
+        for (; *text; s++, text++) {
+            if (*s != *text) {
+                return;
+            }
+        }
+        m_first[marker] = pos;
+    }
+
+    size_t m_first[mkCount];
+};
+
+/// <filename>: line <line>:<message>
+bool IsBashDiagnostic(const char* lineBuffer, const LineMarkers& markers) noexcept
 {
-    const size_t mark = sv.find(bashDiagnosticMark);
-    if (mark == std::string::npos) {
+    if (!markers.Has(mkBashLine)) {
         return false;
     }
-    std::string rest = sv.substr(mark + bashDiagnosticMark.length());
-    if (rest.empty() || !Is0To9(rest.front())) {
+    const char* rest = lineBuffer + markers.First(mkBashLine) + strlen(": line ");
+    if (!Is0To9(*rest)) {
         return false;
     }
-    while (!rest.empty() && Is0To9(rest.front())) {
-        rest = rest.substr(1);
+    while (Is0To9(*rest)) {
+        rest++;
     }
-    return !rest.empty() && (rest.front() == ':');
+    return *rest == ':';
 }
 
 int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci_Position& startValue)
@@ -138,12 +488,15 @@ int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci
     } else if (strstart(lineBuffer, "fortcom:")) {
         // Intel Fortran Compiler v8.0 error/warning message
         return wxSTC_TERMINAL_IFORT;
-    } else if (strstr(lineBuffer, "File \"") && strstr(lineBuffer, ", line ")) {
+    }
+
+    const LineMarkers markers(lineBuffer);
+    if (markers.Has(mkPythonFile) && markers.Has(mkPythonLine)) {
         return wxSTC_TERMINAL_PYTHON;
-    } else if (strstr(lineBuffer, " in ") && strstr(lineBuffer, " on line ")) {
+    } else if (markers.Has(mkIn) && markers.Has(mkOnLine)) {
         return wxSTC_TERMINAL_PHP;
-    } else if ((strstart(lineBuffer, "Error ") || strstart(lineBuffer, "Warning ")) && strstr(lineBuffer, " at (") &&
-               strstr(lineBuffer, ") : ") && (strstr(lineBuffer, " at (") < strstr(lineBuffer, ") : "))) {
+    } else if ((strstart(lineBuffer, "Error ") || strstart(lineBuffer, "Warning ")) && markers.Has(mkAtBracket) &&
+               markers.Has(mkBracketColon) && (markers.First(mkAtBracket) < markers.First(mkBracketColon))) {
         // Intel Fortran Compiler error/warning message
         return wxSTC_TERMINAL_IFC;
     } else if (strstart(lineBuffer, "Error ")) {
@@ -152,26 +505,23 @@ int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci
     } else if (strstart(lineBuffer, "Warning ")) {
         // Borland warning message
         return wxSTC_TERMINAL_BORLAND;
-    } else if (strstr(lineBuffer, "at line ") && (strstr(lineBuffer, "at line ") < (lineBuffer + lengthLine)) &&
-               strstr(lineBuffer, "file ") && (strstr(lineBuffer, "file ") < (lineBuffer + lengthLine))) {
+    } else if (markers.Has(mkAtLine) && markers.Has(mkFile)) {
         // Lua 4 error message
         return wxSTC_TERMINAL_LUA;
-    } else if (strstr(lineBuffer, " at ") && (strstr(lineBuffer, " at ") < (lineBuffer + lengthLine)) &&
-               strstr(lineBuffer, " line ") && (strstr(lineBuffer, " line ") < (lineBuffer + lengthLine)) &&
-               (strstr(lineBuffer, " at ") + 4 < (strstr(lineBuffer, " line ")))) {
+    } else if (markers.Has(mkAt) && markers.Has(mkLine) && (markers.First(mkAt) + 4 < markers.First(mkLine))) {
         // perl error message:
         // <message> at <file> line <line>
         return wxSTC_TERMINAL_PERL;
-    } else if ((lengthLine >= 6) && (memcmp(lineBuffer, "   at ", 6) == 0) && strstr(lineBuffer, ":line ")) {
+    } else if ((lengthLine >= 6) && (memcmp(lineBuffer, "   at ", 6) == 0) && markers.Has(mkDotNetLine)) {
         // A .NET traceback
         return wxSTC_TERMINAL_NET;
-    } else if (strstart(lineBuffer, "Line ") && strstr(lineBuffer, ", file ")) {
+    } else if (strstart(lineBuffer, "Line ") && markers.Has(mkCommaFile)) {
         // Essential Lahey Fortran error message
         return wxSTC_TERMINAL_ELF;
-    } else if (strstart(lineBuffer, "line ") && strstr(lineBuffer, " column ")) {
+    } else if (strstart(lineBuffer, "line ") && markers.Has(mkColumn)) {
         // HTML tidy style: line 42 column 1
         return wxSTC_TERMINAL_TIDY;
-    } else if (strstart(lineBuffer, "\tat ") && strchr(lineBuffer, '(') && strstr(lineBuffer, ".java:")) {
+    } else if (strstart(lineBuffer, "\tat ") && markers.Has(mkOpenBracket) && markers.Has(mkJava)) {
         // Java stack back trace
         return wxSTC_TERMINAL_JAVA_STACK;
     } else if (strstart(lineBuffer, "In file included from ") || strstart(lineBuffer, "                 from ")) {
@@ -181,11 +531,11 @@ int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci
         // Microsoft nmake fatal error:
         // NMAKE : fatal error <code>: <program> : return code <return>
         return wxSTC_TERMINAL_MS;
-    } else if (strstr(lineBuffer, "warning LNK") || strstr(lineBuffer, "error LNK")) {
+    } else if (markers.Has(mkWarningLnk) || markers.Has(mkErrorLnk)) {
         // Microsoft linker warning:
         // {<object> : } (warning|error) LNK9999
         return wxSTC_TERMINAL_MS;
-    } else if (IsBashDiagnostic(lineBuffer)) {
+    } else if (IsBashDiagnostic(lineBuffer, markers)) {
         // Bash diagnostic
         // <filename>: line <line>:<message>
         return wxSTC_TERMINAL_BASH;
@@ -285,20 +635,18 @@ int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci
                 } else if ((ch == ':' && chNext == ' ') || (ch == ' ')) {
                     // Possibly Delphi.. don't test against chNext as it's one of the
                     // strings below.
-                    char word[512];
+                    static constexpr KeywordSet levels{ "error", "warning", "fatal", "catastrophic", "note", "remark" };
                     unsigned numstep = 0;
                     if (ch == ' ')
                         numstep = 1; // ch was ' ', handle as if it's a delphi errorline,
                                      // only add 1 to i.
                     else
                         numstep = 2; // otherwise add 2.
-                    Sci_PositionU chPos = 0;
-                    for (Sci_PositionU j = i + numstep;
-                         j < lengthLine && IsUpperOrLowerCase(lineBuffer[j]) && chPos < sizeof(word) - 1; j++)
-                        word[chPos++] = lineBuffer[j];
-                    word[chPos] = 0;
-                    if (InListCaseInsensitive(word,
-                                              { "error", "warning", "fatal", "catastrophic", "note", "remark" })) {
+                    const Sci_PositionU wordStart = std::min<Sci_PositionU>(i + numstep, lengthLine);
+                    Sci_PositionU wordEnd = wordStart;
+                    while (wordEnd < lengthLine && IsUpperOrLowerCase(lineBuffer[wordEnd]))
+                        wordEnd++;
+                    if (levels.ContainsCaseInsensitive(std::string_view(lineBuffer + wordStart, wordEnd - wordStart))) {
                         state = stMsVc;
                     } else {
                         state = stUnrecognized;
@@ -333,9 +681,9 @@ int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci
             if (initialColonPart) {
                 return wxSTC_TERMINAL_LUA;
             } else {
-                if (strstr(lineBuffer, "warning:")) {
+                if (markers.Has(mkWarning)) {
                     return wxSTC_TERMINAL_GCC_WARNING;
-                } else if (strstr(lineBuffer, "note:")) {
+                } else if (markers.Has(mkNote)) {
                     return wxSTC_TERMINAL_GCC_NOTE;
                 } else {
                     return wxSTC_TERMINAL_GCC;
@@ -345,7 +693,7 @@ int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci
             return wxSTC_TERMINAL_MS;
         } else if ((state == stCtagsStringDollar) || (state == stCtags)) {
             return wxSTC_TERMINAL_CTAG;
-        } else if (initialColonPart && strstr(lineBuffer, ": warning C")) {
+        } else if (initialColonPart && markers.Has(mkWarningC)) {
             // Microsoft warning without line number
             // <filename>: warning C9999
             return wxSTC_TERMINAL_MS;
@@ -359,24 +707,24 @@ int RecogniseErrorListLine(const char* lineBuffer, Sci_PositionU lengthLine, Sci
 #define G(c) (((c) >> 8) & 0xff)
 #define B(c) ((c) & 0xff)
 
-uint32_t base_colours[16] = {
+constexpr uint32_t base_colours[16] = {
     0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
     0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff,
 };
 
-int base_colour_to_style[16] = { wxSTC_TERMINAL_ES_BLACK,        wxSTC_TERMINAL_ES_RED,
-                                 wxSTC_TERMINAL_ES_GREEN,        wxSTC_TERMINAL_ES_BROWN,
-                                 wxSTC_TERMINAL_ES_BLUE,         wxSTC_TERMINAL_ES_MAGENTA,
-                                 wxSTC_TERMINAL_ES_CYAN,         wxSTC_TERMINAL_ES_GRAY,
-                                 wxSTC_TERMINAL_ES_DARK_GRAY,    wxSTC_TERMINAL_ES_BRIGHT_RED,
-                                 wxSTC_TERMINAL_ES_BRIGHT_GREEN, wxSTC_TERMINAL_ES_YELLOW,
-                                 wxSTC_TERMINAL_ES_BRIGHT_BLUE,  wxSTC_TERMINAL_ES_BRIGHT_MAGENTA,
-                                 wxSTC_TERMINAL_ES_BRIGHT_CYAN,  wxSTC_TERMINAL_ES_WHITE };
+constexpr int base_colour_to_style[16] = { wxSTC_TERMINAL_ES_BLACK,        wxSTC_TERMINAL_ES_RED,
+                                           wxSTC_TERMINAL_ES_GREEN,        wxSTC_TERMINAL_ES_BROWN,
+                                           wxSTC_TERMINAL_ES_BLUE,         wxSTC_TERMINAL_ES_MAGENTA,
+                                           wxSTC_TERMINAL_ES_CYAN,         wxSTC_TERMINAL_ES_GRAY,
+                                           wxSTC_TERMINAL_ES_DARK_GRAY,    wxSTC_TERMINAL_ES_BRIGHT_RED,
+                                           wxSTC_TERMINAL_ES_BRIGHT_GREEN, wxSTC_TERMINAL_ES_YELLOW,
+                                           wxSTC_TERMINAL_ES_BRIGHT_BLUE,  wxSTC_TERMINAL_ES_BRIGHT_MAGENTA,
+                                           wxSTC_TERMINAL_ES_BRIGHT_CYAN,  wxSTC_TERMINAL_ES_WHITE };
 
 // clang-format off
 /// Returns sRGB colour corresponding to the index in the 256-colour ANSI palette
-uint32_t rgb_from_ansi256(uint8_t index) {
-    static uint32_t colours[256] = {
+constexpr uint32_t rgb_from_ansi256(uint8_t index) {
+    constexpr uint32_t colours[256] = {
         /* The 16 system colours as used by default by xterm.  Taken
            from XTerm-col.ad distributed with xterm source code. */
         0x000000, 0xcd0000, 0x00cd00, 0xcdcd00,
@@ -460,7 +808,7 @@ uint32_t rgb_from_ansi256(uint8_t index) {
 /// perceptual correctness.  It’s not a proper metric but two properties this
 /// function provides are: d(x, x) = 0 and d(x, y) < d(x, z) implies x being
 /// closer to y than to z.
-uint32_t distance(uint32_t x, uint32_t y)
+constexpr uint32_t distance(uint32_t x, uint32_t y)
 {
     /* See <https://www.compuphase.com/cmetric.htm> though we’re doing a few
        things to avoid some of the calculations.  We can do that since we
@@ -472,281 +820,2094 @@ uint32_t distance(uint32_t x, uint32_t y)
     return (1024 + r_sum) * r * r + 2048 * g * g + (1534 - r_sum) * b * b;
 }
 
-/// Convert 256 colour index to style
-int style_from_colour_number(uint8_t number)
+/// Index of the base colour nearest to rgb
+constexpr int NearestBaseColour(uint32_t rgb) noexcept
 {
-    if (number >= 30 && number <= 37) {
-        return base_colour_to_style[number - 30]; // normal colours are starting from 0
-    } else if (number >= 90 && number <= 97) {
-        return base_colour_to_style[number - 90 + 8]; // bright colours are starting from pos 8
-    }
-
-    // else
-    auto encoded = rgb_from_ansi256(number);
     uint32_t dist = (uint32_t)-1;
     size_t index = 0;
     for (size_t i = 0; i < 16; ++i) {
-        auto base_colour = base_colours[i];
-        auto curdist = distance(encoded, base_colour);
+        const uint32_t curdist = distance(rgb, base_colours[i]);
         if (curdist < dist) {
             dist = curdist;
             index = i;
         }
     }
-    return base_colour_to_style[index];
+    return static_cast<int>(index);
+}
+
+struct BaseColourTable {
+    int colours[256] = {};
+};
+
+constexpr BaseColourTable MakeBaseColourTable() noexcept
+{
+    BaseColourTable table;
+    for (size_t i = 0; i < 256; ++i) {
+        table.colours[i] = NearestBaseColour(rgb_from_ansi256((uint8_t)i));
+    }
+    return table;
 }
 
-#define CSI "\033["
-#define CSI_LEN 2
+/// Base colour for each index of the 256-colour palette, quantized at compile time
+constexpr BaseColourTable base_colour_table = MakeBaseColourTable();
+
+/// Base colour for a 24-bit colour. A tool only uses a handful of distinct colours so the quantization is
+/// memoized in a small direct-mapped cache
+int BaseColourFromRGB(uint32_t rgb) noexcept
+{
+    struct CacheEntry {
+        uint32_t key; // rgb with bit 24 set, 0 for an unused entry
+        int colour;
+    };
+    static thread_local CacheEntry cache[64] = {};
+
+    const uint32_t key = rgb | 0x1000000;
+    CacheEntry& entry = cache[(rgb ^ (rgb >> 6) ^ (rgb >> 12) ^ (rgb >> 18)) & 63];
+    if (entry.key != key) {
+        entry.key = key;
+        entry.colour = NearestBaseColour(rgb);
+    }
+    return entry.colour;
+}
 
-#define ESC "\033"
-#define ESC_LEN 1
+constexpr char ESC = '\033';
 
-constexpr bool SequenceEnd(int ch) noexcept { return (ch == 0) || ((ch >= '@') && (ch <= '~')); }
 constexpr bool IsSeparator(int ch) noexcept { return (ch == ';' || ch == ':'); }
 
-enum class TokenType {
-    Eof,
-    Number,
-    Separator,
-};
+/// Reads the colour following 38 or 48 in an SGR sequence: 5;<index> or 2;<r>;<g>;<b>, or the ':' separated
+/// forms where 2 may be followed by a colour space id, as the nearest base colour. colour is -1 when there is no
+/// valid colour. Returns the number of parameters used
+size_t ReadExtendedColour(const unsigned* params, const bool* subParams, size_t count, int& colour) noexcept
+{
+    colour = -1;
+    if (count == 0) {
+        return 0;
+    }
+    if (params[0] == 5) {
+        if (count < 2) {
+            return count;
+        }
+        if (params[1] < 256) {
+            colour = base_colour_table.colours[params[1]];
+        }
+        return 2;
+    }
+    if (params[0] == 2) {
+        // 38:2:<colour space>:<r>:<g>:<b> has one more sub-parameter than 38:2:<r>:<g>:<b>
+        const size_t first = (subParams[0] && (count >= 5) && subParams[4]) ? 2 : 1;
+        if (count < first + 3) {
+            return count;
+        }
+        const unsigned r = std::min(params[first], 255u);
+        const unsigned g = std::min(params[first + 1], 255u);
+        const unsigned b = std::min(params[first + 2], 255u);
+        colour = BaseColourFromRGB((r << 16) | (g << 8) | b);
+        return first + 3;
+    }
+    return 1;
+}
 
-static TokenType ReadNext(const char* seq, size_t& number, size_t& consumed)
+/// Applies the parameters of an SGR sequence, such as "1;31;44", to the TerminalAttributes key current and returns
+/// the resulting key, 0 when no attributes are set. When all is false only the foreground colour is followed and
+/// the other attributes are parsed over
+int AttributesFromSequence(std::string_view seq, int current, bool all) noexcept
 {
-    enum StateInternal {
-        Start,
-        Digit,
-    };
+    constexpr size_t maxParams = 32;
+    unsigned params[maxParams];
+    bool subParams[maxParams]; // the parameter follows a ':'
+    size_t count = 0;
 
-    number = 0;
-    StateInternal state = StateInternal::Start;
-    bool cont = true;
-    const char* start = seq;
-    while (cont && !SequenceEnd(*seq)) {
-        switch (state) {
-        case StateInternal::Start:
-            if (Is0To9(*seq)) {
-                state = StateInternal::Digit;
-                ++seq;
-            } else if (IsSeparator(*seq)) {
-                consumed = 1;
-                return TokenType::Separator;
-            } else {
-                consumed = 1;
-                return TokenType::Eof;
+    unsigned value = 0;
+    bool subParam = false;
+    for (const char ch : seq) {
+        if (Is0To9(ch)) {
+            if (value < 100000) {
+                value = value * 10 + (ch - '0');
             }
-            break;
-        case StateInternal::Digit:
-            if (Is0To9(*seq)) {
-                ++seq;
-            } else {
-                cont = false;
+        } else if (IsSeparator(ch)) {
+            if (count < maxParams) {
+                params[count] = value;
+                subParams[count] = subParam;
+                count++;
             }
-            break;
+            value = 0;
+            subParam = (ch == ':');
+        } else {
+            // Not a parameter string
+            return 0;
         }
     }
-
-    if (state == StateInternal::Digit && start != seq) {
-        std::string_view sv(start, seq - start);
-        number = ::atoi(sv.data());
-        consumed = sv.length();
-        return TokenType::Number;
+    if (count < maxParams) {
+        // An empty parameter, as in "ESC[m", is 0
+        params[count] = value;
+        subParams[count] = subParam;
+        count++;
     }
 
-    consumed = seq - start;
-    return TokenType::Eof;
+    TerminalAttributes attributes = TerminalAttributes::FromKey(current);
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned code = params[i];
+        if (code == 0) {
+            attributes = TerminalAttributes();
+        } else if (code == 39) {
+            attributes.foreground = -1;
+        } else if (code >= 30 && code <= 37) {
+            attributes.foreground = code - 30; // normal colours are starting from 0
+        } else if (code >= 90 && code <= 97) {
+            attributes.foreground = code - 90 + 8; // bright colours are starting from pos 8
+        } else if (code == 38 || code == 48) {
+            int extended = -1;
+            i += ReadExtendedColour(params + i + 1, subParams + i + 1, count - i - 1, extended);
+            if (extended >= 0) {
+                (code == 38 ? attributes.foreground : attributes.background) = extended;
+            }
+        } else if (code == 49) {
+            attributes.background = -1;
+        } else if (code >= 40 && code <= 47) {
+            attributes.background = code - 40;
+        } else if (code >= 100 && code <= 107) {
+            attributes.background = code - 100 + 8;
+        } else if (code == 1 || code == 22) {
+            attributes.bold = code == 1;
+        } else if (code == 3 || code == 23) {
+            attributes.italic = code == 3;
+        } else if (code == 4 || code == 21 || code == 24) {
+            attributes.underline = code != 24;
+        } else if (code == 7 || code == 27) {
+            attributes.inverse = code == 7;
+        }
+    }
+    if (!all) {
+        return attributes.Key() & TerminalAttributes::foregroundMask;
+    }
+    return attributes.Key();
 }
 
-#define CHECK_EQ_OR_RETURN(a, b, retval) \
-    if (a != b)                          \
-        return retval;
+/// Style of the foreground colour of a TerminalAttributes key, wxSTC_TERMINAL_DEFAULT when it is the default
+constexpr int ForegroundStyle(int key) noexcept
+{
+    const int foreground = (key & TerminalAttributes::foregroundMask) - 1;
+    return (foreground >= 0) ? base_colour_to_style[foreground] : wxSTC_TERMINAL_DEFAULT;
+}
 
-int StyleFromSequence(const char* seq) noexcept
+/// Style for text with the attributes of key. Just a foreground colour uses that colour's style, any other
+/// combination the style the styler allocates for it, falling back to the foreground colour's style
+template <typename Styler>
+int StyleOfAttributes(Styler& styler, int key)
 {
-    const char* p = seq;
-    size_t num, consumed;
-    // Common
-    TokenType t = ReadNext(p, num, consumed);
-    if (t == TokenType::Number && (num >= 0 && num <= 9)) {
-        p += consumed;
-        // Read the next token - it should be a separator
-        t = ReadNext(p, num, consumed);
-        CHECK_EQ_OR_RETURN(t, TokenType::Separator, wxSTC_TERMINAL_DEFAULT);
-        p += consumed;
-        t = ReadNext(p, num, consumed);
+    if ((key & ~TerminalAttributes::foregroundMask) == 0) {
+        return ForegroundStyle(key);
     }
+    const int style = styler.StyleForAttributes(key);
+    return (style >= 0) ? style : ForegroundStyle(key);
+}
 
-    if (t == TokenType::Number && num == 38) {
-        // foreground colour in the format of: 38;5;<number>
-        p += consumed;
-        t = ReadNext(p, num, consumed);
-        CHECK_EQ_OR_RETURN(t, TokenType::Separator, wxSTC_TERMINAL_DEFAULT);
-
-        p += consumed;
-        t = ReadNext(p, num, consumed);
-        CHECK_EQ_OR_RETURN(t, TokenType::Number, wxSTC_TERMINAL_DEFAULT);
-        CHECK_EQ_OR_RETURN(num, 5, wxSTC_TERMINAL_DEFAULT);
-
-        p += consumed;
-        t = ReadNext(p, num, consumed);
-        CHECK_EQ_OR_RETURN(t, TokenType::Separator, wxSTC_TERMINAL_DEFAULT);
-
-        p += consumed;
-        t = ReadNext(p, num, consumed);
-        CHECK_EQ_OR_RETURN(t, TokenType::Number, wxSTC_TERMINAL_DEFAULT);
-        return style_from_colour_number((uint8_t)num);
-
-    } else if (t == TokenType::Number && num == 48) {
-        // background colour
-        return wxSTC_TERMINAL_DEFAULT;
-    } else if (t == TokenType::Number && num < 256) {
-        // find the style from the colour table
-        return style_from_colour_number((uint8_t)num);
+/// The URI of an OSC 8 hyperlink sequence ("8;<params>;<URI>"), empty for the sequence closing a hyperlink.
+/// Returns false for other OSC sequences
+bool HyperlinkURI(std::string_view data, std::string_view& uri) noexcept
+{
+    if ((data.length() < 2) || (data[0] != '8') || (data[1] != ';')) {
+        return false;
     }
-    return wxSTC_TERMINAL_DEFAULT;
+    const size_t endParams = data.find(';', 2);
+    uri = (endParams == std::string_view::npos) ? std::string_view() : data.substr(endParams + 1);
+    return true;
 }
 
-#define NOT_FOUND std::string_view::npos
-bool findOtherEscape(std::string_view sv, size_t& pos, size_t& len)
+/// Reads the decimal number at offset into value, returning false when there are no digits there
+bool ReadNumber(std::string_view line, size_t& offset, int& value) noexcept
 {
-    auto where = sv.find(ESC);
-    if (where == NOT_FOUND) {
+    if ((offset >= line.length()) || !Is0To9(line[offset])) {
         return false;
     }
+    value = 0;
+    for (; (offset < line.length()) && Is0To9(line[offset]); offset++) {
+        if (value < 100000000) {
+            value = value * 10 + (line[offset] - '0');
+        }
+    }
+    return true;
+}
 
-    std::string_view sub = sv.substr(where + ESC_LEN); // skip the escape
-    if (sub.find("(B") != NOT_FOUND || sub.find("(0") != NOT_FOUND || sub.find("(U") != NOT_FOUND ||
-        sub.find("(K") != NOT_FOUND) {
-        // found ESC(<B|0|U|K>
-        pos += where;
-        len = ESC_LEN + 2;
-        return true;
+/// Moves start past the colour escape sequences that coloured output puts before a path
+size_t SkipLeadingSequences(std::string_view line, size_t start, size_t end) noexcept
+{
+    while ((start + 1 < end) && (line[start] == ESC) && (line[start + 1] == '[')) {
+        size_t final = start + 2;
+        while ((final < end) && !((line[final] >= 0x40) && (line[final] <= 0x7e))) {
+            final++;
+        }
+        if (final >= end) {
+            break;
+        }
+        start = final + 1;
+    }
+    return start;
+}
+
+/// Reads "<path>:<line>[:<column>]" with the path starting at start, where the ':' after the path is not the one
+/// in a drive letter. GCC's coloured output puts escape sequences before the path, which are skipped
+bool ReadGccLocation(std::string_view line, size_t start, DiagnosticLocation& location) noexcept
+{
+    start = SkipLeadingSequences(line, start, line.length());
+    for (size_t colon = line.find(':', start); colon != std::string_view::npos; colon = line.find(':', colon + 1)) {
+        size_t offset = colon + 1;
+        if ((colon > start) && ReadNumber(line, offset, location.lineNumber)) {
+            location.pathStart = start;
+            location.pathEnd = colon;
+            if ((offset < line.length()) && (line[offset] == ':')) {
+                offset++;
+                ReadNumber(line, offset, location.column);
+            }
+            return true;
+        }
     }
     return false;
 }
 
-void ColouriseErrorListLine(const std::string& lineBuffer, Sci_PositionU endPos, AccessorInterface& styler,
-                            bool valueSeparate, bool escapeSequences)
+/// Finds the file, line and column that a diagnostic line with style points at, as offsets into line
+bool FindDiagnosticLocation(std::string_view line, int style, DiagnosticLocation& location) noexcept
 {
-    Sci_Position startValue = -1;
-    const Sci_PositionU lengthLine = lineBuffer.length();
-    const int style = RecogniseErrorListLine(lineBuffer.c_str(), lengthLine, startValue);
-    if (escapeSequences && strstr(lineBuffer.c_str(), CSI)) {
-        const Sci_Position startPos = endPos - lengthLine;
-        const char* linePortion = lineBuffer.c_str();
-        Sci_Position startPortion = startPos;
-        int portionStyle = style;
-        while (const char* startSeq = strstr(linePortion, CSI)) {
-            if (startSeq > linePortion) {
-                std::string_view prefix{ linePortion, static_cast<size_t>(startSeq - linePortion) };
-                size_t pos = startPortion;
-                while (!prefix.empty()) {
-                    size_t otherEscPos = 0;
-                    size_t otherEscLen = 0;
-                    if (findOtherEscape(prefix, otherEscPos, otherEscLen)) {
-                        if (otherEscPos != 0) {
-                            styler.ColourTo(pos + otherEscPos, portionStyle);
-                            pos += otherEscPos;
-                        }
-                        styler.ColourTo(pos + otherEscLen, wxSTC_TERMINAL_ESCSEQ_UNKNOWN);
-                        pos += otherEscLen;
-                        prefix = prefix.substr(otherEscPos + otherEscLen);
-                    } else {
-                        styler.ColourTo(pos + (startSeq - linePortion), portionStyle);
-                        break;
-                    }
+    location.style = style;
+    location.lineNumber = 0;
+    location.column = 0;
+    switch (style) {
+    case wxSTC_TERMINAL_GCC:
+    case wxSTC_TERMINAL_GCC_WARNING:
+    case wxSTC_TERMINAL_GCC_NOTE:
+        // <filename>:<line>:<column>: <message>
+        return ReadGccLocation(line, 0, location);
+    case wxSTC_TERMINAL_GCC_INCLUDED_FROM:
+        // "In file included from " or the same length of spaces then "from ", then <filename>:<line>:<column>
+        return ReadGccLocation(line, strlen("In file included from "), location);
+    case wxSTC_TERMINAL_MS: {
+        // <filename>(<line>) or <filename>(<line>,<column>)
+        for (size_t bracket = line.find('('); bracket != std::string_view::npos;
+             bracket = line.find('(', bracket + 1)) {
+            size_t offset = bracket + 1;
+            if ((bracket > 0) && ReadNumber(line, offset, location.lineNumber)) {
+                location.pathStart = 0;
+                location.pathEnd = bracket;
+                if ((offset < line.length()) && (line[offset] == ',')) {
+                    offset++;
+                    ReadNumber(line, offset, location.column);
                 }
+                return true;
             }
-            const char* endSeq = startSeq + CSI_LEN;
-            while (!SequenceEnd(*endSeq))
-                endSeq++;
-            const Sci_Position endSeqPosition = startPortion + (endSeq - linePortion) + 1;
-            switch (*endSeq) {
-            case 0:
-                styler.ColourTo(endPos, wxSTC_TERMINAL_ESCSEQ_UNKNOWN);
-                return;
-            case 'm': // Colour command
-                styler.ColourTo(endSeqPosition, wxSTC_TERMINAL_ESCSEQ);
-                portionStyle = StyleFromSequence(startSeq + CSI_LEN);
-                break;
-            case 'K': // Erase to end of line -> ignore
-                styler.ColourTo(endSeqPosition, wxSTC_TERMINAL_ESCSEQ);
-                break;
-            default:
-                styler.ColourTo(endSeqPosition, wxSTC_TERMINAL_ESCSEQ_UNKNOWN);
-                portionStyle = style;
+        }
+        return false;
+    }
+    case wxSTC_TERMINAL_PYTHON: {
+        // File "<filename>", line <line>
+        const size_t file = line.find("File \"");
+        const size_t quote = (file == std::string_view::npos) ? file : line.find('"', file + 6);
+        if ((quote == std::string_view::npos) || (line.compare(quote + 1, 7, ", line ") != 0)) {
+            return false;
+        }
+        size_t offset = quote + 8;
+        location.pathStart = file + 6;
+        location.pathEnd = quote;
+        return ReadNumber(line, offset, location.lineNumber);
+    }
+    case wxSTC_TERMINAL_BASH: {
+        // <filename>: line <line>:<message>
+        const size_t marker = line.find(": line ");
+        size_t offset = marker + 7;
+        if ((marker == std::string_view::npos) || (marker == 0) || !ReadNumber(line, offset, location.lineNumber)) {
+            return false;
+        }
+        location.pathStart = 0;
+        location.pathEnd = marker;
+        return true;
+    }
+    case wxSTC_TERMINAL_JAVA_STACK: {
+        // \tat <method>(<filename>:<line>)
+        const size_t bracket = line.rfind('(');
+        return (bracket != std::string_view::npos) && ReadGccLocation(line, bracket + 1, location);
+    }
+    default:
+        return false;
+    }
+}
+
+/// Escape sequence styling of a line, carried from one piece of the line to the next
+struct SequenceState {
+    int style = 0;        // Style of the line for text with no attributes
+    int portionStyle = 0; // Style of the text that follows
+    Sci_Position startHyperlink = -1;
+};
+
+/// Styles a piece of text or an escape sequence found by EscapeSequenceParser, where startPos is the position
+/// before the text parsed. colour is updated by SGR sequences
+template <typename Styler>
+void ColourSequence(const EscapeSequence& sequence, Sci_Position startPos, Styler& styler,
+                    SequenceState& state, int& colour, int hyperlinkIndicator, bool sgrAttributes)
+{
+    const Sci_Position endSequence = startPos + sequence.start + sequence.length;
+    std::string_view uri;
+    switch (sequence.kind) {
+    case EscapeSequenceKind::text:
+        styler.ColourTo(endSequence, state.portionStyle);
+        break;
+    case EscapeSequenceKind::osc:
+        if (HyperlinkURI(sequence.data, uri)) {
+            styler.ColourTo(endSequence, wxSTC_TERMINAL_ESCSEQ);
+            if ((state.startHyperlink >= 0) && (hyperlinkIndicator >= 0)) {
+                styler.IndicatorFill(state.startHyperlink, startPos + sequence.start + 1, hyperlinkIndicator, 1);
             }
-            startPortion = endSeqPosition;
-            linePortion = endSeq + 1;
+            state.startHyperlink = uri.empty() ? -1 : endSequence + 1;
+        } else {
+            styler.ColourTo(endSequence, wxSTC_TERMINAL_ESCSEQ_UNKNOWN);
         }
-        styler.ColourTo(endPos, portionStyle);
-    } else {
-        if (valueSeparate && (startValue >= 0)) {
-            styler.ColourTo(endPos - (lengthLine - startValue), style);
-            styler.ColourTo(endPos, wxSTC_TERMINAL_VALUE);
+        break;
+    case EscapeSequenceKind::csi:
+        if ((sequence.final == 'm') && sequence.intermediates.empty()) { // Colour command
+            styler.ColourTo(endSequence, wxSTC_TERMINAL_ESCSEQ);
+            colour = AttributesFromSequence(sequence.parameters, colour, sgrAttributes);
+            state.portionStyle = StyleOfAttributes(styler, colour);
+        } else if (sequence.final == 'K') { // Erase to end of line -> ignore
+            styler.ColourTo(endSequence, wxSTC_TERMINAL_ESCSEQ);
         } else {
-            styler.ColourTo(endPos, style);
+            styler.ColourTo(endSequence, wxSTC_TERMINAL_ESCSEQ_UNKNOWN);
+            state.portionStyle = state.style;
+            colour = 0;
         }
+        break;
+    default:
+        styler.ColourTo(endSequence, wxSTC_TERMINAL_ESCSEQ_UNKNOWN);
+        break;
     }
 }
 
-void ColouriseTerminalDocInternal(Sci_PositionU startPos, Sci_Position length, int, WordList*[],
-                                  AccessorInterface& styler)
+/// Fills the hyperlink still open at the end of a line, which ends with lineEnd, up to the line end characters.
+/// Hyperlinks are not carried over to the next line
+template <typename Styler>
+void EndHyperlink(std::string_view lineEnd, Sci_Position endPos, Styler& styler,
+                  const SequenceState& state, int hyperlinkIndicator)
 {
-    std::string lineBuffer;
-    styler.StartAt(startPos);
-    styler.StartSegment(startPos);
-
-    // property lexer.errorlist.value.separate
-    //	For lines in the output pane that are matches from Find in Files or
-    // GCC-style 	diagnostics, style the path and line number separately from the
-    // rest of the 	line with style 21 used for the rest of the line. 	This allows
-    // matched text to be more easily distinguished from its location.
-    const bool valueSeparate = styler.GetPropertyInt("lexer.terminal.value.separate", 0) != 0;
-
-    // property lexer.errorlist.escape.sequences
-    //	Set to 1 to interpret escape sequences.
-    const bool escapeSequences = styler.GetPropertyInt("lexer.terminal.escape.sequences") != 0;
-
-    for (Sci_PositionU i = startPos; i < startPos + length; i++) {
-        lineBuffer.push_back(styler[i]);
-        if (AtEOL(styler, i)) {
-            // End of line met, colourise it
-            ColouriseErrorListLine(lineBuffer, i, styler, valueSeparate, escapeSequences);
-            lineBuffer.clear();
-        }
+    if ((state.startHyperlink < 0) || (hyperlinkIndicator < 0)) {
+        return;
     }
-    if (!lineBuffer.empty()) { // Last line does not have ending characters
-        ColouriseErrorListLine(lineBuffer, startPos + length - 1, styler, valueSeparate, escapeSequences);
+    Sci_Position endHyperlink = endPos + 1;
+    for (size_t i = lineEnd.length(); (i > 0) && ((lineEnd[i - 1] == '\r') || (lineEnd[i - 1] == '\n')); i--) {
+        endHyperlink--;
+    }
+    if (endHyperlink > state.startHyperlink) {
+        styler.IndicatorFill(state.startHyperlink, endHyperlink, hyperlinkIndicator, 1);
     }
 }
 
-void ColouriseTerminalDoc(Sci_PositionU startPos, Sci_Position length, int, WordList*[], Accessor& styler)
+/// Remembers how recently seen short lines were classified, as build and test output repeats the same lines over
+/// and over: a warning from each translation unit, make's "Entering directory" lines, test headers.
+/// Entries are found by a hash of the line's length, start and end and then compared in full, so a line is only
+/// ever given the classification of an identical line
+class LineClassCache
 {
-    NativeAccessor accessor(styler);
-    ColouriseTerminalDocInternal(startPos, length, 0, nullptr, accessor);
-}
+public:
+    static constexpr size_t maxLength = 200;
 
-const char* const emptyWordListDesc[] = { nullptr };
+    static uint32_t Hash(std::string_view line) noexcept
+    {
+        // FNV-1a over the first 32 and the last 8 bytes
+        uint32_t hash = 2166136261u ^ static_cast<uint32_t>(line.length());
+        auto mix = [&hash](const char* s, size_t length) {
+            for (size_t i = 0; i < length; i++) {
+                hash = (hash ^ static_cast<unsigned char>(s[i])) * 16777619u;
+            }
+        };
+        const size_t lengthStart = std::min<size_t>(line.length(), 32);
+        mix(line.data(), lengthStart);
+        const size_t lengthEnd = std::min<size_t>(line.length() - lengthStart, 8);
+        mix(line.data() + line.length() - lengthEnd, lengthEnd);
+        return hash;
+    }
+    bool Find(std::string_view line, uint32_t hash, int& style, Sci_Position& startValue) const noexcept
+    {
+        const Entry& entry = m_entries[hash % entries];
+        if (!entry.used || (entry.hash != hash) || (entry.length != line.length()) ||
+            (memcmp(entry.text, line.data(), line.length()) != 0)) {
+            return false;
+        }
+        style = entry.style;
+        startValue = entry.startValue;
+        return true;
+    }
+    void Add(std::string_view line, uint32_t hash, int style, Sci_Position startValue) noexcept
+    {
+        Entry& entry = m_entries[hash % entries];
+        entry.used = true;
+        entry.hash = hash;
+        entry.length = static_cast<unsigned char>(line.length());
+        entry.style = static_cast<unsigned char>(style);
+        entry.startValue = static_cast<short>(startValue);
+        memcpy(entry.text, line.data(), line.length());
+    }
 
-} // namespace
+private:
+    static constexpr size_t entries = 64;
+    struct Entry {
+        bool used = false;
+        unsigned char length = 0;
+        unsigned char style = 0;
+        short startValue = -1;
+        uint32_t hash = 0;
+        char text[maxLength];
+    };
+    static_assert(maxLength <= 255, "Entry::length holds the length");
+    Entry m_entries[entries];
+};
 
-// Our API for exporting the lexer
-void* CreateExtraLexerTerminal()
+/// Classifies a line and reports its diagnostic, lineBuffer being the line or a prefix of it that starts at
+/// lineStart and is followed by a NUL. The host's patterns, when not nullptr, are tried before the built-in
+/// formats. Short lines are looked up in a cache kept by each thread, with hits and misses added to counters when
+/// it is not nullptr. A template so the styler is called directly, not through AccessorInterface
+template <typename Styler>
+int ClassifyLine(std::string_view lineBuffer, Sci_PositionU lineStart, Styler& styler,
+                 bool diagnostics, Sci_Position& startValue, [[maybe_unused]] LexCounters* counters = nullptr,
+                 const LinePatterns* patterns = nullptr)
 {
-    static LexerModule module(wxSTC_LEX_TERMINAL, ColouriseTerminalDoc, "terminal", nullptr, emptyWordListDesc);
-    return (void*)new LexerSimple(&module);
+    LinePatternMatch match;
+    if (patterns && patterns->Match(lineBuffer, match)) {
+        startValue = match.messageStart;
+        if (diagnostics && ((match.pathEnd > match.pathStart) || (match.lineNumber > 0))) {
+            DiagnosticLocation location;
+            location.line = styler.GetLine(lineStart);
+            location.pathStart = lineStart + match.pathStart;
+            location.pathEnd = lineStart + match.pathEnd;
+            location.lineNumber = match.lineNumber;
+            location.column = match.column;
+            location.style = match.style;
+            styler.AddDiagnostic(location);
+        }
+        return match.style;
+    }
+    int style = 0;
+    if (lineBuffer.length() <= LineClassCache::maxLength) {
+        thread_local LineClassCache cache;
+        const uint32_t hash = LineClassCache::Hash(lineBuffer);
+        if (cache.Find(lineBuffer, hash, style, startValue)) {
+            LEXILLA_COUNT(counters, classificationHits, 1);
+        } else {
+            style = RecogniseErrorListLine(lineBuffer.data(), lineBuffer.length(), startValue);
+            cache.Add(lineBuffer, hash, style, startValue);
+            LEXILLA_COUNT(counters, classificationMisses, 1);
+        }
+    } else {
+        style = RecogniseErrorListLine(lineBuffer.data(), lineBuffer.length(), startValue);
+    }
+    if (diagnostics) {
+        DiagnosticLocation location;
+        if (FindDiagnosticLocation(lineBuffer, style, location)) {
+            location.line = styler.GetLine(lineStart);
+            location.pathStart += lineStart;
+            location.pathEnd += lineStart;
+            styler.AddDiagnostic(location);
+        }
+    }
+    return style;
 }
 
-void FreeExtraLexer(void* p)
+/// lineBuffer must be followed by a NUL, as the classification treats it as a C string.
+/// colour is the TerminalAttributes key of the escape sequence attributes active at the start of the line, 0 when
+/// there are none, and is updated to the attributes still active at the end of the line. Only the foreground colour
+/// is followed unless sgrAttributes is set.
+/// When hyperlinkIndicator is not -1, the text of OSC 8 hyperlinks is filled with that indicator.
+/// When diagnostics is set, the location named by a diagnostic line is sent to the styler's AddDiagnostic.
+/// Returns whether the line has a value after its location, styled differently when valueSeparate changes
+template <typename Styler>
+bool ColouriseErrorListLine(std::string_view lineBuffer, Sci_PositionU endPos, Styler& styler,
+                            bool valueSeparate, bool escapeSequences, int& colour, int hyperlinkIndicator = -1,
+                            bool diagnostics = false, bool sgrAttributes = false, LexCounters* counters = nullptr,
+                            const LinePatterns* patterns = nullptr)
 {
-    if (p) {
-        delete reinterpret_cast<LexerSimple*>(p);
+    Sci_Position startValue = -1;
+    const Sci_PositionU lengthLine = lineBuffer.length();
+    LEXILLA_TRACE_SCOPE("TerminalLine", nullptr, endPos + 1 - lengthLine, endPos + 1);
+    const int style =
+        ClassifyLine(lineBuffer, endPos + 1 - lengthLine, styler, diagnostics, startValue, counters, patterns);
+    if (escapeSequences && ((colour != 0) || memchr(lineBuffer.data(), ESC, lengthLine))) {
+        const Sci_Position startPos = endPos - lengthLine;
+        SequenceState state;
+        state.style = style;
+        state.portionStyle = (colour != 0) ? StyleOfAttributes(styler, colour) : style;
+        EscapeSequenceParser parser(lineBuffer);
+        EscapeSequence sequence;
+        while (parser.Next(sequence)) {
+            ColourSequence(sequence, startPos, styler, state, colour, hyperlinkIndicator, sgrAttributes);
+        }
+        EndHyperlink(lineBuffer, endPos, styler, state, hyperlinkIndicator);
+        return false;
+    }
+    if (valueSeparate && (startValue >= 0)) {
+        styler.ColourTo(endPos - (lengthLine - startValue), style);
+        styler.ColourTo(endPos, wxSTC_TERMINAL_VALUE);
+    } else {
+        styler.ColourTo(endPos, style);
+    }
+    return startValue >= 0;
+}
+
+/// Styles a line ended by a '\r' alone, which the next line overwrites, as wxSTC_TERMINAL_OVERWRITTEN without
+/// classifying it and reports it to the styler's AddOverwritten. Escape sequences are still followed so colour
+/// is updated to the attributes active at the end of the line
+template <typename Styler>
+void ColouriseOverwrittenLine(std::string_view lineBuffer, Sci_PositionU endPos, Styler& styler,
+                              bool escapeSequences, int& colour, bool sgrAttributes)
+{
+    styler.ColourTo(endPos, wxSTC_TERMINAL_OVERWRITTEN);
+    styler.AddOverwritten(endPos + 1 - lineBuffer.length(), endPos + 1);
+    if (escapeSequences && memchr(lineBuffer.data(), ESC, lineBuffer.length())) {
+        EscapeSequenceParser parser(lineBuffer);
+        EscapeSequence sequence;
+        while (parser.Next(sequence)) {
+            if (sequence.kind != EscapeSequenceKind::csi) {
+                continue;
+            }
+            // As in ColouriseErrorListLine
+            if ((sequence.final == 'm') && sequence.intermediates.empty()) {
+                colour = AttributesFromSequence(sequence.parameters, colour, sgrAttributes);
+            } else if (sequence.final != 'K') {
+                colour = 0;
+            }
+        }
+    }
+}
+
+/// Finds the end of the line starting at offset in chunk: a '\n', or a '\r' not followed by '\n'.
+/// Returns the position of the last character of the line, chunkLength when the chunk ends first
+size_t FindLineEnd(const char* chunk, size_t offset, size_t chunkLength) noexcept
+{
+    const char* const end = chunk + chunkLength;
+    const char* const found = FindAny2(chunk + offset, end, '\n', '\r');
+    if ((found < end) && (*found == '\r')) {
+        if (found + 1 == end) {
+            return chunkLength;
+        }
+        return (found[1] == '\n') ? (found + 1 - chunk) : (found - chunk);
+    }
+    return found - chunk;
+}
+
+/// What checking styled text as UTF-8 found
+struct EncodingSummary {
+    bool ascii = true;
+    bool valid = true;
+    // End of the text checked
+    Sci_PositionU end = 0;
+
+    void Add(bool asciiText, bool validText, Sci_PositionU endText) noexcept
+    {
+        ascii = ascii && asciiText;
+        valid = valid && validText;
+        end = std::max(end, endText);
+    }
+};
+
+struct TerminalOptions {
+    bool valueSeparate = false;
+    bool escapeSequences = false;
+    int hyperlinkIndicator = -1;
+    bool diagnostics = false;
+    bool sgrAttributes = false;
+    bool overwritten = false;
+    // Where the work done is counted, nullptr when it is not
+    LexCounters* counters = nullptr;
+    // Host defined line formats tried before the built-in ones, nullptr when there are none
+    const LinePatterns* patterns = nullptr;
+    // Where what checking the text as UTF-8 found is added, nullptr when it is not checked
+    EncodingSummary* encoding = nullptr;
+    // Indicator filled over bytes that are not valid UTF-8, -1 for none
+    int utf8Indicator = -1;
+    // Where the start of each line whose styles depend on valueSeparate is marked, nullptr when it is not
+    LexInvalidation* invalidation = nullptr;
+};
+
+/// The dependency of lexer.terminal.value.separate in the module's PropertyScopes
+constexpr int dependencyValueSeparate = 0;
+
+/// Checks text, which starts at start and is styled with options, as UTF-8 with validator, filling the invalid
+/// bytes found with options.utf8Indicator and adding what was found to options.encoding. When more is set the
+/// line continues after text
+template <typename Styler>
+void CheckEncoding(std::string_view text, Sci_PositionU start, bool more, UTF8Validator& validator,
+                   Styler& styler, const TerminalOptions& options)
+{
+    validator.Check(text, start, more, [&styler, &options](size_t invalidStart, size_t invalidEnd) {
+        if (options.utf8Indicator >= 0) {
+            styler.IndicatorFill(invalidStart, invalidEnd, options.utf8Indicator, 1);
+        }
+    });
+    options.encoding->Add(validator.ASCII(), validator.Valid(), start + text.length());
+}
+
+/// Lines longer than longLineLimit are styled a piece at a time and classified by their first classifiedPrefix bytes
+constexpr size_t longLineLimit = 0x10000;
+constexpr size_t classifiedPrefix = 0x1000;
+
+/// Where LongLineColouriser is in a line, kept between pieces so they may be styled by different colourisers
+struct LongLineState {
+    SequenceState sequence;
+    Sci_Position startValue = -1;
+    bool sequences = false;
+    Sci_PositionU position = 0;
+    // Carries a character split between pieces
+    UTF8Validator validator;
+};
+
+/// Styles a line longer than longLineLimit, such as minified JSON or a base64 blob, a piece at a time so it never
+/// has to be held whole. Every pattern recognised is anchored near the start of a line or depends on its
+/// <filename>:<line>: prefix, so the line is classified from its first classifiedPrefix bytes. The rest is styled
+/// with that style, or as the value past a diagnostic's location, up to its first escape sequence after which
+/// sequences are followed as for other lines. Styling does not depend on how the line is split into pieces.
+/// Long lines are never styled as overwritten as whether they end with a '\r' is only known at their end
+template <typename Styler>
+class LongLineColouriser
+{
+public:
+    LongLineColouriser(Styler& styler, const TerminalOptions& options, int& colour, LongLineState& line)
+        : m_styler(styler)
+        , m_options(options)
+        , m_colour(colour)
+        , m_line(line)
+    {
+    }
+
+    /// Starts the line at lineStart, prefix holding at least its first classifiedPrefix bytes
+    void Start(std::string_view prefix, Sci_PositionU lineStart)
+    {
+        char buffer[classifiedPrefix + 1];
+        memcpy(buffer, prefix.data(), classifiedPrefix);
+        buffer[classifiedPrefix] = '\0';
+        Sci_Position startValue = -1;
+        m_line.sequence = SequenceState();
+        m_line.sequence.style = ClassifyLine(std::string_view(buffer, classifiedPrefix), lineStart, m_styler,
+                                     m_options.diagnostics, startValue, nullptr, m_options.patterns);
+        m_line.startValue = (startValue >= 0) ? lineStart + startValue : -1;
+        if ((m_line.startValue >= 0) && m_options.invalidation) {
+            m_options.invalidation->Mark(dependencyValueSeparate, lineStart);
+        }
+        m_line.sequences = m_options.escapeSequences && (m_colour != 0);
+        m_line.sequence.portionStyle = m_line.sequences ? StyleOfAttributes(m_styler, m_colour) : m_line.sequence.style;
+        m_line.position = lineStart;
+        m_line.validator.Reset();
+    }
+
+    /// Styles piece, the text of the line that follows what has been styled so far. When more is set the line
+    /// continues after piece and an escape sequence cut short by its end is left for the next call.
+    /// Returns the number of bytes styled
+    size_t Piece(std::string_view piece, bool more)
+    {
+        const Sci_PositionU start = m_line.position;
+        const size_t styled = StylePiece(piece, more);
+        if (m_options.encoding) {
+            CheckEncoding(piece.substr(0, styled), start, more, m_line.validator, m_styler, m_options);
+        }
+        return styled;
+    }
+
+private:
+    size_t StylePiece(std::string_view piece, bool more)
+    {
+        const Sci_PositionU start = m_line.position;
+        size_t offset = 0;
+        if (!m_line.sequences) {
+            const size_t escape = m_options.escapeSequences ? piece.find(ESC) : std::string_view::npos;
+            const size_t lengthPlain = std::min(escape, piece.length());
+            if (lengthPlain > 0) {
+                const Sci_PositionU last = start + lengthPlain - 1;
+                if (m_options.valueSeparate && (m_line.startValue >= 0)) {
+                    if (static_cast<Sci_PositionU>(m_line.startValue) > start) {
+                        m_styler.ColourTo(std::min<Sci_PositionU>(m_line.startValue - 1, last), m_line.sequence.style);
+                    }
+                    m_styler.ColourTo(last, wxSTC_TERMINAL_VALUE);
+                } else {
+                    m_styler.ColourTo(last, m_line.sequence.style);
+                }
+            }
+            if (escape == std::string_view::npos) {
+                m_line.position = start + piece.length();
+                return piece.length();
+            }
+            m_line.sequences = true;
+            offset = escape;
+        }
+        const std::string_view rest = piece.substr(offset);
+        size_t styled = piece.length();
+        EscapeSequenceParser parser(rest);
+        EscapeSequence sequence;
+        while (parser.Next(sequence)) {
+            if (more && (sequence.kind == EscapeSequenceKind::malformed) &&
+                (sequence.start + sequence.length == rest.length()) && (offset + sequence.start > 0)) {
+                styled = offset + sequence.start;
+                break;
+            }
+            ColourSequence(sequence, static_cast<Sci_Position>(start + offset) - 1, m_styler, m_line.sequence, m_colour,
+                           m_options.hyperlinkIndicator, m_options.sgrAttributes);
+        }
+        if (!more) {
+            EndHyperlink(piece, start + piece.length() - 1, m_styler, m_line.sequence, m_options.hyperlinkIndicator);
+        }
+        m_line.position = start + styled;
+        return styled;
+    }
+
+    Styler& m_styler;
+    const TerminalOptions& m_options;
+    int& m_colour;
+    LongLineState& m_line;
+};
+
+/// Styles one line with the options, the line ending at position last
+template <typename Styler>
+void ColouriseTerminalLine(std::string_view line, Sci_PositionU last, Styler& styler,
+                           const TerminalOptions& options, int& colour)
+{
+    if (line.length() > longLineLimit) {
+        LongLineState state;
+        LongLineColouriser<Styler> colouriser(styler, options, colour, state);
+        colouriser.Start(line, last + 1 - line.length());
+        size_t offset = 0;
+        while (line.length() - offset > longLineLimit) {
+            offset += colouriser.Piece(line.substr(offset, longLineLimit), true);
+        }
+        colouriser.Piece(line.substr(offset), false);
+        return;
+    }
+    if (options.encoding) {
+        // Checked while the line is still in the cache
+        UTF8Validator validator;
+        CheckEncoding(line, last + 1 - line.length(), false, validator, styler, options);
+    }
+    if (options.overwritten && !line.empty() && (line.back() == '\r')) {
+        ColouriseOverwrittenLine(line, last, styler, options.escapeSequences, colour, options.sgrAttributes);
+    } else {
+        const bool hasValue = ColouriseErrorListLine(line, last, styler, options.valueSeparate,
+                                                     options.escapeSequences, colour, options.hyperlinkIndicator,
+                                                     options.diagnostics, options.sgrAttributes, options.counters,
+                                                     options.patterns);
+        if (hasValue && options.invalidation) {
+            options.invalidation->Mark(dependencyValueSeparate, last + 1 - line.length());
+        }
+    }
+}
+
+/// Styles the lines in [startPos, startPos + length), which starts at a line start with colour as the escape
+/// sequence colour active there. Returns the colour active at the end.
+/// When mayStop is set, styling ends early at a line start for which the accessor's StopBefore is true.
+/// The chunk and line buffers come from arena so no heap allocations are made once it has grown to fit.
+/// Lines longer than longLineLimit are styled as they are read so at most two chunks of one are held
+template <typename Styler>
+int ColouriseTerminalLines(Sci_PositionU startPos, Sci_PositionU length, Styler& styler,
+                           const TerminalOptions& options, int colour, LexArena& arena, bool mayStop = true)
+{
+    // The text is fetched in chunks and lines are coloured in place, only a line that continues into the next
+    // chunk is copied to lineBuffer
+    constexpr size_t chunkSize = longLineLimit;
+    const Sci_PositionU endRange = startPos + length;
+    const size_t chunkAllocated = std::min<size_t>(length, chunkSize) + 1; // room for a NUL after the last line
+    char* chunk = arena.AllocateArray<char>(chunkAllocated);
+    chunk[chunkAllocated - 1] = '\0';
+    ArenaString lineBuffer{ ArenaAllocator<char>(arena) };
+    Sci_PositionU lineStart = startPos;
+
+    auto endLine = [&](Sci_PositionU last) {
+        if (options.escapeSequences) {
+            styler.SetLineState(styler.GetLine(lineStart), colour);
+        }
+        lineStart = last + 1;
+    };
+    auto colouriseLine = [&](std::string_view line, Sci_PositionU last) {
+        ColouriseTerminalLine(line, last, styler, options, colour);
+        endLine(last);
+    };
+    // At least one line is styled each time so styling always progresses
+    auto stopBefore = [&]() { return mayStop && (lineStart > startPos) && styler.StopBefore(lineStart); };
+
+    // A long line is styled a piece at a time once lineBuffer holds more than longLineLimit bytes of it, after
+    // which lineBuffer only keeps an escape sequence cut short by the end of a chunk
+    LongLineState longLineState;
+    LongLineColouriser longLine(styler, options, colour, longLineState);
+    bool inLongLine = false;
+    auto continueLongLine = [&](const char* text, size_t lengthText, bool more) {
+        if (lineBuffer.empty()) {
+            const size_t styled = longLine.Piece(std::string_view(text, lengthText), more);
+            lineBuffer.append(text + styled, lengthText - styled);
+        } else {
+            lineBuffer.append(text, lengthText);
+            lineBuffer.erase(0, longLine.Piece(lineBuffer, more));
+        }
+    };
+
+    for (Sci_PositionU chunkStart = startPos; chunkStart < endRange; chunkStart += chunkSize) {
+        const size_t chunkLength = std::min<size_t>(chunkSize, endRange - chunkStart);
+        styler.GetCharRange(chunk, chunkStart, chunkLength);
+        size_t offset = 0;
+        while (offset < chunkLength) {
+            size_t eol = FindLineEnd(chunk, offset, chunkLength);
+            if ((eol == chunkLength) && (chunk[chunkLength - 1] == '\r') &&
+                (styler.SafeGetCharAt(chunkStart + chunkLength) != '\n')) {
+                // The '\r' ending the chunk is not the first half of "\r\n"
+                eol = chunkLength - 1;
+            }
+            if (eol == chunkLength) {
+                if (inLongLine) {
+                    continueLongLine(chunk + offset, chunkLength - offset, true);
+                } else {
+                    lineBuffer.append(chunk + offset, chunkLength - offset);
+                    if (lineBuffer.length() > longLineLimit) {
+                        if (stopBefore()) {
+                            return colour;
+                        }
+                        inLongLine = true;
+                        longLine.Start(lineBuffer, lineStart);
+                        lineBuffer.erase(0, longLine.Piece(lineBuffer, true));
+                    }
+                }
+                break;
+            }
+            // End of line met, colourise it
+            if (inLongLine) {
+                continueLongLine(chunk + offset, eol + 1 - offset, false);
+                lineBuffer.clear();
+                inLongLine = false;
+                endLine(chunkStart + eol);
+                offset = eol + 1;
+                continue;
+            }
+            if (stopBefore()) {
+                return colour;
+            }
+            if (lineBuffer.empty()) {
+                const char after = chunk[eol + 1];
+                chunk[eol + 1] = '\0';
+                colouriseLine(std::string_view(chunk + offset, eol + 1 - offset), chunkStart + eol);
+                chunk[eol + 1] = after;
+            } else {
+                lineBuffer.append(chunk + offset, eol + 1 - offset);
+                colouriseLine(lineBuffer, chunkStart + eol);
+                lineBuffer.clear();
+            }
+            offset = eol + 1;
+        }
+    }
+    // Last line does not have ending characters
+    if (inLongLine) {
+        longLine.Piece(lineBuffer, false);
+        endLine(endRange - 1);
+    } else if (!lineBuffer.empty() && !stopBefore()) {
+        colouriseLine(lineBuffer, endRange - 1);
+    }
+    return colour;
+}
+
+/// Styles a part of the text on a worker thread. The text was copied by the caller and styles, line states and
+/// indicators are recorded so they can be applied to the real accessor afterwards, in document order.
+/// Until then lines are identified by their start position: GetLine returns its argument
+class RecordingAccessor final : public AccessorInterface
+{
+public:
+    struct LineState {
+        size_t lineStart;
+        int state;
+    };
+    struct Indicator {
+        size_t start;
+        size_t end;
+        int indicator;
+        int value;
+    };
+    struct Range {
+        size_t start;
+        size_t end;
+    };
+
+    RecordingAccessor(std::string_view text, size_t startPos, char after)
+        : m_text(text)
+        , m_startPos(startPos)
+        , m_after(after)
+    {
+    }
+
+    const char operator[](size_t index) const override { return m_text[index - m_startPos]; }
+    char SafeGetCharAt(size_t index, char chDefault = ' ') const override
+    {
+        if ((index >= m_startPos) && (index - m_startPos < m_text.length())) {
+            return m_text[index - m_startPos];
+        }
+        return (index == m_startPos + m_text.length()) ? m_after : chDefault;
+    }
+    void GetCharRange(char* buffer, size_t pos, size_t length) const override
+    {
+        memcpy(buffer, m_text.data() + pos - m_startPos, length);
+    }
+    void ColourTo(size_t pos, int style) override
+    {
+        if (pos < m_segmentStart) {
+            return;
+        }
+        const size_t length = pos + 1 - m_segmentStart;
+        if (!m_runs.empty() && (m_runs.back().style == style)) {
+            m_runs.back().length += length;
+        } else {
+            m_runs.push_back({ length, style });
+        }
+        m_segmentStart = pos + 1;
+    }
+    void StartAt(size_t start) override { m_segmentStart = start; }
+    void StartSegment(size_t pos) override { m_segmentStart = pos; }
+    int GetPropertyInt(const std::string& /*name*/, int defaultVal = 0) const override { return defaultVal; }
+    size_t GetLine(size_t pos) const override { return pos; }
+    void SetLineState(size_t line, int state) override { m_lineStates.push_back({ line, state }); }
+    void IndicatorFill(size_t start, size_t end, int indicator, int value) override
+    {
+        m_indicators.push_back({ start, end, indicator, value });
+    }
+    void AddDiagnostic(const DiagnosticLocation& location) override { m_diagnostics.push_back(location); }
+    /// Styles for attributes are allocated when replayed, in document order, so workers need not share the table
+    int StyleForAttributes(int key) override { return attributesStyle + key; }
+    void AddOverwritten(size_t start, size_t end) override { m_overwritten.push_back({ start, end }); }
+
+    /// Sends everything recorded from position from onwards to styler, which has been styled up to from
+    template <typename Styler>
+    void Replay(size_t from, Styler& styler) const
+    {
+        size_t pos = m_startPos;
+        for (const StyleRun& run : m_runs) {
+            pos += run.length;
+            if (pos > from) {
+                styler.ColourTo(pos - 1,
+                                (run.style >= attributesStyle) ? StyleOfAttributes(styler, run.style - attributesStyle)
+                                                               : run.style);
+            }
+        }
+        for (const LineState& lineState : m_lineStates) {
+            if (lineState.lineStart >= from) {
+                styler.SetLineState(styler.GetLine(lineState.lineStart), lineState.state);
+            }
+        }
+        for (const Indicator& indicator : m_indicators) {
+            if (indicator.start >= from) {
+                styler.IndicatorFill(indicator.start, indicator.end, indicator.indicator, indicator.value);
+            }
+        }
+        for (DiagnosticLocation diagnostic : m_diagnostics) {
+            // line holds the line's start until now
+            if (diagnostic.line >= from) {
+                diagnostic.line = styler.GetLine(diagnostic.line);
+                styler.AddDiagnostic(diagnostic);
+            }
+        }
+        for (const Range& range : m_overwritten) {
+            if (range.start >= from) {
+                styler.AddOverwritten(range.start, range.end);
+            }
+        }
+    }
+
+    const std::vector<LineState>& LineStates() const { return m_lineStates; }
+
+private:
+    /// Recorded in place of the style for a TerminalAttributes key, beyond any real style
+    static constexpr int attributesStyle = 0x100;
+
+    std::string_view m_text;
+    size_t m_startPos;
+    char m_after;
+    size_t m_segmentStart = 0;
+    std::vector<StyleRun> m_runs;
+    std::vector<LineState> m_lineStates;
+    std::vector<Indicator> m_indicators;
+    std::vector<DiagnosticLocation> m_diagnostics;
+    std::vector<Range> m_overwritten;
+};
+
+/// Styles [startPos, startPos + length) with up to threads worker threads. The text is read in batches that are
+/// split into one part per thread at line ends. Parts other than the first of the text start with an unknown
+/// escape sequence colour, so they are styled assuming none. When that turns out to be wrong, lines of the part
+/// are restyled with the right colour until the colour at a line end agrees with the one recorded, after which
+/// the recorded styling is correct.
+/// Returns the colour active at the end
+template <typename Styler>
+int ColouriseTerminalParallel(Sci_PositionU startPos, Sci_PositionU length, Styler& styler,
+                              const TerminalOptions& options, int colour, size_t threads, size_t partSize,
+                              LexArena& arena)
+{
+    struct Part {
+        size_t offset = 0;
+        size_t length = 0;
+        int startColour = 0;
+        int endColour = 0;
+        bool failed = false;
+        std::unique_ptr<RecordingAccessor> recording;
+        // Counted separately by each thread and added to options.counters once joined
+        LexCounters counters;
+        // Likewise added to options.encoding
+        EncodingSummary encoding;
+        // And merged into options.invalidation
+        LexInvalidation invalidation;
+    };
+
+    const Sci_PositionU endRange = startPos + length;
+    ArenaString text{ ArenaAllocator<char>(arena) };
+    Sci_PositionU batchStart = startPos;
+    while ((batchStart < endRange) && ((batchStart == startPos) || !styler.StopBefore(batchStart))) {
+        // Read a batch ending at a line end
+        size_t batchLength = std::min<size_t>(threads * partSize, endRange - batchStart);
+        text.resize(batchLength);
+        styler.GetCharRange(&text[0], batchStart, batchLength);
+        size_t lastLF = text.rfind('\n');
+        while ((lastLF == ArenaString::npos) && (batchStart + batchLength < endRange)) {
+            // A long line, read on until it ends
+            const size_t more = std::min<size_t>(partSize, endRange - batchStart - batchLength);
+            text.resize(batchLength + more);
+            styler.GetCharRange(&text[batchLength], batchStart + batchLength, more);
+            lastLF = text.find('\n', batchLength);
+            batchLength += more;
+        }
+        if ((batchStart + batchLength < endRange) && (lastLF != ArenaString::npos)) {
+            batchLength = lastLF + 1;
+        }
+        const char after = styler.SafeGetCharAt(batchStart + batchLength);
+        // There is room for a NUL after each line of the batch
+        text.resize(batchLength + 1);
+        text[batchLength] = after;
+
+        std::vector<Part> parts;
+        for (size_t offset = 0; offset < batchLength;) {
+            Part part;
+            part.offset = offset;
+            const size_t lineEnd = (offset + partSize < batchLength) ? text.find('\n', offset + partSize) : batchLength;
+            part.length = std::min(lineEnd, batchLength - 1) + 1 - offset;
+            part.startColour = parts.empty() ? colour : 0;
+            offset += part.length;
+            parts.push_back(std::move(part));
+        }
+
+        auto stylePart = [&](Part& part) {
+            try {
+                // Each thread needs its own arena
+                LexArena partArena;
+                part.recording = std::make_unique<RecordingAccessor>(
+                    std::string_view(text.data() + part.offset, part.length), batchStart + part.offset,
+                    text[part.offset + part.length]);
+                part.recording->StartAt(batchStart + part.offset);
+                TerminalOptions partOptions = options;
+                partOptions.counters = options.counters ? &part.counters : nullptr;
+                partOptions.encoding = options.encoding ? &part.encoding : nullptr;
+                partOptions.invalidation = options.invalidation ? &part.invalidation : nullptr;
+                part.endColour = ColouriseTerminalLines(batchStart + part.offset, part.length, *part.recording,
+                                                        partOptions, part.startColour, partArena);
+            } catch (...) {
+                part.failed = true;
+            }
+        };
+        std::vector<std::thread> workers;
+        try {
+            for (size_t i = 1; i < parts.size(); i++) {
+                workers.emplace_back(stylePart, std::ref(parts[i]));
+            }
+        } catch (const std::system_error&) {
+            // Parts without a thread are styled on this thread
+        }
+        stylePart(parts[0]);
+        for (size_t i = workers.size() + 1; i < parts.size(); i++) {
+            stylePart(parts[i]);
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        // Apply the parts in order
+        for (const Part& part : parts) {
+            LEXILLA_COUNT(options.counters, classificationHits, part.counters.classificationHits);
+            LEXILLA_COUNT(options.counters, classificationMisses, part.counters.classificationMisses);
+            const Sci_PositionU partStart = batchStart + part.offset;
+            if (part.failed) {
+                colour = ColouriseTerminalLines(partStart, part.length, styler, options, colour, arena, false);
+                continue;
+            }
+            if (options.encoding) {
+                options.encoding->Add(part.encoding.ascii, part.encoding.valid, part.encoding.end);
+            }
+            if (options.invalidation) {
+                options.invalidation->Merge(part.invalidation);
+            }
+            Sci_PositionU from = partStart;
+            bool agrees = colour == part.startColour;
+            if (!agrees) {
+                // Restyle lines until the colour agrees with the one recorded
+                const std::vector<RecordingAccessor::LineState>& lineStates = part.recording->LineStates();
+                for (size_t line = 0; (line < lineStates.size()) && !agrees; line++) {
+                    const size_t lineStart = lineStates[line].lineStart - batchStart;
+                    const size_t lineEnd = (line + 1 < lineStates.size()) ? lineStates[line + 1].lineStart - batchStart
+                                                                          : part.offset + part.length;
+                    const char saved = text[lineEnd];
+                    text[lineEnd] = '\0';
+                    ColouriseTerminalLine(std::string_view(text.data() + lineStart, lineEnd - lineStart),
+                                          batchStart + lineEnd - 1, styler, options, colour);
+                    text[lineEnd] = saved;
+                    styler.SetLineState(styler.GetLine(batchStart + lineStart), colour);
+                    from = batchStart + lineEnd;
+                    agrees = colour == lineStates[line].state;
+                }
+            }
+            part.recording->Replay(from, styler);
+            if (agrees) {
+                colour = part.endColour;
+            }
+        }
+        batchStart += batchLength;
+    }
+    return colour;
+}
+
+/// Number of lexer.terminal.patterns.<n> properties read, from 0
+constexpr int patternProperties = 16;
+
+/// Joins the values of lexer.terminal.patterns.0 to lexer.terminal.patterns.15 that are set, one per line,
+/// getValue returning the value of a property's name
+template <typename GetValue>
+std::string ReadPatternDefinitions(GetValue getValue)
+{
+    std::string definitions;
+    for (int n = 0; n < patternProperties; n++) {
+        const std::string value = getValue("lexer.terminal.patterns." + std::to_string(n));
+        if (!value.empty()) {
+            definitions += value;
+            definitions += '\n';
+        }
+    }
+    return definitions;
+}
+
+/// The patterns compiled from definitions, nullptr when there are none. The compiled form is kept by each
+/// thread and only rebuilt when the definitions change. Definitions that are not valid are ignored
+const LinePatterns* CompiledPatterns(const std::string& definitions)
+{
+    if (definitions.empty()) {
+        return nullptr;
+    }
+    thread_local std::string compiledFrom;
+    thread_local LinePatterns compiled;
+    if (definitions != compiledFrom) {
+        compiled.Clear();
+        std::string_view rest(definitions);
+        while (!rest.empty()) {
+            const size_t end = rest.find('\n');
+            compiled.Add(rest.substr(0, end));
+            rest.remove_prefix(std::min(end + 1, rest.length()));
+        }
+        compiledFrom = definitions;
+    }
+    return compiled.Empty() ? nullptr : &compiled;
+}
+
+/// The options that style text as properties set, adding what checking it as UTF-8 finds to encoding when
+/// properties.utf8Validate is set
+TerminalOptions OptionsOf(const TerminalProperties& properties, EncodingSummary& encoding)
+{
+    TerminalOptions options;
+    options.valueSeparate = properties.valueSeparate;
+    options.escapeSequences = properties.escapeSequences;
+    options.hyperlinkIndicator = properties.hyperlinkIndicator;
+    options.diagnostics = properties.diagnostics;
+    options.sgrAttributes = properties.sgrAttributes;
+    options.overwritten = properties.overwritten;
+    options.patterns = CompiledPatterns(properties.patterns);
+    options.encoding = properties.utf8Validate ? &encoding : nullptr;
+    options.utf8Indicator = properties.utf8Indicator;
+    return options;
+}
+
+const PropertyKey keyValueSeparate("lexer.terminal.value.separate");
+const PropertyKey keyEscapeSequences("lexer.terminal.escape.sequences");
+const PropertyKey keyHyperlinkIndicator("lexer.terminal.hyperlink.indicator");
+const PropertyKey keySgrAttributes("lexer.terminal.sgr.attributes");
+const PropertyKey keyOverwrittenLines("lexer.terminal.overwritten.lines");
+const PropertyKey keyThreads("lexer.terminal.threads");
+const PropertyKey keyUTF8Validate("lexer.terminal.utf8.validate");
+const PropertyKey keyUTF8Indicator("lexer.terminal.utf8.indicator");
+
+/// Reads the properties through readInt, returning the number set for a PropertyKey or the default given, and
+/// readString, returning the value of a property's name. Whether diagnostics are collected is left to the caller
+template <typename ReadInt, typename ReadString>
+TerminalProperties ReadTerminalProperties(ReadInt readInt, ReadString readString)
+{
+    TerminalProperties properties;
+
+    // property lexer.errorlist.value.separate
+    //	For lines in the output pane that are matches from Find in Files or
+    // GCC-style 	diagnostics, style the path and line number separately from the
+    // rest of the 	line with style 21 used for the rest of the line. 	This allows
+    // matched text to be more easily distinguished from its location.
+    properties.valueSeparate = readInt(keyValueSeparate, 0) != 0;
+
+    // property lexer.errorlist.escape.sequences
+    //	Set to 1 to interpret escape sequences.
+    properties.escapeSequences = readInt(keyEscapeSequences, 0) != 0;
+
+    // property lexer.terminal.hyperlink.indicator
+    //	Indicator used to mark the text of OSC 8 hyperlinks when escape sequences are interpreted.
+    // -1, the default, turns this off.
+    properties.hyperlinkIndicator = properties.escapeSequences ? readInt(keyHyperlinkIndicator, -1) : -1;
+
+    // property lexer.terminal.sgr.attributes
+    //	Set to 1 to style text by all the attributes set by SGR escape sequences: foreground and background
+    // colour, bold, italic, underline and inverse. Each combination other than a foreground colour alone is
+    // given a style from wxSTC_TERMINAL_SGR_FIRST to wxSTC_TERMINAL_SGR_LAST as it is first seen. 0, the
+    // default, styles by the foreground colour only.
+    properties.sgrAttributes = properties.escapeSequences && (readInt(keySgrAttributes, 0) != 0);
+
+    // property lexer.terminal.overwritten.lines
+    //	Set to 1 to style each line ended by a carriage return alone, which a terminal overwrites with the next
+    // line as progress bars do, as wxSTC_TERMINAL_OVERWRITTEN and report it to AddOverwritten so it can be
+    // dropped or collapsed. 0, the default, styles these lines like any other.
+    properties.overwritten = readInt(keyOverwrittenLines, 0) != 0;
+
+    // property lexer.terminal.threads
+    //	Number of threads used to style large ranges of text.
+    // 0, the default, uses one per processor and 1 styles on the calling thread only.
+    properties.threads = readInt(keyThreads, 0);
+
+    // property lexer.terminal.patterns.<n>
+    //	Line formats of tools not recognised by default, for n from 0 to 15, each as "<style> <pattern>". The
+    // pattern matches from the start of a line with %f for a file path, %l for a line number, %c for a column,
+    // %* for any text, %m for the message that ends it and %% for a '%'. Lines matched are given the style
+    // and, when diagnostics are collected, their location is reported. Patterns are tried in order before
+    // the built-in formats. For example "2 [lint] %f|%l|%c %m".
+    properties.patterns = ReadPatternDefinitions(readString);
+
+    // property lexer.terminal.utf8.validate
+    //	Set to 1 to check the text as UTF-8 as it is styled and report, through EncodingChecked, whether each
+    // range styled is pure ASCII and whether it is valid, so hosts need not check it again. 0, the default,
+    // does not check it.
+    properties.utf8Validate = readInt(keyUTF8Validate, 0) != 0;
+
+    // property lexer.terminal.utf8.indicator
+    //	Indicator used to mark bytes that are not valid UTF-8 when lexer.terminal.utf8.validate is set.
+    // -1, the default, turns this off.
+    properties.utf8Indicator = properties.utf8Validate ? readInt(keyUTF8Indicator, -1) : -1;
+    return properties;
+}
+
+/// Reads the properties from a host, an AccessorInterface or AccessorInterfaceV2
+template <typename Host>
+TerminalProperties ReadTerminalProperties(const Host& styler)
+{
+    TerminalProperties properties = ReadTerminalProperties(
+        [&styler](const PropertyKey& key, int defaultValue) { return styler.GetPropertyInt(key.Key(), defaultValue); },
+        [&styler](const std::string& name) { return styler.GetPropertyString(name); });
+    properties.diagnostics = styler.CollectsDiagnostics();
+    return properties;
+}
+
+/// Reads the same properties from the lexer's own property set, where each name is only looked up once
+TerminalProperties ReadTerminalProperties(const Accessor& styler)
+{
+    TerminalProperties properties = ReadTerminalProperties(
+        [&styler](const PropertyKey& key, int defaultValue) { return styler.GetPropertyInt(key, defaultValue); },
+        [&styler](const std::string& name) { return std::string(styler.pprops->Get(name)); });
+    // Collected when the lexer property lexer.locations is set
+    properties.diagnostics = styler.Locations() != nullptr;
+    return properties;
+}
+
+/// Styles the range as properties set, counting the work done in counters and marking the lines whose styles
+/// depend on lexer.terminal.value.separate in invalidation when they are not nullptr
+template <typename Styler>
+void ColouriseTerminalDocInternal(Sci_PositionU startPos, Sci_Position length, Styler& styler,
+                                  const TerminalProperties& properties, LexArena& arena,
+                                  LexCounters* counters = nullptr, LexInvalidation* invalidation = nullptr)
+{
+    styler.StartAt(startPos);
+    styler.StartSegment(startPos);
+
+    EncodingSummary encoding;
+    TerminalOptions options = OptionsOf(properties, encoding);
+    options.counters = counters;
+    options.invalidation = invalidation;
+    if (options.hyperlinkIndicator >= 0) {
+        styler.IndicatorFill(startPos, startPos + length, options.hyperlinkIndicator, 0);
+    }
+    if (options.utf8Indicator >= 0) {
+        styler.IndicatorFill(startPos, startPos + length, options.utf8Indicator, 0);
+    }
+
+    size_t threads = std::max(properties.threads, 0);
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+
+    // The line state of each line holds the escape sequence colour active at its end
+    int colour = 0;
+    if (options.escapeSequences && (startPos > 0)) {
+        const size_t line = styler.GetLine(startPos);
+        colour = (line > 0) ? styler.GetLineState(line - 1) : 0;
+    }
+
+    constexpr size_t partSize = 0x100000;
+    if ((threads > 1) && (static_cast<size_t>(length) >= 2 * partSize)) {
+        ColouriseTerminalParallel(startPos, length, styler, options, colour, threads, partSize, arena);
+    } else {
+        ColouriseTerminalLines(startPos, length, styler, options, colour, arena);
+    }
+    if (options.encoding && (encoding.end > startPos)) {
+        styler.EncodingChecked(startPos, encoding.end, encoding.ascii, encoding.valid);
+    }
+}
+
+void ColouriseTerminalDoc(Sci_PositionU startPos, Sci_Position length, int, WordList*[], Accessor& styler)
+{
+    const TerminalProperties properties = ReadTerminalProperties(styler);
+    if (properties.escapeSequences) {
+        // The line of each line start is needed to store its escape sequence colour
+        styler.CacheLines(startPos, startPos + length);
+    }
+    NativeAccessor accessor(styler);
+    // LexerSimple lends the Accessor an arena that it resets after each Lex
+    ColouriseTerminalDocInternal(startPos, length, accessor, properties, styler.Arena(), styler.Counters(),
+                                 styler.Invalidation());
+}
+
+/// The kinds of line that folding groups
+enum class FoldKind { other, command, includedFrom, diagnostic, excerpt };
+
+/// Finds what a styled line is from the style of its first character that is not part of an escape sequence
+FoldKind FoldKindOfLine(Accessor& styler, Sci_Position lineStart, Sci_Position lineEnd)
+{
+    for (Sci_Position position = lineStart; position < lineEnd; position++) {
+        switch (styler.StyleAt(position)) {
+        case wxSTC_TERMINAL_ESCSEQ:
+        case wxSTC_TERMINAL_ESCSEQ_UNKNOWN:
+            break;
+        case wxSTC_TERMINAL_CMD:
+            return FoldKind::command;
+        case wxSTC_TERMINAL_GCC_INCLUDED_FROM:
+            return FoldKind::includedFrom;
+        case wxSTC_TERMINAL_GCC:
+        case wxSTC_TERMINAL_GCC_WARNING:
+        case wxSTC_TERMINAL_GCC_NOTE:
+            return FoldKind::diagnostic;
+        case wxSTC_TERMINAL_GCC_EXCERPT:
+            return FoldKind::excerpt;
+        default:
+            return FoldKind::other;
+        }
+    }
+    return FoldKind::other;
+}
+
+// Folding state after each line, kept in the upper 16 bits of its level which Scintilla leaves to lexers, so
+// folding can start again at any line from the level of the line before
+constexpr int foldInCommand = 1 << 16;       // After a command line
+constexpr int foldInDiagnostic = 1 << 17;    // In a diagnostic with its include path and excerpt
+constexpr int foldDiagnosticSeen = 1 << 18;  // The diagnostic's message line has been seen
+constexpr int foldStateMask = foldInCommand | foldInDiagnostic | foldDiagnosticSeen;
+
+/// Folds output under each command line and each GCC diagnostic's "In file included from" lines, message and
+/// code excerpt under its first line. Only the lines of the range are folded with the line before it updated
+/// to show whether it is now a fold header, so folding output as it is appended only visits the new lines.
+void FoldTerminalDoc(Sci_PositionU startPos, Sci_Position length, int, WordList*[], Accessor& styler)
+{
+    if (length <= 0) {
+        return;
+    }
+    const Sci_Position lineFirst = styler.GetLine(startPos);
+    const Sci_Position lineLast = styler.GetLine(startPos + length - 1);
+    const Sci_Position lineDocumentLast = styler.GetLine(styler.Length());
+
+    auto setLevel = [&styler](Sci_Position line, int level, int levelNext) {
+        if ((levelNext & SC_FOLDLEVELNUMBERMASK) > (level & SC_FOLDLEVELNUMBERMASK)) {
+            level |= SC_FOLDLEVELHEADERFLAG;
+        }
+        if (styler.LevelAt(line) != level) {
+            styler.SetLevel(line, level);
+        }
+    };
+
+    int state = 0;
+    int levelPrevious = 0;
+    if (lineFirst > 0) {
+        levelPrevious = styler.LevelAt(lineFirst - 1) & ~SC_FOLDLEVELHEADERFLAG;
+        state = levelPrevious & foldStateMask;
+    }
+    for (Sci_Position line = lineFirst; line <= lineLast; line++) {
+        bool command = false;
+        bool child = false;
+        switch (FoldKindOfLine(styler, styler.LineStart(line), styler.LineEnd(line))) {
+        case FoldKind::command:
+            command = true;
+            state = foldInCommand;
+            break;
+        case FoldKind::includedFrom:
+            // Part of the include path before a diagnostic or else the start of a new one
+            if ((state & foldInDiagnostic) && !(state & foldDiagnosticSeen)) {
+                child = true;
+            } else {
+                state = (state & foldInCommand) | foldInDiagnostic;
+            }
+            break;
+        case FoldKind::diagnostic:
+            if ((state & foldInDiagnostic) && !(state & foldDiagnosticSeen)) {
+                child = true;
+                state |= foldDiagnosticSeen;
+            } else {
+                state = (state & foldInCommand) | foldInDiagnostic | foldDiagnosticSeen;
+            }
+            break;
+        case FoldKind::excerpt:
+            if ((state & foldInDiagnostic) && (state & foldDiagnosticSeen)) {
+                child = true;
+            } else {
+                state &= foldInCommand;
+            }
+            break;
+        default:
+            state &= foldInCommand;
+            break;
+        }
+        int level = SC_FOLDLEVELBASE;
+        if (command) {
+            level |= state;
+        } else {
+            level = (level + ((state & foldInCommand) ? 1 : 0) + (child ? 1 : 0)) | state;
+        }
+        if (line > 0) {
+            setLevel(line - 1, levelPrevious, level);
+        }
+        levelPrevious = level;
+    }
+    // The line after the range may already have been folded
+    const int levelNext = (lineLast < lineDocumentLast) ? styler.LevelAt(lineLast + 1) : SC_FOLDLEVELBASE;
+    setLevel(lineLast, levelPrevious, levelNext);
+}
+
+/// The arena used by the Accessor API on each thread, reset at the end of each call
+LexArena& ThreadArena()
+{
+    thread_local LexArena arena;
+    return arena;
+}
+
+/// Styler for TerminalTokenizer: appends the styles of the line being styled to runs and forwards everything
+/// else that carries no text to the host, when there is one
+class TokenizerAccessor final : public AccessorInterface
+{
+public:
+    TokenizerAccessor(std::string_view line, size_t lineStart, size_t lineNumber, AccessorInterfaceV2* host,
+                      std::vector<StyleRun>& runs)
+        : m_line(line)
+        , m_lineStart(lineStart)
+        , m_lineNumber(lineNumber)
+        , m_host(host)
+        , m_runs(runs)
+        , m_segmentStart(lineStart)
+    {
+    }
+
+    const char operator[](size_t index) const override { return m_line[index - m_lineStart]; }
+    char SafeGetCharAt(size_t index, char chDefault = ' ') const override
+    {
+        if ((index >= m_lineStart) && (index - m_lineStart < m_line.length())) {
+            return m_line[index - m_lineStart];
+        }
+        return chDefault;
+    }
+    void GetCharRange(char* buffer, size_t pos, size_t length) const override
+    {
+        memcpy(buffer, m_line.data() + pos - m_lineStart, length);
+    }
+    void ColourTo(size_t pos, int style) override
+    {
+        if (pos < m_segmentStart) {
+            return;
+        }
+        const size_t length = pos + 1 - m_segmentStart;
+        if (!m_runs.empty() && (m_runs.back().style == style)) {
+            m_runs.back().length += length;
+        } else {
+            m_runs.push_back({ length, style });
+        }
+        m_segmentStart = pos + 1;
+    }
+    void StartAt(size_t start) override { m_segmentStart = start; }
+    void StartSegment(size_t pos) override { m_segmentStart = pos; }
+    int GetPropertyInt(const std::string& /*name*/, int defaultVal = 0) const override { return defaultVal; }
+    size_t GetLine(size_t /*pos*/) const override { return m_lineNumber; }
+    void IndicatorFill(size_t start, size_t end, int indicator, int value) override
+    {
+        if (m_host) {
+            m_host->IndicatorFill(start, end, indicator, value);
+        }
+    }
+    void AddDiagnostic(const DiagnosticLocation& location) override
+    {
+        if (m_host) {
+            m_host->AddDiagnostic(location);
+        }
+    }
+    int StyleForAttributes(int key) override { return m_host ? m_host->StyleForAttributes(key) : -1; }
+    void AddOverwritten(size_t start, size_t end) override
+    {
+        if (m_host) {
+            m_host->AddOverwritten(start, end);
+        }
+    }
+
+private:
+    std::string_view m_line;
+    size_t m_lineStart;
+    size_t m_lineNumber;
+    AccessorInterfaceV2* m_host;
+    std::vector<StyleRun>& m_runs;
+    size_t m_segmentStart;
+};
+
+const char* const emptyWordListDesc[] = { nullptr };
+
+/// Changing whether values are separate only restyles the lines with a value and the number of threads does not
+/// change any style
+const PropertyScope terminalScopes[] = {
+    { "lexer.terminal.value.separate", -1, Restyle::dependent, dependencyValueSeparate },
+    { "lexer.terminal.threads", -1, Restyle::none, 0 },
+    { nullptr, -1, Restyle::all, 0 },
+};
+
+} // namespace
+
+// Our API for exporting the lexer
+void* CreateExtraLexerTerminal()
+{
+    static LexerModule module(wxSTC_LEX_TERMINAL, ColouriseTerminalDoc, "terminal", FoldTerminalDoc, emptyWordListDesc,
+                              nullptr, 0, terminalScopes);
+    // Reuses a lexer freed earlier, so panes created for each build or debug session do not
+    // allocate a new one each time
+    return (void*)static_cast<LexerSimple*>(module.Create());
+}
+
+void FreeExtraLexer(void* p)
+{
+    if (p) {
+        reinterpret_cast<LexerSimple*>(p)->Release();
     }
 }
 
 /// Accessor API
 void LexerTerminalStyle(size_t startPos, size_t length, AccessorInterface& styler)
 {
-    ColouriseTerminalDocInternal(startPos, length, 0, nullptr, styler);
+    LEXILLA_TRACE_SCOPE("Lex", "terminal", startPos, startPos + length);
+    LexArena& arena = ThreadArena();
+    ColouriseTerminalDocInternal(startPos, length, styler, ReadTerminalProperties(styler), arena);
+    arena.Reset();
+}
+
+void LexerTerminalStyle(size_t startPos, size_t length, AccessorInterfaceV2& styler)
+{
+    LEXILLA_TRACE_SCOPE("Lex", "terminal", startPos, startPos + length);
+    BatchedAccessor accessor(styler);
+    LexArena& arena = ThreadArena();
+    ColouriseTerminalDocInternal(startPos, length, accessor, ReadTerminalProperties(accessor), arena);
+    arena.Reset();
+}
+
+StrippedText LexerTerminalStrip(const char* text, size_t length, char* strippedText, StrippedRun* runs,
+                                size_t runCapacity, AccessorInterfaceV2* host)
+{
+    LEXILLA_TRACE_SCOPE("Strip", "terminal", 0, length);
+    StrippingAccessor stripper(text, length, strippedText, runs, runCapacity, host);
+    {
+        // Flushes the last runs to the stripper when it goes out of scope
+        BatchedAccessor accessor(stripper);
+        LexArena& arena = ThreadArena();
+        ColouriseTerminalDocInternal(0, length, accessor, ReadTerminalProperties(accessor), arena);
+        arena.Reset();
+    }
+    return stripper.Result();
+}
+
+/// How far a long partial line has been styled, kept between calls to StyleTo
+struct TerminalStyler::LongLine {
+    LongLineState state;
+    // What checking the line as UTF-8 has found so far
+    EncodingSummary encoding;
+};
+
+TerminalStyler::TerminalStyler() = default;
+TerminalStyler::~TerminalStyler() = default;
+TerminalStyler::TerminalStyler(TerminalStyler&&) noexcept = default;
+TerminalStyler& TerminalStyler::operator=(TerminalStyler&&) noexcept = default;
+
+void TerminalStyler::Reset(size_t pos)
+{
+    m_lineStart = pos;
+    m_readEnd = pos;
+    m_partialLine.clear();
+    m_propertiesRead = false;
+    m_inLongLine = false;
+}
+
+void TerminalStyler::StyleTo(size_t endPos, AccessorInterfaceV2& styler)
+{
+    BatchedAccessor accessor(styler);
+    StyleTo(endPos, accessor);
+}
+
+void TerminalStyler::StyleTo(size_t endPos, AccessorInterface& styler)
+{
+    if (endPos < m_readEnd) {
+        // The document shrank: the caller should have called Reset()
+        Reset(endPos < m_lineStart ? endPos : m_lineStart);
+    }
+    if (endPos == m_readEnd) {
+        return;
+    }
+    LEXILLA_TRACE_SCOPE("Append", "terminal", m_readEnd, endPos);
+
+    if (!m_propertiesRead) {
+        m_properties = ReadTerminalProperties(styler);
+        m_lineStartColour = 0;
+        if (m_properties.escapeSequences && (m_lineStart > 0)) {
+            const size_t line = styler.GetLine(m_lineStart);
+            m_lineStartColour = (line > 0) ? styler.GetLineState(line - 1) : 0;
+        }
+        m_propertiesRead = true;
+    }
+    if (!m_longLine) {
+        m_longLine = std::make_unique<LongLine>();
+    }
+
+    // A long partial line is styled on from where the previous call stopped
+    const size_t restyleFrom = m_inLongLine ? m_longLine->state.position : m_lineStart;
+    styler.StartAt(restyleFrom);
+    styler.StartSegment(restyleFrom);
+    if (m_properties.hyperlinkIndicator >= 0) {
+        styler.IndicatorFill(restyleFrom, endPos, m_properties.hyperlinkIndicator, 0);
+    }
+    if (m_properties.utf8Indicator >= 0) {
+        styler.IndicatorFill(restyleFrom, endPos, m_properties.utf8Indicator, 0);
+    }
+    const size_t styledFrom = m_lineStart;
+    EncodingSummary encoding;
+
+    TerminalOptions options = OptionsOf(m_properties, encoding);
+    options.diagnostics = styler.CollectsDiagnostics();
+    // The pieces of a long line are checked over several calls so what is found is kept with the line
+    TerminalOptions longOptions = options;
+    if (options.encoding) {
+        longOptions.encoding = &m_longLine->encoding;
+    }
+    LongLineColouriser<AccessorInterface> longLine(styler, longOptions, m_lineStartColour, m_longLine->state);
+
+    // Styles the length bytes at text, which follow those held of a long line
+    auto continueLongLine = [&](const char* text, size_t length, bool more) {
+        if (m_partialLine.empty()) {
+            const size_t styled = longLine.Piece(std::string_view(text, length), more);
+            m_partialLine.assign(text + styled, length - styled);
+        } else {
+            m_partialLine.append(text, length);
+            m_partialLine.erase(0, longLine.Piece(m_partialLine, more));
+        }
+    };
+    // Adds the length bytes at text to the partial line, which continues after them
+    auto continueLine = [&](const char* text, size_t length) {
+        if (m_inLongLine) {
+            continueLongLine(text, length, true);
+            return;
+        }
+        m_partialLine.append(text, length);
+        if (m_partialLine.length() > longLineLimit) {
+            m_inLongLine = true;
+            m_longLine->encoding = EncodingSummary();
+            longLine.Start(m_partialLine, m_lineStart);
+            m_partialLine.erase(0, longLine.Piece(m_partialLine, true));
+        }
+    };
+    // Ends the partial line with the length bytes at text, the last of which is at position last
+    auto completeLine = [&](char* text, size_t length, size_t last) {
+        if (m_inLongLine) {
+            continueLongLine(text, length, false);
+            encoding.Add(m_longLine->encoding.ascii, m_longLine->encoding.valid, last + 1);
+            m_inLongLine = false;
+        } else if (m_partialLine.empty()) {
+            // Coloured in place, with a NUL after the line as for the lines of a document
+            const char after = text[length];
+            text[length] = '\0';
+            ColouriseTerminalLine(std::string_view(text, length), last, styler, options, m_lineStartColour);
+            text[length] = after;
+        } else {
+            m_partialLine.append(text, length);
+            ColouriseTerminalLine(m_partialLine, last, styler, options, m_lineStartColour);
+        }
+        if (m_properties.escapeSequences) {
+            styler.SetLineState(styler.GetLine(m_lineStart), m_lineStartColour);
+        }
+        m_partialLine.clear();
+        m_lineStart = last + 1;
+    };
+
+    // Only the newly appended bytes are read, a chunk at a time with room for a NUL after the last line
+    const size_t chunkSize = std::min<size_t>(endPos - m_readEnd, longLineLimit);
+    m_chunk.resize(chunkSize + 1);
+    char* const chunk = &m_chunk[0];
+    if ((m_readEnd > m_lineStart) && (styler.SafeGetCharAt(m_readEnd - 1) == '\r') &&
+        (styler.SafeGetCharAt(m_readEnd) != '\n')) {
+        // The '\r' that ended the previous call was a line end by itself
+        completeLine(chunk, 0, m_readEnd - 1);
+    }
+    for (size_t chunkStart = m_readEnd; chunkStart < endPos; chunkStart += chunkSize) {
+        const size_t chunkLength = std::min(chunkSize, endPos - chunkStart);
+        styler.GetCharRange(chunk, chunkStart, chunkLength);
+        chunk[chunkLength] = '\0';
+        size_t offset = 0;
+        while (offset < chunkLength) {
+            size_t last = FindLineEnd(chunk, offset, chunkLength);
+            if ((last == chunkLength) && (chunk[chunkLength - 1] == '\r') && (chunkStart + chunkLength < endPos) &&
+                (styler.SafeGetCharAt(chunkStart + chunkLength) != '\n')) {
+                // The '\r' ending the chunk is not the first half of "\r\n"
+                last = chunkLength - 1;
+            }
+            if (last == chunkLength) {
+                // A '\r' as the last byte received may be the first half of "\r\n" so wait for the next byte
+                continueLine(chunk + offset, chunkLength - offset);
+                break;
+            }
+            completeLine(chunk + offset, last + 1 - offset, chunkStart + last);
+            offset = last + 1;
+        }
+    }
+    m_readEnd = endPos;
+    if (options.encoding && (m_lineStart > styledFrom)) {
+        styler.EncodingChecked(styledFrom, m_lineStart, encoding.ascii, encoding.valid);
+    }
+
+    if (!m_inLongLine && !m_partialLine.empty()) {
+        // Style the partial line now so it displays correctly, it is restyled once it is complete so its
+        // diagnostic and encoding are only reported then. A '\r' it ends with may yet be followed by '\n' so it
+        // is not overwritten. Only lines up to longLineLimit are restyled like this, a longer one is styled a
+        // piece at a time as it arrives
+        options.diagnostics = false;
+        options.overwritten = false;
+        options.encoding = nullptr;
+        int colour = m_lineStartColour;
+        ColouriseTerminalLine(m_partialLine, endPos - 1, styler, options, colour);
+    }
+}
+
+size_t RunLengthStyles::Next(Cursor& cursor, int& style) const
+{
+    size_t length = 0;
+    for (int shift = 0;; shift += 7) {
+        const unsigned char byte = m_runs[cursor.offset++];
+        length |= static_cast<size_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            break;
+        }
+    }
+    style = m_runs[cursor.offset++];
+    cursor.index++;
+    cursor.start += length;
+    return length;
+}
+
+RunLengthStyles::Cursor RunLengthStyles::Find(size_t pos) const
+{
+    // Reads in order continue from the run found last while pos is in the same block
+    Cursor cursor = m_hint;
+    const size_t nextBlock = cursor.index / runsPerBlock + 1;
+    const size_t blockEnd = (nextBlock < m_blocks.size()) ? m_blocks[nextBlock].start : m_length;
+    if ((cursor.index >= m_count) || (pos < cursor.start) || (pos >= blockEnd)) {
+        // The last block starting at or before pos holds it
+        cursor = *(std::upper_bound(m_blocks.begin(), m_blocks.end(), pos,
+                                    [](size_t position, const Cursor& block) { return position < block.start; }) -
+                   1);
+    }
+    for (;;) {
+        Cursor next = cursor;
+        int style = 0;
+        Next(next, style);
+        if (pos < next.start) {
+            break;
+        }
+        cursor = next;
+    }
+    m_hint = cursor;
+    return cursor;
+}
+
+size_t RunLengthStyles::RunIndex(size_t pos) const
+{
+    if (pos >= m_length) {
+        return m_count;
+    }
+    if (m_flat) {
+        size_t index = 0;
+        for (size_t i = 1; i <= pos; i++) {
+            index += (m_bytes[i] != m_bytes[i - 1]) ? 1 : 0;
+        }
+        return index;
+    }
+    return Find(pos).index;
+}
+
+int RunLengthStyles::StyleAt(size_t pos) const
+{
+    if (pos >= m_length) {
+        return 0;
+    }
+    if (m_flat) {
+        return m_bytes[pos];
+    }
+    Cursor cursor = Find(pos);
+    int style = 0;
+    Next(cursor, style);
+    return style;
+}
+
+RunLengthStyles::Run RunLengthStyles::At(size_t index) const
+{
+    if (m_flat) {
+        size_t end = 0;
+        for (size_t run = 0; run <= index; run++) {
+            const unsigned char style = m_bytes[end];
+            while ((end < m_length) && (m_bytes[end] == style)) {
+                end++;
+            }
+        }
+        return { end, m_bytes[end - 1] };
+    }
+    Cursor cursor = m_blocks[index / runsPerBlock];
+    int style = 0;
+    while (cursor.index <= index) {
+        Next(cursor, style);
+    }
+    return { cursor.start, style };
+}
+
+void RunLengthStyles::Truncate(size_t pos)
+{
+    if (pos >= m_length) {
+        return;
+    }
+    if (pos == 0) {
+        Clear();
+        return;
+    }
+    if (m_flat) {
+        m_count = RunIndex(pos - 1) + 1;
+        m_bytes.resize(pos);
+        m_length = pos;
+        return;
+    }
+    const Cursor cursor = Find(pos);
+    Cursor next = cursor;
+    int style = 0;
+    Next(next, style);
+    m_runs.resize(cursor.offset);
+    m_blocks.resize((cursor.index + runsPerBlock - 1) / runsPerBlock);
+    m_count = cursor.index;
+    m_length = cursor.start;
+    m_hint = Cursor();
+    if (m_count > 0) {
+        // Find the run that is now last so a run of its style appended merges with it
+        m_last = m_blocks[(m_count - 1) / runsPerBlock];
+        while (m_last.index < m_count - 1) {
+            Next(m_last, m_lastStyle);
+        }
+        Cursor last = m_last;
+        Next(last, m_lastStyle);
+    }
+    Append(pos, style);
+}
+
+void RunLengthStyles::Clear()
+{
+    m_count = 0;
+    m_length = 0;
+    m_flat = false;
+    m_runs.clear();
+    m_blocks.clear();
+    m_hint = Cursor();
+    m_bytes.clear();
+}
+
+size_t RunLengthStyles::MemoryUse() const
+{
+    return m_runs.capacity() + m_blocks.capacity() * sizeof(Cursor) + m_bytes.capacity();
+}
+
+void RunLengthStyles::MakeFlat()
+{
+    m_bytes.reserve(m_length);
+    Cursor cursor;
+    while (cursor.index < m_count) {
+        int style = 0;
+        const size_t length = Next(cursor, style);
+        m_bytes.insert(m_bytes.end(), length, static_cast<unsigned char>(style));
+    }
+    std::vector<unsigned char>().swap(m_runs);
+    std::vector<Cursor>().swap(m_blocks);
+    m_hint = Cursor();
+    m_flat = true;
+}
+
+void RunLengthStyles::Append(size_t end, int style)
+{
+    if (end <= m_length) {
+        return;
+    }
+    style &= 0xff;
+    if (m_flat) {
+        if ((m_length == 0) || (m_bytes.back() != style)) {
+            m_count++;
+        }
+        m_bytes.resize(end, static_cast<unsigned char>(style));
+        m_length = end;
+        return;
+    }
+    if ((m_count > 0) && (m_lastStyle == style)) {
+        // The last run grows so is written again, its length may take another byte
+        m_runs.resize(m_last.offset);
+    } else {
+        m_last = { m_count, m_length, m_runs.size() };
+        m_lastStyle = style;
+        if (m_count % runsPerBlock == 0) {
+            m_blocks.push_back(m_last);
+        }
+        m_count++;
+    }
+    size_t length = end - m_last.start;
+    while (length >= 0x80) {
+        m_runs.push_back(static_cast<unsigned char>(length | 0x80));
+        length >>= 7;
+    }
+    m_runs.push_back(static_cast<unsigned char>(length));
+    m_runs.push_back(static_cast<unsigned char>(style));
+    m_length = end;
+    if ((m_length >= flatMinimum) && (m_runs.size() + m_blocks.size() * sizeof(Cursor) > m_length)) {
+        MakeFlat();
+    }
+}
+
+void RunLengthStyles::SetStyleRuns(size_t start, const StyleRun* runs, size_t count)
+{
+    if (start < Length()) {
+        Truncate(start);
+    }
+    Append(start, 0);
+    for (size_t i = 0; i < count; i++) {
+        start += runs[i].length;
+        Append(start, runs[i].style);
+    }
+}
+
+RunLengthAccessor::RunLengthAccessor(const char* text, size_t length)
+    : m_text(text)
+    , m_length(length)
+{
+}
+
+void RunLengthAccessor::SetProperty(const std::string& name, const std::string& value) { m_properties[name] = value; }
+
+void RunLengthAccessor::GetRange(size_t start, size_t length, char* buffer) const
+{
+    memcpy(buffer, m_text + start, length);
+}
+
+void RunLengthAccessor::SetStyleRuns(size_t start, const StyleRun* runs, size_t count)
+{
+    m_styles.SetStyleRuns(start, runs, count);
+}
+
+int RunLengthAccessor::GetPropertyInt(const std::string& name, int defaultVal) const
+{
+    const auto it = m_properties.find(name);
+    return ((it == m_properties.end()) || it->second.empty()) ? defaultVal : atoi(it->second.c_str());
+}
+
+std::string RunLengthAccessor::GetPropertyString(const std::string& name) const
+{
+    const auto it = m_properties.find(name);
+    return (it == m_properties.end()) ? std::string() : it->second;
+}
+
+TerminalTokenizer::TerminalTokenizer(AccessorInterfaceV2* host)
+    : m_host(host)
+{
+    ReadProperties();
+}
+
+void TerminalTokenizer::ReadProperties()
+{
+    m_properties = m_host ? ReadTerminalProperties(*m_host) : TerminalProperties();
+}
+
+void TerminalTokenizer::Reset()
+{
+    m_styled = 0;
+    m_line = 0;
+    m_partialLine.clear();
+    m_colour = 0;
+    m_checkedASCII = true;
+    m_checkedValid = true;
+    ReadProperties();
+}
+
+void TerminalTokenizer::CompleteLine(std::vector<StyleRun>& runs)
+{
+    EncodingSummary encoding;
+    const TerminalOptions options = OptionsOf(m_properties, encoding);
+    TokenizerAccessor accessor(m_partialLine, m_styled, m_line, m_host, runs);
+    // Styled through the interface, as for other hosts, rather than instantiating the lexer again
+    ColouriseTerminalLine(m_partialLine, m_styled + m_partialLine.length() - 1,
+                          static_cast<AccessorInterface&>(accessor), options, m_colour);
+    m_checkedASCII = m_checkedASCII && encoding.ascii;
+    m_checkedValid = m_checkedValid && encoding.valid;
+    m_styled += m_partialLine.length();
+    m_line++;
+    m_partialLine.clear();
+}
+
+void TerminalTokenizer::Feed(const char* data, size_t length, std::vector<StyleRun>& runs)
+{
+    if (length == 0) {
+        return;
+    }
+    LEXILLA_TRACE_SCOPE("Feed", "terminal", m_styled + m_partialLine.length(),
+                        m_styled + m_partialLine.length() + length);
+    const size_t styledFrom = m_styled;
+    if (!m_partialLine.empty() && (m_partialLine.back() == '\r') && (data[0] != '\n')) {
+        // The '\r' that ended the previous call was a line end by itself
+        CompleteLine(runs);
+    }
+    size_t offset = 0;
+    while (offset < length) {
+        // A '\r' as the last byte fed may be the first half of "\r\n" so it waits for the next byte
+        const size_t last = FindLineEnd(data, offset, length);
+        if (last >= length) {
+            m_partialLine.append(data + offset, length - offset);
+            break;
+        }
+        m_partialLine.append(data + offset, last + 1 - offset);
+        CompleteLine(runs);
+        offset = last + 1;
+    }
+    ReportEncoding(styledFrom);
+}
+
+void TerminalTokenizer::Flush(std::vector<StyleRun>& runs)
+{
+    if (!m_partialLine.empty()) {
+        const size_t styledFrom = m_styled;
+        CompleteLine(runs);
+        ReportEncoding(styledFrom);
+    }
+}
+
+void TerminalTokenizer::ReportEncoding(size_t styledFrom)
+{
+    if (m_host && m_properties.utf8Validate && (m_styled > styledFrom)) {
+        m_host->EncodingChecked(styledFrom, m_styled, m_checkedASCII, m_checkedValid);
+    }
+    m_checkedASCII = true;
+    m_checkedValid = true;
 }
@@ -7,8 +7,12 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -16,18 +20,121 @@
 
 #include "PropSetSimple.h"
 #include "WordList.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
 #include "Accessor.h"
 
 using namespace Lexilla;
 
-Accessor::Accessor(Scintilla::IDocument *pAccess_, PropSetSimple *pprops_) : LexAccessor(pAccess_), pprops(pprops_) {
+namespace {
+
+long long SteadyNanoseconds() noexcept {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The clock is read after this many bytes rather than at every line
+constexpr Sci_Position timeCheckInterval = 0x10000;
+
+const PropertyKey keyBufferDirect("lexer.buffer.direct");
+const PropertyKey keyStylesCompare("lexer.styles.compare");
+
+}
+
+Accessor::Accessor(Scintilla::IDocument *pAccess_, PropSetSimple *pprops_) : LexAccessor(pAccess_),
+	budgetEnd(-1), deadline(0), nextTimeCheck(0), stoppedAt(-1), pprops(pprops_) {
+	// property lexer.buffer.direct
+	//	Set to 1 when the application allows lexers to read the document's buffer directly instead of copying
+	//	it. The text must not be modified while lexing or folding.
+	if (pprops && pprops->GetInt(keyBufferDirect)) {
+		UseDocumentBuffer();
+	}
+	// property lexer.styles.compare
+	//	Set to 1 to only write styles that differ from those already in the document.
+	if (pprops && pprops->GetInt(keyStylesCompare)) {
+		SetCompareStyles(true);
+	}
+}
+
+void Accessor::SetBudget(Sci_Position startPos, Sci_Position bytes, int milliseconds) {
+	budgetEnd = (bytes > 0) ? startPos + bytes : -1;
+	deadline = (milliseconds > 0) ? SteadyNanoseconds() + milliseconds * 1000000LL : 0;
+	nextTimeCheck = startPos + timeCheckInterval;
+	stoppedAt = -1;
+}
+
+bool Accessor::BudgetSpent(Sci_Position lineStart) {
+	if (stoppedAt >= 0) {
+		return true;
+	}
+	bool spent = (budgetEnd >= 0) && (lineStart >= budgetEnd);
+	if (!spent && deadline && (lineStart >= nextTimeCheck)) {
+		nextTimeCheck = lineStart + timeCheckInterval;
+		spent = SteadyNanoseconds() >= deadline;
+	}
+	if (spent) {
+		stoppedAt = lineStart;
+	}
+	return spent;
 }
 
 int Accessor::GetPropertyInt(std::string const& key, int defaultValue) const {
 	return pprops->GetInt(key, defaultValue);
 }
 
+int Accessor::GetPropertyInt(const PropertyKey &key, int defaultValue) const {
+	return pprops->GetInt(key, defaultValue);
+}
+
+void Accessor::IndentAmounts(Sci_Position lineFirst, Sci_Position lineLast, int *levels, int *flags,
+	PFNIsCommentLeader pfnIsCommentLeader) {
+	const Sci_Position end = Length();
+	std::string prefixPrev;
+	std::string prefix;
+	if (lineFirst > 0) {
+		for (Sci_Position pos = LineStart(lineFirst - 1); pos < end; pos++) {
+			const char ch = (*this)[pos];
+			if (ch != ' ' && ch != '\t')
+				break;
+			prefixPrev.push_back(ch);
+		}
+	}
+	Sci_Position lineStart = LineStart(lineFirst);
+	for (Sci_Position line = lineFirst; line < lineLast; line++) {
+		const Sci_Position lineNext = LineStart(line + 1);
+		int spaceFlags = 0;
+		int indent = 0;
+		Sci_Position pos = lineStart;
+		char ch = (*this)[pos];
+		prefix.clear();
+		while ((ch == ' ' || ch == '\t') && (pos < end)) {
+			const size_t column = prefix.length();
+			if ((column < prefixPrev.length()) && (prefixPrev[column] != ch))
+				spaceFlags |= wsInconsistent;
+			prefix.push_back(ch);
+			if (ch == ' ') {
+				spaceFlags |= wsSpace;
+				indent++;
+			} else {	// Tab
+				spaceFlags |= wsTab;
+				if (spaceFlags & wsSpace)
+					spaceFlags |= wsSpaceTab;
+				indent = (indent / 8 + 1) * 8;
+			}
+			ch = (*this)[++pos];
+		}
+		indent += SC_FOLDLEVELBASE;
+		if ((lineStart == end) || (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') ||
+				(pfnIsCommentLeader && (*pfnIsCommentLeader)(*this, pos, end-pos)))
+			indent |= SC_FOLDLEVELWHITEFLAG;
+		levels[line - lineFirst] = indent;
+		flags[line - lineFirst] = spaceFlags;
+		prefixPrev.swap(prefix);
+		lineStart = lineNext;
+	}
+}
+
 int Accessor::IndentAmount(Sci_Position line, int *flags, PFNIsCommentLeader pfnIsCommentLeader) {
 	const Sci_Position end = Length();
 	int spaceFlags = 0;
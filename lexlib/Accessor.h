@@ -15,15 +15,36 @@ enum { wsSpace=1, wsTab=2, wsSpaceTab=4, wsInconsistent=8 };
 class Accessor;
 class WordList;
 class PropSetSimple;
+class PropertyKey;
 
 typedef bool (*PFNIsCommentLeader)(Accessor &styler, Sci_Position pos, Sci_Position len);
 
 class Accessor : public LexAccessor {
+	// Budget for lexers that can stop at a line start, see BudgetSpent
+	Sci_Position budgetEnd;
+	long long deadline;		// steady_clock nanoseconds, 0 when there is no time limit
+	Sci_Position nextTimeCheck;
+	Sci_Position stoppedAt;
 public:
 	PropSetSimple *pprops;
 	Accessor(Scintilla::IDocument *pAccess_, PropSetSimple *pprops_);
 	int GetPropertyInt(std::string const& key, int defaultValue=0) const;
+	int GetPropertyInt(const PropertyKey &key, int defaultValue=0) const;
+	/** Limit lexing from startPos to about bytes bytes and milliseconds, 0 for no limit. */
+	void SetBudget(Sci_Position startPos, Sci_Position bytes, int milliseconds);
+	/** Lexers that can resume at any line start ask this before each line.
+	 * True when the budget is spent, in which case lexing should stop without styling the line
+	 * and StoppedAt returns lineStart. */
+	bool BudgetSpent(Sci_Position lineStart);
+	/** Where lexing stopped because the budget was spent, -1 when it was not. */
+	Sci_Position StoppedAt() const noexcept {
+		return stoppedAt;
+	}
 	int IndentAmount(Sci_Position line, int *flags, PFNIsCommentLeader pfnIsCommentLeader = nullptr);
+	// Indentation of lines [lineFirst, lineLast) into levels and flags as IndentAmount returns them,
+	// scanning each line once and comparing with the previous line's remembered whitespace.
+	void IndentAmounts(Sci_Position lineFirst, Sci_Position lineLast, int *levels, int *flags,
+		PFNIsCommentLeader pfnIsCommentLeader = nullptr);
 };
 
 }
@@ -0,0 +1,143 @@
+// Scintilla source code edit control
+/** @file BatchLexing.cxx
+ ** Style many documents at once on a set of worker threads.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <system_error>
+
+#include "ILexer.h"
+
+#include "BatchLexing.h"
+
+using namespace Lexilla;
+
+namespace {
+
+// The jobs for one document and the amount of text they style
+struct DocumentJobs {
+	std::vector<const LexJob *> jobs;
+	Sci_PositionU total = 0;
+};
+
+Sci_Position JobLength(const LexJob &job) {
+	if (job.length >= 0) {
+		return job.length;
+	}
+	return std::max<Sci_Position>(job.pAccess->Length() - static_cast<Sci_Position>(job.start), 0);
+}
+
+// Lexers created by one worker thread, found by name
+class WorkerLexers {
+	const LexerCreator &creator;
+	const BatchOptions &options;
+	// Few lexer names are expected so a vector is searched
+	std::vector<std::pair<std::string, Scintilla::ILexer5 *>> lexers;
+public:
+	WorkerLexers(const LexerCreator &creator_, const BatchOptions &options_) noexcept :
+		creator(creator_), options(options_) {
+	}
+	// Deleted so WorkerLexers objects can not be copied.
+	WorkerLexers(const WorkerLexers &) = delete;
+	WorkerLexers(WorkerLexers &&) = delete;
+	WorkerLexers &operator=(const WorkerLexers &) = delete;
+	WorkerLexers &operator=(WorkerLexers &&) = delete;
+	~WorkerLexers() {
+		for (const auto &[name, lexer] : lexers) {
+			if (lexer) {
+				lexer->Release();
+			}
+		}
+	}
+	// Names without a lexer are remembered as nullptr so they are only tried once
+	Scintilla::ILexer5 *Find(const std::string &name) {
+		for (const auto &[nameLexer, lexer] : lexers) {
+			if (nameLexer == name) {
+				return lexer;
+			}
+		}
+		Scintilla::ILexer5 *lexer = creator(name.c_str());
+		if (lexer) {
+			for (const auto &[key, value] : options.properties) {
+				lexer->PropertySet(key.c_str(), value.c_str());
+			}
+		}
+		lexers.emplace_back(name, lexer);
+		return lexer;
+	}
+};
+
+}
+
+size_t Lexilla::LexDocuments(const std::vector<LexJob> &jobs, const LexerCreator &creator, const BatchOptions &options) {
+	std::vector<DocumentJobs> documents;
+	std::unordered_map<Scintilla::IDocument *, size_t> documentIndex;
+	for (const LexJob &job : jobs) {
+		if (!job.pAccess) {
+			continue;
+		}
+		const auto [it, added] = documentIndex.emplace(job.pAccess, documents.size());
+		if (added) {
+			documents.emplace_back();
+		}
+		DocumentJobs &document = documents[it->second];
+		document.jobs.push_back(&job);
+		document.total += JobLength(job);
+	}
+	std::stable_sort(documents.begin(), documents.end(), [](const DocumentJobs &a, const DocumentJobs &b) noexcept {
+		return a.total > b.total;
+	});
+
+	std::atomic<size_t> next{0};
+	std::atomic<size_t> styled{0};
+	auto work = [&]() {
+		WorkerLexers lexers(creator, options);
+		for (size_t index = next++; index < documents.size(); index = next++) {
+			for (const LexJob *job : documents[index].jobs) {
+				Scintilla::ILexer5 *lexer = lexers.Find(job->lexerName);
+				if (!lexer) {
+					continue;
+				}
+				// A lexer that fails does not stop the other jobs
+				try {
+					const Sci_Position length = JobLength(*job);
+					lexer->Lex(job->start, length, job->initStyle, job->pAccess);
+					if (job->fold) {
+						lexer->Fold(job->start, length, job->initStyle, job->pAccess);
+					}
+					styled++;
+				} catch (...) {
+				}
+			}
+		}
+	};
+
+	size_t threads = options.threads;
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1U);
+	}
+	threads = std::min(threads, documents.size());
+	std::vector<std::thread> workers;
+	for (size_t thread = 1; thread < threads; thread++) {
+		try {
+			workers.emplace_back(work);
+		} catch (const std::system_error &) {
+			// Continue with the threads already started
+			break;
+		}
+	}
+	// The calling thread works too
+	work();
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	return styled;
+}
@@ -0,0 +1,49 @@
+// Scintilla source code edit control
+/** @file BatchLexing.h
+ ** Style many documents at once on a set of worker threads.
+ ** Meant for headless uses like previews of search results, indexing and diff views where many
+ ** documents are styled without being shown in an editor.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef BATCHLEXING_H
+#define BATCHLEXING_H
+
+namespace Lexilla {
+
+// Styling of [start, start + length) of a document with the lexer called lexerName.
+// A length of -1 styles to the end of the document.
+struct LexJob {
+	std::string lexerName;
+	Scintilla::IDocument *pAccess = nullptr;
+	Sci_PositionU start = 0;
+	Sci_Position length = -1;
+	int initStyle = 0;
+	// Also fold the range after styling it
+	bool fold = false;
+};
+
+// Creates a lexer from its name, returning nullptr when there is no such lexer.
+// Usually CreateLexer when statically linked or LexillaAccess's MakeLexer.
+// It is called from the worker threads so must be safe to call from several threads at once.
+using LexerCreator = std::function<Scintilla::ILexer5 *(const char *name)>;
+
+struct BatchOptions {
+	// Number of worker threads, where 0 uses one per processor
+	size_t threads = 0;
+	// Properties set on each lexer when it is created
+	std::vector<std::pair<std::string, std::string>> properties;
+};
+
+// Style each job and return the number of jobs styled. Jobs whose lexer could not be created
+// or whose lexer failed are skipped.
+// Jobs for the same document run in the order given on one thread so a document is only used
+// by one lexer at a time. Documents are handed to threads as they become free, largest first, so
+// a few large documents do not leave most threads waiting at the end.
+// Each thread keeps the lexers it creates for later jobs with the same lexer name and releases
+// them after the last job so only one lexer per name and thread is created.
+size_t LexDocuments(const std::vector<LexJob> &jobs, const LexerCreator &creator, const BatchOptions &options = {});
+
+}
+
+#endif
@@ -3,6 +3,7 @@
  ** Lexer infrastructure.
  ** Contains a list of LexerModules which can be searched to find a module appropriate for a
  ** particular language.
+ ** Searches by name or language are binary searches of indices kept sorted as modules are added.
  **/
 // Copyright 1998-2010 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
@@ -14,22 +15,46 @@ namespace Lexilla {
 
 class CatalogueModules {
 	std::vector<LexerModule *> lexerCatalogue;
+	// Indices into lexerCatalogue sorted by name and by language for binary search.
+	// Modules with the same key stay in the order they were added so the first is found.
+	std::vector<size_t> byName;
+	std::vector<size_t> byLanguage;
+
+	void Index(size_t index) {
+		const LexerModule *plm = lexerCatalogue[index];
+		if (plm->languageName) {
+			const auto itName = std::upper_bound(byName.begin(), byName.end(), plm->languageName,
+				[this](const char *name, size_t i) noexcept {
+					return strcmp(name, lexerCatalogue[i]->languageName) < 0;
+				});
+			byName.insert(itName, index);
+		}
+		const auto itLanguage = std::upper_bound(byLanguage.begin(), byLanguage.end(), plm->language,
+			[this](int language, size_t i) noexcept {
+				return language < lexerCatalogue[i]->language;
+			});
+		byLanguage.insert(itLanguage, index);
+	}
 public:
 	const LexerModule *Find(int language) const noexcept {
-		for (const LexerModule *lm : lexerCatalogue) {
-			if (lm->GetLanguage() == language) {
-				return lm;
-			}
+		const auto it = std::lower_bound(byLanguage.begin(), byLanguage.end(), language,
+			[this](size_t i, int languageFind) noexcept {
+				return lexerCatalogue[i]->language < languageFind;
+			});
+		if ((it != byLanguage.end()) && (lexerCatalogue[*it]->language == language)) {
+			return lexerCatalogue[*it];
 		}
 		return nullptr;
 	}
 
 	const LexerModule *Find(const char *languageName) const noexcept {
 		if (languageName) {
-			for (const LexerModule *lm : lexerCatalogue) {
-				if (lm->languageName && (0 == strcmp(lm->languageName, languageName))) {
-					return lm;
-				}
+			const auto it = std::lower_bound(byName.begin(), byName.end(), languageName,
+				[this](size_t i, const char *nameFind) noexcept {
+					return strcmp(lexerCatalogue[i]->languageName, nameFind) < 0;
+				});
+			if ((it != byName.end()) && (0 == strcmp(lexerCatalogue[*it]->languageName, languageName))) {
+				return lexerCatalogue[*it];
 			}
 		}
 		return nullptr;
@@ -37,10 +62,16 @@ public:
 
 	void AddLexerModule(LexerModule *plm) {
 		lexerCatalogue.push_back(plm);
+		Index(lexerCatalogue.size() - 1);
 	}
 
 	void AddLexerModules(std::initializer_list<LexerModule *> modules) {
-		lexerCatalogue.insert(lexerCatalogue.end(), modules);
+		lexerCatalogue.reserve(lexerCatalogue.size() + modules.size());
+		byName.reserve(lexerCatalogue.capacity());
+		byLanguage.reserve(lexerCatalogue.capacity());
+		for (LexerModule *plm : modules) {
+			AddLexerModule(plm);
+		}
 	}
 
 	size_t Count() const noexcept {
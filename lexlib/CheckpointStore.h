@@ -0,0 +1,78 @@
+// Scintilla source code edit control
+/** @file CheckpointStore.h
+ ** Hold snapshots of the full state of a lexer at regular line intervals.
+ ** A lexer with state too complex for the line state, such as a stack of nested constructs,
+ ** can resume from the nearest snapshot before the start of a Lex instead of backing up
+ ** to a line where the state is known to be simple.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef CHECKPOINTSTORE_H
+#define CHECKPOINTSTORE_H
+
+namespace Lexilla {
+
+/** The snapshots are held in the storage used by SparseState, with the line of each as its position, so
+ * ChunkedStates may be chosen for documents with many snapshots. Unlike SparseState, a snapshot equal to the
+ * one before it is still kept as it lets lexing resume from a later line. */
+template <typename T, template <typename> class Storage=VectorStates>
+class CheckpointStore {
+	Sci_Position interval;
+	Storage<T> checkpoints;
+
+public:
+	explicit CheckpointStore(Sci_Position interval_=64) noexcept : interval(interval_ > 0 ? interval_ : 1) {
+	}
+	Sci_Position Interval() const noexcept {
+		return interval;
+	}
+	/** Called by the lexer with the state at the start of each line it lexes.
+	 * Keeps a snapshot every Interval lines. */
+	void Note(Sci_Position line, const T &state) {
+		if ((line % interval) == 0) {
+			Set(line, state);
+		}
+	}
+	/** Store state as the state at the start of line.
+	 * Snapshots after line are dropped unless the one at line is unchanged, as then they are still valid. */
+	void Set(Sci_Position line, const T &state) {
+		const size_t at = checkpoints.LowerBound(line);
+		if (at < checkpoints.size()) {
+			if ((checkpoints.Position(at) == line) && (checkpoints.Value(at) == state)) {
+				return;
+			}
+			checkpoints.Truncate(at);
+		}
+		checkpoints.PushBack(line, state);
+	}
+	/** Drop the snapshots at and after line, call when the document is modified in line.
+	 * Snapshots are only removed from the end so this does not move any others. */
+	void Invalidate(Sci_Position line) {
+		checkpoints.Truncate(checkpoints.LowerBound(line));
+	}
+	/** Find the nearest snapshot at or before line, setting lineFound and state.
+	 * Returns false when there is none. */
+	bool Before(Sci_Position line, Sci_Position &lineFound, T &state) const {
+		const size_t after = checkpoints.LowerBound(line + 1);
+		if (after == 0) {
+			return false;
+		}
+		lineFound = checkpoints.Position(after - 1);
+		state = checkpoints.Value(after - 1);
+		return true;
+	}
+	void Clear() {
+		checkpoints.Truncate(0);
+	}
+	size_t size() const noexcept {
+		return checkpoints.size();
+	}
+	// Bytes held by the storage of snapshots, not including any memory owned by them
+	size_t MemoryUse() const noexcept {
+		return checkpoints.MemoryUse();
+	}
+};
+
+}
+
+#endif
@@ -10,6 +10,8 @@
 #include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -17,6 +19,9 @@
 
 #include "PropSetSimple.h"
 #include "WordList.h"
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "LexerModule.h"
@@ -71,7 +76,17 @@ Sci_Position SCI_METHOD DefaultLexer::WordListSet(int, const char *) {
 void SCI_METHOD DefaultLexer::Fold(Sci_PositionU, Sci_Position, int, Scintilla::IDocument *) {
 }
 
-void * SCI_METHOD DefaultLexer::PrivateCall(int, void *) {
+void DefaultLexer::AddMemoryUse(LexMemory &memory) const {
+	memory.lexer += sizeof(DefaultLexer);
+}
+
+void * SCI_METHOD DefaultLexer::PrivateCall(int operation, void *pointer) {
+	if ((operation == privateCallLexMemory) && pointer) {
+		LexMemory *memory = static_cast<LexMemory *>(pointer);
+		*memory = LexMemory();
+		AddMemoryUse(*memory);
+		return pointer;
+	}
 	return nullptr;
 }
 
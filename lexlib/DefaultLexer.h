@@ -12,6 +12,8 @@
 
 namespace Lexilla {
 
+struct LexMemory;
+
 // A simple lexer with no state
 class DefaultLexer : public Scintilla::ILexer5 {
 	const char *languageName;
@@ -22,6 +24,9 @@ public:
 	DefaultLexer(const char *languageName_, int language_,
 		const LexicalClass *lexClasses_ = nullptr, size_t nClasses_ = 0);
 	virtual ~DefaultLexer();
+	// Add the bytes held by this lexer to memory, reported through PrivateCall(privateCallLexMemory).
+	// Lexers override this to add their OptionSet, WordLists, SubStyles and other members, calling the base.
+	virtual void AddMemoryUse(LexMemory &memory) const;
 	void SCI_METHOD Release() override;
 	int SCI_METHOD Version() const override;
 	const char * SCI_METHOD PropertyNames() override;
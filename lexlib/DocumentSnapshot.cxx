@@ -0,0 +1,482 @@
+// Scintilla source code edit control
+/** @file DocumentSnapshot.cxx
+ ** Lex a copy of a document on another thread and apply the results on the thread that owns it.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "LexCounters.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "LexUTF8.h"
+#include "DocumentSnapshot.h"
+
+using namespace Lexilla;
+
+namespace {
+
+constexpr int codePageUTF8 = 65001;
+
+// As Scintilla's DBCS trail byte ranges for each code page
+constexpr bool IsDBCSTrailByte(int codePage, unsigned char trail) noexcept {
+	switch (codePage) {
+	case 932:
+		return ((trail >= 0x40) && (trail <= 0x7E)) || ((trail >= 0x80) && (trail <= 0xFC));
+	case 936:
+		return ((trail >= 0x40) && (trail <= 0x7E)) || ((trail >= 0x80) && (trail <= 0xFE));
+	case 949:
+		return ((trail >= 0x41) && (trail <= 0x5A)) || ((trail >= 0x61) && (trail <= 0x7A)) ||
+			((trail >= 0x81) && (trail <= 0xFE));
+	case 950:
+		return ((trail >= 0x40) && (trail <= 0x7E)) || ((trail >= 0xA1) && (trail <= 0xFE));
+	case 1361:
+		return ((trail >= 0x31) && (trail <= 0x7E)) || ((trail >= 0x81) && (trail <= 0xFE));
+	default:
+		return false;
+	}
+}
+
+// Code point of the valid UTF-8 character of width bytes at s
+int UnicodeFromUTF8(const unsigned char *s, int width) noexcept {
+	switch (width) {
+	case 2:
+		return ((s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+	case 3:
+		return ((s[0] & 0xF) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+	default:
+		return ((s[0] & 0x7) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+	}
+}
+
+// Sets values[index - start] to value. Values between the range and index are filled from base so the range
+// stays contiguous
+template <typename Base>
+void SetInRange(std::deque<int> &values, Sci_Position &start, Sci_Position index, int value, Base base) {
+	if (values.empty()) {
+		start = index;
+	} else if (index < start) {
+		for (Sci_Position line = start - 1; line >= index; line--) {
+			values.push_front(base(line));
+		}
+		start = index;
+	}
+	for (Sci_Position line = start + static_cast<Sci_Position>(values.size()); line < index; line++) {
+		values.push_back(base(line));
+	}
+	if (index - start < static_cast<Sci_Position>(values.size())) {
+		values[index - start] = value;
+	} else {
+		values.push_back(value);
+	}
+}
+
+// The value in the range when index is in it, otherwise fallback
+int GetInRange(const std::deque<int> &values, Sci_Position start, Sci_Position index, int fallback) noexcept {
+	if ((index >= start) && (index - start < static_cast<Sci_Position>(values.size()))) {
+		return values[index - start];
+	}
+	return fallback;
+}
+
+}
+
+DocumentSnapshot::DocumentSnapshot(Scintilla::IDocument *pAccess, int version_) :
+	version(version_), codePage(pAccess->CodePage()) {
+	const Sci_Position length = pAccess->Length();
+	text.resize(length);
+	pAccess->GetCharRange(text.data(), 0, length);
+	styles.resize(length);
+	GetDocumentStyles(pAccess, nullptr, styles.data(), 0, length);
+	const Sci_Position lines = pAccess->LineFromPosition(length) + 1;
+	lineStarts.reserve(lines + 1);
+	lineStates.reserve(lines);
+	levels.reserve(lines);
+	indentations.reserve(lines);
+	for (Sci_Position line = 0; line < lines; line++) {
+		lineStarts.push_back(pAccess->LineStart(line));
+		lineStates.push_back(pAccess->GetLineState(line));
+		levels.push_back(pAccess->GetLevel(line));
+		indentations.push_back(pAccess->GetLineIndentation(line));
+	}
+	lineStarts.push_back(length);
+	if ((codePage != 0) && (codePage != codePageUTF8)) {
+		for (int ch = 0x80; ch < 0x100; ch++) {
+			dbcsLeadBytes[ch] = pAccess->IsDBCSLeadByte(static_cast<char>(ch));
+		}
+	}
+}
+
+char DocumentSnapshot::StyleAt(Sci_Position position) const noexcept {
+	if ((position < 0) || (position >= static_cast<Sci_Position>(styles.length()))) {
+		return 0;
+	}
+	return styles[position];
+}
+
+Sci_Position DocumentSnapshot::LineFromPosition(Sci_Position position) const noexcept {
+	const auto after = std::upper_bound(lineStarts.begin(), lineStarts.end() - 1, position);
+	return std::max<Sci_Position>(after - lineStarts.begin() - 1, 0);
+}
+
+Sci_Position DocumentSnapshot::LineStart(Sci_Position line) const noexcept {
+	if (line <= 0) {
+		return 0;
+	}
+	if (line >= Lines()) {
+		return text.length();
+	}
+	return lineStarts[line];
+}
+
+Sci_Position DocumentSnapshot::LineEnd(Sci_Position line) const noexcept {
+	if (line >= Lines() - 1) {
+		return text.length();
+	}
+	const Sci_Position lineStart = LineStart(line);
+	Sci_Position position = lineStarts[line + 1];
+	const auto before = [&](Sci_Position back) noexcept {
+		return (position - back >= lineStart) ? static_cast<unsigned char>(text[position - back]) : 0;
+	};
+	if (before(1) == '\n') {
+		position -= (before(2) == '\r') ? 2 : 1;
+	} else if (before(1) == '\r') {
+		position--;
+	} else if (codePage == codePageUTF8) {
+		// A line only follows these when the document treats them as line ends
+		if ((before(2) == 0xC2) && (before(1) == 0x85)) {
+			position -= 2;
+		} else if ((before(3) == 0xE2) && (before(2) == 0x80) && ((before(1) == 0xA8) || (before(1) == 0xA9))) {
+			position -= 3;
+		}
+	}
+	return position;
+}
+
+int DocumentSnapshot::LineState(Sci_Position line) const noexcept {
+	return ((line >= 0) && (line < Lines())) ? lineStates[line] : 0;
+}
+
+int DocumentSnapshot::Level(Sci_Position line) const noexcept {
+	return ((line >= 0) && (line < Lines())) ? levels[line] : SC_FOLDLEVELBASE;
+}
+
+int DocumentSnapshot::LineIndentation(Sci_Position line) const noexcept {
+	return ((line >= 0) && (line < Lines())) ? indentations[line] : 0;
+}
+
+int DocumentSnapshot::CharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const noexcept {
+	Sci_Position width = 1;
+	int character = 0;
+	const Sci_Position length = text.length();
+	if ((position >= 0) && (position < length)) {
+		const unsigned char *s = reinterpret_cast<const unsigned char *>(text.data()) + position;
+		character = s[0];
+		if ((character >= 0x80) && (codePage == codePageUTF8)) {
+			const int widthUTF8 = UTF8CharacterWidth(s, length - position);
+			if (widthUTF8 > 0) {
+				width = widthUTF8;
+				character = UnicodeFromUTF8(s, widthUTF8);
+			} else {
+				// As Scintilla, invalid bytes are reported as singleton surrogates
+				character = 0xDC80 + s[0];
+			}
+		} else if ((character >= 0x80) && dbcsLeadBytes[character] && (position + 1 < length) &&
+			IsDBCSTrailByte(codePage, s[1])) {
+			width = 2;
+			character = (character << 8) | s[1];
+		}
+	}
+	if (pWidth) {
+		*pWidth = width;
+	}
+	return character;
+}
+
+Sci_Position DocumentSnapshot::RelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const noexcept {
+	const Sci_Position length = text.length();
+	if (codePage == 0) {
+		const Sci_Position position = positionStart + characterOffset;
+		return ((position < 0) || (position > length)) ? -1 : position;
+	}
+	Sci_Position position = positionStart;
+	for (; characterOffset > 0; characterOffset--) {
+		if (position >= length) {
+			return -1;
+		}
+		Sci_Position width = 1;
+		CharacterAndWidth(position, &width);
+		position += width;
+	}
+	for (; characterOffset < 0; characterOffset++) {
+		if (position <= 0) {
+			return -1;
+		}
+		Sci_Position previous = position - 1;
+		if (codePage == codePageUTF8) {
+			// Back to the lead byte when the bytes from it are a character ending at position
+			for (Sci_Position back = 1; (back <= 4) && (position - back >= 0); back++) {
+				const unsigned char ch = text[position - back];
+				if ((ch < 0x80) || (ch >= 0xC0)) {
+					Sci_Position width = 1;
+					CharacterAndWidth(position - back, &width);
+					if (position - back + width == position) {
+						previous = position - back;
+					}
+					break;
+				}
+			}
+		} else {
+			// DBCS can only be read forwards so the characters of the line are found from its start
+			for (Sci_Position start = LineStart(LineFromPosition(position - 1)); start < position;) {
+				previous = start;
+				Sci_Position width = 1;
+				CharacterAndWidth(start, &width);
+				start += width;
+			}
+		}
+		position = previous;
+	}
+	return position;
+}
+
+size_t DocumentSnapshot::MemoryUse() const noexcept {
+	return text.capacity() + styles.capacity() + lineStarts.capacity() * sizeof(Sci_Position) +
+		(lineStates.capacity() + levels.capacity() + indentations.capacity()) * sizeof(int);
+}
+
+bool SnapshotOutput::Apply(Scintilla::IDocument *pAccess, int currentVersion) const {
+	if (currentVersion != version) {
+		return false;
+	}
+	if (!styles.empty()) {
+		pAccess->StartStyling(stylesStart);
+		pAccess->SetStyles(styles.length(), styles.data());
+	}
+	for (size_t index = 0; index < lineStates.size(); index++) {
+		pAccess->SetLineState(lineStatesStart + index, lineStates[index]);
+	}
+	for (size_t index = 0; index < levels.size(); index++) {
+		pAccess->SetLevel(levelsStart + index, levels[index]);
+	}
+	for (const Fill &fill : fills) {
+		pAccess->DecorationSetCurrentIndicator(fill.indicator);
+		pAccess->DecorationFillRange(fill.position, fill.value, fill.fillLength);
+	}
+	if (changedStart >= 0) {
+		pAccess->ChangeLexerState(changedStart, changedEnd);
+	}
+	if (errorStatus) {
+		pAccess->SetErrorStatus(errorStatus);
+	}
+	return true;
+}
+
+SnapshotAccess::SnapshotAccess(const DocumentSnapshot &snapshot_) : snapshot(snapshot_) {
+	output.version = snapshot.Version();
+}
+
+SnapshotOutput SnapshotAccess::TakeOutput() {
+	output.styles.assign(styles.begin(), styles.end());
+	output.lineStates.assign(lineStates.begin(), lineStates.end());
+	output.levels.assign(levels.begin(), levels.end());
+	styles.clear();
+	lineStates.clear();
+	levels.clear();
+	SnapshotOutput taken = std::move(output);
+	output = SnapshotOutput();
+	output.version = snapshot.Version();
+	return taken;
+}
+
+void SnapshotAccess::SetStyleRange(Sci_Position position, Sci_Position length, const char *stylesSet, char style) {
+	const Sci_Position lengthDocument = Length();
+	position = std::clamp<Sci_Position>(position, 0, lengthDocument);
+	length = std::clamp<Sci_Position>(length, 0, lengthDocument - position);
+	if (length == 0) {
+		return;
+	}
+	if (styles.empty()) {
+		output.stylesStart = position;
+	} else if (position < output.stylesStart) {
+		const std::string_view before = snapshot.Styles().substr(position, output.stylesStart - position);
+		styles.insert(styles.begin(), before.begin(), before.end());
+		output.stylesStart = position;
+	}
+	// Keep the range contiguous with the snapshot's styles up to position
+	const Sci_Position end = output.stylesStart + static_cast<Sci_Position>(styles.size());
+	if (end < position) {
+		const std::string_view between = snapshot.Styles().substr(end, position - end);
+		styles.insert(styles.end(), between.begin(), between.end());
+	}
+	const Sci_Position offset = position - output.stylesStart;
+	if (offset + length > static_cast<Sci_Position>(styles.size())) {
+		styles.resize(offset + length);
+	}
+	const std::deque<char>::iterator first = styles.begin() + offset;
+	if (stylesSet) {
+		std::copy(stylesSet, stylesSet + length, first);
+	} else {
+		std::fill(first, first + length, style);
+	}
+}
+
+int SCI_METHOD SnapshotAccess::Version() const {
+	return Scintilla::dvRelease4;
+}
+
+void SCI_METHOD SnapshotAccess::SetErrorStatus(int status) {
+	output.errorStatus = status;
+}
+
+Sci_Position SCI_METHOD SnapshotAccess::Length() const {
+	return snapshot.Text().length();
+}
+
+void SCI_METHOD SnapshotAccess::GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
+	const std::string_view text = snapshot.Text();
+	for (Sci_Position index = 0; index < lengthRetrieve; index++) {
+		const Sci_Position at = position + index;
+		buffer[index] = ((at >= 0) && (at < static_cast<Sci_Position>(text.length()))) ? text[at] : '\0';
+	}
+}
+
+char SCI_METHOD SnapshotAccess::StyleAt(Sci_Position position) const {
+	const Sci_Position offset = position - output.stylesStart;
+	if ((offset >= 0) && (offset < static_cast<Sci_Position>(styles.size()))) {
+		return styles[offset];
+	}
+	return snapshot.StyleAt(position);
+}
+
+void SCI_METHOD SnapshotAccess::GetStyleRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
+	// The snapshot's styles then those set so far over them
+	for (Sci_Position index = 0; index < lengthRetrieve; index++) {
+		buffer[index] = snapshot.StyleAt(position + index);
+	}
+	const Sci_Position overlapStart = std::max(position, output.stylesStart);
+	const Sci_Position overlapEnd = std::min(position + lengthRetrieve,
+		output.stylesStart + static_cast<Sci_Position>(styles.size()));
+	if (overlapStart < overlapEnd) {
+		const std::deque<char>::const_iterator first = styles.begin() + (overlapStart - output.stylesStart);
+		std::copy(first, first + (overlapEnd - overlapStart), buffer + (overlapStart - position));
+	}
+}
+
+Sci_Position SCI_METHOD SnapshotAccess::LineFromPosition(Sci_Position position) const {
+	return snapshot.LineFromPosition(position);
+}
+
+Sci_Position SCI_METHOD SnapshotAccess::LineStart(Sci_Position line) const {
+	return snapshot.LineStart(line);
+}
+
+int SCI_METHOD SnapshotAccess::GetLevel(Sci_Position line) const {
+	return GetInRange(levels, output.levelsStart, line, snapshot.Level(line));
+}
+
+int SCI_METHOD SnapshotAccess::SetLevel(Sci_Position line, int level) {
+	const int previous = GetLevel(line);
+	if ((line >= 0) && (line < snapshot.Lines())) {
+		SetInRange(levels, output.levelsStart, line, level,
+			[this](Sci_Position other) noexcept { return snapshot.Level(other); });
+	}
+	return previous;
+}
+
+int SCI_METHOD SnapshotAccess::GetLineState(Sci_Position line) const {
+	return GetInRange(lineStates, output.lineStatesStart, line, snapshot.LineState(line));
+}
+
+int SCI_METHOD SnapshotAccess::SetLineState(Sci_Position line, int state) {
+	const int previous = GetLineState(line);
+	if ((line >= 0) && (line < snapshot.Lines())) {
+		SetInRange(lineStates, output.lineStatesStart, line, state,
+			[this](Sci_Position other) noexcept { return snapshot.LineState(other); });
+	}
+	return previous;
+}
+
+void SCI_METHOD SnapshotAccess::StartStyling(Sci_Position position) {
+	positionStyling = position;
+}
+
+bool SCI_METHOD SnapshotAccess::SetStyleFor(Sci_Position length, char style) {
+	SetStyleRange(positionStyling, length, nullptr, style);
+	positionStyling += length;
+	return true;
+}
+
+bool SCI_METHOD SnapshotAccess::SetStyles(Sci_Position length, const char *stylesSet) {
+	SetStyleRange(positionStyling, length, stylesSet, 0);
+	positionStyling += length;
+	return true;
+}
+
+void SCI_METHOD SnapshotAccess::DecorationSetCurrentIndicator(int indicator_) {
+	indicator = indicator_;
+}
+
+void SCI_METHOD SnapshotAccess::DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) {
+	output.fills.push_back({ indicator, position, value, fillLength });
+}
+
+void SCI_METHOD SnapshotAccess::ChangeLexerState(Sci_Position start, Sci_Position end) {
+	if (output.changedStart < 0) {
+		output.changedStart = start;
+		output.changedEnd = end;
+	} else {
+		output.changedStart = std::min(output.changedStart, start);
+		output.changedEnd = std::max(output.changedEnd, end);
+	}
+}
+
+int SCI_METHOD SnapshotAccess::CodePage() const {
+	return snapshot.CodePage();
+}
+
+bool SCI_METHOD SnapshotAccess::IsDBCSLeadByte(char ch) const {
+	return snapshot.IsDBCSLeadByte(ch);
+}
+
+const char *SCI_METHOD SnapshotAccess::BufferPointer() {
+	return snapshot.Text().data();
+}
+
+int SCI_METHOD SnapshotAccess::GetLineIndentation(Sci_Position line) {
+	return snapshot.LineIndentation(line);
+}
+
+Sci_Position SCI_METHOD SnapshotAccess::LineEnd(Sci_Position line) const {
+	return snapshot.LineEnd(line);
+}
+
+Sci_Position SCI_METHOD SnapshotAccess::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const {
+	return snapshot.RelativePosition(positionStart, characterOffset);
+}
+
+int SCI_METHOD SnapshotAccess::GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const {
+	return snapshot.CharacterAndWidth(position, pWidth);
+}
+
+SnapshotOutput Lexilla::LexSnapshot(Scintilla::ILexer5 *lexer, const DocumentSnapshot &snapshot, Sci_PositionU start,
+	Sci_Position length, int initStyle, bool fold) {
+	SnapshotAccess access(snapshot);
+	lexer->PrivateCall(privateCallStyleRange, static_cast<IDocumentStyleRange *>(&access));
+	lexer->Lex(start, length, initStyle, &access);
+	if (fold) {
+		lexer->Fold(start, length, initStyle, &access);
+	}
+	return access.TakeOutput();
+}
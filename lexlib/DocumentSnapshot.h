@@ -0,0 +1,144 @@
+// Scintilla source code edit control
+/** @file DocumentSnapshot.h
+ ** Lex a copy of a document on another thread and apply the results on the thread that owns it.
+ ** A DocumentSnapshot is taken on the owning thread. Lexers then read it through a SnapshotAccess, which
+ ** gathers the styles, line states, fold levels and indicators they set into a SnapshotOutput. The owning
+ ** thread applies that output only when the document has not changed since the snapshot was taken.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef DOCUMENTSNAPSHOT_H
+#define DOCUMENTSNAPSHOT_H
+
+namespace Lexilla {
+
+/** An immutable copy of a document's text, styles, lines, line states, fold levels and indentation.
+ * IDocument has no revision number so the owner gives a version that it changes whenever the document is
+ * modified, such as a count of SCN_MODIFIED notifications that insert or delete text. */
+class DocumentSnapshot {
+	int version;
+	int codePage;
+	std::string text;
+	std::string styles;
+	// One more than the number of lines so the last is the length of the document
+	std::vector<Sci_Position> lineStarts;
+	std::vector<int> lineStates;
+	std::vector<int> levels;
+	std::vector<int> indentations;
+	bool dbcsLeadBytes[256] {};
+public:
+	/// Copies pAccess, which is only read, so must be called on the thread that owns it
+	DocumentSnapshot(Scintilla::IDocument *pAccess, int version_);
+
+	int Version() const noexcept {
+		return version;
+	}
+	int CodePage() const noexcept {
+		return codePage;
+	}
+	std::string_view Text() const noexcept {
+		return text;
+	}
+	char StyleAt(Sci_Position position) const noexcept;
+	std::string_view Styles() const noexcept {
+		return styles;
+	}
+	Sci_Position Lines() const noexcept {
+		return static_cast<Sci_Position>(lineStarts.size()) - 1;
+	}
+	Sci_Position LineFromPosition(Sci_Position position) const noexcept;
+	Sci_Position LineStart(Sci_Position line) const noexcept;
+	Sci_Position LineEnd(Sci_Position line) const noexcept;
+	int LineState(Sci_Position line) const noexcept;
+	int Level(Sci_Position line) const noexcept;
+	int LineIndentation(Sci_Position line) const noexcept;
+	bool IsDBCSLeadByte(char ch) const noexcept {
+		return dbcsLeadBytes[static_cast<unsigned char>(ch)];
+	}
+	int CharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const noexcept;
+	Sci_Position RelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const noexcept;
+	/// Bytes held by the copy
+	size_t MemoryUse() const noexcept;
+};
+
+/** What a lexer set while reading a DocumentSnapshot, kept as contiguous ranges of styles, line states and
+ * levels with the indicators filled and lexer state changes in the order made. */
+struct SnapshotOutput {
+	struct Fill {
+		int indicator;
+		Sci_Position position;
+		int value;
+		Sci_Position fillLength;
+	};
+	int version = 0;
+	Sci_Position stylesStart = 0;
+	std::string styles;
+	Sci_Position lineStatesStart = 0;
+	std::vector<int> lineStates;
+	Sci_Position levelsStart = 0;
+	std::vector<int> levels;
+	std::vector<Fill> fills;
+	// From ChangeLexerState, -1 when it was not called
+	Sci_Position changedStart = -1;
+	Sci_Position changedEnd = -1;
+	int errorStatus = 0;
+
+	/// Sets the output on pAccess, returning false and changing nothing when currentVersion is not the
+	/// version of the snapshot, as the output would be of text that is no longer there
+	bool Apply(Scintilla::IDocument *pAccess, int currentVersion) const;
+};
+
+/** The IDocument given to a lexer to lex a snapshot. Reads see the snapshot as changed by what was set
+ * so far, as they would a document. Each SnapshotAccess is used by one thread but any number may read a
+ * snapshot at once. */
+class SnapshotAccess : public IDocumentStyleRange {
+	const DocumentSnapshot &snapshot;
+	// Everything but the ranges, which are held in deques so lexing backwards from an earlier
+	// position adds to their fronts without moving what follows, then copied out by TakeOutput
+	SnapshotOutput output;
+	std::deque<char> styles;
+	std::deque<int> lineStates;
+	std::deque<int> levels;
+	Sci_Position positionStyling = 0;
+	int indicator = 0;
+	void SetStyleRange(Sci_Position position, Sci_Position length, const char *stylesSet, char style);
+public:
+	explicit SnapshotAccess(const DocumentSnapshot &snapshot_);
+	/// What was set, leaving nothing set
+	SnapshotOutput TakeOutput();
+
+	int SCI_METHOD Version() const override;
+	void SCI_METHOD SetErrorStatus(int status) override;
+	Sci_Position SCI_METHOD Length() const override;
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override;
+	char SCI_METHOD StyleAt(Sci_Position position) const override;
+	void SCI_METHOD GetStyleRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override;
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override;
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override;
+	int SCI_METHOD GetLevel(Sci_Position line) const override;
+	int SCI_METHOD SetLevel(Sci_Position line, int level) override;
+	int SCI_METHOD GetLineState(Sci_Position line) const override;
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override;
+	void SCI_METHOD StartStyling(Sci_Position position) override;
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override;
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *stylesSet) override;
+	void SCI_METHOD DecorationSetCurrentIndicator(int indicator_) override;
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end) override;
+	int SCI_METHOD CodePage() const override;
+	bool SCI_METHOD IsDBCSLeadByte(char ch) const override;
+	const char *SCI_METHOD BufferPointer() override;
+	int SCI_METHOD GetLineIndentation(Sci_Position line) override;
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override;
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override;
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override;
+};
+
+/** Lex, and then fold when fold is set, [start, start + length) of snapshot with lexer, returning what was set.
+ * Safe to call on any thread as long as lexer is not used by another thread at the same time. */
+SnapshotOutput LexSnapshot(Scintilla::ILexer5 *lexer, const DocumentSnapshot &snapshot, Sci_PositionU start,
+	Sci_Position length, int initStyle, bool fold);
+
+}
+
+#endif
@@ -0,0 +1,274 @@
+// Scintilla source code edit control
+/** @file EscapeSequenceParser.cxx
+ ** Split terminal output into text and ECMA-48 escape sequences.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstring>
+
+#include <string_view>
+
+#include "EscapeSequenceParser.h"
+
+using namespace Lexilla;
+
+namespace {
+
+enum State : unsigned char {
+	ground,
+	escape,
+	escapeIntermediate,
+	csiEntry,
+	csiParam,
+	csiIntermediate,
+	csiIgnore,
+	dcsEntry,
+	dcsParam,
+	dcsIntermediate,
+	dcsPassthrough,
+	dcsIgnore,
+	oscString,
+	sosPmApcString,
+	stateCount
+};
+
+enum Action : unsigned char {
+	none,
+	execute,
+	ignore,
+	collect,
+	param,
+	put,
+	hook,
+	escDispatch,
+	csiDispatch,
+	stringEnd,	// BEL ending an OSC string
+	cancel,		// The sequence ends with this byte but is not valid
+	interrupt,	// The sequence ends before this byte, which is read again
+};
+
+constexpr char ESC = '\x1b';
+
+struct TransitionTable {
+	// Each entry is the action in the high nibble and the next state in the low nibble
+	unsigned char entries[stateCount][256] {};
+
+	constexpr void Set(State state, int first, int last, Action action, State next) noexcept {
+		for (int ch = first; ch <= last; ch++) {
+			entries[state][ch] = static_cast<unsigned char>((action << 4) | next);
+		}
+	}
+	constexpr void Set(State state, int ch, Action action, State next) noexcept {
+		Set(state, ch, ch, action, next);
+	}
+	// C0 controls except those handled in every state
+	constexpr void SetControls(State state, Action action) noexcept {
+		Set(state, 0x00, 0x1f, action, state);
+	}
+};
+
+constexpr TransitionTable MakeTransitionTable() noexcept {
+	TransitionTable table;
+
+	table.SetControls(ground, execute);
+	table.Set(ground, 0x20, 0xff, none, ground);
+	table.Set(ground, ESC, none, escape);
+
+	table.SetControls(escape, execute);
+	table.Set(escape, 0x20, 0x2f, collect, escapeIntermediate);
+	table.Set(escape, 0x30, 0x7e, escDispatch, ground);
+	table.Set(escape, '[', none, csiEntry);
+	table.Set(escape, ']', none, oscString);
+	table.Set(escape, 'P', none, dcsEntry);
+	table.Set(escape, 'X', none, sosPmApcString);
+	table.Set(escape, '^', none, sosPmApcString);
+	table.Set(escape, '_', none, sosPmApcString);
+	table.Set(escape, 0x7f, ignore, escape);
+	table.Set(escape, 0x80, 0xff, interrupt, ground);
+
+	table.SetControls(escapeIntermediate, execute);
+	table.Set(escapeIntermediate, 0x20, 0x2f, collect, escapeIntermediate);
+	table.Set(escapeIntermediate, 0x30, 0x7e, escDispatch, ground);
+	table.Set(escapeIntermediate, 0x7f, ignore, escapeIntermediate);
+	table.Set(escapeIntermediate, 0x80, 0xff, interrupt, ground);
+
+	// ':' is accepted as a parameter byte for sub-parameters such as 38:2::r:g:b
+	table.SetControls(csiEntry, execute);
+	table.Set(csiEntry, 0x20, 0x2f, collect, csiIntermediate);
+	table.Set(csiEntry, 0x30, 0x3f, param, csiParam);
+	table.Set(csiEntry, 0x40, 0x7e, csiDispatch, ground);
+	table.Set(csiEntry, 0x7f, ignore, csiEntry);
+	table.Set(csiEntry, 0x80, 0xff, interrupt, ground);
+
+	table.SetControls(csiParam, execute);
+	table.Set(csiParam, 0x20, 0x2f, collect, csiIntermediate);
+	table.Set(csiParam, 0x30, 0x3b, param, csiParam);
+	table.Set(csiParam, 0x3c, 0x3f, ignore, csiIgnore);
+	table.Set(csiParam, 0x40, 0x7e, csiDispatch, ground);
+	table.Set(csiParam, 0x7f, ignore, csiParam);
+	table.Set(csiParam, 0x80, 0xff, interrupt, ground);
+
+	table.SetControls(csiIntermediate, execute);
+	table.Set(csiIntermediate, 0x20, 0x2f, collect, csiIntermediate);
+	table.Set(csiIntermediate, 0x30, 0x3f, ignore, csiIgnore);
+	table.Set(csiIntermediate, 0x40, 0x7e, csiDispatch, ground);
+	table.Set(csiIntermediate, 0x7f, ignore, csiIntermediate);
+	table.Set(csiIntermediate, 0x80, 0xff, interrupt, ground);
+
+	table.SetControls(csiIgnore, execute);
+	table.Set(csiIgnore, 0x20, 0x3f, ignore, csiIgnore);
+	table.Set(csiIgnore, 0x40, 0x7e, cancel, ground);
+	table.Set(csiIgnore, 0x7f, ignore, csiIgnore);
+	table.Set(csiIgnore, 0x80, 0xff, interrupt, ground);
+
+	table.SetControls(dcsEntry, ignore);
+	table.Set(dcsEntry, 0x20, 0x2f, collect, dcsIntermediate);
+	table.Set(dcsEntry, 0x30, 0x3f, param, dcsParam);
+	table.Set(dcsEntry, 0x40, 0x7e, hook, dcsPassthrough);
+	table.Set(dcsEntry, 0x7f, 0xff, ignore, dcsEntry);
+
+	table.SetControls(dcsParam, ignore);
+	table.Set(dcsParam, 0x20, 0x2f, collect, dcsIntermediate);
+	table.Set(dcsParam, 0x30, 0x3b, param, dcsParam);
+	table.Set(dcsParam, 0x3c, 0x3f, ignore, dcsIgnore);
+	table.Set(dcsParam, 0x40, 0x7e, hook, dcsPassthrough);
+	table.Set(dcsParam, 0x7f, 0xff, ignore, dcsParam);
+
+	table.SetControls(dcsIntermediate, ignore);
+	table.Set(dcsIntermediate, 0x20, 0x2f, collect, dcsIntermediate);
+	table.Set(dcsIntermediate, 0x30, 0x3f, ignore, dcsIgnore);
+	table.Set(dcsIntermediate, 0x40, 0x7e, hook, dcsPassthrough);
+	table.Set(dcsIntermediate, 0x7f, 0xff, ignore, dcsIntermediate);
+
+	table.SetControls(dcsPassthrough, put);
+	table.Set(dcsPassthrough, 0x20, 0xff, put, dcsPassthrough);
+	table.Set(dcsPassthrough, 0x7f, ignore, dcsPassthrough);
+
+	table.Set(dcsIgnore, 0x00, 0xff, ignore, dcsIgnore);
+
+	table.SetControls(oscString, ignore);
+	table.Set(oscString, 0x07, stringEnd, ground);
+	table.Set(oscString, 0x20, 0xff, put, oscString);
+
+	table.Set(sosPmApcString, 0x00, 0xff, put, sosPmApcString);
+
+	// Transitions from every state within a sequence
+	for (int state = escape; state < stateCount; state++) {
+		table.Set(static_cast<State>(state), 0x18, cancel, ground);	// CAN
+		table.Set(static_cast<State>(state), 0x1a, cancel, ground);	// SUB
+		table.Set(static_cast<State>(state), ESC, interrupt, escape);
+		table.Set(static_cast<State>(state), '\n', interrupt, ground);
+		table.Set(static_cast<State>(state), '\r', interrupt, ground);
+	}
+
+	return table;
+}
+
+constexpr TransitionTable transitions = MakeTransitionTable();
+
+constexpr bool IsStringState(State state) noexcept {
+	return (state == dcsPassthrough) || (state == dcsIgnore) || (state == oscString) || (state == sosPmApcString);
+}
+
+constexpr EscapeSequenceKind StringKind(char introducer) noexcept {
+	if (introducer == ']') {
+		return EscapeSequenceKind::osc;
+	} else if (introducer == 'P') {
+		return EscapeSequenceKind::dcs;
+	}
+	return EscapeSequenceKind::controlString;
+}
+
+// Extends the range [start, end) of a part of a sequence to include position
+void Extend(size_t &start, size_t &end, size_t position) noexcept {
+	if (start == end) {
+		start = position;
+	}
+	end = position + 1;
+}
+
+}
+
+bool EscapeSequenceParser::Next(EscapeSequence &sequence) noexcept {
+	if (position >= text.length()) {
+		return false;
+	}
+	sequence = EscapeSequence();
+	sequence.start = position;
+	if (text[position] != ESC) {
+		const void *found = memchr(text.data() + position, ESC, text.length() - position);
+		const size_t end = found ? static_cast<const char *>(found) - text.data() : text.length();
+		sequence.length = end - position;
+		position = end;
+		return true;
+	}
+
+	size_t startParameters = 0;
+	size_t endParameters = 0;
+	size_t startIntermediates = 0;
+	size_t endIntermediates = 0;
+	size_t startData = 0;
+	size_t endData = 0;
+	EscapeSequenceKind kind = EscapeSequenceKind::malformed;
+	State state = escape;
+	size_t end = position + 1;
+	if (end < text.length()) {
+		sequence.introducer = text[end];
+	}
+	for (; end < text.length(); end++) {
+		const unsigned char ch = text[end];
+		const unsigned char transition = transitions.entries[state][ch];
+		const Action action = static_cast<Action>(transition >> 4);
+		switch (action) {
+		case collect:
+			Extend(startIntermediates, endIntermediates, end);
+			break;
+		case param:
+			Extend(startParameters, endParameters, end);
+			break;
+		case put:
+			Extend(startData, endData, end);
+			break;
+		case hook:
+			sequence.final = ch;
+			break;
+		case escDispatch:
+			sequence.final = ch;
+			kind = EscapeSequenceKind::escape;
+			break;
+		case csiDispatch:
+			sequence.final = ch;
+			kind = EscapeSequenceKind::csi;
+			break;
+		case stringEnd:
+			kind = StringKind(sequence.introducer);
+			break;
+		case interrupt:
+			if ((ch == ESC) && IsStringState(state) && (end + 1 < text.length()) && (text[end + 1] == '\\')) {
+				// String terminator ESC \ ends the string
+				kind = StringKind(sequence.introducer);
+				end += 2;
+			}
+			break;
+		default:
+			break;
+		}
+		if (action == interrupt) {
+			break;
+		}
+		state = static_cast<State>(transition & 0xf);
+		if (state == ground) {
+			end++;
+			break;
+		}
+	}
+
+	sequence.kind = kind;
+	sequence.length = end - position;
+	sequence.parameters = text.substr(startParameters, endParameters - startParameters);
+	sequence.intermediates = text.substr(startIntermediates, endIntermediates - startIntermediates);
+	sequence.data = text.substr(startData, endData - startData);
+	position = end;
+	return true;
+}
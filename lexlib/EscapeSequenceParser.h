@@ -0,0 +1,48 @@
+// Scintilla source code edit control
+/** @file EscapeSequenceParser.h
+ ** Split terminal output into text and ECMA-48 escape sequences.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef ESCAPESEQUENCEPARSER_H
+#define ESCAPESEQUENCEPARSER_H
+
+namespace Lexilla {
+
+enum class EscapeSequenceKind {
+	text,		// Text and control characters up to the next ESC
+	csi,		// ESC [ <parameters> <intermediates> <final>
+	escape,		// ESC <intermediates> <final>, such as the charset designator ESC ( B
+	osc,		// ESC ] <data> terminated by ST (ESC \) or BEL
+	dcs,		// ESC P <parameters> <intermediates> <final> <data> terminated by ST
+	controlString,	// SOS, PM or APC: ESC X, ESC ^ or ESC _ <data> terminated by ST
+	malformed,	// A sequence cut short by the end of the text, a line end, CAN, SUB, ESC or a byte >= 0x80
+};
+
+struct EscapeSequence {
+	EscapeSequenceKind kind = EscapeSequenceKind::text;
+	size_t start = 0;
+	size_t length = 0;
+	char introducer = 0;			// Byte following ESC
+	char final = 0;				// Final byte of CSI, DCS and escape sequences
+	std::string_view parameters;		// Parameter bytes 0x30..0x3F, including private markers
+	std::string_view intermediates;		// Intermediate bytes 0x20..0x2F
+	std::string_view data;			// Body of OSC, DCS and control strings
+};
+
+/// Splits text into the sequences of Paul Williams' VT500 parser model with one table lookup per byte.
+/// As text is usually UTF-8, bytes >= 0x80 are never treated as C1 controls.
+/// Lines are styled separately so a line end interrupts a sequence.
+class EscapeSequenceParser {
+	std::string_view text;
+	size_t position = 0;
+public:
+	explicit EscapeSequenceParser(std::string_view text_) noexcept : text(text_) {
+	}
+	/// Reads the next piece of text or sequence, returns false at the end of the text.
+	bool Next(EscapeSequence &sequence) noexcept;
+};
+
+}
+
+#endif
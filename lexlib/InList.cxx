@@ -6,17 +6,17 @@
 // The License.txt file describes the conditions under which this software may be distributed.
 
 #include <cassert>
+#include <cstddef>
 
-#include <string>
+#include <string_view>
 #include <initializer_list>
 
 #include "InList.h"
-#include "LexCharacterSet.h"
 
 namespace Lexilla {
 
-bool InList(std::string const& value, std::initializer_list<std::string> list) noexcept {
-	for (std::string const& element : list) {
+bool InList(std::string_view value, std::initializer_list<std::string_view> list) noexcept {
+	for (std::string_view element : list) {
 		if (value == element) {
 			return true;
 		}
@@ -24,9 +24,9 @@ bool InList(std::string const& value, std::initializer_list<std::string> list) n
 	return false;
 }
 
-bool InListCaseInsensitive(std::string const& value, std::initializer_list<std::string> list) noexcept {
-	for (std::string const& element : list) {
-		if (EqualCaseInsensitive(value, element)) {
+bool InListCaseInsensitive(std::string_view value, std::initializer_list<std::string_view> list) noexcept {
+	for (std::string_view element : list) {
+		if (KeywordCompare(value, element) == 0) {
 			return true;
 		}
 	}
@@ -10,8 +10,81 @@
 
 namespace Lexilla {
 
-bool InList(std::string const& value, std::initializer_list<std::string> list) noexcept;
-bool InListCaseInsensitive(std::string const& value, std::initializer_list<std::string> list) noexcept;
+bool InList(std::string_view value, std::initializer_list<std::string_view> list) noexcept;
+bool InListCaseInsensitive(std::string_view value, std::initializer_list<std::string_view> list) noexcept;
+
+constexpr char KeywordLowered(char ch) noexcept {
+	return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+// Compare ignoring ASCII case: negative, zero or positive as for strcmp
+constexpr int KeywordCompare(std::string_view a, std::string_view b) noexcept {
+	const size_t length = (a.length() < b.length()) ? a.length() : b.length();
+	for (size_t i = 0; i < length; i++) {
+		const unsigned char chA = KeywordLowered(a[i]);
+		const unsigned char chB = KeywordLowered(b[i]);
+		if (chA != chB) {
+			return (chA < chB) ? -1 : 1;
+		}
+	}
+	return (a.length() == b.length()) ? 0 : ((a.length() < b.length()) ? -1 : 1);
+}
+
+/// A fixed set of keywords sorted when constructed, which can be at compile time, so checking a word
+/// is a binary search with no heap work:
+///     constexpr KeywordSet levels { "error", "warning", "note" };
+///     if (levels.ContainsCaseInsensitive(word)) ...
+template <size_t N>
+class KeywordSet {
+	// Sorted ignoring case so both exact and case insensitive searches can use it
+	std::string_view words[N];
+
+	// First word not before value ignoring case
+	constexpr size_t LowerBound(std::string_view value) const noexcept {
+		size_t low = 0;
+		size_t high = N;
+		while (low < high) {
+			const size_t middle = low + (high - low) / 2;
+			if (KeywordCompare(words[middle], value) < 0) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+public:
+	template <typename... Words>
+	constexpr explicit KeywordSet(Words... words_) noexcept : words { std::string_view(words_)... } {
+		for (size_t i = 1; i < N; i++) {
+			const std::string_view word = words[i];
+			size_t j = i;
+			for (; (j > 0) && (KeywordCompare(word, words[j - 1]) < 0); j--) {
+				words[j] = words[j - 1];
+			}
+			words[j] = word;
+		}
+	}
+	constexpr size_t size() const noexcept {
+		return N;
+	}
+	constexpr bool Contains(std::string_view value) const noexcept {
+		for (size_t i = LowerBound(value); (i < N) && (KeywordCompare(words[i], value) == 0); i++) {
+			if (words[i] == value) {
+				return true;
+			}
+		}
+		return false;
+	}
+	constexpr bool ContainsCaseInsensitive(std::string_view value) const noexcept {
+		const size_t i = LowerBound(value);
+		return (i < N) && (KeywordCompare(words[i], value) == 0);
+	}
+};
+
+template <typename... Words>
+KeywordSet(Words...) -> KeywordSet<sizeof...(Words)>;
 
 }
 
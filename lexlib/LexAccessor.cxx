@@ -4,23 +4,77 @@
  **/
 // Copyright 1998-2010 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
+#include <cstddef>
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
 #include <algorithm>
+#include <type_traits>
 
 #include "ILexer.h"
 
+#include "LexCounters.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
+#include "LexArena.h"
 #include "LexCharacterSet.h"
 
 using namespace Lexilla;
 
 namespace Lexilla {
 
+LexAccessor::~LexAccessor() {
+	if (ownsArena) {
+		delete arena;
+	}
+}
+
+void LexAccessor::SetArena(LexArena *arena_) {
+	if (ownsArena) {
+		delete arena;
+		ownsArena = false;
+	}
+	arena = arena_;
+	DropLineCache();
+}
+
+void GetDocumentStyles(const Scintilla::IDocument *pAccess, const IDocumentStyleRange *styleRange, char *buffer,
+	Sci_Position position, Sci_Position lengthRetrieve) {
+	if (styleRange) {
+		styleRange->GetStyleRange(buffer, position, lengthRetrieve);
+		return;
+	}
+	for (Sci_Position i = 0; i < lengthRetrieve; i++) {
+		buffer[i] = pAccess->StyleAt(position + i);
+	}
+}
+
+LexArena &LexAccessor::Arena() {
+	if (!arena) {
+		arena = new LexArena();
+		ownsArena = true;
+	}
+	return *arena;
+}
+
 bool LexAccessor::MatchIgnoreCase(Sci_Position pos, const char *s) {
 	assert(s);
+	const size_t len = strlen(s);
+	Sci_Position available = 0;
+	const char *text = BufferPointerAt(pos, available);
+	if (text && (static_cast<size_t>(available) >= len)) {
+		for (size_t i = 0; i < len; i++) {
+			if (s[i] != MakeLowerCase(text[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
 	for (; *s; s++, pos++) {
 		if (*s != MakeLowerCase(SafeGetCharAt(pos))) {
 			return false;
@@ -29,15 +83,147 @@ bool LexAccessor::MatchIgnoreCase(Sci_Position pos, const char *s) {
 	return true;
 }
 
+void LexAccessor::CacheLines(Sci_Position start, Sci_Position end) {
+	cacheLines = 0;
+	cacheHint = 0;
+	LEXILLA_COUNT(counters, documentCalls, 2);
+	cacheFirstLine = pAccess->LineFromPosition(start);
+	Sci_Position position = pAccess->LineStart(cacheFirstLine);
+	// The arrays start with room for lines of 64 bytes and double when full. Outgrown arrays stay
+	// in the arena until it is reset.
+	LexArena &storage = Arena();
+	size_t capacity = static_cast<size_t>(std::max<Sci_Position>(end - position, 0) / 64) + 16;
+	cacheStarts = storage.AllocateArray<Sci_Position>(capacity + 1);
+	cacheEnds = storage.AllocateArray<Sci_Position>(capacity);
+	size_t lines = 0;
+	cacheStarts[0] = position;
+	while (position < end && position < lenDoc) {
+		// Find the end of the line starting at position
+		Sci_Position eol = position;
+		while (eol < lenDoc) {
+			Sci_Position available = 0;
+			const char *text = BufferPointerAt(eol, available);
+			const char *p = text;
+			const char *textEnd = text + available;
+			while (p < textEnd && *p != '\r' && *p != '\n') {
+				p++;
+			}
+			eol += p - text;
+			if (p < textEnd) {
+				break;
+			}
+		}
+		if (lines == capacity) {
+			Sci_Position *starts = storage.AllocateArray<Sci_Position>(capacity * 2 + 1);
+			Sci_Position *ends = storage.AllocateArray<Sci_Position>(capacity * 2);
+			std::copy(cacheStarts, cacheStarts + lines + 1, starts);
+			std::copy(cacheEnds, cacheEnds + lines, ends);
+			cacheStarts = starts;
+			cacheEnds = ends;
+			capacity *= 2;
+		}
+		cacheEnds[lines] = eol;
+		lines++;
+		if (eol >= lenDoc) {
+			cacheStarts[lines] = lenDoc;
+			break;
+		}
+		position = eol + (((*this)[eol] == '\r' && SafeGetCharAt(eol + 1) == '\n') ? 2 : 1);
+		cacheStarts[lines] = position;
+	}
+	// Other line ends, such as Unicode line separators, make the document count more lines, so check
+	// the document agrees on where the last cached line starts and where the line after it starts
+	const Sci_Position lineLast = cacheFirstLine + static_cast<Sci_Position>(lines);
+	LEXILLA_COUNT(counters, documentCalls, 2);
+	if ((pAccess->LineStart(lineLast) == cacheStarts[lines]) &&
+		((lines == 0) || (pAccess->LineStart(lineLast - 1) == cacheStarts[lines - 1]))) {
+		cacheLines = lines;
+	}
+}
+
+Sci_Position LexAccessor::CachedLine(Sci_Position position) const {
+	// Lines are usually visited in order so try the line after the last one found
+	size_t index = cacheHint + 1;
+	if (!(index < cacheLines && position >= cacheStarts[index] && position < cacheStarts[index + 1])) {
+		index = std::upper_bound(cacheStarts, cacheStarts + cacheLines + 1, position) - cacheStarts - 1;
+	}
+	cacheHint = index;
+	return cacheFirstLine + index;
+}
+
+// Styles [startPosStyling, startPosStyling + length) with styles, or with style when styles is null,
+// only writing from the first to the last position that changes. The document's styling position is
+// left at the end of the range either way.
+void LexAccessor::SetStylesChanged(Sci_Position length, const char *styles, char style) {
+	auto styleOf = [styles, style](Sci_Position i) noexcept {
+		return styles ? styles[i] : style;
+	};
+	// The document's styles are read in blocks, each with one call when the document supports it
+	constexpr Sci_Position blockSize = 0x400;
+	char previous[blockSize];
+	auto readPrevious = [this, &previous](Sci_Position start, Sci_Position lengthBlock) {
+		LEXILLA_COUNT(counters, documentCalls, styleRange ? 1 : lengthBlock);
+		GetDocumentStyles(pAccess, styleRange, previous, startPosStyling + start, lengthBlock);
+	};
+	Sci_Position first = length;
+	for (Sci_Position block = 0; block < length; block += blockSize) {
+		const Sci_Position lengthBlock = std::min(blockSize, length - block);
+		readPrevious(block, lengthBlock);
+		Sci_Position i = 0;
+		while (i < lengthBlock && previous[i] == styleOf(block + i)) {
+			i++;
+		}
+		if (i < lengthBlock) {
+			first = block + i;
+			break;
+		}
+	}
+	Sci_Position last = first;
+	if (first < length) {
+		// Search back from the end for the last change, stopping after the first
+		for (Sci_Position blockEnd = length; blockEnd > first + 1;) {
+			const Sci_Position block = std::max(first + 1, blockEnd - blockSize);
+			readPrevious(block, blockEnd - block);
+			Sci_Position i = blockEnd - 1;
+			while (i >= block && previous[i - block] == styleOf(i)) {
+				i--;
+			}
+			if (i >= block) {
+				last = i;
+				break;
+			}
+			blockEnd = block;
+		}
+		if (first > 0) {
+			LEXILLA_COUNT(counters, documentCalls, 1);
+			pAccess->StartStyling(startPosStyling + first);
+		}
+		LEXILLA_COUNT(counters, documentCalls, 1);
+		if (styles) {
+			pAccess->SetStyles(last - first + 1, styles + first);
+		} else {
+			pAccess->SetStyleFor(last - first + 1, style);
+		}
+		changedStart = std::min(changedStart, startPosStyling + first);
+		changedEnd = std::max(changedEnd, startPosStyling + last + 1);
+	}
+	if (first == length || last < length - 1) {
+		LEXILLA_COUNT(counters, documentCalls, 1);
+		pAccess->StartStyling(startPosStyling + length);
+	}
+}
+
 void LexAccessor::GetRange(Sci_PositionU startPos_, Sci_PositionU endPos_, char *s, Sci_PositionU len) {
 	assert(s);
 	assert(startPos_ <= endPos_ && len != 0);
 	endPos_ = std::min(endPos_, startPos_ + len - 1);
 	len = endPos_ - startPos_;
 	if (startPos_ >= static_cast<Sci_PositionU>(startPos) && endPos_ <= static_cast<Sci_PositionU>(endPos)) {
-		const char * const p = buf + (startPos_ - startPos);
+		const char * const p = pText + (startPos_ - startPos);
 		memcpy(s, p, len);
 	} else {
+		LEXILLA_COUNT(counters, documentCalls, 1);
+		LEXILLA_COUNT(counters, bytesCopied, len);
 		pAccess->GetCharRange(s, startPos_, len);
 	}
 	s[len] = '\0';
@@ -70,4 +256,31 @@ std::string LexAccessor::GetRangeLowered(Sci_PositionU startPos_, Sci_PositionU
 	return s;
 }
 
+std::string_view LexAccessor::GetRangeView(Sci_PositionU startPos_, Sci_PositionU endPos_) {
+	assert(startPos_ <= endPos_);
+	const Sci_PositionU len = endPos_ - startPos_;
+	if (len == 0) {
+		return {};
+	}
+	Sci_Position available = 0;
+	const char *text = BufferPointerAt(startPos_, available);
+	if (text && (static_cast<Sci_PositionU>(available) >= len)) {
+		return std::string_view(text, len);
+	}
+	char *s = Arena().AllocateArray<char>(len + 1);
+	GetRange(startPos_, endPos_, s, len + 1);
+	return std::string_view(s, len);
+}
+
+std::string_view LexAccessor::GetRangeLoweredView(Sci_PositionU startPos_, Sci_PositionU endPos_) {
+	assert(startPos_ <= endPos_);
+	const Sci_PositionU len = endPos_ - startPos_;
+	if (len == 0) {
+		return {};
+	}
+	char *s = Arena().AllocateArray<char>(len + 1);
+	GetRangeLowered(startPos_, endPos_, s, len + 1);
+	return std::string_view(s, len);
+}
+
 }
@@ -12,6 +12,27 @@ namespace Lexilla {
 
 enum class EncodingType { eightBit, unicode, dbcs };
 
+/** Documents that can copy a range of styles at once derive from this instead of IDocument.
+ * An IDocument can not be asked what else it implements, so before each Lex the host lends the document
+ * to the lexer with ILexer5::PrivateCall(privateCallStyleRange, pointer to the IDocumentStyleRange).
+ * lexlib then reads its styles in blocks instead of calling StyleAt for each byte. */
+class IDocumentStyleRange : public Scintilla::IDocument {
+public:
+	virtual void SCI_METHOD GetStyleRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const = 0;
+};
+
+constexpr int privateCallStyleRange = 0x4C585931;	// "LXY1"
+
+/// Copies the styles of [position, position + lengthRetrieve) of pAccess into buffer, with one call through
+/// styleRange when it is not nullptr, in which case it must be pAccess
+void GetDocumentStyles(const Scintilla::IDocument *pAccess, const IDocumentStyleRange *styleRange, char *buffer,
+	Sci_Position position, Sci_Position lengthRetrieve);
+
+class LexArena;
+class LexLocations;
+class LexStyleTable;
+class LexInvalidation;
+
 class LexAccessor {
 private:
 	Scintilla::IDocument *pAccess;
@@ -22,6 +43,8 @@ private:
 	 * in case there is some backtracking. */
 	enum {bufferSize=4000, slopSize=bufferSize/8};
 	char buf[bufferSize+1];
+	/** Text of [startPos, endPos): buf, or the document's own buffer after UseDocumentBuffer. */
+	const char *pText;
 	Sci_Position startPos;
 	Sci_Position endPos;
 	int codePage;
@@ -32,8 +55,42 @@ private:
 	Sci_PositionU startSeg;
 	Sci_Position startPosStyling;
 	int documentVersion;
+	// Optional cache of line positions filled by CacheLines in arrays from the arena.
+	// cacheStarts[i] and cacheEnds[i] are the start and end of line cacheFirstLine+i for the
+	// cacheLines lines cached and cacheStarts[cacheLines] is the start of the line after them.
+	Sci_Position cacheFirstLine;
+	Sci_Position *cacheStarts;
+	Sci_Position *cacheEnds;
+	size_t cacheLines;
+	mutable size_t cacheHint;	// Index of the line found by the last GetLine
+	// When compareStyles is set only styles that differ from the document's are written and
+	// [changedStart, changedEnd) is the smallest range holding them
+	bool compareStyles;
+	Sci_Position changedStart;
+	Sci_Position changedEnd;
+	// The document itself when it was lent with SetStyleRange, so its styles are read in blocks
+	const IDocumentStyleRange *styleRange = nullptr;
+#if defined(LEXILLA_COUNTERS)
+	LexCounters *counters = nullptr;
+#endif
+	// Temporary storage for GetRangeView and similar, lent with SetArena so it lasts between
+	// calls to Lex or else allocated by Arena and deleted with this accessor
+	LexArena *arena = nullptr;
+	bool ownsArena = false;
+	// Where lexers record diagnostic locations, lent with SetLocations, nullptr when not wanted
+	LexLocations *locations = nullptr;
+	// Where lexers allocate styles for combinations of attributes, lent with SetStyleTable
+	LexStyleTable *styleTable = nullptr;
+	// Where lexers mark text whose styles depend on a scoped property, lent with SetInvalidation
+	LexInvalidation *invalidation = nullptr;
+
+	void SetStylesChanged(Sci_Position length, const char *styles, char style);
 
 	void Fill(Sci_Position position) {
+		if (pText != buf) {
+			// The whole document is already available so position is outside it
+			return;
+		}
 		startPos = position - slopSize;
 		if (startPos + bufferSize > lenDoc)
 			startPos = lenDoc - bufferSize;
@@ -43,46 +100,113 @@ private:
 		if (endPos > lenDoc)
 			endPos = lenDoc;
 
+		LEXILLA_TRACE_SCOPE("Fill", nullptr, startPos, endPos);
 		pAccess->GetCharRange(buf, startPos, endPos-startPos);
 		buf[endPos-startPos] = '\0';
+		LEXILLA_COUNT(counters, fills, 1);
+		LEXILLA_COUNT(counters, bytesCopied, endPos - startPos);
+		LEXILLA_COUNT(counters, documentCalls, 1);
 	}
 
 public:
 	explicit LexAccessor(Scintilla::IDocument *pAccess_) :
-		pAccess(pAccess_), startPos(extremePosition), endPos(0),
+		pAccess(pAccess_), pText(buf), startPos(extremePosition), endPos(0),
 		codePage(pAccess->CodePage()),
 		encodingType(EncodingType::eightBit),
 		lenDoc(pAccess->Length()),
 		validLen(0),
 		startSeg(0), startPosStyling(0),
-		documentVersion(pAccess->Version()) {
+		documentVersion(pAccess->Version()),
+		cacheFirstLine(0), cacheStarts(nullptr), cacheEnds(nullptr), cacheLines(0), cacheHint(0),
+		compareStyles(false), changedStart(extremePosition), changedEnd(0) {
 		// Prevent warnings by static analyzers about uninitialized buf and styleBuf.
 		buf[0] = 0;
 		styleBuf[0] = 0;
-		switch (codePage) {
+		encodingType = EncodingOfCodePage(codePage);
+	}
+	static EncodingType EncodingOfCodePage(int codePage_) noexcept {
+		switch (codePage_) {
 		case 65001:
-			encodingType = EncodingType::unicode;
-			break;
+			return EncodingType::unicode;
 		case 932:
 		case 936:
 		case 949:
 		case 950:
 		case 1361:
-			encodingType = EncodingType::dbcs;
-			break;
+			return EncodingType::dbcs;
 		default:
-			break;
+			return EncodingType::eightBit;
 		}
 	}
+	// Deleted so LexAccessor objects can not be copied.
+	LexAccessor(const LexAccessor &) = delete;
+	LexAccessor(LexAccessor &&) = delete;
+	LexAccessor &operator=(const LexAccessor &) = delete;
+	LexAccessor &operator=(LexAccessor &&) = delete;
+	~LexAccessor();
 	char operator[](Sci_Position position) {
 		if (position < startPos || position >= endPos) {
 			Fill(position);
 		}
-		return buf[position - startPos];
+		return pText[position - startPos];
 	}
 	Scintilla::IDocument *MultiByteAccess() const noexcept {
 		return pAccess;
 	}
+	/** Collect counters of the work done into counters_, which may be nullptr to stop.
+	 * Does nothing unless built with LEXILLA_COUNTERS defined. */
+	void SetCounters([[maybe_unused]] LexCounters *counters_) noexcept {
+#if defined(LEXILLA_COUNTERS)
+		counters = counters_;
+#endif
+	}
+	LexCounters *Counters() const noexcept {
+#if defined(LEXILLA_COUNTERS)
+		return counters;
+#else
+		return nullptr;
+#endif
+	}
+	/** Use arena_, owned by the caller and normally Reset at the end of Lex, for temporary storage.
+	 * The line cache, which was in the previous arena, is dropped. */
+	void SetArena(LexArena *arena_);
+	/** The arena for temporary storage that lasts until the end of Lex. */
+	LexArena &Arena();
+	/** Record the locations named by diagnostic lines into locations_, which may be nullptr to stop. */
+	void SetLocations(LexLocations *locations_) noexcept {
+		locations = locations_;
+	}
+	LexLocations *Locations() const noexcept {
+		return locations;
+	}
+	/** Allocate styles for combinations of attributes from styleTable_, which may be nullptr. */
+	void SetStyleTable(LexStyleTable *styleTable_) noexcept {
+		styleTable = styleTable_;
+	}
+	LexStyleTable *StyleTable() const noexcept {
+		return styleTable;
+	}
+	/** Mark the text whose styles depend on scoped properties into invalidation_, which may be nullptr. */
+	void SetInvalidation(LexInvalidation *invalidation_) noexcept {
+		invalidation = invalidation_;
+	}
+	LexInvalidation *Invalidation() const noexcept {
+		return invalidation;
+	}
+	/** Read text straight from the document's buffer instead of copying it into buf a window at a time.
+	 * Only safe when the text will not change while this LexAccessor is used, as when styling in Lex.
+	 * Retrieving the buffer may move the document's gap so this is best for large ranges. */
+	bool UseDocumentBuffer() {
+		LEXILLA_COUNT(counters, documentCalls, 1);
+		const char *documentText = pAccess->BufferPointer();
+		if (!documentText) {
+			return false;
+		}
+		pText = documentText;
+		startPos = 0;
+		endPos = lenDoc;
+		return true;
+	}
 	/** Safe version of operator[], returning a defined value for invalid position. */
 	char SafeGetCharAt(Sci_Position position, char chDefault=' ') {
 		if (position < startPos || position >= endPos) {
@@ -92,20 +216,39 @@ public:
 				return chDefault;
 			}
 		}
-		return buf[position - startPos];
+		return pText[position - startPos];
+	}
+	/** Pointer to the text at position, refilling the buffer when position is outside it.
+	 * length is set to the number of bytes available from there, 0 outside the document. */
+	const char *BufferPointerAt(Sci_Position position, Sci_Position &length) {
+		if (position < startPos || position >= endPos) {
+			Fill(position);
+			if (position < startPos || position >= endPos) {
+				length = 0;
+				return nullptr;
+			}
+		}
+		length = endPos - position;
+		return pText + (position - startPos);
 	}
 	bool IsLeadByte(char ch) const {
 		const unsigned char uch = ch;
 		return
 			(uch >= 0x80) &&	// non-ASCII
 			(encodingType == EncodingType::dbcs) &&		// IsDBCSLeadByte only for DBCS
-			pAccess->IsDBCSLeadByte(ch);
+			(LEXILLA_COUNT(counters, documentCalls, 1), pAccess->IsDBCSLeadByte(ch));
 	}
 	EncodingType Encoding() const noexcept {
 		return encodingType;
 	}
 	bool Match(Sci_Position pos, const char *s) {
 		assert(s);
+		const size_t len = strlen(s);
+		Sci_Position available = 0;
+		const char *text = BufferPointerAt(pos, available);
+		if (text && (static_cast<size_t>(available) >= len)) {
+			return memcmp(text, s, len) == 0;
+		}
 		for (int i=0; *s; i++) {
 			if (*s != SafeGetCharAt(pos+i))
 				return false;
@@ -114,6 +257,15 @@ public:
 		return true;
 	}
 	bool MatchIgnoreCase(Sci_Position pos, const char *s);
+	Sci_Position CachedLine(Sci_Position position) const;
+	/** Forget the lines cached so LineStart, LineEnd and GetLine ask the document again. */
+	void DropLineCache() noexcept {
+		cacheFirstLine = 0;
+		cacheStarts = nullptr;
+		cacheEnds = nullptr;
+		cacheLines = 0;
+		cacheHint = 0;
+	}
 
 	// Get first len - 1 characters in range [startPos_, endPos_).
 	void GetRange(Sci_PositionU startPos_, Sci_PositionU endPos_, char *s, Sci_PositionU len);
@@ -121,11 +273,18 @@ public:
 	// Get all characters in range [startPos_, endPos_).
 	std::string GetRange(Sci_PositionU startPos_, Sci_PositionU endPos_);
 	std::string GetRangeLowered(Sci_PositionU startPos_, Sci_PositionU endPos_);
+	// As GetRange and GetRangeLowered but without a std::string. GetRangeView points into the
+	// accessor's buffer when the range is there, which is only valid until other text is read,
+	// and otherwise copies into Arena. GetRangeLoweredView always copies into Arena.
+	std::string_view GetRangeView(Sci_PositionU startPos_, Sci_PositionU endPos_);
+	std::string_view GetRangeLoweredView(Sci_PositionU startPos_, Sci_PositionU endPos_);
 
 	char StyleAt(Sci_Position position) const {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		return pAccess->StyleAt(position);
 	}
 	int StyleIndexAt(Sci_Position position) const {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		const unsigned char style = pAccess->StyleAt(position);
 		return style;
 	}
@@ -137,39 +296,97 @@ public:
 			const unsigned char style = styleBuf[index];
 			return style;
 		}
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		const unsigned char style = pAccess->StyleAt(position);
 		return style;
 	}
+	/** Find the lines touching [start, end) in one pass over the text so LineStart, LineEnd and
+	 * GetLine are answered without calling the document for them.
+	 * The cache is dropped when the document has line ends other than CR, LF and CR+LF.
+	 * It is held in the arena, so it is also dropped by SetArena, and CacheLines must be
+	 * called again after the arena is Reset before the cache is read. */
+	void CacheLines(Sci_Position start, Sci_Position end);
 	Sci_Position GetLine(Sci_Position position) const {
+		if (cacheLines > 0 && position >= cacheStarts[0] && position < cacheStarts[cacheLines]) {
+			if (position >= cacheStarts[cacheHint] && position < cacheStarts[cacheHint + 1]) {
+				return cacheFirstLine + cacheHint;
+			}
+			return CachedLine(position);
+		}
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		return pAccess->LineFromPosition(position);
 	}
 	Sci_Position LineStart(Sci_Position line) const {
+		const Sci_Position index = line - cacheFirstLine;
+		if (cacheLines > 0 && index >= 0 && index <= static_cast<Sci_Position>(cacheLines)) {
+			return cacheStarts[index];
+		}
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		return pAccess->LineStart(line);
 	}
 	Sci_Position LineEnd(Sci_Position line) const {
+		const Sci_Position index = line - cacheFirstLine;
+		if (index >= 0 && index < static_cast<Sci_Position>(cacheLines)) {
+			return cacheEnds[index];
+		}
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		return pAccess->LineEnd(line);
 	}
 	int LevelAt(Sci_Position line) const {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		return pAccess->GetLevel(line);
 	}
 	Sci_Position Length() const noexcept {
 		return lenDoc;
 	}
+	/** Compare styles with those already in the document before writing them, so unchanged
+	 * runs are not sent and GetChangedRange reports what actually changed.
+	 * The document's styles are read a block at a time, with one call for each block when the document
+	 * was lent with SetStyleRange and a StyleAt call per position otherwise. */
+	void SetCompareStyles(bool compareStyles_) noexcept {
+		compareStyles = compareStyles_;
+	}
+	/** Read the document's styles through styleRange_, which is ignored unless it is the document this
+	 * accessor reads, as when the host lends it with privateCallStyleRange. */
+	void SetStyleRange(const IDocumentStyleRange *styleRange_) noexcept {
+		const bool same = styleRange_ && (static_cast<const Scintilla::IDocument *>(styleRange_) == pAccess);
+		styleRange = same ? styleRange_ : nullptr;
+	}
+	/** The smallest range [start, end) whose styles changed, false when none did or when
+	 * SetCompareStyles was not turned on. */
+	bool GetChangedRange(Sci_Position &start, Sci_Position &end) const noexcept {
+		if (changedStart >= changedEnd) {
+			return false;
+		}
+		start = changedStart;
+		end = changedEnd;
+		return true;
+	}
 	void Flush() {
 		if (validLen > 0) {
-			pAccess->SetStyles(validLen, styleBuf);
+			LEXILLA_TRACE_SCOPE("Flush", nullptr, startPosStyling, startPosStyling + validLen);
+			LEXILLA_COUNT(counters, flushes, 1);
+			if (compareStyles) {
+				SetStylesChanged(validLen, styleBuf, 0);
+			} else {
+				LEXILLA_COUNT(counters, documentCalls, 1);
+				pAccess->SetStyles(validLen, styleBuf);
+			}
 			startPosStyling += validLen;
 			validLen = 0;
 		}
 	}
 	int GetLineState(Sci_Position line) const {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		return pAccess->GetLineState(line);
 	}
 	int SetLineState(Sci_Position line, int state) {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		return pAccess->SetLineState(line, state);
 	}
 	// Style setting
 	void StartAt(Sci_PositionU start) {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		pAccess->StartStyling(start);
 		startPosStyling = start;
 	}
@@ -186,31 +403,48 @@ public:
 			if (pos < startSeg) {
 				return;
 			}
-
-			if (validLen + (pos - startSeg + 1) >= bufferSize)
-				Flush();
-			const unsigned char attr = chAttr & 0xffU;
-			if (validLen + (pos - startSeg + 1) >= bufferSize) {
-				// Too big for buffer so send directly
-				pAccess->SetStyleFor(pos - startSeg + 1, attr);
+			ColourRun(startSeg, pos - startSeg + 1, chAttr);
+		}
+	}
+	/** Style length positions from start, which must be the start of the current segment.
+	 * The next segment starts after the run. */
+	void ColourRun(Sci_PositionU start, Sci_PositionU length, int chAttr) {
+		assert(start == startSeg);
+		const unsigned char attr = chAttr & 0xffU;
+		if (validLen + length >= bufferSize) {
+			Flush();
+		}
+		if (length >= bufferSize) {
+			// Too big for buffer so send directly
+			LEXILLA_TRACE_SCOPE("ColourTo", nullptr, start, start + length);
+			LEXILLA_COUNT(counters, styleForFallbacks, 1);
+			if (compareStyles) {
+				SetStylesChanged(length, nullptr, attr);
 			} else {
-				for (Sci_PositionU i = startSeg; i <= pos; i++) {
-					assert((startPosStyling + validLen) < Length());
-					styleBuf[validLen++] = attr;
-				}
+				LEXILLA_COUNT(counters, documentCalls, 1);
+				pAccess->SetStyleFor(length, attr);
 			}
+			startPosStyling += length;
+		} else {
+			assert((startPosStyling + validLen + static_cast<Sci_Position>(length)) <= Length());
+			memset(styleBuf + validLen, attr, length);
+			validLen += length;
 		}
-		startSeg = pos+1;
+		startSeg = start + length;
 	}
 	void SetLevel(Sci_Position line, int level) {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		pAccess->SetLevel(line, level);
 	}
 	void IndicatorFill(Sci_Position start, Sci_Position end, int indicator, int value) {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		pAccess->DecorationSetCurrentIndicator(indicator);
 		pAccess->DecorationFillRange(start, value, end - start);
+		LEXILLA_COUNT(counters, documentCalls, 1);
 	}
 
 	void ChangeLexerState(Sci_Position start, Sci_Position end) {
+		LEXILLA_COUNT(counters, documentCalls, 1);
 		pAccess->ChangeLexerState(start, end);
 	}
 };
@@ -0,0 +1,150 @@
+// Scintilla source code edit control
+/** @file LexArena.h
+ ** Bump allocator for temporary storage used while lexing.
+ ** Memory is handed out from large blocks and is all released at once by Reset, normally at the
+ ** end of each Lex, so copies of words and lines made while lexing do not each call the heap.
+ ** After Reset the arena keeps one block big enough for everything allocated before, so lexing a
+ ** similar range again makes no heap allocations.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXARENA_H
+#define LEXARENA_H
+
+namespace Lexilla {
+
+class LexArena {
+	struct Block {
+		std::unique_ptr<char[]> data;
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	// Bytes used in the last block
+	size_t used = 0;
+	// Size of the first block allocated after a Reset that freed several blocks
+	size_t reserved = 0;
+	static constexpr size_t minimumBlock = 0x1000;
+
+	char *Fit(size_t size, size_t alignment) noexcept {
+		if (blocks.empty()) {
+			return nullptr;
+		}
+		const Block &block = blocks.back();
+		const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.data.get());
+		const size_t offset = static_cast<size_t>(((base + used + alignment - 1) & ~(alignment - 1)) - base);
+		if ((offset > block.size) || (size > block.size - offset)) {
+			return nullptr;
+		}
+		used = offset + size;
+		return block.data.get() + offset;
+	}
+
+public:
+	LexArena() noexcept = default;
+	// Deleted so LexArena objects can not be copied.
+	LexArena(const LexArena &) = delete;
+	LexArena(LexArena &&) = delete;
+	LexArena &operator=(const LexArena &) = delete;
+	LexArena &operator=(LexArena &&) = delete;
+	~LexArena() = default;
+
+	// Uninitialised memory for size bytes with alignment, a power of 2.
+	void *Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		char *memory = Fit(size, alignment);
+		if (!memory) {
+			size_t blockSize = std::max(minimumBlock, reserved);
+			if (!blocks.empty()) {
+				blockSize = std::max(blockSize, blocks.back().size * 2);
+			}
+			blockSize = std::max(blockSize, size + alignment);
+			blocks.push_back(Block{ std::unique_ptr<char[]>(new char[blockSize]), blockSize });
+			used = 0;
+			reserved = 0;
+			memory = Fit(size, alignment);
+		}
+		return memory;
+	}
+
+	// Uninitialised array of count T, which are never destroyed so must not need it.
+	template <typename T>
+	T *AllocateArray(size_t count) {
+		static_assert(std::is_trivially_destructible_v<T>, "LexArena does not destroy objects");
+		return static_cast<T *>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// A copy of text followed by a NUL.
+	std::string_view Copy(std::string_view text) {
+		char *copy = AllocateArray<char>(text.length() + 1);
+		text.copy(copy, text.length());
+		copy[text.length()] = '\0';
+		return std::string_view(copy, text.length());
+	}
+
+	// Release everything allocated, invalidating it, and keep one block for later allocations.
+	void Reset() noexcept {
+		if (blocks.size() > 1) {
+			size_t total = 0;
+			for (const Block &block : blocks) {
+				total += block.size;
+			}
+			blocks.clear();
+			reserved = total;
+		}
+		used = 0;
+	}
+
+	// Reset and free the blocks when they hold more than maximum bytes, so an arena grown by one large
+	// range does not keep that memory while idle. Later allocations start again from a small block.
+	void Trim(size_t maximum) noexcept {
+		Reset();
+		if (Capacity() > maximum) {
+			blocks.clear();
+		}
+		reserved = std::min(reserved, maximum);
+	}
+
+	// Bytes held in blocks, whether allocated or not
+	size_t Capacity() const noexcept {
+		size_t total = 0;
+		for (const Block &block : blocks) {
+			total += block.size;
+		}
+		return total;
+	}
+};
+
+// Standard library allocator drawing from a LexArena so containers like std::basic_string can
+// grow without calling the heap. Memory is only returned when the arena is Reset, so a container
+// must not be used after that.
+template <typename T>
+class ArenaAllocator {
+	LexArena *arena;
+	template <typename U>
+	friend class ArenaAllocator;
+public:
+	using value_type = T;
+	explicit ArenaAllocator(LexArena &arena_) noexcept : arena(&arena_) {
+	}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.arena) {
+	}
+	T *allocate(size_t n) {
+		return static_cast<T *>(arena->Allocate(sizeof(T) * n, alignof(T)));
+	}
+	void deallocate(T *, size_t) noexcept {
+	}
+	template <typename U>
+	bool operator==(const ArenaAllocator<U> &other) const noexcept {
+		return arena == other.arena;
+	}
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U> &other) const noexcept {
+		return arena != other.arena;
+	}
+};
+
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+}
+
+#endif
@@ -20,29 +20,24 @@ enum CharacterCategory {
 	ccCc, ccCf, ccCs, ccCo, ccCn
 };
 
-CharacterCategory CategoriseCharacter(int character);
+CharacterCategory CategoriseCharacter(int character) noexcept;
 
 // Common definitions of allowable characters in identifiers from UAX #31.
-bool IsIdStart(int character);
-bool IsIdContinue(int character);
-bool IsXidStart(int character);
-bool IsXidContinue(int character);
+bool IsIdStart(int character) noexcept;
+bool IsIdContinue(int character) noexcept;
+bool IsXidStart(int character) noexcept;
+bool IsXidContinue(int character) noexcept;
 
+// A view over the generated table of categories so there is no per-instance data to build.
 class CharacterCategoryMap {
-private:
-	std::vector<unsigned char> dense;
 public:
-	CharacterCategoryMap();
-	CharacterCategory CategoryFor(int character) const {
-		if (static_cast<size_t>(character) < dense.size()) {
-			return static_cast<CharacterCategory>(dense[character]);
-		} else {
-			// binary search through ranges
-			return CategoriseCharacter(character);
-		}
+	constexpr CharacterCategoryMap() noexcept = default;
+	CharacterCategory CategoryFor(int character) const noexcept {
+		return CategoriseCharacter(character);
 	}
 	int Size() const noexcept;
-	void Optimize(int countCharacters);
+	// Retained for compatibility: all characters are always available
+	void Optimize(int countCharacters) noexcept;
 };
 
 }
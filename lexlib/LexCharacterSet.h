@@ -12,6 +12,7 @@
 #include <algorithm>
 
 #include "LexillaCompat.h"
+#include "LexScan.h"
 
 namespace Lexilla {
 
@@ -19,6 +20,26 @@ template<int N>
 class CharacterSetArray {
 	unsigned char bset[(N-1)/8 + 1] = {};
 	bool valueAfter = false;
+	// For sets of 0x80 or 0x100 characters, the set as rows indexed by low nibble for ScanSet to test many bytes
+	// at once: bit h of nibbles[half][l] is character (half << 7) | (h << 4) | l.
+	// For 0x80 characters the second half is valueAfter.
+	ScanNibbles nibbles = {};
+
+	static constexpr bool scanSimd = (N == 0x80) || (N == 0x100);
+
+	// First position from p before end where the byte being in the set differs from inSet
+	const char *Scan(const char *p, const char *end, bool inSet, bool stopAtNonASCII) const noexcept {
+		if (scanSimd) {
+			return ScanSet(p, end, nibbles, inSet, stopAtNonASCII);
+		}
+		for (; p < end; p++) {
+			const unsigned char uch = *p;
+			if ((stopAtNonASCII && (uch >= 0x80)) || (Contains(static_cast<int>(uch)) != inSet))
+				break;
+		}
+		return p;
+	}
+
 public:
 	enum setBase {
 		setNone=0,
@@ -30,6 +51,11 @@ public:
 	};
 	CharacterSetArray(setBase base=setNone, const char *initialSet="", bool valueAfter_=false) noexcept {
 		valueAfter = valueAfter_;
+		if ((N == 0x80) && valueAfter) {
+			for (unsigned char &row : nibbles[1]) {
+				row = 0xff;
+			}
+		}
 		AddString(initialSet);
 		if (base & setLower)
 			AddString("abcdefghijklmnopqrstuvwxyz");
@@ -51,6 +77,9 @@ public:
 		assert(val >= 0);
 		assert(val < N);
 		bset[val >> 3] |= 1 << (val & 7);
+		if (scanSimd) {
+			nibbles[(val >> 7) & 1][val & 0xf] |= static_cast<unsigned char>(1 << ((val >> 4) & 7));
+		}
 	}
 	void AddString(const char *setToAdd) noexcept {
 		for (const char *cp=setToAdd; *cp; cp++) {
@@ -70,6 +99,16 @@ public:
 		const unsigned char uch = ch;
 		return Contains(uch);
 	}
+	/** First position in [begin, end) whose byte is not in the set, or end.
+	 * Bytes >= 0x80 also end the scan when stopAtNonASCII is true, as for UTF-8 text that should be decoded.
+	 * Sets of 0x80 or 0x100 characters test many bytes at a time with the best kernels the processor supports. */
+	const char *ScanWhile(const char *begin, const char *end, bool stopAtNonASCII=false) const noexcept {
+		return Scan(begin, end, true, stopAtNonASCII);
+	}
+	/** First position in [begin, end) whose byte is in the set, or end. */
+	const char *ScanUntil(const char *begin, const char *end, bool stopAtNonASCII=false) const noexcept {
+		return Scan(begin, end, false, stopAtNonASCII);
+	}
 };
 
 using CharacterSet = CharacterSetArray<0x80>;
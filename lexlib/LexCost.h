@@ -0,0 +1,91 @@
+// Scintilla source code edit control
+/** @file LexCost.h
+ ** Running estimate of the time a lexer takes for each byte and line of a document, so that a host
+ ** lexing in idle time can size each range to a time budget instead of guessing one chunk size for
+ ** lexers that differ in cost by 10 times or more.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXCOST_H
+#define LEXCOST_H
+
+namespace Lexilla {
+
+/** Time, bytes and lines of recent Lex calls added up with older calls weighing less, so the estimate
+ * follows changes in the kind of text being lexed. */
+class LexCost {
+	// Weight kept by the calls before each new one
+	static constexpr double decay = 0.75;
+	double nanoseconds = 0.0;
+	double bytes = 0.0;
+	double lines = 0.0;
+	int samples = 0;
+public:
+	// Assumed before anything has been lexed: 50 MB/s
+	static constexpr double defaultNanosecondsPerByte = 20.0;
+
+	void Clear() noexcept {
+		nanoseconds = 0.0;
+		bytes = 0.0;
+		lines = 0.0;
+		samples = 0;
+	}
+	/// Adds a Lex that styled bytesStyled bytes beginning linesStyled lines in nanosecondsTaken
+	void Add(unsigned long long nanosecondsTaken, Sci_Position bytesStyled, Sci_Position linesStyled) noexcept {
+		if (bytesStyled <= 0) {
+			return;
+		}
+		nanoseconds = nanoseconds * decay + static_cast<double>(nanosecondsTaken);
+		bytes = bytes * decay + static_cast<double>(bytesStyled);
+		lines = lines * decay + static_cast<double>(linesStyled);
+		samples++;
+	}
+	int Samples() const noexcept {
+		return samples;
+	}
+	double NanosecondsPerByte() const noexcept {
+		return (samples > 0) ? nanoseconds / bytes : defaultNanosecondsPerByte;
+	}
+	/// 0 when not known
+	double NanosecondsPerLine() const noexcept {
+		return (lines > 0.0) ? nanoseconds / lines : 0.0;
+	}
+	/// Bytes expected to be lexed in milliseconds, at least 1
+	Sci_Position BytesFor(int milliseconds) const noexcept {
+		// Calls too quick to time cost next to nothing
+		const double expected = milliseconds * 1.0e6 / std::max(NanosecondsPerByte(), 1.0e-6);
+		return static_cast<Sci_Position>(std::clamp(expected, 1.0, 1.0e9));
+	}
+	/// Lines expected to be lexed in milliseconds, at least 1, or -1 when not known
+	Sci_Position LinesFor(int milliseconds) const noexcept {
+		if (lines <= 0.0) {
+			return -1;
+		}
+		const double expected = milliseconds * 1.0e6 / std::max(NanosecondsPerLine(), 1.0e-6);
+		return static_cast<Sci_Position>(std::clamp(expected, 1.0, 1.0e9));
+	}
+};
+
+/** The range to lex next so that it takes about a time budget, from the cost of the lexer's recent Lex
+ * calls on the document. Fill in document, start and milliseconds then call
+ * ILexer5::PrivateCall(privateCallLexCost, pointer to a LexCostQuery), which fills in the rest and returns
+ * the pointer, or returns nullptr from lexers that do not estimate their cost. Pass the range to Lex, or
+ * to LexerSimple::LexBudgeted with the same milliseconds to stop at a line start if the text is slower
+ * than expected. */
+struct LexCostQuery {
+	Scintilla::IDocument *document = nullptr;
+	Sci_Position start = 0;
+	int milliseconds = 5;
+	// At a line start after start, or the end of the document, never more than one line past the budget
+	Sci_Position end = 0;
+	double nanosecondsPerByte = 0.0;
+	double nanosecondsPerLine = 0.0;
+	// Lex calls the estimate is from, 0 when it is the default
+	int samples = 0;
+};
+
+constexpr int privateCallLexCost = 0x4C585231;	// "LXR1"
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+// Scintilla source code edit control
+/** @file LexCounters.h
+ ** Counters of the work done by a lexer, collected when built with LEXILLA_COUNTERS defined.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXCOUNTERS_H
+#define LEXCOUNTERS_H
+
+namespace Lexilla {
+
+/** Work done by the last Lex of a LexerSimple.
+ * Retrieve with ILexer5::PrivateCall(privateCallLexCounters, pointer to a LexCounters)
+ * which copies the counters and returns the pointer, or returns nullptr when the counters
+ * were not compiled in. */
+struct LexCounters {
+	unsigned long long fills = 0;			// Refills of the LexAccessor text window
+	unsigned long long bytesCopied = 0;		// Bytes copied from the document into the window
+	unsigned long long flushes = 0;			// Style buffers sent to the document
+	unsigned long long styleForFallbacks = 0;	// Runs too long for the style buffer, sent with SetStyleFor
+	unsigned long long documentCalls = 0;		// IDocument methods called by LexAccessor and StyleContext
+	unsigned long long lines = 0;			// Lines in the range lexed
+	unsigned long long classificationHits = 0;	// Lines whose classification was found in a lexer's cache
+	unsigned long long classificationMisses = 0;	// Lines looked up in that cache and classified
+	unsigned long long nanoseconds = 0;		// Time spent in Lex
+};
+
+constexpr int privateCallLexCounters = 0x4C584331;	// "LXC1"
+
+}
+
+#if defined(LEXILLA_COUNTERS)
+#define LEXILLA_COUNT(counters, field, amount) (((counters) != nullptr) ? (void)((counters)->field += (amount)) : (void)0)
+#else
+#define LEXILLA_COUNT(counters, field, amount) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+// Scintilla source code edit control
+/** @file LexInvalidation.h
+ ** How much of a document a change to a property or word list restyles.
+ ** Lexers declare properties that only change how styles are displayed, or that only change the styles of
+ ** some text, so changing an option of a large document does not relex all of it.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXINVALIDATION_H
+#define LEXINVALIDATION_H
+
+namespace Lexilla {
+
+enum class Restyle {
+	all,		// Restyle the whole document, as for properties that are not declared
+	none,		// No style depends on the value so nothing is restyled
+	dependent,	// Restyle from the first position marked with the scope's dependency by the last Lex
+};
+
+/** Declares what changing the property key, or the word list wordList when key is nullptr, restyles.
+ * A LexerModule is given an array of these ended by one with a nullptr key and a wordList of -1. */
+struct PropertyScope {
+	const char *key;
+	int wordList;
+	Restyle restyle;
+	int dependency;
+};
+
+/** The first position of the text styled by the last Lex of each line whose styles depend on a value,
+ * kept by a LexerSimple and lent to the Accessor of each Lex.
+ * Lexers Mark the start of each line that would be styled differently were the value changed.
+ * Positions are those of the text at the last Lex of each line. Scintilla restyles from any change
+ * to the text before they are used, so a stale position never restyles less than needed. */
+class LexInvalidation {
+public:
+	static constexpr int maxDependencies = 8;
+private:
+	Sci_Position first[maxDependencies];
+public:
+	LexInvalidation() noexcept {
+		Clear();
+	}
+
+	// The lines from startPos are being styled again so forget what was marked there
+	void Start(Sci_Position startPos) noexcept {
+		for (Sci_Position &position : first) {
+			if (position >= startPos) {
+				position = -1;
+			}
+		}
+	}
+
+	void Mark(int dependency, Sci_Position position) noexcept {
+		if ((dependency >= 0) && (dependency < maxDependencies)) {
+			if ((first[dependency] < 0) || (position < first[dependency])) {
+				first[dependency] = position;
+			}
+		}
+	}
+
+	// Add the marks of other, such as those of a part styled by another thread
+	void Merge(const LexInvalidation &other) noexcept {
+		for (int dependency = 0; dependency < maxDependencies; dependency++) {
+			if (other.first[dependency] >= 0) {
+				Mark(dependency, other.first[dependency]);
+			}
+		}
+	}
+
+	// -1 when no text depends on dependency
+	Sci_Position First(int dependency) const noexcept {
+		if ((dependency >= 0) && (dependency < maxDependencies)) {
+			return first[dependency];
+		}
+		return -1;
+	}
+
+	// What a change to a value with scope, which may be nullptr for one that is not declared, restyles:
+	// -1 for nothing, otherwise the first position to restyle
+	Sci_Position FirstInvalidated(const PropertyScope *scope) const noexcept {
+		if (!scope) {
+			return 0;
+		}
+		switch (scope->restyle) {
+		case Restyle::none:
+			return -1;
+		case Restyle::dependent:
+			return First(scope->dependency);
+		default:
+			return 0;
+		}
+	}
+
+	void Clear() noexcept {
+		for (Sci_Position &position : first) {
+			position = -1;
+		}
+	}
+};
+
+/** The scope of key, or of wordList when key is nullptr, in scopes, which may be nullptr, or nullptr when
+ * it is not declared. */
+inline const PropertyScope *FindScope(const PropertyScope *scopes, const char *key, int wordList) noexcept {
+	for (const PropertyScope *scope = scopes; scope && (scope->key || (scope->wordList >= 0)); scope++) {
+		const bool matches = key ? (scope->key && (strcmp(scope->key, key) == 0)) :
+			(!scope->key && (scope->wordList == wordList));
+		if (matches) {
+			return scope;
+		}
+	}
+	return nullptr;
+}
+
+}
+
+#endif
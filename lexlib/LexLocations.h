@@ -0,0 +1,82 @@
+// Scintilla source code edit control
+/** @file LexLocations.h
+ ** Side index of the file locations named by diagnostic lines, filled while lexing.
+ ** Lexers of compiler and tool output that already find the file, line and column of a diagnostic
+ ** to choose its style record them here so an application can list the places to jump to without
+ ** parsing the output again.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXLOCATIONS_H
+#define LEXLOCATIONS_H
+
+namespace Lexilla {
+
+struct LexLocation {
+	Sci_Position line = 0;		// Line of the document holding the diagnostic
+	int style = 0;			// Style of that line
+	Sci_Position pathStart = 0;	// The file's path is the text in [pathStart, pathEnd)
+	Sci_Position pathEnd = 0;
+	int lineNumber = 0;		// Line and column in the file, 0 when not given
+	int column = 0;
+};
+
+/** Locations in line order kept by a LexerSimple when lexer.locations is set.
+ * Retrieve with ILexer5::PrivateCall(privateCallLexLocations, nullptr) which returns a pointer to the
+ * LexLocations, valid until the next Lex or Release, or nullptr when none have been collected.
+ * Each Lex replaces the locations of the lines it styled, so positions are those of the text at the
+ * last Lex of each line. */
+class LexLocations {
+	std::vector<LexLocation> locations;
+	// Added by the current Lex and not yet committed
+	std::vector<LexLocation> added;
+public:
+	// Called by lexers in document order.
+	void Add(const LexLocation &location) {
+		added.push_back(location);
+	}
+
+	// Replace the locations of lines [lineFirst, lineLast] with those added since the last Commit.
+	// Appending to the end, as when styling output as it arrives, only moves the new locations.
+	void Commit(Sci_Position lineFirst, Sci_Position lineLast) {
+		auto lineLess = [](const LexLocation &location, Sci_Position line) noexcept {
+			return location.line < line;
+		};
+		const auto first = std::lower_bound(locations.begin(), locations.end(), lineFirst, lineLess);
+		const auto last = std::lower_bound(first, locations.end(), lineLast + 1, lineLess);
+		const auto position = locations.erase(first, last);
+		locations.insert(position, added.begin(), added.end());
+		added.clear();
+	}
+
+	void Clear() noexcept {
+		locations.clear();
+		added.clear();
+	}
+
+	size_t Count() const noexcept {
+		return locations.size();
+	}
+
+	const LexLocation &Get(size_t index) const {
+		return locations.at(index);
+	}
+
+	size_t MemoryUse() const noexcept {
+		return (locations.capacity() + added.capacity()) * sizeof(LexLocation);
+	}
+
+	// Index of the first location on or after line, Count() when there is none
+	size_t Find(Sci_Position line) const noexcept {
+		return std::lower_bound(locations.begin(), locations.end(), line,
+			[](const LexLocation &location, Sci_Position lineFind) noexcept {
+				return location.line < lineFind;
+			}) - locations.begin();
+	}
+};
+
+constexpr int privateCallLexLocations = 0x4C584C31;	// "LXL1"
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+// Scintilla source code edit control
+/** @file LexMemory.h
+ ** Bytes of memory held by a lexer instance, by the structure holding them.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXMEMORY_H
+#define LEXMEMORY_H
+
+namespace Lexilla {
+
+/** Memory held by one lexer, so the cost of each open document's lexer can be attributed.
+ * Retrieve with ILexer5::PrivateCall(privateCallLexMemory, pointer to a LexMemory) which fills in
+ * the figures and returns the pointer, or returns nullptr from lexers that do not report memory.
+ * Data shared between lexers, such as the words of identical word lists, is divided between them.
+ * Figures include the bookkeeping of standard containers only approximately. */
+struct LexMemory {
+	size_t lexer = 0;		// The lexer object itself
+	size_t wordLists = 0;		// WordList arrays and hash tables
+	size_t properties = 0;		// PropSetSimple entries
+	size_t options = 0;		// OptionSet values
+	size_t subStyles = 0;		// SubStyles classifiers
+	size_t sparseStates = 0;	// SparseState vectors
+	size_t characterCategories = 0;	// CharacterCategoryMap objects, their table is static and shared
+	size_t other = 0;		// Scratch memory and anything else the lexer keeps
+	size_t Total() const noexcept {
+		return lexer + wordLists + properties + options + subStyles + sparseStates + characterCategories + other;
+	}
+};
+
+constexpr int privateCallLexMemory = 0x4C584D31;	// "LXM1"
+
+}
+
+#endif
@@ -0,0 +1,517 @@
+// Scintilla source code edit control
+/** @file LexScan.cxx
+ ** Kernels for scanning text many bytes at a time, shared by lexers.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define LEXILLA_SCAN_X86
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LEXILLA_SCAN_NEON
+#endif
+
+#include "LexScan.h"
+
+using namespace Lexilla;
+
+namespace {
+
+// Kernels for instruction sets beyond the build's baseline are compiled for them alone and only called when
+// the processor has them
+#if defined(__GNUC__) || defined(__clang__)
+#define LEXILLA_TARGET(features) __attribute__((target(features)))
+#else
+#define LEXILLA_TARGET(features)
+#endif
+
+// Index of the lowest set bit of mask, which is not 0
+inline unsigned int LowestBit(uint32_t mask) noexcept {
+#if defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+constexpr bool InNibbles(const ScanNibbles &nibbles, unsigned char uch) noexcept {
+	return (nibbles[uch >> 7][uch & 0xf] >> ((uch >> 4) & 7)) & 1;
+}
+
+// Scalar kernels, also used for what is left after the last whole block
+
+const char *FindAny2Scalar(const char *p, const char *end, char a, char b) noexcept {
+	while ((p < end) && (*p != a) && (*p != b)) {
+		p++;
+	}
+	return p;
+}
+
+const char *FindAny3Scalar(const char *p, const char *end, char a, char b, char c) noexcept {
+	while ((p < end) && (*p != a) && (*p != b) && (*p != c)) {
+		p++;
+	}
+	return p;
+}
+
+const char *FindNonASCIIScalar(const char *p, const char *end) noexcept {
+	for (; end - p >= 8; p += 8) {
+		uint64_t word = 0;
+		memcpy(&word, p, sizeof(word));
+		if (word & UINT64_C(0x8080808080808080)) {
+			break;
+		}
+	}
+	while ((p < end) && (static_cast<unsigned char>(*p) < 0x80)) {
+		p++;
+	}
+	return p;
+}
+
+const char *ScanSetScalar(const char *p, const char *end, const ScanNibbles &nibbles, bool inSet,
+	bool stopAtNonASCII) noexcept {
+	for (; p < end; p++) {
+		const unsigned char uch = *p;
+		if ((stopAtNonASCII && (uch >= 0x80)) || (InNibbles(nibbles, uch) != inSet)) {
+			break;
+		}
+	}
+	return p;
+}
+
+size_t CompareNScalar(const char *a, const char *b, size_t length) noexcept {
+	size_t i = 0;
+	while ((i < length) && (a[i] == b[i])) {
+		i++;
+	}
+	return i;
+}
+
+#if defined(LEXILLA_SCAN_X86)
+
+// 16 bytes at a time
+
+LEXILLA_TARGET("sse2")
+const char *FindAny2SSE2(const char *p, const char *end, char a, char b) noexcept {
+	const __m128i va = _mm_set1_epi8(a);
+	const __m128i vb = _mm_set1_epi8(b);
+	for (; end - p >= 16; p += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const uint32_t found = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+		if (found) {
+			return p + LowestBit(found);
+		}
+	}
+	return FindAny2Scalar(p, end, a, b);
+}
+
+LEXILLA_TARGET("sse2")
+const char *FindAny3SSE2(const char *p, const char *end, char a, char b, char c) noexcept {
+	const __m128i va = _mm_set1_epi8(a);
+	const __m128i vb = _mm_set1_epi8(b);
+	const __m128i vc = _mm_set1_epi8(c);
+	for (; end - p >= 16; p += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const __m128i any = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+			_mm_cmpeq_epi8(v, vc));
+		const uint32_t found = _mm_movemask_epi8(any);
+		if (found) {
+			return p + LowestBit(found);
+		}
+	}
+	return FindAny3Scalar(p, end, a, b, c);
+}
+
+LEXILLA_TARGET("sse2")
+const char *FindNonASCIISSE2(const char *p, const char *end) noexcept {
+	for (; end - p >= 16; p += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const uint32_t found = _mm_movemask_epi8(v);
+		if (found) {
+			return p + LowestBit(found);
+		}
+	}
+	return FindNonASCIIScalar(p, end);
+}
+
+LEXILLA_TARGET("sse2")
+size_t CompareNSSE2(const char *a, const char *b, size_t length) noexcept {
+	size_t i = 0;
+	for (; length - i >= 16; i += 16) {
+		const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		const uint32_t differ = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xffff;
+		if (differ) {
+			return i + LowestBit(differ);
+		}
+	}
+	return i + CompareNScalar(a + i, b + i, length - i);
+}
+
+// The byte at each position of v is looked up in the nibble rows with pshufb
+LEXILLA_TARGET("ssse3")
+const char *ScanSetSSSE3(const char *p, const char *end, const ScanNibbles &nibbles, bool inSet,
+	bool stopAtNonASCII) noexcept {
+	const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+	const __m128i bitTable = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+	const __m128i rowsLow = _mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[0]));
+	const __m128i rowsHigh = _mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[1]));
+	for (; end - p >= 16; p += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const __m128i lowNibble = _mm_and_si128(v, nibbleMask);
+		const __m128i bit = _mm_shuffle_epi8(bitTable, _mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+		const __m128i high = _mm_cmplt_epi8(v, _mm_setzero_si128());
+		const __m128i rows = _mm_or_si128(_mm_and_si128(high, _mm_shuffle_epi8(rowsHigh, lowNibble)),
+			_mm_andnot_si128(high, _mm_shuffle_epi8(rowsLow, lowNibble)));
+		uint32_t stops = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(rows, bit), bit));
+		if (inSet)
+			stops ^= 0xffff;
+		if (stopAtNonASCII)
+			stops |= _mm_movemask_epi8(high);
+		if (stops) {
+			return p + LowestBit(stops);
+		}
+	}
+	return ScanSetScalar(p, end, nibbles, inSet, stopAtNonASCII);
+}
+
+// 32 bytes at a time, leaving the rest to the 16 byte kernels
+
+LEXILLA_TARGET("avx2")
+const char *FindAny2AVX2(const char *p, const char *end, char a, char b) noexcept {
+	const __m256i va = _mm256_set1_epi8(a);
+	const __m256i vb = _mm256_set1_epi8(b);
+	for (; end - p >= 32; p += 32) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		const uint32_t found = _mm256_movemask_epi8(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)));
+		if (found) {
+			return p + LowestBit(found);
+		}
+	}
+	return FindAny2SSE2(p, end, a, b);
+}
+
+LEXILLA_TARGET("avx2")
+const char *FindAny3AVX2(const char *p, const char *end, char a, char b, char c) noexcept {
+	const __m256i va = _mm256_set1_epi8(a);
+	const __m256i vb = _mm256_set1_epi8(b);
+	const __m256i vc = _mm256_set1_epi8(c);
+	for (; end - p >= 32; p += 32) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		const __m256i any = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+			_mm256_cmpeq_epi8(v, vc));
+		const uint32_t found = _mm256_movemask_epi8(any);
+		if (found) {
+			return p + LowestBit(found);
+		}
+	}
+	return FindAny3SSE2(p, end, a, b, c);
+}
+
+LEXILLA_TARGET("avx2")
+const char *FindNonASCIIAVX2(const char *p, const char *end) noexcept {
+	for (; end - p >= 32; p += 32) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		const uint32_t found = _mm256_movemask_epi8(v);
+		if (found) {
+			return p + LowestBit(found);
+		}
+	}
+	return FindNonASCIISSE2(p, end);
+}
+
+LEXILLA_TARGET("avx2")
+size_t CompareNAVX2(const char *a, const char *b, size_t length) noexcept {
+	size_t i = 0;
+	for (; length - i >= 32; i += 32) {
+		const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+		const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+		const uint32_t differ = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+		if (differ) {
+			return i + LowestBit(differ);
+		}
+	}
+	return i + CompareNSSE2(a + i, b + i, length - i);
+}
+
+// vpshufb looks up each 128-bit lane separately so the rows are repeated in both lanes
+LEXILLA_TARGET("avx2")
+const char *ScanSetAVX2(const char *p, const char *end, const ScanNibbles &nibbles, bool inSet,
+	bool stopAtNonASCII) noexcept {
+	const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+	const __m256i bitTable = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+		1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+	const __m256i rowsLow = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[0])));
+	const __m256i rowsHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(nibbles[1])));
+	for (; end - p >= 32; p += 32) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		const __m256i lowNibble = _mm256_and_si256(v, nibbleMask);
+		const __m256i bit = _mm256_shuffle_epi8(bitTable, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibbleMask));
+		const __m256i high = _mm256_cmpgt_epi8(_mm256_setzero_si256(), v);
+		const __m256i rows = _mm256_or_si256(_mm256_and_si256(high, _mm256_shuffle_epi8(rowsHigh, lowNibble)),
+			_mm256_andnot_si256(high, _mm256_shuffle_epi8(rowsLow, lowNibble)));
+		uint32_t stops = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(rows, bit), bit));
+		if (inSet)
+			stops = ~stops;
+		if (stopAtNonASCII)
+			stops |= _mm256_movemask_epi8(high);
+		if (stops) {
+			return p + LowestBit(stops);
+		}
+	}
+	return ScanSetSSSE3(p, end, nibbles, inSet, stopAtNonASCII);
+}
+
+#endif
+
+#if defined(LEXILLA_SCAN_NEON)
+
+// Four bits of the result for each byte of v, which are each all ones or all zeros
+inline uint64_t NibbleMask(uint8x16_t v) noexcept {
+	return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+
+// Index of the byte whose 4 bits are the lowest set in mask, which is not 0
+inline unsigned int LowestByte(uint64_t mask) noexcept {
+#if defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward64(&index, mask);
+	return index / 4;
+#else
+	return __builtin_ctzll(mask) / 4;
+#endif
+}
+
+const char *FindAny2NEON(const char *p, const char *end, char a, char b) noexcept {
+	const uint8x16_t va = vdupq_n_u8(a);
+	const uint8x16_t vb = vdupq_n_u8(b);
+	for (; end - p >= 16; p += 16) {
+		const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+		const uint64_t found = NibbleMask(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)));
+		if (found) {
+			return p + LowestByte(found);
+		}
+	}
+	return FindAny2Scalar(p, end, a, b);
+}
+
+const char *FindAny3NEON(const char *p, const char *end, char a, char b, char c) noexcept {
+	const uint8x16_t va = vdupq_n_u8(a);
+	const uint8x16_t vb = vdupq_n_u8(b);
+	const uint8x16_t vc = vdupq_n_u8(c);
+	for (; end - p >= 16; p += 16) {
+		const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+		const uint8x16_t any = vorrq_u8(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)), vceqq_u8(v, vc));
+		const uint64_t found = NibbleMask(any);
+		if (found) {
+			return p + LowestByte(found);
+		}
+	}
+	return FindAny3Scalar(p, end, a, b, c);
+}
+
+const char *FindNonASCIINEON(const char *p, const char *end) noexcept {
+	for (; end - p >= 16; p += 16) {
+		const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+		const uint64_t found = NibbleMask(vcgeq_u8(v, vdupq_n_u8(0x80)));
+		if (found) {
+			return p + LowestByte(found);
+		}
+	}
+	return FindNonASCIIScalar(p, end);
+}
+
+size_t CompareNNEON(const char *a, const char *b, size_t length) noexcept {
+	size_t i = 0;
+	for (; length - i >= 16; i += 16) {
+		const uint8x16_t va = vld1q_u8(reinterpret_cast<const uint8_t *>(a + i));
+		const uint8x16_t vb = vld1q_u8(reinterpret_cast<const uint8_t *>(b + i));
+		const uint64_t differ = NibbleMask(vmvnq_u8(vceqq_u8(va, vb)));
+		if (differ) {
+			return i + LowestByte(differ);
+		}
+	}
+	return i + CompareNScalar(a + i, b + i, length - i);
+}
+
+const char *ScanSetNEON(const char *p, const char *end, const ScanNibbles &nibbles, bool inSet,
+	bool stopAtNonASCII) noexcept {
+	static constexpr uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	const uint8x16_t bitTable = vld1q_u8(bits);
+	const uint8x16_t rowsLow = vld1q_u8(nibbles[0]);
+	const uint8x16_t rowsHigh = vld1q_u8(nibbles[1]);
+	for (; end - p >= 16; p += 16) {
+		const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+		const uint8x16_t lowNibble = vandq_u8(v, vdupq_n_u8(0x0f));
+		const uint8x16_t bit = vqtbl1q_u8(bitTable, vshrq_n_u8(v, 4));
+		const uint8x16_t high = vcgeq_u8(v, vdupq_n_u8(0x80));
+		const uint8x16_t rows = vbslq_u8(high, vqtbl1q_u8(rowsHigh, lowNibble), vqtbl1q_u8(rowsLow, lowNibble));
+		uint8x16_t stops = vtstq_u8(rows, bit);
+		if (inSet)
+			stops = vmvnq_u8(stops);
+		if (stopAtNonASCII)
+			stops = vorrq_u8(stops, high);
+		const uint64_t found = NibbleMask(stops);
+		if (found) {
+			return p + LowestByte(found);
+		}
+	}
+	return ScanSetScalar(p, end, nibbles, inSet, stopAtNonASCII);
+}
+
+#endif
+
+struct Kernels {
+	ScanLevel level;
+	const char *(*findAny2)(const char *p, const char *end, char a, char b) noexcept;
+	const char *(*findAny3)(const char *p, const char *end, char a, char b, char c) noexcept;
+	const char *(*findNonASCII)(const char *p, const char *end) noexcept;
+	const char *(*scanSet)(const char *p, const char *end, const ScanNibbles &nibbles, bool inSet,
+		bool stopAtNonASCII) noexcept;
+	size_t (*compareN)(const char *a, const char *b, size_t length) noexcept;
+};
+
+constexpr Kernels scalarKernels = {
+	ScanLevel::scalar, FindAny2Scalar, FindAny3Scalar, FindNonASCIIScalar, ScanSetScalar, CompareNScalar
+};
+#if defined(LEXILLA_SCAN_X86)
+constexpr Kernels sse2Kernels = {
+	ScanLevel::sse2, FindAny2SSE2, FindAny3SSE2, FindNonASCIISSE2, ScanSetScalar, CompareNSSE2
+};
+constexpr Kernels ssse3Kernels = {
+	ScanLevel::ssse3, FindAny2SSE2, FindAny3SSE2, FindNonASCIISSE2, ScanSetSSSE3, CompareNSSE2
+};
+constexpr Kernels avx2Kernels = {
+	ScanLevel::avx2, FindAny2AVX2, FindAny3AVX2, FindNonASCIIAVX2, ScanSetAVX2, CompareNAVX2
+};
+#endif
+#if defined(LEXILLA_SCAN_NEON)
+constexpr Kernels neonKernels = {
+	ScanLevel::neon, FindAny2NEON, FindAny3NEON, FindNonASCIINEON, ScanSetNEON, CompareNNEON
+};
+#endif
+
+// The kernels of level built into this library, nullptr when there are none
+const Kernels *KernelsOf(ScanLevel level) noexcept {
+	switch (level) {
+	case ScanLevel::scalar:
+		return &scalarKernels;
+#if defined(LEXILLA_SCAN_X86)
+	case ScanLevel::sse2:
+		return &sse2Kernels;
+	case ScanLevel::ssse3:
+		return &ssse3Kernels;
+	case ScanLevel::avx2:
+		return &avx2Kernels;
+#endif
+#if defined(LEXILLA_SCAN_NEON)
+	case ScanLevel::neon:
+		return &neonKernels;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+ScanLevel DetectScanLevel() noexcept {
+#if defined(LEXILLA_SCAN_X86)
+#if defined(_MSC_VER)
+	int info[4] = {};
+	__cpuid(info, 0);
+	const int leaves = info[0];
+	__cpuid(info, 1);
+	const bool sse2 = (info[3] >> 26) & 1;
+	const bool ssse3 = (info[2] >> 9) & 1;
+	// AVX registers are only usable when the system saves them
+	const bool avxSaved = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && ((_xgetbv(0) & 6) == 6);
+	bool avx2 = false;
+	if (avxSaved && (leaves >= 7)) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] >> 5) & 1;
+	}
+#else
+	__builtin_cpu_init();
+	const bool sse2 = __builtin_cpu_supports("sse2");
+	const bool ssse3 = __builtin_cpu_supports("ssse3");
+	const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+	if (sse2 && ssse3 && avx2) {
+		return ScanLevel::avx2;
+	}
+	if (sse2 && ssse3) {
+		return ScanLevel::ssse3;
+	}
+	return sse2 ? ScanLevel::sse2 : ScanLevel::scalar;
+#elif defined(LEXILLA_SCAN_NEON)
+	return ScanLevel::neon;
+#else
+	return ScanLevel::scalar;
+#endif
+}
+
+// Chosen on first use. Kernels are constant so a thread that loads the pointer can call them at once
+std::atomic<const Kernels *> active{ nullptr };
+
+const Kernels &Active() noexcept {
+	const Kernels *kernels = active.load(std::memory_order_acquire);
+	if (!kernels) {
+		kernels = KernelsOf(BestScanLevel());
+		active.store(kernels, std::memory_order_release);
+	}
+	return *kernels;
+}
+
+}
+
+ScanLevel Lexilla::BestScanLevel() noexcept {
+	static const ScanLevel best = DetectScanLevel();
+	return best;
+}
+
+ScanLevel Lexilla::CurrentScanLevel() noexcept {
+	return Active().level;
+}
+
+bool Lexilla::SetScanLevel(ScanLevel level) noexcept {
+	// Levels are in order of capability except that NEON and the x86 levels are not built together
+	const Kernels *kernels = KernelsOf(level);
+	if (!kernels || (level > BestScanLevel())) {
+		return false;
+	}
+	active.store(kernels, std::memory_order_release);
+	return true;
+}
+
+const char *Lexilla::FindAny2(const char *begin, const char *end, char a, char b) noexcept {
+	return Active().findAny2(begin, end, a, b);
+}
+
+const char *Lexilla::FindAny3(const char *begin, const char *end, char a, char b, char c) noexcept {
+	return Active().findAny3(begin, end, a, b, c);
+}
+
+const char *Lexilla::FindNonASCII(const char *begin, const char *end) noexcept {
+	return Active().findNonASCII(begin, end);
+}
+
+const char *Lexilla::ScanSet(const char *begin, const char *end, const ScanNibbles &nibbles, bool inSet,
+	bool stopAtNonASCII) noexcept {
+	return Active().scanSet(begin, end, nibbles, inSet, stopAtNonASCII);
+}
+
+size_t Lexilla::CompareN(const char *a, const char *b, size_t length) noexcept {
+	return Active().compareN(a, b, length);
+}
@@ -0,0 +1,43 @@
+// Scintilla source code edit control
+/** @file LexScan.h
+ ** Kernels for scanning text many bytes at a time, shared by lexers.
+ ** The best of SSE2, SSSE3, AVX2 or NEON that the processor supports is chosen on first use, with
+ ** scalar versions for others, so lexlib need not be built for a particular target.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXSCAN_H
+#define LEXSCAN_H
+
+namespace Lexilla {
+
+enum class ScanLevel { scalar, sse2, ssse3, avx2, neon };
+
+/// The best level supported by this build and processor, found once
+ScanLevel BestScanLevel() noexcept;
+/// The level of the kernels in use
+ScanLevel CurrentScanLevel() noexcept;
+/// Use the kernels of level, for tests and benchmarks to compare levels. Returns false, changing nothing,
+/// when level is not supported. Not to be called while another thread is scanning
+bool SetScanLevel(ScanLevel level) noexcept;
+
+/// First position in [begin, end) holding a or b, or end
+const char *FindAny2(const char *begin, const char *end, char a, char b) noexcept;
+/// First position in [begin, end) holding a, b or c, or end
+const char *FindAny3(const char *begin, const char *end, char a, char b, char c) noexcept;
+/// First position in [begin, end) holding a byte >= 0x80, or end
+const char *FindNonASCII(const char *begin, const char *end) noexcept;
+
+/// A set of bytes as rows indexed by low nibble: bit h of nibbles[half][l] is byte (half << 7) | (h << 4) | l
+typedef unsigned char ScanNibbles[2][16];
+/// First position in [begin, end) whose byte being in the set of nibbles differs from inSet, or end.
+/// Bytes >= 0x80 also end the scan when stopAtNonASCII is set
+const char *ScanSet(const char *begin, const char *end, const ScanNibbles &nibbles, bool inSet,
+	bool stopAtNonASCII) noexcept;
+
+/// Number of bytes at the start of a and b that are the same, no more than length
+size_t CompareN(const char *a, const char *b, size_t length) noexcept;
+
+}
+
+#endif
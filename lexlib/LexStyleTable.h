@@ -0,0 +1,96 @@
+// Scintilla source code edit control
+/** @file LexStyleTable.h
+ ** Styles allocated on demand for combinations of attributes.
+ ** Lexers of text such as terminal output, where escape sequences combine colours and font attributes
+ ** freely, intern each combination seen into a style from a range so only those used take a style.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXSTYLETABLE_H
+#define LEXSTYLETABLE_H
+
+namespace Lexilla {
+
+/** Styles for keys, each a combination of attributes packed into a non-negative int by the lexer.
+ * A LexerSimple owns one and lends it to each Accessor. Retrieve it with
+ * ILexer5::PrivateCall(privateCallLexStyleTable, nullptr) which returns a pointer to the LexStyleTable,
+ * valid until Release, so the application can set the appearance of each style from its key.
+ * Styles stay allocated for the life of the lexer so text styled earlier keeps its meaning. */
+class LexStyleTable {
+	int first = 0;
+	int count = 0;
+	// Key of each allocated style, in style order
+	std::vector<int> keys;
+	// Open addressing hash table of indices into keys, -1 when empty, at most half full
+	std::vector<int> slots;
+
+	size_t Slot(int key) const noexcept {
+		const size_t mask = slots.size() - 1;
+		size_t slot = (static_cast<unsigned int>(key) * 2654435761U >> 8) & mask;
+		while ((slots[slot] >= 0) && (keys[slots[slot]] != key)) {
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+public:
+	/// Allocate from styles [first_, first_ + count_). Changing the range forgets the styles allocated.
+	void SetRange(int first_, int count_) {
+		if ((first_ == first) && (count_ == count)) {
+			return;
+		}
+		first = first_;
+		count = count_;
+		keys.clear();
+		size_t size = 16;
+		while (size < static_cast<size_t>(count) * 2) {
+			size *= 2;
+		}
+		slots.assign(size, -1);
+	}
+
+	/// The style of key, allocating the next style the first time key is seen, -1 when all are used
+	int StyleFor(int key) {
+		if (slots.empty()) {
+			return -1;
+		}
+		const size_t slot = Slot(key);
+		if (slots[slot] < 0) {
+			if (static_cast<int>(keys.size()) >= count) {
+				return -1;
+			}
+			slots[slot] = static_cast<int>(keys.size());
+			keys.push_back(key);
+		}
+		return first + slots[slot];
+	}
+
+	int First() const noexcept {
+		return first;
+	}
+
+	int Allocated() const noexcept {
+		return static_cast<int>(keys.size());
+	}
+
+	/// The key that style was allocated for, -1 when it has not been allocated
+	int KeyOf(int style) const noexcept {
+		const int index = style - first;
+		return ((index >= 0) && (index < Allocated())) ? keys[index] : -1;
+	}
+
+	void Clear() noexcept {
+		keys.clear();
+		std::fill(slots.begin(), slots.end(), -1);
+	}
+
+	size_t MemoryUse() const noexcept {
+		return (keys.capacity() + slots.capacity()) * sizeof(int);
+	}
+};
+
+constexpr int privateCallLexStyleTable = 0x4C585331;	// "LXS1"
+
+}
+
+#endif
@@ -0,0 +1,27 @@
+// Scintilla source code edit control
+/** @file LexTrace.cxx
+ ** Holds the TraceSink that trace scopes are sent to.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <atomic>
+
+#include "Sci_Position.h"
+
+#include "LexTrace.h"
+
+using namespace Lexilla;
+
+namespace {
+
+std::atomic<TraceSink *> traceSink { nullptr };
+
+}
+
+void Lexilla::SetTraceSink(TraceSink *sink) noexcept {
+	traceSink.store(sink, std::memory_order_release);
+}
+
+TraceSink *Lexilla::CurrentTraceSink() noexcept {
+	return traceSink.load(std::memory_order_acquire);
+}
@@ -0,0 +1,64 @@
+// Scintilla source code edit control
+/** @file LexTrace.h
+ ** Trace scopes around lexing work, compiled in when built with LEXILLA_TRACE defined.
+ ** An application forwards them to a profiler's timeline, such as Tracy, Perfetto or ETW,
+ ** by installing a TraceSink so a stall can be attributed to a lexer and a document range.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXTRACE_H
+#define LEXTRACE_H
+
+namespace Lexilla {
+
+/** Receives the start and end of each traced scope on the thread doing the work, which may be
+ * several threads at once. name is a string literal such as "Lex" or "Fill". detail is the
+ * lexer's name for "Lex" and "Fold" and otherwise nullptr. [start, end) is the document range
+ * worked on. Scopes on one thread are nested so End matches the latest unmatched Begin.
+ * For example, a Tracy sink could call ___tracy_emit_zone_begin and ___tracy_emit_zone_end and a
+ * Perfetto sink could use TRACE_EVENT_BEGIN and TRACE_EVENT_END. */
+class TraceSink {
+public:
+	virtual ~TraceSink() = default;
+	virtual void Begin(const char *name, const char *detail, Sci_Position start, Sci_Position end) noexcept = 0;
+	virtual void End(const char *name) noexcept = 0;
+};
+
+/** Install sink, or nullptr to stop tracing. The sink must stay valid until replaced and until
+ * any lexing that started while it was installed has finished.
+ * Tracing costs nothing when not built with LEXILLA_TRACE and is a test of the installed sink
+ * per scope when built with it but no sink is installed. */
+void SetTraceSink(TraceSink *sink) noexcept;
+TraceSink *CurrentTraceSink() noexcept;
+
+class TraceScope {
+	TraceSink *sink;
+	const char *name;
+public:
+	TraceScope(const char *name_, const char *detail, Sci_Position start, Sci_Position end) noexcept :
+		sink(CurrentTraceSink()), name(name_) {
+		if (sink) {
+			sink->Begin(name, detail, start, end);
+		}
+	}
+	// Deleted so TraceScope objects can not be copied.
+	TraceScope(const TraceScope &) = delete;
+	TraceScope(TraceScope &&) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+	TraceScope &operator=(TraceScope &&) = delete;
+	~TraceScope() {
+		if (sink) {
+			sink->End(name);
+		}
+	}
+};
+
+}
+
+#if defined(LEXILLA_TRACE)
+#define LEXILLA_TRACE_SCOPE(name, detail, start, end) const Lexilla::TraceScope traceScope(name, detail, start, end)
+#else
+#define LEXILLA_TRACE_SCOPE(name, detail, start, end) ((void)0)
+#endif
+
+#endif
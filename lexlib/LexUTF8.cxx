@@ -0,0 +1,89 @@
+// Scintilla source code edit control
+/** @file LexUTF8.cxx
+ ** Check text as UTF-8 a chunk at a time, skipping runs of ASCII many bytes at once.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <string_view>
+#include <algorithm>
+
+#include "LexScan.h"
+#include "LexUTF8.h"
+
+using namespace Lexilla;
+
+namespace {
+
+constexpr bool IsTrailByte(unsigned char ch) noexcept {
+	return (ch >= 0x80) && (ch < 0xC0);
+}
+
+// Width of a valid sequence starting with leadByte, 0 when leadByte can not start a sequence
+constexpr int BytesOfLead(unsigned char leadByte) noexcept {
+	if (leadByte < 0xC2)
+		return 0;
+	if (leadByte < 0xE0)
+		return 2;
+	if (leadByte < 0xF0)
+		return 3;
+	if (leadByte < 0xF5)
+		return 4;
+	return 0;
+}
+
+}
+
+const char *Lexilla::SkipASCII(const char *begin, const char *end) noexcept {
+	return FindNonASCII(begin, end);
+}
+
+int Lexilla::UTF8CharacterWidth(const unsigned char *s, size_t available) noexcept {
+	if (available == 0) {
+		return -1;
+	}
+	const unsigned char lead = s[0];
+	if (lead < 0x80) {
+		return 1;
+	}
+	const int width = BytesOfLead(lead);
+	if (width == 0) {
+		return 0;
+	}
+	const size_t present = std::min<size_t>(width, available);
+	for (size_t b = 1; b < present; b++) {
+		if (!IsTrailByte(s[b])) {
+			return 0;
+		}
+	}
+	if (present >= 2) {
+		const unsigned char second = s[1];
+		if (((lead == 0xE0) && (second < 0xA0)) || ((lead == 0xF0) && (second < 0x90))) {
+			return 0;	// Overlong
+		}
+		if ((lead == 0xED) && (second >= 0xA0)) {
+			return 0;	// Surrogate
+		}
+		if ((lead == 0xF4) && (second > 0x8F)) {
+			return 0;	// Beyond U+10FFFF
+		}
+	}
+	if (present < static_cast<size_t>(width)) {
+		return -1;
+	}
+	if (width == 3) {
+		const int character = ((lead & 0xF) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+		if (character >= 0xFFFE) {
+			return 0;	// U+FFFE and U+FFFF non-characters
+		}
+	} else if (width == 4) {
+		const int character = ((lead & 0x7) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+		if ((character & 0xFFFE) == 0xFFFE) {
+			return 0;	// Plane-final non-characters
+		}
+	}
+	return width;
+}
@@ -0,0 +1,134 @@
+// Scintilla source code edit control
+/** @file LexUTF8.h
+ ** Check text as UTF-8 a chunk at a time, skipping runs of ASCII many bytes at once.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LEXUTF8_H
+#define LEXUTF8_H
+
+namespace Lexilla {
+
+/// First position in [begin, end) holding a byte >= 0x80, or end.
+/// Tests many bytes at a time with FindNonASCII
+const char *SkipASCII(const char *begin, const char *end) noexcept;
+
+/// Width of the UTF-8 character starting at s, of which available bytes can be read: 0 when the bytes are not a
+/// valid character and -1 when they are valid so far but are cut short by available.
+/// Follows the validation of Scintilla's UTF8Classify, as StyleContext does, so overlong forms, surrogates,
+/// code points beyond U+10FFFF and the non-characters U+FFFE and U+FFFF of each plane are not valid
+int UTF8CharacterWidth(const unsigned char *s, size_t available) noexcept;
+
+/// Checks text given as a sequence of pieces, such as the lines of a document, as UTF-8.
+/// A character cut short by the end of a piece is completed by the next piece when more was set.
+/// Invalid bytes are invalid as for StyleContext, one byte at a time, and are reported as runs of adjacent
+/// invalid bytes within a piece
+class UTF8Validator {
+	unsigned char pending[4] = {};
+	size_t pendingLength = 0;
+	size_t pendingPosition = 0;
+	bool ascii = true;
+	bool valid = true;
+
+	// Checks the pending bytes followed by the start of text, returning how many bytes of text were used
+	template <typename Invalid>
+	size_t CompletePending(std::string_view text, bool more, Invalid &invalid) {
+		unsigned char bytes[sizeof(pending)] = {};
+		size_t count = 0;
+		for (; (count < pendingLength) && (count < sizeof(bytes)); count++) {
+			bytes[count] = pending[count];
+		}
+		for (size_t i = 0; (i < text.length()) && (count < sizeof(bytes)); i++) {
+			bytes[count++] = text[i];
+		}
+		const size_t used = count - pendingLength;
+		const int width = UTF8CharacterWidth(bytes, count);
+		if (width > 0) {
+			const size_t completed = width - pendingLength;
+			pendingLength = 0;
+			return completed;
+		}
+		if ((width < 0) && more) {
+			// Still cut short: text is too short to complete the character
+			std::copy(bytes, bytes + count, pending);
+			pendingLength = count;
+			return used;
+		}
+		// The lead byte is invalid and the pending bytes after it are trail bytes, so invalid by themselves.
+		// Bytes of text are checked afresh
+		valid = false;
+		invalid(pendingPosition, pendingPosition + pendingLength);
+		pendingLength = 0;
+		return 0;
+	}
+
+public:
+	/// Checks text, which starts at position and follows the text of the previous call, calling
+	/// invalid(start, end) for each run of invalid bytes found, in order
+	template <typename Invalid>
+	void Check(std::string_view text, size_t position, bool more, Invalid invalid) {
+		size_t offset = 0;
+		if (pendingLength > 0) {
+			offset = CompletePending(text, more, invalid);
+			if (pendingLength > 0) {
+				return;
+			}
+		}
+		const char *const begin = text.data();
+		const char *const end = begin + text.length();
+		size_t invalidStart = 0;
+		size_t invalidEnd = 0;
+		for (const char *p = SkipASCII(begin + offset, end); p < end; p = SkipASCII(p, end)) {
+			ascii = false;
+			const int width = UTF8CharacterWidth(reinterpret_cast<const unsigned char *>(p), end - p);
+			if (width > 0) {
+				p += width;
+				continue;
+			}
+			const size_t at = position + (p - begin);
+			if ((width < 0) && more) {
+				// Fewer bytes remain than the character needs so they fit in pending
+				pendingLength = 0;
+				for (; (p + pendingLength < end) && (pendingLength < sizeof(pending)); pendingLength++) {
+					pending[pendingLength] = p[pendingLength];
+				}
+				pendingPosition = at;
+				break;
+			}
+			valid = false;
+			if (invalidEnd != at) {
+				if (invalidEnd > invalidStart) {
+					invalid(invalidStart, invalidEnd);
+				}
+				invalidStart = at;
+			}
+			invalidEnd = at + 1;
+			p++;
+		}
+		if (invalidEnd > invalidStart) {
+			invalid(invalidStart, invalidEnd);
+		}
+	}
+
+	/// Bytes of a character cut short by the end of the last piece, waiting for the next
+	size_t Pending() const noexcept {
+		return pendingLength;
+	}
+	/// No byte >= 0x80 has been seen
+	bool ASCII() const noexcept {
+		return ascii;
+	}
+	/// No invalid byte has been seen
+	bool Valid() const noexcept {
+		return valid;
+	}
+	void Reset() noexcept {
+		pendingLength = 0;
+		ascii = true;
+		valid = true;
+	}
+};
+
+}
+
+#endif
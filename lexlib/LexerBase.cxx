@@ -5,11 +5,14 @@
 // Copyright 1998-2010 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cstdint>
 #include <cstdlib>
 #include <cassert>
 #include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -17,9 +20,13 @@
 
 #include "PropSetSimple.h"
 #include "WordList.h"
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "LexerModule.h"
+#include "StyleCache.h"
 #include "LexerBase.h"
 
 using namespace Lexilla;
@@ -47,6 +54,13 @@ void SCI_METHOD LexerBase::Release() {
 	delete this;
 }
 
+void LexerBase::Reset() {
+	props.Clear();
+	for (int wl = 0; wl < numWordLists; wl++) {
+		keyWordLists[wl]->Clear();
+	}
+}
+
 int SCI_METHOD LexerBase::Version() const {
 	return Scintilla::lvRelease5;
 }
@@ -63,9 +77,17 @@ const char * SCI_METHOD LexerBase::DescribeProperty(const char *) {
 	return "";
 }
 
+Sci_Position LexerBase::FirstInvalidated(const char *) {
+	return 0;
+}
+
+Sci_Position LexerBase::FirstInvalidatedByWordList(int) {
+	return 0;
+}
+
 Sci_Position SCI_METHOD LexerBase::PropertySet(const char *key, const char *val) {
 	if (props.Set(key, val)) {
-		return 0;
+		return FirstInvalidated(key);
 	} else {
 		return -1;
 	}
@@ -82,13 +104,50 @@ const char * SCI_METHOD LexerBase::DescribeWordListSets() {
 Sci_Position SCI_METHOD LexerBase::WordListSet(int n, const char *wl) {
 	if (n < numWordLists) {
 		if (keyWordLists[n]->Set(wl)) {
-			return 0;
+			return FirstInvalidatedByWordList(n);
 		}
 	}
 	return -1;
 }
 
-void * SCI_METHOD LexerBase::PrivateCall(int, void *) {
+void LexerBase::AddMemoryUse(LexMemory &memory) const {
+	memory.lexer += sizeof(LexerBase);
+	for (int wl = 0; wl < numWordLists; wl++) {
+		memory.wordLists += sizeof(WordList) + keyWordLists[wl]->MemoryUse();
+	}
+	memory.properties += props.MemoryUse();
+}
+
+void LexerBase::AppendSettings(std::string &settings) const {
+	props.AppendSettings(settings);
+	for (int wl = 0; wl < numWordLists; wl++) {
+		const WordList &words = *keyWordLists[wl];
+		const int length = words.Length();
+		if (length > 0) {
+			// Words are held sorted so the same list in any order gives the same text
+			settings.append("wordlist");
+			settings.append(std::to_string(wl));
+			settings.push_back('=');
+			for (int word = 0; word < length; word++) {
+				settings.append(words.WordAt(word));
+				settings.push_back(' ');
+			}
+			settings.push_back('\n');
+		}
+	}
+}
+
+void * SCI_METHOD LexerBase::PrivateCall(int operation, void *pointer) {
+	if ((operation == privateCallLexMemory) && pointer) {
+		LexMemory *memory = static_cast<LexMemory *>(pointer);
+		*memory = LexMemory();
+		AddMemoryUse(*memory);
+		return pointer;
+	}
+	if ((operation == privateCallLexSettings) && pointer) {
+		AppendSettings(*static_cast<std::string *>(pointer));
+		return pointer;
+	}
 	return nullptr;
 }
 
@@ -10,6 +10,8 @@
 
 namespace Lexilla {
 
+struct LexMemory;
+
 // A simple lexer with no state
 class LexerBase : public Scintilla::ILexer5 {
 protected:
@@ -18,10 +20,22 @@ protected:
 	PropSetSimple props;
 	enum {numWordLists=KEYWORDSET_MAX+1};
 	WordList *keyWordLists[numWordLists+1];
+	// The first position to restyle once the property key or word list n has changed, -1 for none.
+	// 0, restyling everything, unless a lexer knows which styles depend on the value.
+	virtual Sci_Position FirstInvalidated(const char *key);
+	virtual Sci_Position FirstInvalidatedByWordList(int n);
 public:
 	LexerBase(const LexicalClass *lexClasses_=nullptr, size_t nClasses_=0);
 	virtual ~LexerBase();
 	void SCI_METHOD Release() override;
+	// Clear properties and word lists so the lexer is as newly created, keeping allocated memory
+	virtual void Reset();
+	// Add the bytes held by this lexer to memory, reported through PrivateCall(privateCallLexMemory).
+	// Lexers holding more state override this and call the base.
+	virtual void AddMemoryUse(LexMemory &memory) const;
+	// Append every property and word list set, reported through PrivateCall(privateCallLexSettings)
+	// so a StyleCache key changes with any setting.
+	virtual void AppendSettings(std::string &settings) const;
 	int SCI_METHOD Version() const override;
 	const char * SCI_METHOD PropertyNames() override;
 	int SCI_METHOD PropertyType(const char *name) override;
@@ -7,8 +7,12 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -16,6 +20,9 @@
 
 #include "PropSetSimple.h"
 #include "WordList.h"
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "LexerModule.h"
@@ -24,13 +31,36 @@
 
 using namespace Lexilla;
 
+namespace Lexilla {
+
+struct LexerPool {
+	std::vector<LexerSimple *> idle;
+};
+
+}
+
+namespace {
+
+// Lexers are created and released rarely so one mutex guards every module's pool
+std::mutex poolMutex;
+
+// Enough for the views a host commonly has open at once for one language
+constexpr size_t poolLimit = 8;
+
+// Memory a Reset lexer may hold to be pooled. Reset trims the arena but property values keep their
+// buffers so a lexer given very long values is deleted instead of holding them while idle
+constexpr size_t idleMemoryLimit = 0x10000;
+
+}
+
 LexerModule::LexerModule(int language_,
 	LexerFunction fnLexer_,
 	const char *languageName_,
 	LexerFunction fnFolder_,
 	const char *const wordListDescriptions_[],
 	const LexicalClass *lexClasses_,
-	size_t nClasses_) noexcept :
+	size_t nClasses_,
+	const PropertyScope *propertyScopes_) noexcept :
 	language(language_),
 	fnLexer(fnLexer_),
 	fnFolder(fnFolder_),
@@ -38,6 +68,8 @@ LexerModule::LexerModule(int language_,
 	wordListDescriptions(wordListDescriptions_),
 	lexClasses(lexClasses_),
 	nClasses(nClasses_),
+	propertyScopes(propertyScopes_),
+	pool(nullptr),
 	languageName(languageName_) {
 }
 
@@ -52,6 +84,8 @@ LexerModule::LexerModule(int language_,
 	wordListDescriptions(wordListDescriptions_),
 	lexClasses(nullptr),
 	nClasses(0),
+	propertyScopes(nullptr),
+	pool(nullptr),
 	languageName(languageName_) {
 }
 
@@ -59,6 +93,10 @@ int LexerModule::GetLanguage() const noexcept {
 	return language;
 }
 
+LexerFactoryFunction LexerModule::GetFactory() const noexcept {
+	return fnFactory;
+}
+
 int LexerModule::GetNumWordLists() const noexcept {
 	if (!wordListDescriptions) {
 		return -1;
@@ -90,11 +128,45 @@ size_t LexerModule::NamedStyles() const noexcept {
 	return nClasses;
 }
 
+const PropertyScope *LexerModule::PropertyScopes() const noexcept {
+	return propertyScopes;
+}
+
 Scintilla::ILexer5 *LexerModule::Create() const {
 	if (fnFactory)
 		return fnFactory();
-	else
-		return new LexerSimple(this);
+	{
+		std::lock_guard<std::mutex> guard(poolMutex);
+		if (pool && !pool->idle.empty()) {
+			LexerSimple *lexer = pool->idle.back();
+			pool->idle.pop_back();
+			return lexer;
+		}
+	}
+	return new LexerSimple(this);
+}
+
+void LexerModule::Recycle(LexerSimple *lexer) const {
+	if (!lexer)
+		return;
+	lexer->Reset();
+	LexMemory memory;
+	lexer->AddMemoryUse(memory);
+	if (memory.Total() > idleMemoryLimit) {
+		delete lexer;
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(poolMutex);
+		// The pool is never freed so lexers released while statics are destroyed still find it
+		if (!pool)
+			pool = new LexerPool;
+		if (pool->idle.size() < poolLimit) {
+			pool->idle.push_back(lexer);
+			return;
+		}
+	}
+	delete lexer;
 }
 
 void LexerModule::Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle,
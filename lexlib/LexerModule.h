@@ -12,7 +12,10 @@ namespace Lexilla {
 
 class Accessor;
 class WordList;
+class LexerSimple;
 struct LexicalClass;
+struct LexerPool;
+struct PropertyScope;
 
 typedef void (*LexerFunction)(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle,
                   WordList *keywordlists[], Accessor &styler);
@@ -33,6 +36,10 @@ protected:
 	const char * const * wordListDescriptions;
 	const LexicalClass *lexClasses;
 	size_t nClasses;
+	// What changing each declared property or word list restyles, nullptr when every change restyles all
+	const PropertyScope *propertyScopes;
+	// Released LexerSimple instances kept for Create to hand out again, allocated on first Recycle
+	mutable LexerPool *pool;
 
 public:
 	const char *languageName;
@@ -43,21 +50,29 @@ public:
 		LexerFunction fnFolder_= nullptr,
 		const char * const wordListDescriptions_[]=nullptr,
 		const LexicalClass *lexClasses_=nullptr,
-		size_t nClasses_=0) noexcept;
+		size_t nClasses_=0,
+		const PropertyScope *propertyScopes_=nullptr) noexcept;
 	LexerModule(
 		int language_,
 		LexerFactoryFunction fnFactory_,
 		const char *languageName_,
 		const char * const wordListDescriptions_[]=nullptr) noexcept;
 	int GetLanguage() const noexcept;
+	// nullptr for modules with a LexerFunction
+	LexerFactoryFunction GetFactory() const noexcept;
 
 	// -1 is returned if no WordList information is available
 	int GetNumWordLists() const noexcept;
 	const char *GetWordListDescription(int index) const noexcept;
 	const LexicalClass *LexClasses() const noexcept;
 	size_t NamedStyles() const noexcept;
+	const PropertyScope *PropertyScopes() const noexcept;
 
+	// A LexerSimple from the pool is returned when there is one, already Reset by Recycle.
 	Scintilla::ILexer5 *Create() const;
+	// Reset lexer and keep it for a later Create, or delete it when enough are kept or it still holds
+	// much memory after Reset, which trims its arena.
+	void Recycle(LexerSimple *lexer) const;
 
 	void Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle,
                   WordList *keywordlists[], Accessor &styler) const;
@@ -7,8 +7,11 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -16,6 +19,8 @@
 
 #include "PropSetSimple.h"
 #include "WordList.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "LexerModule.h"
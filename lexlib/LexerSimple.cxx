@@ -7,8 +7,17 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <chrono>
 
 #include "ILexer.h"
 #include "Scintilla.h"
@@ -16,7 +25,15 @@
 
 #include "PropSetSimple.h"
 #include "WordList.h"
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexCost.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
+#include "LexArena.h"
+#include "LexLocations.h"
+#include "LexStyleTable.h"
+#include "LexInvalidation.h"
 #include "Accessor.h"
 #include "LexerModule.h"
 #include "LexerBase.h"
@@ -24,9 +41,35 @@
 
 using namespace Lexilla;
 
+namespace {
+
+const PropertyKey keyBudgetBytes("lexer.budget.bytes");
+const PropertyKey keyBudgetMilliseconds("lexer.budget.milliseconds");
+const PropertyKey keyFold("fold");
+const PropertyKey keyLocations("lexer.locations");
+
+// Arena memory a Reset lexer keeps, enough for lexing a few screens again without the heap while a lexer
+// grown by one large range does not hold that memory idle in its module's pool
+constexpr size_t arenaKept = 0x4000;
+
+// Properties read by lexlib that change how much is styled at once but not the styles
+const PropertyScope lexlibScopes[] = {
+	{ "lexer.budget.bytes", -1, Restyle::none, 0 },
+	{ "lexer.budget.milliseconds", -1, Restyle::none, 0 },
+	{ "lexer.buffer.direct", -1, Restyle::none, 0 },
+	{ "lexer.styles.compare", -1, Restyle::none, 0 },
+	{ nullptr, -1, Restyle::all, 0 },
+};
+
+}
+
 LexerSimple::LexerSimple(const LexerModule *module_) :
 	LexerBase(module_->LexClasses(), module_->NamedStyles()),
-	module(module_) {
+	module(module_),
+	arena(new LexArena()),
+	styleTable(new LexStyleTable()),
+	invalidation(new LexInvalidation()),
+	cost(new LexCost()) {
 	for (int wl = 0; wl < module->GetNumWordLists(); wl++) {
 		if (!wordLists.empty())
 			wordLists += "\n";
@@ -34,21 +77,203 @@ LexerSimple::LexerSimple(const LexerModule *module_) :
 	}
 }
 
+LexerSimple::~LexerSimple() {
+	delete cost;
+	delete invalidation;
+	delete locations;
+	delete styleTable;
+	delete arena;
+}
+
+void SCI_METHOD LexerSimple::Release() {
+	module->Recycle(this);
+}
+
+void LexerSimple::Reset() {
+	LexerBase::Reset();
+	delete locations;
+	locations = nullptr;
+	styleTable->Clear();
+	invalidation->Clear();
+	arena->Trim(arenaKept);
+	cost->Clear();
+	costDocument = nullptr;
+	changedStart = 0;
+	changedEnd = 0;
+	styleRange = nullptr;
+#if defined(LEXILLA_COUNTERS)
+	counters = LexCounters();
+#endif
+}
+
+void LexerSimple::AddMemoryUse(LexMemory &memory) const {
+	LexerBase::AddMemoryUse(memory);
+	memory.lexer += sizeof(LexerSimple) - sizeof(LexerBase);
+	if (wordLists.capacity() > std::string().capacity()) {
+		memory.other += wordLists.capacity() + 1;
+	}
+	memory.other += sizeof(LexArena) + arena->Capacity();
+	if (locations) {
+		memory.other += sizeof(LexLocations) + locations->MemoryUse();
+	}
+	memory.subStyles += sizeof(LexStyleTable) + styleTable->MemoryUse();
+	memory.other += sizeof(LexInvalidation) + sizeof(LexCost);
+}
+
+Sci_Position LexerSimple::FirstInvalidated(const char *key) {
+	const PropertyScope *scope = FindScope(module->PropertyScopes(), key, -1);
+	if (!scope) {
+		scope = FindScope(lexlibScopes, key, -1);
+	}
+	return invalidation->FirstInvalidated(scope);
+}
+
+Sci_Position LexerSimple::FirstInvalidatedByWordList(int n) {
+	return invalidation->FirstInvalidated(FindScope(module->PropertyScopes(), nullptr, n));
+}
+
 const char * SCI_METHOD LexerSimple::DescribeWordListSets() {
 	return wordLists.c_str();
 }
 
 void SCI_METHOD LexerSimple::Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess) {
+	// property lexer.budget.bytes
+	//	Stop styling at a line start after about this many bytes, for lexers that support it.
+	//	The rest is styled when the application asks again. 0, the default, has no limit.
+	// property lexer.budget.milliseconds
+	//	Stop styling at a line start after about this much time, for lexers that support it.
+	LexBudgeted(startPos, lengthDoc, initStyle, pAccess,
+		props.GetInt(keyBudgetBytes), props.GetInt(keyBudgetMilliseconds));
+}
+
+Sci_Position LexerSimple::LexBudgeted(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess,
+	Sci_Position bytes, int milliseconds) {
+	LEXILLA_TRACE_SCOPE("Lex", module->languageName, startPos, startPos + lengthDoc);
+	const std::chrono::steady_clock::time_point timeStart = std::chrono::steady_clock::now();
+#if defined(LEXILLA_COUNTERS)
+	counters = LexCounters();
+	counters.lines = pAccess->LineFromPosition(startPos + lengthDoc) - pAccess->LineFromPosition(startPos) + 1;
+#endif
 	Accessor astyler(pAccess, &props);
+#if defined(LEXILLA_COUNTERS)
+	astyler.SetCounters(&counters);
+#endif
+	astyler.SetArena(arena);
+	astyler.SetStyleRange(styleRange);
+	styleRange = nullptr;
+	astyler.SetStyleTable(styleTable);
+	invalidation->Start(startPos);
+	astyler.SetInvalidation(invalidation);
+	astyler.SetBudget(startPos, bytes, milliseconds);
+	// property lexer.locations
+	//	Set to 1 to collect the file, line and column named by each diagnostic line, for lexers
+	//	that find them. Retrieve them with PrivateCall(privateCallLexLocations).
+	if (props.GetInt(keyLocations)) {
+		if (!locations)
+			locations = new LexLocations();
+		astyler.SetLocations(locations);
+	} else if (locations) {
+		delete locations;
+		locations = nullptr;
+	}
 	module->Lex(startPos, lengthDoc, initStyle, keyWordLists, astyler);
 	astyler.Flush();
+	arena->Reset();
+	const unsigned long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - timeStart).count();
+#if defined(LEXILLA_COUNTERS)
+	counters.nanoseconds = nanoseconds;
+#endif
+	changedStart = 0;
+	changedEnd = 0;
+	astyler.GetChangedRange(changedStart, changedEnd);
+	const Sci_Position stoppedAt = astyler.StoppedAt();
+	const Sci_Position endStyled = (stoppedAt >= 0) ? stoppedAt : startPos + lengthDoc;
+	if (endStyled > static_cast<Sci_Position>(startPos)) {
+		const Sci_Position lineFirst = pAccess->LineFromPosition(startPos);
+		const Sci_Position lineLast = pAccess->LineFromPosition(endStyled - 1);
+		if (locations) {
+			locations->Commit(lineFirst, lineLast);
+		}
+		if (costDocument != pAccess) {
+			cost->Clear();
+			costDocument = pAccess;
+		}
+		cost->Add(nanoseconds, endStyled - startPos, lineLast - lineFirst + 1);
+	}
+	return endStyled;
+}
+
+void LexerSimple::RecommendRange(LexCostQuery &query) const {
+	query.nanosecondsPerByte = cost->NanosecondsPerByte();
+	query.nanosecondsPerLine = cost->NanosecondsPerLine();
+	query.samples = cost->Samples();
+	const Sci_Position start = std::max<Sci_Position>(query.start, 0);
+	Scintilla::IDocument *pAccess = query.document;
+	if (!pAccess) {
+		query.end = start + cost->BytesFor(query.milliseconds);
+		return;
+	}
+	const Sci_Position length = pAccess->Length();
+	Sci_Position end = std::min(start + cost->BytesFor(query.milliseconds), length);
+	const Sci_Position lines = cost->LinesFor(query.milliseconds);
+	if (lines > 0) {
+		end = std::min(end, pAccess->LineStart(pAccess->LineFromPosition(start) + lines));
+	}
+	if ((end > start) && (end < length)) {
+		// Lexers stop at line starts so end at the start of the line after the one end is in
+		end = pAccess->LineStart(pAccess->LineFromPosition(end - 1) + 1);
+	}
+	query.end = std::max(end, std::min(start, length));
+}
+
+bool LexerSimple::LastChangedRange(Sci_Position &start, Sci_Position &end) const noexcept {
+	if (changedStart >= changedEnd) {
+		return false;
+	}
+	start = changedStart;
+	end = changedEnd;
+	return true;
+}
+
+void * SCI_METHOD LexerSimple::PrivateCall(int operation, void *pointer) {
+	if (operation == privateCallLexCounters) {
+#if defined(LEXILLA_COUNTERS)
+		if (pointer) {
+			*static_cast<LexCounters *>(pointer) = counters;
+		}
+		return pointer;
+#else
+		return nullptr;
+#endif
+	}
+	if (operation == privateCallLexCost) {
+		if (pointer) {
+			RecommendRange(*static_cast<LexCostQuery *>(pointer));
+		}
+		return pointer;
+	}
+	if (operation == privateCallLexLocations) {
+		return locations;
+	}
+	if (operation == privateCallLexStyleTable) {
+		return styleTable;
+	}
+	if (operation == privateCallStyleRange) {
+		styleRange = static_cast<const IDocumentStyleRange *>(pointer);
+		return pointer;
+	}
+	return LexerBase::PrivateCall(operation, pointer);
 }
 
 void SCI_METHOD LexerSimple::Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess) {
-	if (props.GetInt("fold")) {
+	if (props.GetInt(keyFold)) {
+		LEXILLA_TRACE_SCOPE("Fold", module->languageName, startPos, startPos + lengthDoc);
 		Accessor astyler(pAccess, &props);
+		astyler.SetArena(arena);
 		module->Fold(startPos, lengthDoc, initStyle, keyWordLists, astyler);
 		astyler.Flush();
+		arena->Reset();
 	}
 }
 
@@ -10,16 +10,67 @@
 
 namespace Lexilla {
 
+class LexArena;
+class LexLocations;
+class LexStyleTable;
+class LexInvalidation;
+class LexCost;
+struct LexCostQuery;
+class IDocumentStyleRange;
+
 // A simple lexer with no state
 class LexerSimple : public LexerBase {
 	const LexerModule *module;
 	std::string wordLists;
+	// Lent to the Accessor of each Lex and Fold and Reset after so its memory is reused
+	LexArena *arena;
+	// Diagnostic locations, allocated while lexer.locations is set
+	LexLocations *locations = nullptr;
+	// Styles allocated by the lexer for combinations of attributes
+	LexStyleTable *styleTable;
+	// Text whose styles depend on properties the module scopes, marked by the lexer
+	LexInvalidation *invalidation;
+	// Time taken by recent calls to Lex for costDocument, started again for another document
+	LexCost *cost;
+	const Scintilla::IDocument *costDocument = nullptr;
+	Sci_Position changedStart = 0;
+	Sci_Position changedEnd = 0;
+	// Lent by the host with privateCallStyleRange for the next Lex only, as the document may not outlive it
+	const IDocumentStyleRange *styleRange = nullptr;
+#if defined(LEXILLA_COUNTERS)
+	LexCounters counters;
+#endif
+protected:
+	// From the module's PropertyScopes, then those of the properties read by lexlib itself
+	Sci_Position FirstInvalidated(const char *key) override;
+	Sci_Position FirstInvalidatedByWordList(int n) override;
 public:
 	explicit LexerSimple(const LexerModule *module_);
+	// Deleted so LexerSimple objects can not be copied.
+	LexerSimple(const LexerSimple &) = delete;
+	LexerSimple(LexerSimple &&) = delete;
+	LexerSimple &operator=(const LexerSimple &) = delete;
+	LexerSimple &operator=(LexerSimple &&) = delete;
+	~LexerSimple() override;
+	// Returns the lexer to its module's pool to be handed out again by LexerModule::Create
+	void SCI_METHOD Release() override;
+	void Reset() override;
+	void AddMemoryUse(LexMemory &memory) const override;
 	const char * SCI_METHOD DescribeWordListSets() override;
 	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess) override;
 	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess) override;
+	// Lex with a budget of bytes and milliseconds, 0 for no limit, returning the end of the text styled.
+	// Lexers that check Accessor::BudgetSpent stop at a line start once it is spent and the host
+	// resumes from the returned position later. Others always style the whole range.
+	Sci_Position LexBudgeted(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess,
+		Sci_Position bytes, int milliseconds);
+	// Fills in the end of the range from query.start that Lex is expected to style in query.milliseconds for
+	// query.document, and the cost per byte and per line that is from
+	void RecommendRange(LexCostQuery &query) const;
+	// The range whose styles changed in the last Lex, when lexer.styles.compare is set
+	bool LastChangedRange(Sci_Position &start, Sci_Position &end) const noexcept;
 	// ILexer5 methods
+	void * SCI_METHOD PrivateCall(int operation, void *pointer) override;
 	const char * SCI_METHOD GetName() override;
 	int SCI_METHOD  GetIdentifier() override;
 };
@@ -0,0 +1,226 @@
+// Scintilla source code edit control
+/** @file LinePatterns.cxx
+ ** Match lines of output against simple anchored patterns with slots for a file, line and column.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iterator>
+#include <utility>
+#include <algorithm>
+
+#include "LinePatterns.h"
+
+using namespace Lexilla;
+
+namespace {
+
+constexpr bool IsDigit(char ch) noexcept {
+	return (ch >= '0') && (ch <= '9');
+}
+
+// Length of line without the line end characters
+size_t LengthText(std::string_view line) noexcept {
+	size_t length = line.length();
+	while ((length > 0) && ((line[length - 1] == '\r') || (line[length - 1] == '\n'))) {
+		length--;
+	}
+	return length;
+}
+
+}
+
+bool LinePatterns::Add(std::string_view definition) {
+	if (patterns.size() >= maxPatterns) {
+		return false;
+	}
+	Pattern pattern;
+	size_t position = 0;
+	while ((position < definition.length()) && IsDigit(definition[position])) {
+		pattern.style = pattern.style * 10 + (definition[position] - '0');
+		if (pattern.style > 255) {
+			return false;
+		}
+		position++;
+	}
+	if ((position == 0) || (position >= definition.length()) || (definition[position] != ' ')) {
+		return false;
+	}
+	position++;
+	if (position >= definition.length()) {
+		return false;
+	}
+	for (; position < definition.length(); position++) {
+		const char ch = definition[position];
+		Kind kind = Kind::text;
+		if (ch == '%') {
+			position++;
+			if (position >= definition.length()) {
+				return false;
+			}
+			switch (definition[position]) {
+			case '%':
+				break;
+			case 'f':
+				kind = Kind::path;
+				break;
+			case 'l':
+				kind = Kind::lineNumber;
+				break;
+			case 'c':
+				kind = Kind::column;
+				break;
+			case '*':
+				kind = Kind::any;
+				break;
+			case 'm':
+				kind = Kind::message;
+				break;
+			default:
+				return false;
+			}
+		}
+		if (!pattern.elements.empty()) {
+			const Kind previous = pattern.elements.back().kind;
+			if (previous == Kind::message) {
+				return false;
+			}
+			if (((previous == Kind::path) || (previous == Kind::any)) && (kind != Kind::text)) {
+				// Where the path would end is not known
+				return false;
+			}
+		}
+		if (kind == Kind::text) {
+			if (pattern.elements.empty() || (pattern.elements.back().kind != Kind::text)) {
+				pattern.elements.push_back(Element());
+			}
+			pattern.elements.back().text.push_back(definition[position]);
+		} else {
+			Element element;
+			element.kind = kind;
+			pattern.elements.push_back(element);
+		}
+	}
+
+	const unsigned long bit = 1UL << patterns.size();
+	const Element &first = pattern.elements.front();
+	for (int ch = 0; ch < 256; ch++) {
+		bool candidate = true;
+		if (first.kind == Kind::text) {
+			candidate = ch == static_cast<unsigned char>(first.text[0]);
+		} else if ((first.kind == Kind::lineNumber) || (first.kind == Kind::column)) {
+			candidate = IsDigit(static_cast<char>(ch));
+		}
+		if (candidate) {
+			candidates[ch] |= bit;
+		}
+	}
+	patterns.push_back(std::move(pattern));
+	return true;
+}
+
+void LinePatterns::Clear() noexcept {
+	patterns.clear();
+	std::fill(std::begin(candidates), std::end(candidates), 0UL);
+}
+
+bool LinePatterns::Empty() const noexcept {
+	return patterns.empty();
+}
+
+size_t LinePatterns::Count() const noexcept {
+	return patterns.size();
+}
+
+bool LinePatterns::MatchFrom(const Pattern &pattern, size_t element, std::string_view line, size_t position,
+	LinePatternMatch &match, int &attempts) noexcept {
+	for (; element < pattern.elements.size(); element++) {
+		const Element &current = pattern.elements[element];
+		switch (current.kind) {
+		case Kind::text:
+			if (line.substr(position, current.text.length()) != current.text) {
+				return false;
+			}
+			position += current.text.length();
+			break;
+		case Kind::lineNumber:
+		case Kind::column: {
+				if ((position >= line.length()) || !IsDigit(line[position])) {
+					return false;
+				}
+				int number = 0;
+				for (; (position < line.length()) && IsDigit(line[position]); position++) {
+					if (number < 100000000) {
+						number = number * 10 + (line[position] - '0');
+					}
+				}
+				if (current.kind == Kind::lineNumber) {
+					match.lineNumber = number;
+				} else {
+					match.column = number;
+				}
+			}
+			break;
+		case Kind::path:
+		case Kind::any: {
+				const size_t minimum = (current.kind == Kind::path) ? 1 : 0;
+				if (element + 1 == pattern.elements.size()) {
+					// Extends to the end of the text
+					const size_t end = LengthText(line);
+					if ((end < position) || (end - position < minimum)) {
+						return false;
+					}
+					if (current.kind == Kind::path) {
+						match.pathStart = position;
+						match.pathEnd = end;
+					}
+					return true;
+				}
+				// Try each place the following text is found, nearest first
+				const std::string &following = pattern.elements[element + 1].text;
+				for (size_t found = line.find(following, position + minimum); found != std::string_view::npos;
+					found = line.find(following, found + 1)) {
+					if (--attempts < 0) {
+						return false;
+					}
+					if (MatchFrom(pattern, element + 1, line, found, match, attempts)) {
+						if (current.kind == Kind::path) {
+							match.pathStart = position;
+							match.pathEnd = found;
+						}
+						return true;
+					}
+				}
+				return false;
+			}
+		case Kind::message:
+			match.messageStart = position;
+			return true;
+		}
+	}
+	return true;
+}
+
+bool LinePatterns::Match(std::string_view line, LinePatternMatch &match) const noexcept {
+	if (line.empty()) {
+		return false;
+	}
+	unsigned long remaining = candidates[static_cast<unsigned char>(line[0])];
+	for (size_t index = 0; remaining != 0; index++, remaining >>= 1) {
+		if (remaining & 1) {
+			LinePatternMatch found;
+			// Bounds the work for patterns with several %f or %* on lines with many places they could end
+			int attempts = maxAttempts;
+			if (MatchFrom(patterns[index], 0, line, 0, found, attempts)) {
+				found.style = patterns[index].style;
+				match = found;
+				return true;
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,66 @@
+// Scintilla source code edit control
+/** @file LinePatterns.h
+ ** Match lines of output against simple anchored patterns with slots for a file, line and column.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LINEPATTERNS_H
+#define LINEPATTERNS_H
+
+namespace Lexilla {
+
+/// Where the parts captured by a pattern are in the line it matched
+struct LinePatternMatch {
+	int style = 0;			// Style given with the pattern
+	size_t pathStart = 0;		// The file's path is [pathStart, pathEnd), empty without %f
+	size_t pathEnd = 0;
+	int lineNumber = 0;		// 0 without %l
+	int column = 0;			// 0 without %c
+	ptrdiff_t messageStart = -1;	// Start of %m, -1 without it
+};
+
+/** Patterns for lines of output, such as diagnostics from tools a lexer does not know.
+ * Each is defined as "<style> <pattern>" and the pattern matches from the start of a line:
+ *	%f	a file path: one or more characters, as few as possible before the text that follows
+ *	%l	a line number and %c a column number: one or more digits
+ *	%*	any characters, as few as possible before the text that follows
+ *	%m	the message: the rest of the line, ending the pattern
+ *	%%	a '%'
+ * Other characters match themselves. %f and %* must be followed by text or end the pattern, in
+ * which case they extend to the line end characters. When the rest of the pattern does not match
+ * after the shortest %f or %*, longer ones are tried, up to a limit.
+ * Patterns are compiled into a table of the patterns that can match each first byte so a line is
+ * only compared with those. */
+class LinePatterns {
+	enum class Kind : unsigned char { text, path, lineNumber, column, any, message };
+	struct Element {
+		Kind kind = Kind::text;
+		std::string text;
+	};
+	struct Pattern {
+		int style = 0;
+		std::vector<Element> elements;
+	};
+	std::vector<Pattern> patterns;
+	// Bit i of candidates[ch] is set when pattern i can match a line starting with ch
+	unsigned long candidates[256] {};
+
+	static constexpr int maxAttempts = 1000;
+	static bool MatchFrom(const Pattern &pattern, size_t element, std::string_view line, size_t position,
+		LinePatternMatch &match, int &attempts) noexcept;
+public:
+	static constexpr size_t maxPatterns = 32;
+
+	/// Adds the pattern defined, returning false and leaving the patterns unchanged when the
+	/// definition is not valid or there are already maxPatterns
+	bool Add(std::string_view definition);
+	void Clear() noexcept;
+	bool Empty() const noexcept;
+	size_t Count() const noexcept;
+	/// Tries the patterns in the order they were added, match is filled from the first that matches
+	bool Match(std::string_view line, LinePatternMatch &match) const noexcept;
+};
+
+}
+
+#endif
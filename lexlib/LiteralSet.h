@@ -0,0 +1,75 @@
+// Scintilla source code edit control
+/** @file LiteralSet.h
+ ** A set of literal strings that can be matched together at a position.
+ ** Literals are grouped by their first byte, longest first, so a match is
+ ** a table lookup followed by a memcmp for each candidate.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef LITERALSET_H
+#define LITERALSET_H
+
+namespace Lexilla {
+
+class LiteralSet {
+	std::vector<std::string> literals;
+	// Indices into literals sorted by first byte then by decreasing length
+	std::vector<int> order;
+	// Literals starting with byte b are order[starts[b]] .. order[starts[b+1]-1]
+	int starts[0x100 + 1] = {};
+	size_t maxLength = 0;
+
+public:
+	explicit LiteralSet(std::initializer_list<const char *> literals_) {
+		for (const char *literal : literals_) {
+			assert(literal && *literal);
+			literals.emplace_back(literal);
+			maxLength = std::max(maxLength, literals.back().length());
+		}
+		for (int i = 0; i < static_cast<int>(literals.size()); i++) {
+			order.push_back(i);
+		}
+		std::stable_sort(order.begin(), order.end(), [this](int a, int b) noexcept {
+			const unsigned char firstA = literals[a][0];
+			const unsigned char firstB = literals[b][0];
+			if (firstA != firstB)
+				return firstA < firstB;
+			return literals[a].length() > literals[b].length();
+		});
+		int position = 0;
+		for (int b = 0; b <= 0x100; b++) {
+			while ((position < static_cast<int>(order.size())) &&
+				(static_cast<unsigned char>(literals[order[position]][0]) < b)) {
+				position++;
+			}
+			starts[b] = position;
+		}
+	}
+	size_t MaxLength() const noexcept {
+		return maxLength;
+	}
+	size_t Length(int index) const noexcept {
+		return literals[index].length();
+	}
+	const std::string &Literal(int index) const noexcept {
+		return literals[index];
+	}
+	/** Index of the longest literal that is a prefix of the length bytes at text, -1 when none is.
+	 * When literals are the same length the one listed first wins. */
+	int Match(const char *text, size_t length) const noexcept {
+		if (length == 0)
+			return -1;
+		const unsigned char first = text[0];
+		for (int position = starts[first]; position < starts[first + 1]; position++) {
+			const std::string &literal = literals[order[position]];
+			if ((literal.length() <= length) && (memcmp(text, literal.data(), literal.length()) == 0)) {
+				return order[position];
+			}
+		}
+		return -1;
+	}
+};
+
+}
+
+#endif
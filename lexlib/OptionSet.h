@@ -3,6 +3,8 @@
  ** Manage descriptive information about an options struct for a lexer.
  ** Hold the names, positions, and descriptions of boolean, integer and string options and
  ** allow setting options and retrieving metadata about the options.
+ ** The options may instead be defined once for a lexer type in an OptionSet::Table shared
+ ** by every instance so an instance's OptionSet only holds the values that have been set.
  **/
 // Copyright 2010 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
@@ -43,6 +45,9 @@ class OptionSet {
 		}
 		bool Set(T *base, const char *val) {
 			value = val;
+			return Apply(base, val);
+		}
+		bool Apply(T *base, const char *val) const {
 			switch (opType) {
 			case SC_TYPE_BOOLEAN: {
 					const bool option = atoi(val) != 0;
@@ -76,6 +81,8 @@ class OptionSet {
 			return value.c_str();
 		}
 	};
+	template <typename E>
+	static plcoi EnumAsInt(E T::*pe) noexcept;
 	typedef std::map<std::string, Option, std::less<std::string>> OptionMap;
 	OptionMap nameToDef;
 	std::string names;
@@ -86,36 +93,108 @@ class OptionSet {
 			names += "\n";
 		names += name;
 	}
+
+public:
+	/** The options of a lexer type, normally a static object, that OptionSets of each instance refer to.
+	 * Names are found with a binary search and nothing is allocated for an instance until an option is set. */
+	class Table {
+		friend class OptionSet;
+	public:
+		struct Definition {
+			const char *name;
+			Option option;
+			Definition(const char *name_, plcob pb, const char *description="") :
+				name(name_), option(pb, description) {
+			}
+			Definition(const char *name_, plcoi pi, const char *description="") :
+				name(name_), option(pi, description) {
+			}
+			Definition(const char *name_, plcos ps, const char *description="") :
+				name(name_), option(ps, description) {
+			}
+			template <typename E>
+			Definition(const char *name_, E T::*pe, const char *description="") :
+				name(name_), option(EnumAsInt(pe), description) {
+			}
+		};
+	private:
+		// In definition order, which is the order of PropertyNames
+		std::vector<Definition> definitions;
+		// Indices of definitions in name order
+		std::vector<int> sorted;
+		std::string names;
+		std::string wordLists;
+		int Find(const char *name) const noexcept {
+			const auto it = std::lower_bound(sorted.begin(), sorted.end(), name,
+				[this](int index, const char *nameFind) noexcept {
+					return strcmp(definitions[index].name, nameFind) < 0;
+				});
+			if ((it != sorted.end()) && (strcmp(definitions[*it].name, name) == 0)) {
+				return *it;
+			}
+			return -1;
+		}
+	public:
+		explicit Table(std::initializer_list<Definition> definitions_,
+			const char * const wordListDescriptions[]=nullptr) : definitions(definitions_) {
+			for (int i = 0; i < static_cast<int>(definitions.size()); i++) {
+				sorted.push_back(i);
+				if (!names.empty())
+					names += "\n";
+				names += definitions[i].name;
+			}
+			std::sort(sorted.begin(), sorted.end(), [this](int a, int b) noexcept {
+				return strcmp(definitions[a].name, definitions[b].name) < 0;
+			});
+			if (wordListDescriptions) {
+				for (size_t wl = 0; wordListDescriptions[wl]; wl++) {
+					if (wl > 0)
+						wordLists += "\n";
+					wordLists += wordListDescriptions[wl];
+				}
+			}
+		}
+	};
+
+private:
+	const Table *table = nullptr;
+	// Values set for the options of table by index, empty until the first PropertySet
+	std::vector<std::string> values;
+
 public:
+	OptionSet() = default;
+	/// Options are those of table which must outlive this, DefineProperty must not be called
+	explicit OptionSet(const Table &table_) noexcept : table(&table_) {
+	}
 	void DefineProperty(const char *name, plcob pb, std::string const& description="") {
+		assert(!table);
 		nameToDef[name] = Option(pb, description);
 		AppendName(name);
 	}
 	void DefineProperty(const char *name, plcoi pi, std::string const& description="") {
+		assert(!table);
 		nameToDef[name] = Option(pi, description);
 		AppendName(name);
 	}
 	void DefineProperty(const char *name, plcos ps, std::string const& description="") {
+		assert(!table);
 		nameToDef[name] = Option(ps, description);
 		AppendName(name);
 	}
 	template <typename E>
 	void DefineProperty(const char *name, E T::*pe, std::string const& description="") {
-#if wxCHECK_CXX_STD(201703L)
-		static_assert(std::is_enum<E>::value);
-#endif
-		plcoi pi {};
-#if wxCHECK_CXX_STD(201703L)
-		static_assert(sizeof(pe) == sizeof(pi));
-#endif
-		memcpy(&pi, &pe, sizeof(pe));
-		nameToDef[name] = Option(pi, description);
+		assert(!table);
+		nameToDef[name] = Option(EnumAsInt(pe), description);
 		AppendName(name);
 	}
 	const char *PropertyNames() const noexcept {
-		return names.c_str();
+		return table ? table->names.c_str() : names.c_str();
 	}
 	int PropertyType(const char *name) const {
+		if (table) {
+			const int index = table->Find(name);
+			return (index >= 0) ? table->definitions[index].option.opType : SC_TYPE_BOOLEAN;
+		}
 		typename OptionMap::const_iterator const it = nameToDef.find(name);
 		if (it != nameToDef.end()) {
 			return it->second.opType;
@@ -123,6 +202,10 @@ public:
 		return SC_TYPE_BOOLEAN;
 	}
 	const char *DescribeProperty(const char *name) const {
+		if (table) {
+			const int index = table->Find(name);
+			return (index >= 0) ? table->definitions[index].option.description.c_str() : "";
+		}
 		typename OptionMap::const_iterator const it = nameToDef.find(name);
 		if (it != nameToDef.end()) {
 			return it->second.description.c_str();
@@ -131,6 +214,17 @@ public:
 	}
 
 	bool PropertySet(T *base, const char *name, const char *val) {
+		if (table) {
+			const int index = table->Find(name);
+			if (index < 0) {
+				return false;
+			}
+			if (values.empty()) {
+				values.resize(table->definitions.size());
+			}
+			values[index] = val;
+			return table->definitions[index].option.Apply(base, val);
+		}
 		typename OptionMap::iterator const it = nameToDef.find(name);
 		if (it != nameToDef.end()) {
 			return it->second.Set(base, val);
@@ -139,6 +233,13 @@ public:
 	}
 
 	const char *PropertyGet(const char *name) const {
+		if (table) {
+			const int index = table->Find(name);
+			if (index < 0) {
+				return nullptr;
+			}
+			return values.empty() ? "" : values[index].c_str();
+		}
 		typename OptionMap::const_iterator const it = nameToDef.find(name);
 		if (it != nameToDef.end()) {
 			return it->second.Get();
@@ -156,11 +257,44 @@ public:
 		}
 	}
 
+	// Bytes held for this instance's options. A Table is shared so is not included.
+	size_t MemoryUse() const noexcept {
+		auto stringBytes = [](const std::string &s) noexcept {
+			return (s.capacity() > std::string().capacity()) ? s.capacity() + 1 : 0;
+		};
+		size_t bytes = stringBytes(names) + stringBytes(wordLists) + values.capacity() * sizeof(std::string);
+		for (const std::string &value : values) {
+			bytes += stringBytes(value);
+		}
+		for (const auto &[name, option] : nameToDef) {
+			bytes += sizeof(typename OptionMap::value_type) + 4 * sizeof(void *) + stringBytes(name) +
+				stringBytes(option.value) + stringBytes(option.description);
+		}
+		return bytes;
+	}
+
 	const char *DescribeWordListSets() const noexcept {
+		if (table && wordLists.empty()) {
+			return table->wordLists.c_str();
+		}
 		return wordLists.c_str();
 	}
 };
 
+template <typename T>
+template <typename E>
+typename OptionSet<T>::plcoi OptionSet<T>::EnumAsInt(E T::*pe) noexcept {
+#if wxCHECK_CXX_STD(201703L)
+	static_assert(std::is_enum<E>::value);
+#endif
+	plcoi pi {};
+#if wxCHECK_CXX_STD(201703L)
+	static_assert(sizeof(pe) == sizeof(pi));
+#endif
+	memcpy(&pi, &pe, sizeof(pe));
+	return pi;
+}
+
 }
 
 #endif
@@ -12,8 +12,10 @@
 #include <cstring>
 
 #include <string>
+#include <vector>
 #include <map>
 #include <functional>
+#include <mutex>
 
 #include "PropSetSimple.h"
 
@@ -21,56 +23,172 @@ using namespace Lexilla;
 
 namespace {
 
-using mapss = std::map<std::string, std::string, std::less<std::string>>;
+struct Entry {
+	std::string value;
+	// Integer value of value, parsed when it is set so reading does not write
+	int number = 0;
+	void SetValue(std::string const& val) {
+		value = val;
+		number = atoi(value.c_str());
+	}
+};
+
+using mapss = std::map<std::string, Entry, std::less<std::string>>;
+
+struct Properties {
+	mapss props;
+	// Entries for each PropertyKey by its index, filled in by Set when an entry is added so reads only
+	// look. Entries are never removed so these stay valid
+	std::vector<Entry *> keyed;
+};
+
+Properties *PropsFromPointer(void *impl) noexcept {
+	return static_cast<Properties *>(impl);
+}
+
+int EntryInt(const Entry &entry, int defaultValue) noexcept {
+	if (entry.value.empty()) {
+		return defaultValue;
+	}
+	return entry.number;
+}
+
+// Index of each PropertyKey declared by its name. Declaring is rare so a lock is cheap enough
+struct KeyRegistry {
+	std::mutex mutex;
+	std::multimap<std::string, int> indices;
+	int declared = 0;
+};
 
-mapss *PropsFromPointer(void *impl) noexcept {
-	return static_cast<mapss *>(impl);
+KeyRegistry &Registry() {
+	static KeyRegistry registry;
+	return registry;
 }
 
+// Heap bytes of a string, none while it fits in the string object
+size_t StringBytes(const std::string &s) noexcept {
+	return (s.capacity() > std::string().capacity()) ? s.capacity() + 1 : 0;
+}
+
+}
+
+PropertyKey::PropertyKey(const char *key_) : key(key_), index(0) {
+	KeyRegistry &registry = Registry();
+	std::lock_guard<std::mutex> guard(registry.mutex);
+	index = registry.declared++;
+	registry.indices.emplace(key_, index);
 }
 
 PropSetSimple::PropSetSimple() {
-	mapss *props = new mapss;
+	Properties *props = new Properties;
 	impl = static_cast<void *>(props);
 }
 
 PropSetSimple::~PropSetSimple() {
-	mapss *props = PropsFromPointer(impl);
+	Properties *props = PropsFromPointer(impl);
 	delete props;
 	impl = nullptr;
 }
 
 bool PropSetSimple::Set(std::string const& key, std::string const& val) {
-	mapss *props = PropsFromPointer(impl);
+	Properties *props = PropsFromPointer(impl);
 	if (!props)
 		return false;
-	mapss::iterator const it = props->find(key);
-	if (it != props->end()) {
-		if (val == it->second)
+	mapss::iterator const it = props->props.find(key);
+	if (it != props->props.end()) {
+		if (val == it->second.value)
 			return false;
-		it->second = val;
+		it->second.SetValue(val);
 	} else {
-		props->emplace(key, val);
+		Entry *entry = &props->props[key];
+		entry->SetValue(val);
+		// Point the keys with this name at the new entry
+		KeyRegistry &registry = Registry();
+		std::lock_guard<std::mutex> guard(registry.mutex);
+		const auto [first, last] = registry.indices.equal_range(key);
+		for (auto named = first; named != last; ++named) {
+			const size_t slot = named->second;
+			if (slot >= props->keyed.size()) {
+				props->keyed.resize(slot + 1);
+			}
+			props->keyed[slot] = entry;
+		}
 	}
 	return true;
 }
 
+void PropSetSimple::Clear() noexcept {
+	Properties *props = PropsFromPointer(impl);
+	if (!props)
+		return;
+	for (std::pair<const std::string, Entry> &it : props->props) {
+		it.second.value.clear();
+	}
+}
+
 const char *PropSetSimple::Get(std::string const& key) const {
-	mapss *props = PropsFromPointer(impl);
+	Properties *props = PropsFromPointer(impl);
 	if (props) {
-		mapss::const_iterator const keyPos = props->find(key);
-		if (keyPos != props->end()) {
-			return keyPos->second.c_str();
+		mapss::const_iterator const keyPos = props->props.find(key);
+		if (keyPos != props->props.end()) {
+			return keyPos->second.value.c_str();
 		}
 	}
 	return "";
 }
 
 int PropSetSimple::GetInt(std::string const& key, int defaultValue) const {
-	const char *val = Get(key);
-	assert(val);
-	if (*val) {
-		return atoi(val);
+	const Properties *props = PropsFromPointer(impl);
+	if (props) {
+		mapss::const_iterator const keyPos = props->props.find(key);
+		if (keyPos != props->props.end()) {
+			return EntryInt(keyPos->second, defaultValue);
+		}
 	}
 	return defaultValue;
 }
+
+int PropSetSimple::GetInt(const PropertyKey &key, int defaultValue) const {
+	const Properties *props = PropsFromPointer(impl);
+	if (!props)
+		return defaultValue;
+	// Only reads so any number of threads can call this at once
+	const size_t index = key.Index();
+	if ((index < props->keyed.size()) && props->keyed[index]) {
+		return EntryInt(*props->keyed[index], defaultValue);
+	}
+	// Not set, or set before the key was declared
+	mapss::const_iterator const keyPos = props->props.find(key.Key());
+	if (keyPos != props->props.end()) {
+		return EntryInt(keyPos->second, defaultValue);
+	}
+	return defaultValue;
+}
+
+void PropSetSimple::AppendSettings(std::string &settings) const {
+	const Properties *props = PropsFromPointer(impl);
+	if (!props)
+		return;
+	for (const auto &[key, entry] : props->props) {
+		// Empty values read the same as missing ones
+		if (!entry.value.empty()) {
+			settings.append(key);
+			settings.push_back('=');
+			settings.append(entry.value);
+			settings.push_back('\n');
+		}
+	}
+}
+
+size_t PropSetSimple::MemoryUse() const noexcept {
+	const Properties *props = PropsFromPointer(impl);
+	if (!props)
+		return 0;
+	// Each map node holds its value and, in common implementations, 3 links and a colour
+	constexpr size_t nodeBytes = sizeof(mapss::value_type) + 4 * sizeof(void *);
+	size_t bytes = sizeof(Properties) + props->keyed.capacity() * sizeof(Entry *);
+	for (const auto &[key, entry] : props->props) {
+		bytes += nodeBytes + StringBytes(key) + StringBytes(entry.value);
+	}
+	return bytes;
+}
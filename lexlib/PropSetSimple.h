@@ -10,6 +10,21 @@
 
 namespace Lexilla {
 
+/** A property name declared once, normally as a static object, that can be read from any
+ * PropSetSimple without building a string or searching for the name after the first read. */
+class PropertyKey {
+	const char *key;
+	int index;
+public:
+	explicit PropertyKey(const char *key_);
+	const char *Key() const noexcept {
+		return key;
+	}
+	int Index() const noexcept {
+		return index;
+	}
+};
+
 class PropSetSimple {
 	void *impl;
 public:
@@ -22,8 +37,19 @@ public:
 	virtual ~PropSetSimple();
 
 	bool Set(std::string const& key, std::string const& val);
+	/** Empty every value. Entries and their string buffers are kept for the next values set and
+	 * an empty value reads the same as a missing one. */
+	void Clear() noexcept;
 	const char *Get(std::string const& key) const;
 	int GetInt(std::string const& key, int defaultValue=0) const;
+	/** The value of key parsed as an integer. Set remembers the entry for each key declared with its
+	 * name, and parses the value, so calls do not search or parse and never change the set. */
+	int GetInt(const PropertyKey &key, int defaultValue=0) const;
+	/** Append "key=value\n" for every property with a value, in order of key, so two sets
+	 * with the same values give the same text. */
+	void AppendSettings(std::string &settings) const;
+	/** Bytes held for the entries, estimating the map's nodes. */
+	size_t MemoryUse() const noexcept;
 };
 
 }
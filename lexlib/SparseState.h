@@ -12,29 +12,234 @@
 
 namespace Lexilla {
 
+/// A state set at position, held in order by a SparseState's storage
 template <typename T>
-class SparseState {
-	struct State {
-		Sci_Position position;
-		T value;
-		State(Sci_Position position_, T value_) noexcept :
-			position(position_), value(std::move(value_)) {
+struct SparseStateEntry {
+	Sci_Position position;
+	T value;
+	SparseStateEntry(Sci_Position position_, T value_) noexcept :
+		position(position_), value(std::move(value_)) {
+	}
+	inline bool operator==(const SparseStateEntry &other) const noexcept {
+		return (position == other.position) && (value == other.value);
+	}
+};
+
+/// The default storage of SparseState: one vector of entries
+template <typename T>
+class VectorStates {
+	typedef SparseStateEntry<T> Entry;
+	std::vector<Entry> entries;
+public:
+	size_t size() const noexcept {
+		return entries.size();
+	}
+	Sci_Position Position(size_t index) const noexcept {
+		return entries[index].position;
+	}
+	const T &Value(size_t index) const noexcept {
+		return entries[index].value;
+	}
+	// Index of the first entry at or after position
+	size_t LowerBound(Sci_Position position) const noexcept {
+		const auto it = std::lower_bound(entries.begin(), entries.end(), position,
+			[](const Entry &entry, Sci_Position pos) noexcept { return entry.position < pos; });
+		return it - entries.begin();
+	}
+	void Truncate(size_t length) {
+		if (length < entries.size()) {
+			entries.erase(entries.begin() + length, entries.end());
 		}
-		inline bool operator<(const State &other) const noexcept {
-			return position < other.position;
+	}
+	void PushBack(Sci_Position position, T value) {
+		entries.emplace_back(position, std::move(value));
+	}
+	// Number of entries from start that are equal to those of other from startOther
+	size_t Matching(size_t start, const VectorStates &other, size_t startOther) const noexcept {
+		const auto [mismatch, mismatchOther] = std::mismatch(entries.begin() + start, entries.end(),
+			other.entries.begin() + startOther, other.entries.end());
+		return mismatch - (entries.begin() + start);
+	}
+	void Append(const VectorStates &other, size_t startOther) {
+		entries.insert(entries.end(), other.entries.begin() + startOther, other.entries.end());
+	}
+	size_t MemoryUse() const noexcept {
+		return entries.capacity() * sizeof(Entry);
+	}
+};
+
+/** Storage for SparseState that holds entries in fixed size chunks, for lexers that may set tens of thousands
+ * of states. Growing never copies the entries already held and truncating releases the chunks after the end,
+ * so a document whose states are rebuilt after each edit does not repeatedly copy or keep every state.
+ * Each chunk holds its positions as 32 bit deltas from its first position and its values in an array of their
+ * own, so an int state takes 8 bytes where an entry takes 16. A chunk whose states span 4 GB or more holds
+ * full positions instead.
+ * Lookups are a binary search of the first position of each chunk and then of one chunk. */
+template <typename T>
+class ChunkedStates {
+	static constexpr size_t chunkBits = 8;
+	static constexpr size_t chunkSize = 1 << chunkBits;
+	struct Chunk {
+		// Position of each entry less the first, empty when wide holds the positions
+		std::vector<std::uint32_t> deltas;
+		std::vector<Sci_Position> wide;
+		std::vector<T> values;
+	};
+	// Each chunk but the last is full and no chunk is empty
+	std::vector<Chunk> chunks;
+	std::vector<Sci_Position> firsts;
+	size_t length = 0;
+public:
+	size_t size() const noexcept {
+		return length;
+	}
+	Sci_Position Position(size_t index) const noexcept {
+		const Chunk &chunk = chunks[index >> chunkBits];
+		const size_t offset = index & (chunkSize - 1);
+		return chunk.wide.empty() ? firsts[index >> chunkBits] + chunk.deltas[offset] : chunk.wide[offset];
+	}
+	const T &Value(size_t index) const noexcept {
+		return chunks[index >> chunkBits].values[index & (chunkSize - 1)];
+	}
+	size_t LowerBound(Sci_Position position) const noexcept {
+		// The entry is in the last chunk starting before position or at the start of the chunk after it
+		const size_t after = std::lower_bound(firsts.begin(), firsts.end(), position) - firsts.begin();
+		if (after == 0) {
+			return 0;
 		}
-		inline bool operator==(const State &other) const noexcept {
-			return (position == other.position) && (value == other.value);
+		const Chunk &chunk = chunks[after - 1];
+		size_t offset = 0;
+		if (chunk.wide.empty()) {
+			const std::uint64_t delta = position - firsts[after - 1];
+			offset = std::lower_bound(chunk.deltas.begin(), chunk.deltas.end(), delta,
+				[](std::uint32_t deltaEntry, std::uint64_t d) noexcept { return deltaEntry < d; }) -
+				chunk.deltas.begin();
+		} else {
+			offset = std::lower_bound(chunk.wide.begin(), chunk.wide.end(), position) - chunk.wide.begin();
 		}
-	};
-	Sci_Position positionFirst;
-	typedef std::vector<State> stateVector;
-	stateVector states;
-
-	typename stateVector::iterator Find(Sci_Position position) {
-		const State searchValue(position, T());
-		return std::lower_bound(states.begin(), states.end(), searchValue);
+		return ((after - 1) << chunkBits) + offset;
+	}
+	void Truncate(size_t newLength) {
+		if (newLength >= length) {
+			return;
+		}
+		const size_t kept = (newLength + chunkSize - 1) >> chunkBits;
+		chunks.resize(kept);
+		firsts.resize(kept);
+		if (kept > 0) {
+			Chunk &last = chunks.back();
+			const size_t lengthLast = newLength - ((kept - 1) << chunkBits);
+			last.values.erase(last.values.begin() + lengthLast, last.values.end());
+			if (last.wide.empty()) {
+				last.deltas.resize(lengthLast);
+			} else {
+				last.wide.resize(lengthLast);
+			}
+		}
+		length = newLength;
+	}
+	void PushBack(Sci_Position position, T value) {
+		if ((length & (chunkSize - 1)) == 0) {
+			chunks.emplace_back();
+			chunks.back().deltas.reserve(chunkSize);
+			chunks.back().values.reserve(chunkSize);
+			firsts.push_back(position);
+		}
+		Chunk &chunk = chunks.back();
+		const std::uint64_t delta = position - firsts.back();
+		if (chunk.wide.empty() && (delta > 0xffffffffU)) {
+			// Too far from the first position for a delta so the chunk changes to holding positions
+			for (const std::uint32_t deltaEntry : chunk.deltas) {
+				chunk.wide.push_back(firsts.back() + deltaEntry);
+			}
+			std::vector<std::uint32_t>().swap(chunk.deltas);
+		}
+		if (chunk.wide.empty()) {
+			chunk.deltas.push_back(static_cast<std::uint32_t>(delta));
+		} else {
+			chunk.wide.push_back(position);
+		}
+		chunk.values.push_back(std::move(value));
+		length++;
 	}
+	// Compares and copies a run of entries within one chunk of each at a time. The deltas of chunks starting
+	// at different positions are compared and copied after shifting by the difference of their firsts
+	size_t Matching(size_t start, const ChunkedStates &other, size_t startOther) const noexcept {
+		size_t matched = 0;
+		while ((start + matched < length) && (startOther + matched < other.length)) {
+			const size_t index = start + matched;
+			const size_t indexOther = startOther + matched;
+			const Chunk &chunk = chunks[index >> chunkBits];
+			const Chunk &chunkOther = other.chunks[indexOther >> chunkBits];
+			const size_t offset = index & (chunkSize - 1);
+			const size_t offsetOther = indexOther & (chunkSize - 1);
+			const size_t span = std::min(chunk.values.size() - offset, chunkOther.values.size() - offsetOther);
+			const auto values = chunk.values.begin() + offset;
+			const size_t sameValues = std::mismatch(values, values + span,
+				chunkOther.values.begin() + offsetOther).first - values;
+			size_t same = 0;
+			if (chunk.wide.empty() && chunkOther.wide.empty()) {
+				const Sci_Position shift = firsts[index >> chunkBits] - other.firsts[indexOther >> chunkBits];
+				while ((same < sameValues) && (chunk.deltas[offset + same] + shift ==
+					static_cast<Sci_Position>(chunkOther.deltas[offsetOther + same]))) {
+					same++;
+				}
+			} else {
+				while ((same < sameValues) && (Position(index + same) == other.Position(indexOther + same))) {
+					same++;
+				}
+			}
+			matched += same;
+			if (same < span) {
+				break;
+			}
+		}
+		return matched;
+	}
+	void Append(const ChunkedStates &other, size_t startOther) {
+		size_t index = startOther;
+		while (index < other.length) {
+			const Chunk &chunkOther = other.chunks[index >> chunkBits];
+			const size_t offsetOther = index & (chunkSize - 1);
+			const Sci_Position shift = other.firsts.empty() || chunks.empty() ? 0 :
+				other.firsts[index >> chunkBits] - firsts.back();
+			const size_t span = chunks.empty() ? 0 : std::min(chunkSize - chunks.back().values.size(),
+				chunkOther.values.size() - offsetOther);
+			if ((span == 0) || !chunkOther.wide.empty() || !chunks.back().wide.empty() ||
+				(static_cast<std::uint64_t>(chunkOther.deltas[offsetOther + span - 1] + shift) > 0xffffffffU)) {
+				// Starting a chunk or with full positions the entries are added one at a time
+				PushBack(other.Position(index), other.Value(index));
+				index++;
+				continue;
+			}
+			Chunk &last = chunks.back();
+			const size_t held = last.deltas.size();
+			last.deltas.resize(held + span);
+			const auto deltas = chunkOther.deltas.begin() + offsetOther;
+			std::transform(deltas, deltas + span, last.deltas.begin() + held, [shift](std::uint32_t delta) noexcept {
+				return static_cast<std::uint32_t>(delta + shift);
+			});
+			last.values.insert(last.values.end(), chunkOther.values.begin() + offsetOther,
+				chunkOther.values.begin() + offsetOther + span);
+			length += span;
+			index += span;
+		}
+	}
+	size_t MemoryUse() const noexcept {
+		size_t memory = chunks.capacity() * sizeof(Chunk) + firsts.capacity() * sizeof(Sci_Position);
+		for (const Chunk &chunk : chunks) {
+			memory += chunk.deltas.capacity() * sizeof(std::uint32_t) + chunk.wide.capacity() * sizeof(Sci_Position) +
+				chunk.values.capacity() * sizeof(T);
+		}
+		return memory;
+	}
+};
+
+/// Storage is VectorStates or ChunkedStates, chosen by each lexer for how many states it expects
+template <typename T, template <typename> class Storage=VectorStates>
+class SparseState {
+	Sci_Position positionFirst;
+	Storage<T> states;
 
 public:
 	explicit SparseState(Sci_Position positionFirst_=-1) {
@@ -42,29 +247,29 @@ public:
 	}
 	void Set(Sci_Position position, T value) {
 		Delete(position);
-		if (states.empty() || (value != states[states.size()-1].value)) {
-			states.push_back(State(position, value));
+		if ((states.size() == 0) || (value != states.Value(states.size()-1))) {
+			states.PushBack(position, std::move(value));
 		}
 	}
 	T ValueAt(Sci_Position position) {
-		if (states.empty())
+		if (states.size() == 0)
 			return T();
-		if (position < states[0].position)
+		if (position < states.Position(0))
 			return T();
-		typename stateVector::iterator low = Find(position);
-		if (low == states.end()) {
-			return states[states.size()-1].value;
+		size_t low = states.LowerBound(position);
+		if (low == states.size()) {
+			return states.Value(states.size()-1);
 		} else {
-			if (low->position > position) {
+			if (states.Position(low) > position) {
 				--low;
 			}
-			return low->value;
+			return states.Value(low);
 		}
 	}
 	bool Delete(Sci_Position position) {
-		typename stateVector::iterator low = Find(position);
-		if (low != states.end()) {
-			states.erase(low, states.end());
+		const size_t low = states.LowerBound(position);
+		if (low != states.size()) {
+			states.Truncate(low);
 			return true;
 		}
 		return false;
@@ -72,31 +277,36 @@ public:
 	size_t size() const {
 		return states.size();
 	}
+	// Bytes held by the storage of states, not including any memory owned by values
+	size_t MemoryUse() const noexcept {
+		return states.MemoryUse();
+	}
 
 	// Returns true if Merge caused a significant change
-	bool Merge(const SparseState<T> &other, Sci_Position ignoreAfter) {
+	bool Merge(const SparseState &other, Sci_Position ignoreAfter) {
 		// Changes caused beyond ignoreAfter are not significant
 		Delete(ignoreAfter+1);
 
+		const size_t sizeOther = other.states.size();
 		bool different = true;
 		bool changed = false;
-		typename stateVector::iterator low = Find(other.positionFirst);
-		if (static_cast<size_t>(states.end() - low) == other.states.size()) {
+		const size_t low = states.LowerBound(other.positionFirst);
+		if (states.size() - low == sizeOther) {
 			// Same number in other as after positionFirst in this
-			different = !std::equal(low, states.end(), other.states.begin());
+			different = states.Matching(low, other.states, 0) != sizeOther;
 		}
 		if (different) {
-			if (low != states.end()) {
-				states.erase(low, states.end());
-				changed = true;
-			}
-			typename stateVector::const_iterator startOther = other.states.begin();
-			if (!states.empty() && !other.states.empty() && states.back().value == startOther->value)
+			changed = low != states.size();
+			size_t startOther = 0;
+			if ((low > 0) && (sizeOther > 0) && (states.Value(low - 1) == other.states.Value(0)))
 				++startOther;
-			if (startOther != other.states.end()) {
-				states.insert(states.end(), startOther, other.states.end());
+			if (startOther != sizeOther) {
 				changed = true;
 			}
+			// States already equal to those merged are kept instead of being erased and copied again
+			const size_t matched = states.Matching(low, other.states, startOther);
+			states.Truncate(low + matched);
+			states.Append(other.states, startOther + matched);
 		}
 		return changed;
 	}
@@ -0,0 +1,235 @@
+// Scintilla source code edit control
+/** @file StyleCache.cxx
+ ** Save the styling of a document to a file and restore it without lexing.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include "ILexer.h"
+
+#include "StyleCache.h"
+
+using namespace Lexilla;
+
+namespace {
+
+constexpr char magic[8] = { 'L', 'X', 'S', 'T', 'Y', 'L', 'E', '1' };
+
+struct Header {
+	char magic[8];
+	std::uint64_t key;
+	std::uint64_t length;
+	std::uint64_t lines;
+	std::uint64_t runs;
+};
+
+// Multiply and shift mixing of 8 bytes at a time, much faster than a byte at a time for
+// documents of many megabytes and good enough to tell different versions of a file apart.
+constexpr std::uint64_t hashMultiplier = 0x9E3779B97F4A7C15ULL;
+
+constexpr std::uint64_t Mix(std::uint64_t hash, std::uint64_t value) noexcept {
+	hash = (hash ^ value) * hashMultiplier;
+	return hash ^ (hash >> 29);
+}
+
+std::uint64_t HashBytes(std::uint64_t hash, const char *bytes, size_t length) noexcept {
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8) {
+		std::uint64_t value;
+		memcpy(&value, bytes + i, 8);
+		hash = Mix(hash, value);
+	}
+	if (i < length) {
+		std::uint64_t value = 0;
+		memcpy(&value, bytes + i, length - i);
+		hash = Mix(hash, value);
+	}
+	return Mix(hash, length);
+}
+
+constexpr Sci_Position blockSize = 0x10000;
+
+Sci_Position LineCount(Scintilla::IDocument *pAccess) {
+	return pAccess->LineFromPosition(pAccess->Length()) + 1;
+}
+
+class File {
+	std::FILE *fp;
+public:
+	File(const char *path, const char *mode) noexcept : fp(std::fopen(path, mode)) {
+	}
+	// Deleted so File objects can not be copied.
+	File(const File &) = delete;
+	File(File &&) = delete;
+	File &operator=(const File &) = delete;
+	File &operator=(File &&) = delete;
+	~File() {
+		if (fp)
+			std::fclose(fp);
+	}
+	explicit operator bool() const noexcept {
+		return fp != nullptr;
+	}
+	template <typename T>
+	bool Write(const T *values, size_t count) noexcept {
+		return std::fwrite(values, sizeof(T), count, fp) == count;
+	}
+	template <typename T>
+	bool Read(T *values, size_t count) noexcept {
+		return std::fread(values, sizeof(T), count, fp) == count;
+	}
+	bool Close() noexcept {
+		const bool closed = std::fclose(fp) == 0;
+		fp = nullptr;
+		return closed;
+	}
+};
+
+}
+
+std::uint64_t Lexilla::HashDocumentText(Scintilla::IDocument *pAccess) {
+	const Sci_Position length = pAccess->Length();
+	std::vector<char> block(blockSize);
+	std::uint64_t hash = 0;
+	for (Sci_Position position = 0; position < length; position += blockSize) {
+		const Sci_Position lengthBlock = std::min(blockSize, length - position);
+		pAccess->GetCharRange(block.data(), position, lengthBlock);
+		hash = HashBytes(hash, block.data(), lengthBlock);
+	}
+	return Mix(hash, length);
+}
+
+std::uint64_t Lexilla::HashLexerSettings(Scintilla::ILexer5 *pLexer, std::string_view extra) {
+	std::string settings;
+	const char *name = pLexer->GetName();
+	settings.append(name ? name : "");
+	settings.push_back('\n');
+	if (pLexer->PrivateCall(privateCallLexSettings, &settings)) {
+		settings.append(extra);
+		return HashBytes(0, settings.data(), settings.size());
+	}
+	const char *names = pLexer->PropertyNames();
+	std::string_view remaining(names ? names : "");
+	while (!remaining.empty()) {
+		const size_t separator = remaining.find('\n');
+		const std::string property(remaining.substr(0, separator));
+		remaining.remove_prefix((separator == std::string_view::npos) ? remaining.size() : separator + 1);
+		if (!property.empty()) {
+			const char *value = pLexer->PropertyGet(property.c_str());
+			settings.append(property);
+			settings.push_back('=');
+			settings.append(value ? value : "");
+			settings.push_back('\n');
+		}
+	}
+	settings.append(extra);
+	return HashBytes(0, settings.data(), settings.size());
+}
+
+std::uint64_t Lexilla::StyleCacheKey(Scintilla::IDocument *pAccess, Scintilla::ILexer5 *pLexer, std::string_view extra) {
+	return Mix(HashDocumentText(pAccess), HashLexerSettings(pLexer, extra));
+}
+
+bool Lexilla::StyleCacheSave(const char *path, Scintilla::IDocument *pAccess, std::uint64_t key) {
+	const Sci_Position length = pAccess->Length();
+	const Sci_Position lines = LineCount(pAccess);
+
+	std::vector<std::uint32_t> runLengths;
+	std::vector<unsigned char> runStyles;
+	for (Sci_Position position = 0; position < length;) {
+		const char style = pAccess->StyleAt(position);
+		Sci_Position end = position + 1;
+		while ((end < length) && (pAccess->StyleAt(end) == style) && (end - position < UINT32_MAX)) {
+			end++;
+		}
+		runLengths.push_back(static_cast<std::uint32_t>(end - position));
+		runStyles.push_back(static_cast<unsigned char>(style));
+		position = end;
+	}
+
+	std::vector<std::int32_t> lineStates(lines);
+	std::vector<std::int32_t> levels(lines);
+	for (Sci_Position line = 0; line < lines; line++) {
+		lineStates[line] = pAccess->GetLineState(line);
+		levels[line] = pAccess->GetLevel(line);
+	}
+
+	Header header {};
+	memcpy(header.magic, magic, sizeof(magic));
+	header.key = key;
+	header.length = length;
+	header.lines = lines;
+	header.runs = runLengths.size();
+
+	File file(path, "wb");
+	if (!file) {
+		return false;
+	}
+	const bool written = file.Write(&header, 1) &&
+		file.Write(runLengths.data(), runLengths.size()) &&
+		file.Write(lineStates.data(), lineStates.size()) &&
+		file.Write(levels.data(), levels.size()) &&
+		file.Write(runStyles.data(), runStyles.size());
+	const bool closed = file.Close();
+	if (!written || !closed) {
+		std::remove(path);
+		return false;
+	}
+	return true;
+}
+
+bool Lexilla::StyleCacheRestore(const char *path, Scintilla::IDocument *pAccess, std::uint64_t key) {
+	File file(path, "rb");
+	if (!file) {
+		return false;
+	}
+	Header header {};
+	if (!file.Read(&header, 1) || (memcmp(header.magic, magic, sizeof(magic)) != 0)) {
+		return false;
+	}
+	const Sci_Position length = pAccess->Length();
+	const Sci_Position lines = LineCount(pAccess);
+	if ((header.key != key) ||
+		(header.length != static_cast<std::uint64_t>(length)) ||
+		(header.lines != static_cast<std::uint64_t>(lines)) ||
+		(header.runs > header.length)) {
+		return false;
+	}
+
+	// Read everything before changing the document so a truncated file changes nothing
+	std::vector<std::uint32_t> runLengths(header.runs);
+	std::vector<std::int32_t> lineStates(lines);
+	std::vector<std::int32_t> levels(lines);
+	std::vector<unsigned char> runStyles(header.runs);
+	if (!file.Read(runLengths.data(), runLengths.size()) ||
+		!file.Read(lineStates.data(), lineStates.size()) ||
+		!file.Read(levels.data(), levels.size()) ||
+		!file.Read(runStyles.data(), runStyles.size())) {
+		return false;
+	}
+	std::uint64_t total = 0;
+	for (const std::uint32_t runLength : runLengths) {
+		total += runLength;
+	}
+	if (total != header.length) {
+		return false;
+	}
+
+	pAccess->StartStyling(0);
+	for (size_t run = 0; run < runLengths.size(); run++) {
+		pAccess->SetStyleFor(runLengths[run], static_cast<char>(runStyles[run]));
+	}
+	for (Sci_Position line = 0; line < lines; line++) {
+		pAccess->SetLineState(line, lineStates[line]);
+		pAccess->SetLevel(line, levels[line]);
+	}
+	return true;
+}
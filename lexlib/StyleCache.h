@@ -0,0 +1,46 @@
+// Scintilla source code edit control
+/** @file StyleCache.h
+ ** Save the styling of a document to a file and restore it without lexing.
+ ** The file holds the style runs, line states and fold levels of the whole document with a key
+ ** made from the text and the lexer settings so it is only used for the same text styled the
+ ** same way. Reopening a large file can then apply the saved styles instead of lexing again.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef STYLECACHE_H
+#define STYLECACHE_H
+
+namespace Lexilla {
+
+// Hash of the whole text of pAccess, read in blocks so any IDocument can be hashed.
+std::uint64_t HashDocumentText(Scintilla::IDocument *pAccess);
+
+// Hash of the lexer's name and its settings. Lexers answering privateCallLexSettings give every
+// property and word list set. For others only the values of the properties named in PropertyNames
+// are known so word lists and any other setting that affects styling should be passed as extra.
+std::uint64_t HashLexerSettings(Scintilla::ILexer5 *pLexer, std::string_view extra = {});
+
+// ILexer5::PrivateCall(privateCallLexSettings, pointer to a std::string) appends every setting of the
+// lexer, its properties and word lists, as text to the string and returns the pointer. Lexers with
+// no way to list their settings return nullptr.
+constexpr int privateCallLexSettings = 0x4C585031;	// "LXP1"
+
+// The key of a document styled by pLexer, combining the two hashes above.
+std::uint64_t StyleCacheKey(Scintilla::IDocument *pAccess, Scintilla::ILexer5 *pLexer, std::string_view extra = {});
+
+// Write the styles, line states and fold levels of the whole of pAccess to path, returning false
+// if the file could not be written.
+// The file is a header followed by arrays in the byte order of the machine, each aligned for its
+// type so the file may also be mapped into memory and read in place:
+//	char magic[8], uint64 key, uint64 length, uint64 lines, uint64 runs
+//	uint32 runLengths[runs], int32 lineStates[lines], int32 levels[lines], uint8 runStyles[runs]
+bool StyleCacheSave(const char *path, Scintilla::IDocument *pAccess, std::uint64_t key);
+
+// When path holds styling saved with key for a document of the same length and number of lines,
+// apply it to pAccess with SetStyleFor, SetLineState and SetLevel and return true.
+// Otherwise leave pAccess unchanged and return false so the caller lexes as usual.
+bool StyleCacheRestore(const char *path, Scintilla::IDocument *pAccess, std::uint64_t key);
+
+}
+
+#endif
@@ -8,22 +8,100 @@
 #include <cstdlib>
 #include <cstdint>
 #include <cassert>
+#include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
 
 #include "ILexer.h"
 
+#include "LexCounters.h"
+#include "LexTrace.h"
 #include "LexAccessor.h"
 #include "Accessor.h"
 #include "StyleContext.h"
 #include "LexCharacterSet.h"
+#include "LiteralSet.h"
 
 using namespace Lexilla;
 
+namespace {
+
+constexpr bool IsTrailByte(unsigned char ch) noexcept {
+	return (ch >= 0x80) && (ch < 0xC0);
+}
+
+// Width of a valid sequence starting with leadByte, 0 when leadByte can not start a sequence
+constexpr int BytesOfLead(unsigned char leadByte) noexcept {
+	if (leadByte < 0xC2)
+		return 0;
+	if (leadByte < 0xE0)
+		return 2;
+	if (leadByte < 0xF0)
+		return 3;
+	if (leadByte < 0xF5)
+		return 4;
+	return 0;
+}
+
+}
+
+int StyleContext::DecodeUTF8(Sci_PositionU position, unsigned char leadByte, Sci_Position &widthChar) {
+	// Follows the validation of Scintilla's UTF8Classify so styles match the characters Scintilla displays
+	const int invalid = 0xDC80 + leadByte;
+	const int widthCharBytes = BytesOfLead(leadByte);
+	if (widthCharBytes == 0) {
+		return invalid;
+	}
+	unsigned char us[4] = { leadByte, 0, 0, 0 };
+	for (int b = 1; b < widthCharBytes; b++) {
+		us[b] = styler.SafeGetCharAt(position + b, 0);
+		if (!IsTrailByte(us[b])) {
+			return invalid;
+		}
+	}
+	int character = 0;
+	switch (widthCharBytes) {
+	case 2:
+		character = ((us[0] & 0x1F) << 6) | (us[1] & 0x3F);
+		break;
+	case 3:
+		if ((us[0] == 0xE0) && (us[1] < 0xA0)) {
+			return invalid;	// Overlong
+		}
+		if ((us[0] == 0xED) && (us[1] >= 0xA0)) {
+			return invalid;	// Surrogate
+		}
+		character = ((us[0] & 0xF) << 12) | ((us[1] & 0x3F) << 6) | (us[2] & 0x3F);
+		if (character >= 0xFFFE) {
+			return invalid;	// U+FFFE and U+FFFF non-characters
+		}
+		break;
+	default:
+		if ((us[0] == 0xF0) && (us[1] < 0x90)) {
+			return invalid;	// Overlong
+		}
+		if ((us[0] == 0xF4) && (us[1] > 0x8F)) {
+			return invalid;	// Beyond U+10FFFF
+		}
+		character = ((us[0] & 0x7) << 18) | ((us[1] & 0x3F) << 12) | ((us[2] & 0x3F) << 6) | (us[3] & 0x3F);
+		if ((character & 0xFFFE) == 0xFFFE) {
+			return invalid;	// Plane-final non-characters
+		}
+		break;
+	}
+	widthChar = widthCharBytes;
+	return character;
+}
+
 StyleContext::StyleContext(Sci_PositionU startPos, Sci_PositionU length,
 	int initStyle, LexAccessor &styler_, char chMask) :
 	styler(styler_),
 	multiByteAccess((styler.Encoding() == EncodingType::eightBit) ? nullptr : styler.MultiByteAccess()),
+	decodeUTF8(styler.Encoding() == EncodingType::unicode),
 	lengthDocument(static_cast<Sci_PositionU>(styler.Length())),
 	endPos(((startPos + length) < lengthDocument) ? (startPos + length) : (lengthDocument+1)),
 	lineDocEnd(styler.GetLine(lengthDocument)),
@@ -56,6 +134,16 @@ bool StyleContext::MatchIgnoreCase(const char *s) {
 	if (MakeLowerCase(chNext) != static_cast<unsigned char>(*s))
 		return false;
 	s++;
+	const size_t len = strlen(s);
+	Sci_Position available = 0;
+	const char *text = styler.BufferPointerAt(currentPos + 2, available);
+	if (text && (static_cast<size_t>(available) >= len)) {
+		for (size_t i = 0; i < len; i++) {
+			if (s[i] != MakeLowerCase(text[i]))
+				return false;
+		}
+		return true;
+	}
 	for (int n = 2; *s; n++) {
 		if (*s !=
 			MakeLowerCase(styler.SafeGetCharAt(currentPos + n, 0)))
@@ -65,6 +153,21 @@ bool StyleContext::MatchIgnoreCase(const char *s) {
 	return true;
 }
 
+int StyleContext::MatchAny(const LiteralSet &set) {
+	Sci_Position available = 0;
+	const char *text = styler.BufferPointerAt(currentPos, available);
+	const size_t remaining = (currentPos < lengthDocument) ? lengthDocument - currentPos : 0;
+	if (text && (static_cast<size_t>(available) >= std::min(set.MaxLength(), remaining))) {
+		return set.Match(text, available);
+	}
+	// The buffer ends too soon
+	std::string bytes;
+	for (size_t n = 0; (n < set.MaxLength()) && (n < remaining); n++) {
+		bytes.push_back(styler.SafeGetCharAt(currentPos + n, 0));
+	}
+	return set.Match(bytes.data(), bytes.length());
+}
+
 void StyleContext::GetCurrent(char *s, Sci_PositionU len) {
 	styler.GetRange(styler.GetStartSegment(), currentPos, s, len);
 }
@@ -73,6 +176,17 @@ void StyleContext::GetCurrentLowered(char *s, Sci_PositionU len) {
 	styler.GetRangeLowered(styler.GetStartSegment(), currentPos, s, len);
 }
 
+std::string_view StyleContext::CurrentView() {
+	return styler.GetRangeView(styler.GetStartSegment(), currentPos);
+}
+
+std::string_view StyleContext::CurrentView(Transform transform) {
+	if (transform == Transform::lower) {
+		return styler.GetRangeLoweredView(styler.GetStartSegment(), currentPos);
+	}
+	return CurrentView();
+}
+
 void StyleContext::GetCurrentString(std::string &string, Transform transform) {
 	const Sci_PositionU startPos = styler.GetStartSegment();
 	const Sci_PositionU len = currentPos - styler.GetStartSegment();
@@ -10,6 +10,9 @@
 
 namespace Lexilla {
 
+template<int N> class CharacterSetArray;
+class LiteralSet;
+
 // All languages handled so far can treat all characters >= 0x80 as one class
 // which just continues the current token or starts an identifier if in default.
 // DBCS treated specially as the second character can be < 0x80 and hence
@@ -17,6 +20,8 @@ namespace Lexilla {
 class StyleContext {
 	LexAccessor &styler;
 	Scintilla::IDocument * const multiByteAccess;
+	// UTF-8 is decoded from the accessor's buffer instead of calling multiByteAccess
+	const bool decodeUTF8;
 	const Sci_PositionU lengthDocument;
 	const Sci_PositionU endPos;
 	const Sci_Position lineDocEnd;
@@ -26,8 +31,39 @@ class StyleContext {
 	Sci_PositionU currentPosLastRelative;
 	Sci_Position offsetRelative = 0;
 
+	// Slow path of CharacterAndWidthUTF8 for non-ASCII lead bytes
+	int DecodeUTF8(Sci_PositionU position, unsigned char leadByte, Sci_Position &widthChar);
+
+	// Same results as IDocument::GetCharacterAndWidth for UTF-8 documents: invalid bytes are
+	// returned one at a time as 0xDC80 + byte and positions outside the document as NUL
+	int CharacterAndWidthUTF8(Sci_PositionU position, Sci_Position &widthChar) {
+		const unsigned char leadByte = styler.SafeGetCharAt(position, 0);
+		widthChar = 1;
+		if (leadByte < 0x80) {
+			return leadByte;
+		}
+		return DecodeUTF8(position, leadByte, widthChar);
+	}
+
+	// Moves to pos which is further on the current line: the byte before pos is a whole character
+	void SkipTo(Sci_PositionU pos) {
+		atLineStart = false;
+		chPrev = static_cast<unsigned char>(styler[pos - 1]);
+		currentPos = pos;
+		if (decodeUTF8) {
+			ch = CharacterAndWidthUTF8(currentPos, width);
+		} else {
+			ch = static_cast<unsigned char>(styler.SafeGetCharAt(currentPos, 0));
+			width = 1;
+		}
+		GetNextChar();
+	}
+
 	void GetNextChar() {
-		if (multiByteAccess) {
+		if (decodeUTF8) {
+			chNext = CharacterAndWidthUTF8(currentPos + width, widthNext);
+		} else if (multiByteAccess) {
+			LEXILLA_COUNT(styler.Counters(), documentCalls, 1);
 			chNext = multiByteAccess->GetCharacterAndWidth(currentPos+width, &widthNext);
 		} else {
 			const unsigned char charNext = styler.SafeGetCharAt(currentPos + width, 0);
@@ -42,6 +78,37 @@ class StyleContext {
 			atLineEnd = currentPosSigned >= lineStartNext;
 	}
 
+	// Moves forward while predicate(ch) is true, with scan(p, end) finding where a run of bytes in
+	// the accessor's buffer stops matching
+	template <typename Predicate, typename Scanner>
+	void ForwardScanning(Predicate predicate, Scanner scan) {
+		const Sci_Position lineLimit = lineEnd;
+		const Sci_PositionU limit = (static_cast<Sci_PositionU>(lineLimit) < endPos) ? lineLimit : endPos;
+		while ((currentPos < limit) && predicate(ch)) {
+			if (multiByteAccess && (!decodeUTF8 || ch >= 0x80)) {
+				// DBCS trail bytes may be ASCII so only UTF-8 text is scanned, one ASCII run at a time
+				Forward();
+				continue;
+			}
+			Sci_PositionU pos = currentPos + 1;
+			while (pos < limit) {
+				Sci_Position length = 0;
+				const char *text = styler.BufferPointerAt(pos, length);
+				const Sci_PositionU endScan = (pos + length < limit) ? pos + length : limit;
+				const char *end = text + (endScan - pos);
+				const char *p = scan(text, end);
+				pos += p - text;
+				if (p < end || length == 0)
+					break;
+			}
+			if (pos == currentPos + 1) {
+				Forward();
+			} else {
+				SkipTo(pos);
+			}
+		}
+	}
+
 public:
 	Sci_PositionU currentPos;
 	Sci_Position currentLine;
@@ -94,6 +161,42 @@ public:
 			Forward();
 		}
 	}
+	// Moves forward while predicate(ch) is true, stopping at the end of the line (MatchLineEnd) or the range.
+	// Runs of single byte characters are scanned in the accessor's buffer and the state is updated once.
+	template <typename Predicate>
+	void ForwardWhile(Predicate predicate) {
+		ForwardScanning(predicate, [this, &predicate](const char *p, const char *end) {
+			while ((p < end) && !(decodeUTF8 && (static_cast<unsigned char>(*p) >= 0x80)) &&
+				predicate(static_cast<unsigned char>(*p))) {
+				p++;
+			}
+			return p;
+		});
+	}
+	// Moves forward while ch is in set, scanning runs of bytes with CharacterSetArray::ScanWhile
+	template<int N>
+	void ForwardWhile(const CharacterSetArray<N> &set) {
+		ForwardScanning([&set](int chTest) noexcept {
+			return set.Contains(chTest);
+		}, [this, &set](const char *p, const char *end) noexcept {
+			return set.ScanWhile(p, end, decodeUTF8);
+		});
+	}
+	// Moves forward until ch is in set or the end of the line or range is reached
+	template<int N>
+	void ForwardUntil(const CharacterSetArray<N> &set) {
+		ForwardScanning([&set](int chTest) noexcept {
+			return !set.Contains(chTest);
+		}, [this, &set](const char *p, const char *end) noexcept {
+			return set.ScanUntil(p, end, decodeUTF8);
+		});
+	}
+	// Moves forward to the end of the line (MatchLineEnd) or range
+	void ForwardToLineEnd() {
+		ForwardWhile([](int) noexcept {
+			return true;
+		});
+	}
 	void ForwardBytes(Sci_Position nb) {
 		const Sci_PositionU forwardPos = currentPos + nb;
 		while (forwardPos > currentPos) {
@@ -127,6 +230,17 @@ public:
 	int GetRelativeCharacter(Sci_Position n) {
 		if (n == 0)
 			return ch;
+		if (decodeUTF8 && (n > 0)) {
+			if (n == 1)
+				return chNext;
+			Sci_PositionU posNew = currentPos + width + widthNext;
+			Sci_Position widthChar = 0;
+			for (Sci_Position i = 2; i < n; i++) {
+				CharacterAndWidthUTF8(posNew, widthChar);
+				posNew += widthChar;
+			}
+			return CharacterAndWidthUTF8(posNew, widthChar);
+		}
 		if (multiByteAccess) {
 			if ((currentPosLastRelative != currentPos) ||
 				((n > 0) && ((offsetRelative < 0) || (n < offsetRelative))) ||
@@ -135,6 +249,7 @@ public:
 				offsetRelative = 0;
 			}
 			const Sci_Position diffRelative = n - offsetRelative;
+			LEXILLA_COUNT(styler.Counters(), documentCalls, 2);
 			const Sci_Position posNew = multiByteAccess->GetRelativePosition(posRelative, diffRelative);
 			const int chReturn = multiByteAccess->GetCharacterAndWidth(posNew, nullptr);
 			posRelative = posNew;
@@ -171,6 +286,13 @@ public:
 		if (chNext != sNext)
 			return false;
 		s++;
+		// The rest is compared as bytes following 2 single byte characters
+		const size_t len = strlen(s);
+		Sci_Position available = 0;
+		const char *text = styler.BufferPointerAt(currentPos + 2, available);
+		if (text && (static_cast<size_t>(available) >= len)) {
+			return memcmp(text, s, len) == 0;
+		}
 		for (int n=2; *s; n++) {
 			if (*s != styler.SafeGetCharAt(currentPos+n, 0))
 				return false;
@@ -180,10 +302,17 @@ public:
 	}
 	// Non-inline
 	bool MatchIgnoreCase(const char *s);
+	// Index in set of the longest literal matching the bytes at the current position, -1 when none do
+	int MatchAny(const LiteralSet &set);
 	void GetCurrent(char *s, Sci_PositionU len);
 	void GetCurrentLowered(char *s, Sci_PositionU len);
 	enum class Transform { none, lower };
 	void GetCurrentString(std::string &string, Transform transform);
+	// The text of the current segment, from the start of the segment to currentPos, without copying
+	// it when it is in the accessor's buffer. Valid until the context moves on.
+	std::string_view CurrentView();
+	// As CurrentView, copied into the accessor's arena when lowered or not in the buffer
+	std::string_view CurrentView(Transform transform);
 };
 
 }
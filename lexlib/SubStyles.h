@@ -14,8 +14,56 @@ class WordClassifier {
 	int baseStyle;
 	int firstStyle;
 	int lenStyles;
-	using WordStyleMap = std::map<std::string, int, std::less<std::string>>;
-	WordStyleMap wordToStyle;
+	// Each word with its style, words are unique
+	std::vector<std::pair<std::string, int>> words;
+	// Open addressing hash table of indices into words, -1 for empty slots, at most half full
+	std::vector<int> slots;
+
+	static size_t Hash(std::string_view s) noexcept {
+		// FNV-1a
+		unsigned int hash = 2166136261U;
+		for (const char ch : s) {
+			hash = (hash ^ static_cast<unsigned char>(ch)) * 16777619U;
+		}
+		return hash;
+	}
+
+	// Slot holding s or the empty slot where it would be added
+	size_t Slot(std::string_view s) const noexcept {
+		const size_t mask = slots.size() - 1;
+		size_t slot = Hash(s) & mask;
+		while ((slots[slot] >= 0) && (words[slots[slot]].first != s)) {
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+	// Remake the table from words. When a word is present more than once the last wins.
+	void Rebuild() {
+		size_t size = 16;
+		while (size < words.size() * 2) {
+			size *= 2;
+		}
+		std::vector<std::pair<std::string, int>> unique;
+		unique.reserve(words.size());
+		words.swap(unique);
+		slots.assign(size, -1);
+		for (std::pair<std::string, int> &word : unique) {
+			const size_t slot = Slot(word.first);
+			if (slots[slot] >= 0) {
+				words[slots[slot]].second = word.second;
+			} else {
+				slots[slot] = static_cast<int>(words.size());
+				words.push_back(std::move(word));
+			}
+		}
+	}
+
+	void EraseStyle(int style) {
+		words.erase(std::remove_if(words.begin(), words.end(), [style](const std::pair<std::string, int> &word) noexcept {
+			return word.second == style;
+		}), words.end());
+	}
 
 public:
 
@@ -25,7 +73,8 @@ public:
 	void Allocate(int firstStyle_, int lenStyles_) {
 		firstStyle = firstStyle_;
 		lenStyles = lenStyles_;
-		wordToStyle.clear();
+		words.clear();
+		slots.clear();
 	}
 
 	int Base() const noexcept {
@@ -47,48 +96,52 @@ public:
 	void Clear() noexcept {
 		firstStyle = 0;
 		lenStyles = 0;
-		wordToStyle.clear();
+		words.clear();
+		slots.clear();
 	}
 
-	int ValueFor(std::string const& s) const {
-		WordStyleMap::const_iterator const it = wordToStyle.find(s);
-		if (it != wordToStyle.end())
-			return it->second;
-		else
+	int ValueFor(std::string_view s) const noexcept {
+		if (slots.empty())
 			return -1;
+		const int index = slots[Slot(s)];
+		return (index >= 0) ? words[index].second : -1;
+	}
+
+	size_t MemoryUse() const noexcept {
+		size_t bytes = words.capacity() * sizeof(words[0]) + slots.capacity() * sizeof(int);
+		for (const std::pair<std::string, int> &word : words) {
+			if (word.first.capacity() > std::string().capacity()) {
+				bytes += word.first.capacity() + 1;
+			}
+		}
+		return bytes;
 	}
 
 	bool IncludesStyle(int style) const noexcept {
 		return (style >= firstStyle) && (style < (firstStyle + lenStyles));
 	}
 
-	void RemoveStyle(int style) noexcept {
-		WordStyleMap::iterator it = wordToStyle.begin();
-		while (it != wordToStyle.end()) {
-			if (it->second == style) {
-				it = wordToStyle.erase(it);
-			} else {
-				++it;
-			}
-		}
+	void RemoveStyle(int style) {
+		EraseStyle(style);
+		Rebuild();
 	}
 
 	void SetIdentifiers(int style, const char *identifiers) {
-		RemoveStyle(style);
-		if (!identifiers)
-			return;
-		while (*identifiers) {
-			const char *cpSpace = identifiers;
-			while (*cpSpace && !(*cpSpace == ' ' || *cpSpace == '\t' || *cpSpace == '\r' || *cpSpace == '\n'))
-				cpSpace++;
-			if (cpSpace > identifiers) {
-				const std::string word(identifiers, cpSpace - identifiers);
-				wordToStyle[word] = style;
+		EraseStyle(style);
+		if (identifiers) {
+			while (*identifiers) {
+				const char *cpSpace = identifiers;
+				while (*cpSpace && !(*cpSpace == ' ' || *cpSpace == '\t' || *cpSpace == '\r' || *cpSpace == '\n'))
+					cpSpace++;
+				if (cpSpace > identifiers) {
+					words.emplace_back(std::string(identifiers, cpSpace - identifiers), style);
+				}
+				identifiers = cpSpace;
+				if (*identifiers)
+					identifiers++;
 			}
-			identifiers = cpSpace;
-			if (*identifiers)
-				identifiers++;
 		}
+		Rebuild();
 	}
 };
 
@@ -201,6 +254,14 @@ public:
 		}
 	}
 
+	size_t MemoryUse() const noexcept {
+		size_t bytes = classifiers.capacity() * sizeof(WordClassifier);
+		for (const WordClassifier &wc : classifiers) {
+			bytes += wc.MemoryUse();
+		}
+		return bytes;
+	}
+
 	const WordClassifier &Classifier(int baseStyle) const noexcept {
 		const int block = BlockFromBaseStyle(baseStyle);
 		return classifiers[block >= 0 ? block : 0];
@@ -10,9 +10,13 @@
 #include <cstring>
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <mutex>
 
 #include "WordList.h"
 
@@ -71,12 +75,184 @@ bool cmpWords(const char *a, const char *b) noexcept {
 	return strcmp(a, b) < 0;
 }
 
+constexpr unsigned int hashBasis = 2166136261U;
+
+// One step of FNV-1a
+constexpr unsigned int HashStep(unsigned int hash, char ch) noexcept {
+	return (hash ^ static_cast<unsigned char>(ch)) * 16777619U;
+}
+
+unsigned int HashWord(const char *s) noexcept {
+	unsigned int hash = hashBasis;
+	for (; *s; s++) {
+		hash = HashStep(hash, *s);
+	}
+	return hash;
+}
+
+struct Unchanged {
+	char operator()(char ch) const noexcept {
+		return ch;
+	}
+};
+
+struct Lowered {
+	char operator()(char ch) const noexcept {
+		return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+	}
+};
+
+// Whether s, with each character passed through fold, is a word or starts with a '^' prefix word.
+template <typename Fold>
+bool InListFolded(const char *const *words, const int *hashTable, size_t hashMask, const int *starts,
+	std::string_view s, Fold fold) noexcept {
+	unsigned int hash = hashBasis;
+	for (const char ch : s) {
+		hash = HashStep(hash, fold(ch));
+	}
+	for (size_t slot = hash & hashMask; hashTable[slot] >= 0; slot = (slot + 1) & hashMask) {
+		const char *word = words[hashTable[slot]];
+		size_t i = 0;
+		while ((i < s.length()) && (word[i] == fold(s[i]))) {
+			i++;
+		}
+		if ((i == s.length()) && !word[i])
+			return true;
+	}
+	int j = starts[static_cast<unsigned int>('^')];
+	if (j >= 0) {
+		while (words[j][0] == '^') {
+			const char *a = words[j] + 1;
+			size_t i = 0;
+			while (*a && (i < s.length()) && (*a == fold(s[i]))) {
+				a++;
+				i++;
+			}
+			if (!*a)
+				return true;
+			j++;
+		}
+	}
+	return false;
+}
+
+}
+
+namespace Lexilla {
+
+struct WordListData {
+	std::string text;
+	bool onlyLineEnds;
+	// WordLists using this, changed only while holding the registry's mutex
+	size_t references = 1;
+	std::unique_ptr<char[]> list;
+	std::unique_ptr<char *[]> words;
+	size_t len = 0;
+	int starts[256];
+	std::unique_ptr<int[]> hashTable;
+	size_t hashMask = 0;
+
+	WordListData(const char *s, bool onlyLineEnds_) : text(s), onlyLineEnds(onlyLineEnds_) {
+		const size_t lenS = text.length() + 1;
+		list = Sci::make_unique<char[]>(lenS);
+		memcpy(list.get(), s, lenS);
+		words = ArrayFromWordList(list.get(), lenS - 1, &len, onlyLineEnds);
+		std::sort(words.get(), words.get() + len, cmpWords);
+		std::fill(starts, std::end(starts), -1);
+		for (int l = static_cast<int>(len - 1); l >= 0; l--) {
+			unsigned char const indexChar = words[l][0];
+			starts[indexChar] = l;
+		}
+		// At most half full so probe sequences stay short
+		size_t size = 16;
+		while (size < len * 2) {
+			size *= 2;
+		}
+		hashTable = Sci::make_unique<int[]>(size);
+		hashMask = size - 1;
+		std::fill(hashTable.get(), hashTable.get() + size, -1);
+		for (size_t i = 0; i < len; i++) {
+			size_t slot = HashWord(words[i]) & hashMask;
+			while (hashTable[slot] >= 0) {
+				slot = (slot + 1) & hashMask;
+			}
+			hashTable[slot] = static_cast<int>(i);
+		}
+	}
+
+	size_t Bytes() const noexcept {
+		const size_t textBytes = (text.capacity() > std::string().capacity()) ? text.capacity() + 1 : 0;
+		return sizeof(WordListData) + textBytes + text.length() + 1 + (len + 1) * sizeof(char *) +
+			(hashMask + 1) * sizeof(int);
+	}
+};
+
+}
+
+namespace {
+
+// The WordListData in use, by hash of their text
+struct Registry {
+	std::mutex mutex;
+	std::unordered_multimap<unsigned int, WordListData *> byHash;
+};
+
+Registry &TheRegistry() {
+	// Never destroyed so WordLists destroyed during program exit can still release their data
+	static Registry *registry = new Registry();
+	return *registry;
+}
+
+unsigned int HashText(const char *s, bool onlyLineEnds) noexcept {
+	return HashStep(HashWord(s), onlyLineEnds ? '\n' : ' ');
+}
+
+// Find or make the data for s with a reference for the caller
+WordListData *Intern(const char *s, bool onlyLineEnds) {
+	Registry &registry = TheRegistry();
+	const unsigned int hash = HashText(s, onlyLineEnds);
+	{
+		std::lock_guard<std::mutex> guard(registry.mutex);
+		const auto range = registry.byHash.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it) {
+			WordListData *data = it->second;
+			if ((data->onlyLineEnds == onlyLineEnds) && (data->text == s)) {
+				data->references++;
+				return data;
+			}
+		}
+	}
+	// Parsed without the lock so other lists can be set meanwhile. If the same text is
+	// interned by another thread in the meantime there are briefly two copies which is harmless.
+	std::unique_ptr<WordListData> dataNew = Sci::make_unique<WordListData>(s, onlyLineEnds);
+	std::lock_guard<std::mutex> guard(registry.mutex);
+	registry.byHash.emplace(hash, dataNew.get());
+	return dataNew.release();
+}
+
+void Release(WordListData *data) noexcept {
+	if (!data)
+		return;
+	Registry &registry = TheRegistry();
+	std::lock_guard<std::mutex> guard(registry.mutex);
+	data->references--;
+	if (data->references == 0) {
+		const auto range = registry.byHash.equal_range(HashText(data->text.c_str(), data->onlyLineEnds));
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second == data) {
+				registry.byHash.erase(it);
+				break;
+			}
+		}
+		delete data;
+	}
+}
+
 }
 
 WordList::WordList(bool onlyLineEnds_) noexcept :
-	words(nullptr), list(nullptr), len(0), onlyLineEnds(onlyLineEnds_) {
-	// Prevent warnings by static analyzers about uninitialized starts.
-	starts[0] = -1;
+	data(nullptr), words(nullptr), len(0), onlyLineEnds(onlyLineEnds_), starts(nullptr),
+	hashTable(nullptr), hashMask(0) {
 }
 
 WordList::~WordList() {
@@ -102,43 +278,38 @@ int WordList::Length() const noexcept {
 }
 
 void WordList::Clear() noexcept {
-	delete []list;
-	list = nullptr;
-	delete []words;
+	Release(data);
+	data = nullptr;
 	words = nullptr;
+	starts = nullptr;
+	hashTable = nullptr;
+	hashMask = 0;
 	len = 0;
 }
 
 bool WordList::Set(const char *s) {
-	const size_t lenS = strlen(s) + 1;
-	std::unique_ptr<char[]> listTemp = Sci::make_unique<char[]>(lenS);
-	memcpy(listTemp.get(), s, lenS);
-	size_t lenTemp = 0;
-	std::unique_ptr<char *[]> wordsTemp = ArrayFromWordList(listTemp.get(), lenS - 1, &lenTemp, onlyLineEnds);
-	std::sort(wordsTemp.get(), wordsTemp.get() + lenTemp, cmpWords);
-
-	if (lenTemp == len) {
-		bool changed = false;
-		for (size_t i = 0; i < lenTemp; i++) {
-			if (strcmp(words[i], wordsTemp[i]) != 0) {
+	WordListData *dataNew = Intern(s, onlyLineEnds);
+	bool changed = (dataNew != data) && (dataNew->len != len);
+	if ((dataNew != data) && !changed) {
+		for (size_t i = 0; i < len; i++) {
+			if (strcmp(words[i], dataNew->words[i]) != 0) {
 				changed = true;
 				break;
 			}
 		}
-		if (!changed) {
-			return false;
-		}
+	}
+	if (!changed) {
+		Release(dataNew);
+		return false;
 	}
 
 	Clear();
-	words = wordsTemp.release();
-	list = listTemp.release();
-	len = lenTemp;
-	std::fill(starts, std::end(starts), -1);
-	for (int l = static_cast<int>(len - 1); l >= 0; l--) {
-		unsigned char const indexChar = words[l][0];
-		starts[indexChar] = l;
-	}
+	data = dataNew;
+	words = data->words.get();
+	len = data->len;
+	starts = data->starts;
+	hashTable = data->hashTable.get();
+	hashMask = data->hashMask;
 	return true;
 }
 
@@ -148,47 +319,27 @@ bool WordList::Set(const char *s) {
  * so '^GTK_' matches 'GTK_X', 'GTK_MAJOR_VERSION', and 'GTK_'.
  */
 bool WordList::InList(const char *s) const noexcept {
-	if (!words)
-		return false;
-	const char first = s[0];
-	const unsigned char firstChar = first;
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while (words[j][0] == first) {
-			if (s[1] == words[j][1]) {
-				const char *a = words[j] + 1;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					b++;
-				}
-				if (!*a && !*b)
-					return true;
-			}
-			j++;
-		}
-	}
-	j = starts[static_cast<unsigned int>('^')];
-	if (j >= 0) {
-		while (words[j][0] == '^') {
-			const char *a = words[j] + 1;
-			const char *b = s;
-			while (*a && *a == *b) {
-				a++;
-				b++;
-			}
-			if (!*a)
-				return true;
-			j++;
-		}
-	}
-	return false;
+	return InList(std::string_view(s));
 }
 
 /** convenience overload so can easily call with std::string.
  */
 bool WordList::InList(const std::string &s) const noexcept {
-	return InList(s.c_str());
+	return InList(std::string_view(s));
+}
+
+/** Overload for text that is not NUL terminated, such as a view into the lexer's buffer.
+ */
+bool WordList::InList(std::string_view s) const noexcept {
+	if (!words)
+		return false;
+	return InListFolded(words, hashTable, hashMask, starts, s, Unchanged());
+}
+
+bool WordList::InListLowered(std::string_view s) const noexcept {
+	if (!words)
+		return false;
+	return InListFolded(words, hashTable, hashMask, starts, s, Lowered());
 }
 
 /** similar to InList, but word s can be a substring of keyword.
@@ -309,3 +460,10 @@ const char *WordList::WordAt(int n) const noexcept {
 	return words[n];
 }
 
+size_t WordList::MemoryUse() const {
+	if (!data)
+		return 0;
+	std::lock_guard<std::mutex> guard(TheRegistry().mutex);
+	return data->Bytes() / data->references;
+}
+
@@ -10,15 +10,23 @@
 
 namespace Lexilla {
 
+struct WordListData;
+
 /**
  */
 class WordList {
+	// Parsed words, shared between all WordLists set to the same text so they are only
+	// split, sorted and hashed once and kept in memory once.
+	WordListData *data;
 	// Each word contains at least one character - an empty word acts as sentinel at the end.
-	char **words;
-	char *list;
+	const char *const *words;
 	size_t len;
 	bool onlyLineEnds;	///< Delimited by any white space or only line ends
-	int starts[256];
+	const int *starts;
+	// Open addressing hash table of indices into words, -1 when empty, so InList does not
+	// compare with every word sharing a first character
+	const int *hashTable;
+	size_t hashMask;
 public:
 	explicit WordList(bool onlyLineEnds_ = false) noexcept;
 	// Deleted so WordList objects can not be copied.
@@ -34,9 +42,14 @@ public:
 	bool Set(const char *s);
 	bool InList(const char *s) const noexcept;
 	bool InList(const std::string &s) const noexcept;
+	bool InList(std::string_view s) const noexcept;
+	// As InList on s converted to lower case, for lists of lower case words
+	bool InListLowered(std::string_view s) const noexcept;
 	bool InListAbbreviated(const char *s, const char marker) const noexcept;
 	bool InListAbridged(const char *s, const char marker) const noexcept;
 	const char *WordAt(int n) const noexcept;
+	// Bytes held for the words, divided by the number of WordLists sharing them
+	size_t MemoryUse() const;
 };
 
 }
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# GenerateCharacterCategory.py - regenerate the two stage table in LexCharacterCategory.cxx
+# Released to the public domain.
+
+"""
+Regenerate the two stage table in lexlib/LexCharacterCategory.cxx from the catRanges
+table in the same file so every character's category and identifier properties can be
+found with two array lookups.
+"""
+
+# Run by LexillaGen.py and should be run whenever catRanges is regenerated for a new
+# version of Unicode.
+# Requires Python 3.6 or later
+
+import pathlib
+
+import LexillaData
+
+thisPath = pathlib.Path(__file__).resolve()
+categoryPath = thisPath.parent.parent / "lexlib" / "LexCharacterCategory.cxx"
+
+maxUnicode = 0x10ffff
+blockShift = 7
+blockSize = 1 << blockShift
+
+# Bits above the 5 bit category in each table entry
+flagXidStart = 0x20
+flagXidContinue = 0x40
+
+categories = [
+    "Lu", "Ll", "Lt", "Lm", "Lo",
+    "Mn", "Mc", "Me",
+    "Nd", "Nl", "No",
+    "Pc", "Pd", "Ps", "Pe", "Pi", "Pf", "Po",
+    "Sm", "Sc", "Sk", "So",
+    "Zs", "Zl", "Zp",
+    "Cc", "Cf", "Cs", "Co", "Cn"
+]
+
+# These lists match OtherIDOfCharacter and IsIdPattern in LexCharacterCategory.cxx.
+# The characters that are in ID_Start or ID_Continue but not XID_Start or XID_Continue
+# are only listed here.
+otherIdStart = {0x1885, 0x1886, 0x2118, 0x212E, 0x309B, 0x309C}
+otherIdContinue = {0x00B7, 0x0387, 0x19DA} | set(range(0x1369, 0x1372))
+idPattern = {0x2E2F}
+omitXidContinue = {0x037A, 0x309B, 0x309C, 0xFC5E, 0xFC5F, 0xFC60, 0xFC61, 0xFC62, 0xFC63,
+    0xFDFA, 0xFDFB, 0xFE70, 0xFE72, 0xFE74, 0xFE76, 0xFE78, 0xFE7A, 0xFE7C, 0xFE7E}
+omitXidStart = omitXidContinue | {0x0E33, 0x0EB3, 0xFF9E, 0xFF9F}
+
+idStartCategories = {"Lu", "Ll", "Lt", "Lm", "Lo", "Nl"}
+idContinueCategories = idStartCategories | {"Mn", "Mc", "Nd", "Pc"}
+
+def AddIdentifierFlags(values):
+    for ch in range(maxUnicode + 1):
+        category = categories[values[ch]]
+        isIdStart = ch not in idPattern and (ch in otherIdStart or category in idStartCategories)
+        isIdContinue = ch not in idPattern and \
+            (ch in otherIdStart or ch in otherIdContinue or category in idContinueCategories)
+        if isIdStart and ch not in omitXidStart:
+            values[ch] |= flagXidStart
+        if isIdContinue and ch not in omitXidContinue:
+            values[ch] |= flagXidContinue
+
+def TwoStage(values):
+    blocks = {}
+    index = []
+    for start in range(0, maxUnicode + 1, blockSize):
+        block = bytes(values[start:start + blockSize])
+        index.append(blocks.setdefault(block, len(blocks)))
+    return index, list(blocks.keys())
+
+def Wrapped(numbers, perLine=32):
+    return [",".join(str(n) for n in numbers[i:i + perLine]) + "," for i in range(0, len(numbers), perLine)]
+
+def RegenerateTable():
+    text = categoryPath.read_text()
+    values = LexillaData.FindCharacterCategories(categoryPath)
+    AddIdentifierFlags(values)
+    index, blocks = TwoStage(values)
+    indexType = "unsigned char" if len(blocks) <= 0x100 else "unsigned short"
+    out = []
+    out.append("// %d blocks of %d characters, %d bytes" % (len(blocks), blockSize,
+        len(index) * (1 if len(blocks) <= 0x100 else 2) + len(blocks) * blockSize))
+    out.append("constexpr int blockShift = %d;" % blockShift)
+    out.append("constexpr %s catBlockIndex[] = {" % indexType)
+    out.extend(Wrapped(index))
+    out.append("};")
+    out.append("constexpr unsigned char catBlocks[] = {")
+    for block in blocks:
+        out.extend(Wrapped(list(block)))
+    out.append("};")
+    startMarker = "//++Autogenerated -- start of two stage table automatically generated\n"
+    endMarker = "//--Autogenerated -- end of two stage table automatically generated\n"
+    start = text.index(startMarker) + len(startMarker)
+    end = text.index(endMarker)
+    updated = text[:start] + "\n".join(out) + "\n" + text[end:]
+    if updated != text:
+        categoryPath.write_text(updated)
+        print("Changed", categoryPath)
+
+if __name__ == "__main__":
+    RegenerateTable()
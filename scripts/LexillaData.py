@@ -25,6 +25,9 @@ Common code used by Lexilla and SciTE for source file regeneration.
 #         sorted list of lexer file stems like LexAbaqus
 #     lexerModules
 #         sorted list of module names like lmAbaqus
+#     moduleDetails
+#         dictionary of SCLEX_* IDs and lexer names { module: [SCLEX_ID, name] }
+#         like lmAVE: [SCLEX_AVE, ave]
 #     lexerProperties
 #         sorted list of lexer properties like lexer.bash.command.substitution
 #     propertyDocuments
@@ -242,6 +245,21 @@ def FindCredits(historyFile):
                 creditList.append(credit)
     return creditList
 
+def FindCharacterCategories(categoryFile):
+    """ Return a bytearray with the general category of every Unicode character as
+    decoded from the catRanges table in LexCharacterCategory.cxx. """
+    text = categoryFile.read_text()
+    start = text.index("//++Autogenerated -- start of section automatically generated")
+    end = text.index("//--Autogenerated -- end of section automatically generated")
+    ranges = [int(line.rstrip(",")) for line in text[start:end].splitlines()[2:]]
+    maxUnicode = 0x10ffff
+    categories = bytearray(maxUnicode + 1)
+    for index, value in enumerate(ranges):
+        first = value >> 5
+        last = (ranges[index + 1] >> 5) if index + 1 < len(ranges) else maxUnicode + 1
+        categories[first:last] = bytes([value & 0x1f]) * (last - first)
+    return categories
+
 def ciKey(a):
     """ Return a string lowered to be used when sorting. """
     return str(a).lower()
@@ -282,6 +300,7 @@ class LexillaData:
         SortListInsensitive(lexFilePaths)
         self.lexFiles = [f.stem for f in lexFilePaths]
         self.lexerModules = []
+        self.moduleDetails = {}
         lexerProperties = set()
         self.propertyDocuments = {}
         self.sclexFromName = {}
@@ -292,6 +311,7 @@ class LexillaData:
                 self.sclexFromName[module[2]] = module[1]
                 self.fileFromSclex[module[1]] = lexFile
                 self.lexerModules.append(module[0])
+                self.moduleDetails[module[0]] = [module[1], module[2]]
             for prop in FindProperties(lexFile):
                 lexerProperties.add(prop)
             documents = FindPropertyDocumentation(lexFile)
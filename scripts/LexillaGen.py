@@ -21,6 +21,7 @@ from FileGenerator import Regenerate, UpdateLineInFile, \
     ReplaceREInFile, UpdateLineInPlistFile, UpdateFileFromLines
 import LexillaData
 import LexFacer
+import GenerateCharacterCategory
 
 sys.path.append(str(thisPath.parent.parent / "src"))
 import DepGen
@@ -92,6 +93,19 @@ def RegenerateXcodeProject(path, lexers, lexerReferences):
 
     UpdateFileFromLines(path, lines, os.linesep)
 
+def LazyModuleLists(lex):
+    """ Return the lines of the table of module names and IDs used when Lexilla is built with
+    LEXILLA_LAZY_REGISTRATION and the indices of that table sorted by name. """
+    entries = []
+    for module in lex.lexerModules:
+        sclex, name = lex.moduleDetails[module]
+        entries.append(f'{{"{name}", {sclex}, &{module}}}')
+    # Python sorts str by code point like strcmp does and is stable so the first of
+    # any modules with the same name is found first
+    byName = sorted(range(len(lex.lexerModules)),
+        key=lambda i: lex.moduleDetails[lex.lexerModules[i]][1])
+    return entries, [str(i) for i in byName]
+
 def RegenerateAll(rootDirectory):
     """ Regenerate all the files. """
 
@@ -105,7 +119,8 @@ def RegenerateAll(rootDirectory):
     srcDir = lexillaDir / "src"
     docDir = lexillaDir / "doc"
 
-    Regenerate(srcDir / "Lexilla.cxx", "//", lex.lexerModules)
+    lazyModules, lazyByName = LazyModuleLists(lex)
+    Regenerate(srcDir / "Lexilla.cxx", "//", lex.lexerModules, lazyModules, lazyByName)
     Regenerate(srcDir / "lexilla.mak", "#", lex.lexFiles)
 
     # Discover version information
@@ -156,6 +171,8 @@ def RegenerateAll(rootDirectory):
 
     LexFacer.RegenerateAll(root, False)
 
+    GenerateCharacterCategory.RegenerateTable()
+
     currentDirectory = pathlib.Path.cwd()
     os.chdir(srcDir)
     DepGen.Generate()
@@ -6,10 +6,16 @@
 // Copyright 2019 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cassert>
 #include <cstring>
 
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <initializer_list>
+#include <memory>
+#include <atomic>
+#include <mutex>
 
 #if defined(_WIN32)
 #define EXPORT_FUNCTION __declspec(dllexport)
@@ -21,6 +27,10 @@
 
 #include "ILexer.h"
 
+#if defined(LEXILLA_LAZY_REGISTRATION)
+#include "SciLexer.h"
+#endif
+
 #include "LexerModule.h"
 #include "CatalogueModules.h"
 
@@ -165,15 +175,417 @@ extern LexerModule lmYAML;
 
 namespace {
 
-CatalogueModules catalogueLexilla;
+void AddBuiltInModules(CatalogueModules &catalogue);
+
+// The catalogue is published as an immutable snapshot so that lexers can be counted, named and
+// created from any thread at once without locking. Adding a module copies the current snapshot,
+// adds to the copy and publishes that. Earlier snapshots are kept as other threads may still be
+// reading them and modules are only added a few times, at startup.
+class Catalogue {
+	std::atomic<const CatalogueModules *> current;
+	std::mutex mutexAdd;
+	std::vector<std::unique_ptr<CatalogueModules>> snapshots;
+public:
+	Catalogue() {
+		snapshots.push_back(std::make_unique<CatalogueModules>());
+		AddBuiltInModules(*snapshots.back());
+		current.store(snapshots.back().get(), std::memory_order_release);
+	}
+	const CatalogueModules &Current() const noexcept {
+		return *current.load(std::memory_order_acquire);
+	}
+	void Add(LexerModule *plm) {
+		std::lock_guard<std::mutex> guard(mutexAdd);
+		auto snapshot = std::make_unique<CatalogueModules>(Current());
+		snapshot->AddLexerModule(plm);
+		current.store(snapshot.get(), std::memory_order_release);
+		snapshots.push_back(std::move(snapshot));
+	}
+};
+
+// Built on first use, which the compiler makes thread safe, so first uses on several threads
+// do not race to add the built in modules. Later calls only read an atomic pointer.
+Catalogue &TheCatalogue() {
+	static Catalogue catalogue;
+	return catalogue;
+}
+
+const CatalogueModules &Modules() {
+	return TheCatalogue().Current();
+}
+
+#if defined(LEXILLA_LAZY_REGISTRATION)
+
+// The built in modules are listed with their names and identifiers so that lexers can be
+// counted, named and found without reading any LexerModule. A module's code and data are
+// only touched when a lexer is first created from it. Modules added by AddStaticLexerModule
+// are kept in the catalogue and follow the built in modules.
+
+struct LazyModule {
+	const char *languageName;
+	int language;
+	LexerModule *module;
+};
+
+const LazyModule lazyModules[] = {
+//++Autogenerated -- run scripts/LexillaGen.py to regenerate
+//**1 \(\t\*,\n\)
+	{"a68k", SCLEX_A68K, &lmA68k},
+	{"abaqus", SCLEX_ABAQUS, &lmAbaqus},
+	{"ada", SCLEX_ADA, &lmAda},
+	{"apdl", SCLEX_APDL, &lmAPDL},
+	{"as", SCLEX_AS, &lmAs},
+	{"asciidoc", SCLEX_ASCIIDOC, &lmAsciidoc},
+	{"asm", SCLEX_ASM, &lmAsm},
+	{"asn1", SCLEX_ASN1, &lmAsn1},
+	{"asy", SCLEX_ASYMPTOTE, &lmASY},
+	{"au3", SCLEX_AU3, &lmAU3},
+	{"ave", SCLEX_AVE, &lmAVE},
+	{"avs", SCLEX_AVS, &lmAVS},
+	{"baan", SCLEX_BAAN, &lmBaan},
+	{"bash", SCLEX_BASH, &lmBash},
+	{"batch", SCLEX_BATCH, &lmBatch},
+	{"bib", SCLEX_BIBTEX, &lmBibTeX},
+	{"blitzbasic", SCLEX_BLITZBASIC, &lmBlitzBasic},
+	{"bullant", SCLEX_BULLANT, &lmBullant},
+	{"caml", SCLEX_CAML, &lmCaml},
+	{"cil", SCLEX_CIL, &lmCIL},
+	{"clarion", SCLEX_CLW, &lmClw},
+	{"clarionnocase", SCLEX_CLWNOCASE, &lmClwNoCase},
+	{"cmake", SCLEX_CMAKE, &lmCmake},
+	{"COBOL", SCLEX_COBOL, &lmCOBOL},
+	{"coffeescript", SCLEX_COFFEESCRIPT, &lmCoffeeScript},
+	{"conf", SCLEX_CONF, &lmConf},
+	{"cpp", SCLEX_CPP, &lmCPP},
+	{"cppnocase", SCLEX_CPPNOCASE, &lmCPPNoCase},
+	{"csound", SCLEX_CSOUND, &lmCsound},
+	{"css", SCLEX_CSS, &lmCss},
+	{"d", SCLEX_D, &lmD},
+	{"dataflex", SCLEX_DATAFLEX, &lmDataflex},
+	{"diff", SCLEX_DIFF, &lmDiff},
+	{"DMAP", SCLEX_DMAP, &lmDMAP},
+	{"DMIS", SCLEX_DMIS, &lmDMIS},
+	{"ecl", SCLEX_ECL, &lmECL},
+	{"edifact", SCLEX_EDIFACT, &lmEDIFACT},
+	{"eiffel", SCLEX_EIFFEL, &lmEiffel},
+	{"eiffelkw", SCLEX_EIFFELKW, &lmEiffelkw},
+	{"erlang", SCLEX_ERLANG, &lmErlang},
+	{"errorlist", SCLEX_ERRORLIST, &lmErrorList},
+	{"escript", SCLEX_ESCRIPT, &lmESCRIPT},
+	{"f77", SCLEX_F77, &lmF77},
+	{"flagship", SCLEX_FLAGSHIP, &lmFlagShip},
+	{"forth", SCLEX_FORTH, &lmForth},
+	{"fortran", SCLEX_FORTRAN, &lmFortran},
+	{"freebasic", SCLEX_FREEBASIC, &lmFreeBasic},
+	{"fsharp", SCLEX_FSHARP, &lmFSharp},
+	{"gap", SCLEX_GAP, &lmGAP},
+	{"gdscript", SCLEX_GDSCRIPT, &lmGDScript},
+	{"gui4cli", SCLEX_GUI4CLI, &lmGui4Cli},
+	{"haskell", SCLEX_HASKELL, &lmHaskell},
+	{"hollywood", SCLEX_HOLLYWOOD, &lmHollywood},
+	{"hypertext", SCLEX_HTML, &lmHTML},
+	{"ihex", SCLEX_IHEX, &lmIHex},
+	{"indent", SCLEX_INDENT, &lmIndent},
+	{"inno", SCLEX_INNOSETUP, &lmInno},
+	{"json", SCLEX_JSON, &lmJSON},
+	{"julia", SCLEX_JULIA, &lmJulia},
+	{"kix", SCLEX_KIX, &lmKix},
+	{"kvirc", SCLEX_KVIRC, &lmKVIrc},
+	{"latex", SCLEX_LATEX, &lmLatex},
+	{"lisp", SCLEX_LISP, &lmLISP},
+	{"literatehaskell", SCLEX_LITERATEHASKELL, &lmLiterateHaskell},
+	{"lot", SCLEX_LOT, &lmLot},
+	{"lout", SCLEX_LOUT, &lmLout},
+	{"lua", SCLEX_LUA, &lmLua},
+	{"magiksf", SCLEX_MAGIK, &lmMagikSF},
+	{"makefile", SCLEX_MAKEFILE, &lmMake},
+	{"markdown", SCLEX_MARKDOWN, &lmMarkdown},
+	{"matlab", SCLEX_MATLAB, &lmMatlab},
+	{"maxima", SCLEX_MAXIMA, &lmMaxima},
+	{"metapost", SCLEX_METAPOST, &lmMETAPOST},
+	{"mmixal", SCLEX_MMIXAL, &lmMMIXAL},
+	{"modula", SCLEX_MODULA, &lmModula},
+	{"mssql", SCLEX_MSSQL, &lmMSSQL},
+	{"mysql", SCLEX_MYSQL, &lmMySQL},
+	{"nim", SCLEX_NIM, &lmNim},
+	{"nimrod", SCLEX_NIMROD, &lmNimrod},
+	{"nncrontab", SCLEX_NNCRONTAB, &lmNncrontab},
+	{"nsis", SCLEX_NSIS, &lmNsis},
+	{"null", SCLEX_NULL, &lmNull},
+	{"octave", SCLEX_OCTAVE, &lmOctave},
+	{"opal", SCLEX_OPAL, &lmOpal},
+	{"oscript", SCLEX_OSCRIPT, &lmOScript},
+	{"pascal", SCLEX_PASCAL, &lmPascal},
+	{"powerbasic", SCLEX_POWERBASIC, &lmPB},
+	{"perl", SCLEX_PERL, &lmPerl},
+	{"phpscript", SCLEX_PHPSCRIPT, &lmPHPSCRIPT},
+	{"PL/M", SCLEX_PLM, &lmPLM},
+	{"po", SCLEX_PO, &lmPO},
+	{"pov", SCLEX_POV, &lmPOV},
+	{"powerpro", SCLEX_POWERPRO, &lmPowerPro},
+	{"powershell", SCLEX_POWERSHELL, &lmPowerShell},
+	{"abl", SCLEX_PROGRESS, &lmProgress},
+	{"props", SCLEX_PROPERTIES, &lmProps},
+	{"ps", SCLEX_PS, &lmPS},
+	{"purebasic", SCLEX_PUREBASIC, &lmPureBasic},
+	{"python", SCLEX_PYTHON, &lmPython},
+	{"r", SCLEX_R, &lmR},
+	{"raku", SCLEX_RAKU, &lmRaku},
+	{"rebol", SCLEX_REBOL, &lmREBOL},
+	{"registry", SCLEX_REGISTRY, &lmRegistry},
+	{"ruby", SCLEX_RUBY, &lmRuby},
+	{"rust", SCLEX_RUST, &lmRust},
+	{"sas", SCLEX_SAS, &lmSAS},
+	{"scriptol", SCLEX_SCRIPTOL, &lmScriptol},
+	{"smalltalk", SCLEX_SMALLTALK, &lmSmalltalk},
+	{"SML", SCLEX_SML, &lmSML},
+	{"sorcins", SCLEX_SORCUS, &lmSorc},
+	{"specman", SCLEX_SPECMAN, &lmSpecman},
+	{"spice", SCLEX_SPICE, &lmSpice},
+	{"sql", SCLEX_SQL, &lmSQL},
+	{"srec", SCLEX_SREC, &lmSrec},
+	{"stata", SCLEX_STATA, &lmStata},
+	{"fcST", SCLEX_STTXT, &lmSTTXT},
+	{"TACL", SCLEX_TACL, &lmTACL},
+	{"tads3", SCLEX_TADS3, &lmTADS3},
+	{"TAL", SCLEX_TAL, &lmTAL},
+	{"tcl", SCLEX_TCL, &lmTCL},
+	{"tcmd", SCLEX_TCMD, &lmTCMD},
+	{"tehex", SCLEX_TEHEX, &lmTEHex},
+	{"tex", SCLEX_TEX, &lmTeX},
+	{"txt2tags", SCLEX_TXT2TAGS, &lmTxt2tags},
+	{"vb", SCLEX_VB, &lmVB},
+	{"vbscript", SCLEX_VBSCRIPT, &lmVBScript},
+	{"verilog", SCLEX_VERILOG, &lmVerilog},
+	{"vhdl", SCLEX_VHDL, &lmVHDL},
+	{"visualprolog", SCLEX_VISUALPROLOG, &lmVisualProlog},
+	{"x12", SCLEX_X12, &lmX12},
+	{"xml", SCLEX_XML, &lmXML},
+	{"yaml", SCLEX_YAML, &lmYAML},
+
+//--Autogenerated -- end of automatically generated section
+};
+
+// Indices into lazyModules sorted by name
+const unsigned short lazyByName[] = {
+//++Autogenerated -- run scripts/LexillaGen.py to regenerate
+//**2 \(\t\*,\n\)
+	23,
+	33,
+	34,
+	89,
+	108,
+	116,
+	118,
+	0,
+	1,
+	94,
+	2,
+	3,
+	4,
+	5,
+	6,
+	7,
+	8,
+	9,
+	10,
+	11,
+	12,
+	13,
+	14,
+	15,
+	16,
+	17,
+	18,
+	19,
+	20,
+	21,
+	22,
+	24,
+	25,
+	26,
+	27,
+	28,
+	29,
+	30,
+	31,
+	32,
+	35,
+	36,
+	37,
+	38,
+	39,
+	40,
+	41,
+	42,
+	115,
+	43,
+	44,
+	45,
+	46,
+	47,
+	48,
+	49,
+	50,
+	51,
+	52,
+	53,
+	54,
+	55,
+	56,
+	57,
+	58,
+	59,
+	60,
+	61,
+	62,
+	63,
+	64,
+	65,
+	66,
+	67,
+	68,
+	69,
+	70,
+	71,
+	72,
+	73,
+	74,
+	75,
+	76,
+	77,
+	78,
+	79,
+	80,
+	81,
+	82,
+	83,
+	84,
+	85,
+	87,
+	88,
+	90,
+	91,
+	86,
+	92,
+	93,
+	95,
+	96,
+	97,
+	98,
+	99,
+	100,
+	101,
+	102,
+	103,
+	104,
+	105,
+	106,
+	107,
+	109,
+	110,
+	111,
+	112,
+	113,
+	114,
+	117,
+	119,
+	120,
+	121,
+	122,
+	123,
+	124,
+	125,
+	126,
+	127,
+	128,
+	129,
+	130,
+	131,
+
+//--Autogenerated -- end of automatically generated section
+};
+
+constexpr size_t lazyCount = std::size(lazyModules);
+static_assert(std::size(lazyByName) == lazyCount);
+
+const LazyModule *LazyModuleFromName(const char *name) noexcept {
+	const unsigned short *it = std::lower_bound(std::begin(lazyByName), std::end(lazyByName), name,
+		[](unsigned short index, const char *nameFind) noexcept {
+			return strcmp(lazyModules[index].languageName, nameFind) < 0;
+		});
+	if ((it != std::end(lazyByName)) && (0 == strcmp(lazyModules[*it].languageName, name))) {
+		return &lazyModules[*it];
+	}
+	return nullptr;
+}
+
+const LazyModule *LazyModuleFromLanguage(int language) noexcept {
+	for (const LazyModule &lazy : lazyModules) {
+		if (lazy.language == language) {
+			return &lazy;
+		}
+	}
+	return nullptr;
+}
 
-void AddEachLexer() {
+size_t LexerCount() {
+	return lazyCount + Modules().Count();
+}
+
+const char *LexerName(size_t index) {
+	if (index < lazyCount) {
+		return lazyModules[index].languageName;
+	}
+	return Modules().Name(index - lazyCount);
+}
 
-	if (catalogueLexilla.Count() > 0) {
-		return;
+LexerFactoryFunction LexerFactory(size_t index) {
+	if (index < lazyCount) {
+		return lazyModules[index].module->GetFactory();
 	}
+	return Modules().Factory(index - lazyCount);
+}
 
-	catalogueLexilla.AddLexerModules({
+const LexerModule *ModuleFromName(const char *name) {
+	if (!name) {
+		return nullptr;
+	}
+	const LazyModule *lazy = LazyModuleFromName(name);
+	if (lazy) {
+		// The table is generated from the modules so should always agree with them
+		assert(0 == strcmp(lazy->module->languageName, lazy->languageName));
+		assert(lazy->module->GetLanguage() == lazy->language);
+		return lazy->module;
+	}
+	return Modules().Find(name);
+}
+
+const char *NameFromLanguage(int language) {
+	const LazyModule *lazy = LazyModuleFromLanguage(language);
+	if (lazy) {
+		return lazy->languageName;
+	}
+	const LexerModule *pModule = Modules().Find(language);
+	if (pModule) {
+		return pModule->languageName;
+	}
+	return nullptr;
+}
+
+void AddBuiltInModules(CatalogueModules &) {
+	// The built in modules are found through lazyModules
+}
+
+void AddModule(LexerModule *plm) {
+	TheCatalogue().Add(plm);
+}
+
+#else
+
+void AddBuiltInModules(CatalogueModules &catalogue) {
+
+	catalogue.AddLexerModules({
 //++Autogenerated -- run scripts/LexillaGen.py to regenerate
 //**\(\t\t&\*,\n\)
 		&lmA68k,
@@ -314,47 +726,66 @@ void AddEachLexer() {
 
 }
 
+size_t LexerCount() {
+	return Modules().Count();
+}
+
+const char *LexerName(size_t index) {
+	return Modules().Name(index);
+}
+
+LexerFactoryFunction LexerFactory(size_t index) {
+	return Modules().Factory(index);
+}
+
+const LexerModule *ModuleFromName(const char *name) {
+	return Modules().Find(name);
+}
+
+const char *NameFromLanguage(int language) {
+	const LexerModule *pModule = Modules().Find(language);
+	if (pModule) {
+		return pModule->languageName;
+	}
+	return nullptr;
+}
+
+void AddModule(LexerModule *plm) {
+	TheCatalogue().Add(plm);
+}
+
+#endif
+
 }
 
 extern "C" {
 
 EXPORT_FUNCTION int CALLING_CONVENTION GetLexerCount() {
-	AddEachLexer();
-	return static_cast<int>(catalogueLexilla.Count());
+	return static_cast<int>(LexerCount());
 }
 
 EXPORT_FUNCTION void CALLING_CONVENTION GetLexerName(unsigned int index, char *name, int buflength) {
-	AddEachLexer();
 	*name = 0;
-	const char *lexerName = catalogueLexilla.Name(index);
+	const char *lexerName = LexerName(index);
 	if (static_cast<size_t>(buflength) > strlen(lexerName)) {
 		strcpy(name, lexerName);
 	}
 }
 
 EXPORT_FUNCTION LexerFactoryFunction CALLING_CONVENTION GetLexerFactory(unsigned int index) {
-	AddEachLexer();
-	return catalogueLexilla.Factory(index);
+	return LexerFactory(index);
 }
 
 EXPORT_FUNCTION Scintilla::ILexer5 * CALLING_CONVENTION CreateLexer(const char *name) {
-	AddEachLexer();
-	for (size_t i = 0; i < catalogueLexilla.Count(); i++) {
-		const char *lexerName = catalogueLexilla.Name(i);
-		if (0 == strcmp(lexerName, name)) {
-			return catalogueLexilla.Create(i);
-		}
+	const LexerModule *pModule = ModuleFromName(name);
+	if (pModule) {
+		return pModule->Create();
 	}
 	return nullptr;
 }
 
 EXPORT_FUNCTION const char * CALLING_CONVENTION LexerNameFromID(int identifier) {
-	AddEachLexer();
-	const LexerModule *pModule = catalogueLexilla.Find(identifier);
-	if (pModule) {
-		return pModule->languageName;
-	}
-	return nullptr;
+	return NameFromLanguage(identifier);
 }
 
 EXPORT_FUNCTION const char * CALLING_CONVENTION GetLibraryPropertyNames() {
@@ -374,6 +805,5 @@ EXPORT_FUNCTION const char * CALLING_CONVENTION GetNameSpace() {
 // Not exported from binary as LexerModule must be built exactly the same as
 // modules listed above
 void AddStaticLexerModule(LexerModule *plm) {
-	AddEachLexer();
-	catalogueLexilla.AddLexerModule(plm);
+	AddModule(plm);
 }
@@ -13,13 +13,21 @@ $(DIR_O)/Accessor.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h
+$(DIR_O)/BatchLexing.o: \
+	../lexlib/BatchLexing.cxx \
+	../../scintilla/include/ILexer.h \
+	../../scintilla/include/Sci_Position.h \
+	../lexlib/BatchLexing.h
 $(DIR_O)/LexCharacterCategory.o: \
 	../lexlib/LexCharacterCategory.cxx \
 	../lexlib/LexCharacterCategory.h
 $(DIR_O)/LexCharacterSet.o: \
 	../lexlib/LexCharacterSet.cxx \
+	../lexlib/LexScan.h \
 	../lexlib/LexCharacterSet.h
 $(DIR_O)/DefaultLexer.o: \
 	../lexlib/DefaultLexer.cxx \
@@ -29,18 +37,35 @@ $(DIR_O)/DefaultLexer.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexMemory.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/LexerModule.h \
 	../lexlib/DefaultLexer.h
+$(DIR_O)/DocumentSnapshot.o: \
+	../lexlib/DocumentSnapshot.cxx \
+	../../scintilla/include/ILexer.h \
+	../../scintilla/include/Sci_Position.h \
+	../../scintilla/include/Scintilla.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
+	../lexlib/LexAccessor.h \
+	../lexlib/LexUTF8.h \
+	../lexlib/DocumentSnapshot.h
+$(DIR_O)/EscapeSequenceParser.o: \
+	../lexlib/EscapeSequenceParser.cxx \
+	../lexlib/EscapeSequenceParser.h
 $(DIR_O)/InList.o: \
 	../lexlib/InList.cxx \
-	../lexlib/InList.h \
-	../lexlib/LexCharacterSet.h
+	../lexlib/InList.h
 $(DIR_O)/LexAccessor.o: \
 	../lexlib/LexAccessor.cxx \
 	../../scintilla/include/ILexer.h \
 	../../scintilla/include/Sci_Position.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/LexCharacterSet.h
 $(DIR_O)/LexerBase.o: \
@@ -51,9 +76,13 @@ $(DIR_O)/LexerBase.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexMemory.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/LexerModule.h \
+	../lexlib/StyleCache.h \
 	../lexlib/LexerBase.h
 $(DIR_O)/LexerModule.o: \
 	../lexlib/LexerModule.cxx \
@@ -63,6 +92,9 @@ $(DIR_O)/LexerModule.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexMemory.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/LexerModule.h \
@@ -76,6 +108,8 @@ $(DIR_O)/LexerNoExceptions.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/LexerModule.h \
@@ -89,22 +123,49 @@ $(DIR_O)/LexerSimple.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexMemory.h \
+	../lexlib/LexCost.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
+	../lexlib/LexInvalidation.h \
 	../lexlib/Accessor.h \
 	../lexlib/LexerModule.h \
 	../lexlib/LexerBase.h \
 	../lexlib/LexerSimple.h
+$(DIR_O)/LexScan.o: \
+	../lexlib/LexScan.cxx \
+	../lexlib/LexScan.h
+$(DIR_O)/LexTrace.o: \
+	../lexlib/LexTrace.cxx \
+	../../scintilla/include/Sci_Position.h \
+	../lexlib/LexTrace.h
+$(DIR_O)/LexUTF8.o: \
+	../lexlib/LexUTF8.cxx \
+	../lexlib/LexScan.h \
+	../lexlib/LexUTF8.h
+$(DIR_O)/LinePatterns.o: \
+	../lexlib/LinePatterns.cxx \
+	../lexlib/LinePatterns.h
 $(DIR_O)/PropSetSimple.o: \
 	../lexlib/PropSetSimple.cxx \
 	../lexlib/PropSetSimple.h
+$(DIR_O)/StyleCache.o: \
+	../lexlib/StyleCache.cxx \
+	../../scintilla/include/ILexer.h \
+	../../scintilla/include/Sci_Position.h \
+	../lexlib/StyleCache.h
 $(DIR_O)/StyleContext.o: \
 	../lexlib/StyleContext.cxx \
 	../../scintilla/include/ILexer.h \
 	../../scintilla/include/Sci_Position.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
-	../lexlib/LexCharacterSet.h
+	../lexlib/LexCharacterSet.h \
+	../lexlib/LiteralSet.h
 $(DIR_O)/WordList.o: \
 	../lexlib/WordList.cxx \
 	../lexlib/WordList.h
@@ -115,6 +176,8 @@ $(DIR_O)/LexA68k.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -127,6 +190,8 @@ $(DIR_O)/LexAbaqus.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -139,6 +204,8 @@ $(DIR_O)/LexAda.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -151,6 +218,8 @@ $(DIR_O)/LexAPDL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -163,6 +232,8 @@ $(DIR_O)/LexAsciidoc.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -175,6 +246,8 @@ $(DIR_O)/LexAsm.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -188,6 +261,8 @@ $(DIR_O)/LexAsn1.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -200,6 +275,8 @@ $(DIR_O)/LexASY.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -212,6 +289,8 @@ $(DIR_O)/LexAU3.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -224,6 +303,8 @@ $(DIR_O)/LexAVE.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -236,6 +317,8 @@ $(DIR_O)/LexAVS.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -248,6 +331,8 @@ $(DIR_O)/LexBaan.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -263,6 +348,8 @@ $(DIR_O)/LexBash.o: \
 	../lexlib/StringCopy.h \
 	../lexlib/InList.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -277,6 +364,8 @@ $(DIR_O)/LexBasic.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -291,6 +380,8 @@ $(DIR_O)/LexBatch.o: \
 	../include/SciLexer.h \
 	../lexlib/InList.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -304,6 +395,8 @@ $(DIR_O)/LexBibTeX.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -316,6 +409,8 @@ $(DIR_O)/LexBullant.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -328,6 +423,8 @@ $(DIR_O)/LexCaml.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -341,6 +438,8 @@ $(DIR_O)/LexCIL.o: \
 	../include/SciLexer.h \
 	../lexlib/StringCopy.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -355,6 +454,8 @@ $(DIR_O)/LexCLW.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -367,6 +468,8 @@ $(DIR_O)/LexCmake.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -379,6 +482,8 @@ $(DIR_O)/LexCOBOL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -391,6 +496,8 @@ $(DIR_O)/LexCoffeeScript.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -403,6 +510,8 @@ $(DIR_O)/LexConf.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -416,6 +525,8 @@ $(DIR_O)/LexCPP.o: \
 	../include/SciLexer.h \
 	../lexlib/StringCopy.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -431,6 +542,8 @@ $(DIR_O)/LexCrontab.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -443,6 +556,8 @@ $(DIR_O)/LexCsound.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -455,6 +570,8 @@ $(DIR_O)/LexCSS.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -467,6 +584,8 @@ $(DIR_O)/LexD.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -480,6 +599,8 @@ $(DIR_O)/LexDataflex.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -492,6 +613,8 @@ $(DIR_O)/LexDiff.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -504,6 +627,8 @@ $(DIR_O)/LexDMAP.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -516,6 +641,8 @@ $(DIR_O)/LexDMIS.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -529,6 +656,8 @@ $(DIR_O)/LexECL.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -541,6 +670,8 @@ $(DIR_O)/LexEDIFACT.o: \
 	../../scintilla/include/Sci_Position.h \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/LexerModule.h \
 	../lexlib/DefaultLexer.h
@@ -551,6 +682,8 @@ $(DIR_O)/LexEiffel.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -563,6 +696,8 @@ $(DIR_O)/LexErlang.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -576,6 +711,8 @@ $(DIR_O)/LexErrorList.o: \
 	../include/SciLexer.h \
 	../lexlib/InList.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -588,6 +725,8 @@ $(DIR_O)/LexEScript.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -600,6 +739,8 @@ $(DIR_O)/LexFlagship.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -612,6 +753,8 @@ $(DIR_O)/LexForth.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -624,6 +767,8 @@ $(DIR_O)/LexFortran.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -636,6 +781,8 @@ $(DIR_O)/LexFSharp.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -649,6 +796,8 @@ $(DIR_O)/LexGAP.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -662,6 +811,8 @@ $(DIR_O)/LexGDScript.o: \
 	../include/SciLexer.h \
 	../lexlib/StringCopy.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -678,6 +829,8 @@ $(DIR_O)/LexGui4Cli.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -691,6 +844,8 @@ $(DIR_O)/LexHaskell.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -706,6 +861,8 @@ $(DIR_O)/LexHex.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -718,6 +875,8 @@ $(DIR_O)/LexHollywood.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -731,6 +890,8 @@ $(DIR_O)/LexHTML.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -745,6 +906,8 @@ $(DIR_O)/LexIndent.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -757,6 +920,8 @@ $(DIR_O)/LexInno.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -769,6 +934,8 @@ $(DIR_O)/LexJSON.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -784,6 +951,8 @@ $(DIR_O)/LexJulia.o: \
 	../lexlib/StringCopy.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -799,6 +968,8 @@ $(DIR_O)/LexKix.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -811,6 +982,8 @@ $(DIR_O)/LexKVIrc.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -824,6 +997,8 @@ $(DIR_O)/LexLaTeX.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -838,6 +1013,8 @@ $(DIR_O)/LexLisp.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -850,6 +1027,8 @@ $(DIR_O)/LexLout.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -862,6 +1041,8 @@ $(DIR_O)/LexLua.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -876,6 +1057,8 @@ $(DIR_O)/LexMagik.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -888,6 +1071,8 @@ $(DIR_O)/LexMake.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -900,6 +1085,8 @@ $(DIR_O)/LexMarkdown.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -912,6 +1099,8 @@ $(DIR_O)/LexMatlab.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -924,6 +1113,8 @@ $(DIR_O)/LexMaxima.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -936,6 +1127,8 @@ $(DIR_O)/LexMetapost.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -948,6 +1141,8 @@ $(DIR_O)/LexMMIXAL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -961,6 +1156,8 @@ $(DIR_O)/LexModula.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -973,6 +1170,8 @@ $(DIR_O)/LexMPT.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -985,6 +1184,8 @@ $(DIR_O)/LexMSSQL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -997,6 +1198,8 @@ $(DIR_O)/LexMySQL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1010,6 +1213,8 @@ $(DIR_O)/LexNim.o: \
 	../include/SciLexer.h \
 	../lexlib/StringCopy.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1024,6 +1229,8 @@ $(DIR_O)/LexNimrod.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1036,6 +1243,8 @@ $(DIR_O)/LexNsis.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1048,6 +1257,8 @@ $(DIR_O)/LexNull.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1060,6 +1271,8 @@ $(DIR_O)/LexOpal.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1072,6 +1285,8 @@ $(DIR_O)/LexOScript.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1084,6 +1299,8 @@ $(DIR_O)/LexPascal.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1096,6 +1313,8 @@ $(DIR_O)/LexPB.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1108,6 +1327,8 @@ $(DIR_O)/LexPerl.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -1121,6 +1342,8 @@ $(DIR_O)/LexPLM.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1133,6 +1356,8 @@ $(DIR_O)/LexPO.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1145,6 +1370,8 @@ $(DIR_O)/LexPOV.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1157,6 +1384,8 @@ $(DIR_O)/LexPowerPro.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1169,6 +1398,8 @@ $(DIR_O)/LexPowerShell.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1181,6 +1412,8 @@ $(DIR_O)/LexProgress.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -1195,6 +1428,8 @@ $(DIR_O)/LexProps.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1207,6 +1442,8 @@ $(DIR_O)/LexPS.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1219,6 +1456,8 @@ $(DIR_O)/LexPython.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1235,6 +1474,8 @@ $(DIR_O)/LexR.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1247,6 +1488,8 @@ $(DIR_O)/LexRaku.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -1261,6 +1504,8 @@ $(DIR_O)/LexRebol.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1273,6 +1518,8 @@ $(DIR_O)/LexRegistry.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/StyleContext.h \
 	../lexlib/LexCharacterSet.h \
@@ -1286,6 +1533,8 @@ $(DIR_O)/LexRuby.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1299,6 +1548,8 @@ $(DIR_O)/LexRust.o: \
 	../include/SciLexer.h \
 	../lexlib/PropSetSimple.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1313,6 +1564,8 @@ $(DIR_O)/LexSAS.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1325,6 +1578,8 @@ $(DIR_O)/LexScriptol.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1337,6 +1592,8 @@ $(DIR_O)/LexSmalltalk.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1349,6 +1606,8 @@ $(DIR_O)/LexSML.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1361,6 +1620,8 @@ $(DIR_O)/LexSorcus.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1373,6 +1634,8 @@ $(DIR_O)/LexSpecman.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1385,6 +1648,8 @@ $(DIR_O)/LexSpice.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1397,6 +1662,8 @@ $(DIR_O)/LexSQL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1412,6 +1679,8 @@ $(DIR_O)/LexStata.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1424,6 +1693,8 @@ $(DIR_O)/LexSTTXT.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1436,6 +1707,8 @@ $(DIR_O)/LexTACL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1448,6 +1721,8 @@ $(DIR_O)/LexTADS3.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1460,6 +1735,8 @@ $(DIR_O)/LexTAL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1472,6 +1749,8 @@ $(DIR_O)/LexTCL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1484,6 +1763,8 @@ $(DIR_O)/LexTCMD.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1496,6 +1777,8 @@ $(DIR_O)/LexTeX.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1508,6 +1791,8 @@ $(DIR_O)/LexTxt2tags.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1520,6 +1805,8 @@ $(DIR_O)/LexVB.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1532,6 +1819,8 @@ $(DIR_O)/LexVerilog.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1547,6 +1836,8 @@ $(DIR_O)/LexVHDL.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1559,6 +1850,8 @@ $(DIR_O)/LexVisualProlog.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -1582,6 +1875,8 @@ $(DIR_O)/LexYAML.o: \
 	../../scintilla/include/Scintilla.h \
 	../include/SciLexer.h \
 	../lexlib/WordList.h \
+	../lexlib/LexCounters.h \
+	../lexlib/LexTrace.h \
 	../lexlib/LexAccessor.h \
 	../lexlib/Accessor.h \
 	../lexlib/StyleContext.h \
@@ -58,6 +58,21 @@ LDFLAGS=$(LDDEBUG) $(LDFLAGS)
 CXXFLAGS=$(CXXFLAGS) $(CXXNDEBUG)
 !ENDIF
 
+# Define COUNTERS to collect the performance counters in LexCounters.h
+!IFDEF COUNTERS
+CXXFLAGS=$(CXXFLAGS) -DLEXILLA_COUNTERS
+!ENDIF
+
+# Define TRACE to compile the trace scopes in LexTrace.h
+!IFDEF TRACE
+CXXFLAGS=$(CXXFLAGS) -DLEXILLA_TRACE
+!ENDIF
+
+# Define LAZY to find built in lexers from a generated table without reading each LexerModule
+!IFDEF LAZY
+CXXFLAGS=$(CXXFLAGS) -DLEXILLA_LAZY_REGISTRATION
+!ENDIF
+
 SCINTILLA_INCLUDE = ../../scintilla/include
 
 INCLUDEDIRS=-I../include -I$(SCINTILLA_INCLUDE) -I../lexlib
@@ -203,15 +218,23 @@ LEX_OBJS=\
 # Required by lexers
 LEXLIB_OBJS=\
 	$(DIR_O)\Accessor.obj \
+	$(DIR_O)\BatchLexing.obj \
 	$(DIR_O)\LexCharacterCategory.obj \
 	$(DIR_O)\LexCharacterSet.obj \
 	$(DIR_O)\DefaultLexer.obj \
+	$(DIR_O)\DocumentSnapshot.obj \
+	$(DIR_O)\EscapeSequenceParser.obj \
 	$(DIR_O)\InList.obj \
 	$(DIR_O)\LexAccessor.obj \
 	$(DIR_O)\LexerBase.obj \
 	$(DIR_O)\LexerModule.obj \
 	$(DIR_O)\LexerSimple.obj \
+	$(DIR_O)\LexScan.obj \
+	$(DIR_O)\LexTrace.obj \
+	$(DIR_O)\LexUTF8.obj \
+	$(DIR_O)\LinePatterns.obj \
 	$(DIR_O)\PropSetSimple.obj \
+	$(DIR_O)\StyleCache.obj \
 	$(DIR_O)\StyleContext.obj \
 	$(DIR_O)\WordList.obj
 
@@ -0,0 +1,155 @@
+// Lexilla lexer library
+/** @file EditReplay.cxx
+ ** Read a script of edits and replay it on a GapDocument, styling after each edit as an editor would.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdlib>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "ILexer.h"
+
+#include "GapDocument.h"
+#include "EditReplay.h"
+
+namespace {
+
+int HexDigit(char ch) noexcept {
+	if (ch >= '0' && ch <= '9') {
+		return ch - '0';
+	}
+	if (ch >= 'a' && ch <= 'f') {
+		return ch - 'a' + 10;
+	}
+	if (ch >= 'A' && ch <= 'F') {
+		return ch - 'A' + 10;
+	}
+	return -1;
+}
+
+bool Unescape(std::string_view sv, std::string &text) {
+	text.clear();
+	for (size_t i = 0; i < sv.length(); i++) {
+		if (sv[i] != '\\') {
+			text.push_back(sv[i]);
+			continue;
+		}
+		i++;
+		if (i >= sv.length()) {
+			return false;
+		}
+		switch (sv[i]) {
+		case 'n':
+			text.push_back('\n');
+			break;
+		case 'r':
+			text.push_back('\r');
+			break;
+		case 't':
+			text.push_back('\t');
+			break;
+		case '\\':
+			text.push_back('\\');
+			break;
+		case 'x': {
+				if (i + 2 >= sv.length()) {
+					return false;
+				}
+				const int high = HexDigit(sv[i + 1]);
+				const int low = HexDigit(sv[i + 2]);
+				if (high < 0 || low < 0) {
+					return false;
+				}
+				text.push_back(static_cast<char>(high * 16 + low));
+				i += 2;
+			}
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+// Reads a non-negative integer followed by a space or the end of the line
+bool ReadNumber(std::string_view &sv, Sci_Position &value) {
+	const size_t digits = sv.find_first_not_of("0123456789");
+	if (sv.empty() || digits == 0) {
+		return false;
+	}
+	value = std::strtoll(std::string(sv.substr(0, digits)).c_str(), nullptr, 10);
+	sv.remove_prefix(std::min(digits, sv.length()));
+	if (!sv.empty()) {
+		if (sv.front() != ' ') {
+			return false;
+		}
+		sv.remove_prefix(1);
+	}
+	return true;
+}
+
+}
+
+bool ReadEdits(std::string_view script, std::vector<Edit> &edits, std::string &error) {
+	size_t lineNumber = 0;
+	while (!script.empty()) {
+		lineNumber++;
+		const size_t end = script.find('\n');
+		std::string_view line = script.substr(0, end);
+		script.remove_prefix((end == std::string_view::npos) ? script.length() : end + 1);
+		if (!line.empty() && line.back() == '\r') {
+			line.remove_suffix(1);
+		}
+		if (line.empty() || line.front() == '#') {
+			continue;
+		}
+		Edit edit;
+		bool valid = (line.length() >= 2) && (line[1] == ' ');
+		if (valid) {
+			const char kind = line.front();
+			line.remove_prefix(2);
+			valid = ReadNumber(line, edit.position);
+			if (valid && kind == 'i') {
+				edit.kind = Edit::Kind::insert;
+				valid = Unescape(line, edit.text) && !edit.text.empty();
+			} else if (valid && kind == 'd') {
+				edit.kind = Edit::Kind::remove;
+				valid = ReadNumber(line, edit.length) && line.empty();
+			} else {
+				valid = false;
+			}
+		}
+		if (!valid) {
+			error = "can not read edit on line " + std::to_string(lineNumber);
+			return false;
+		}
+		edits.push_back(std::move(edit));
+	}
+	return true;
+}
+
+std::vector<double> ReplayEdits(GapDocument &doc, Scintilla::ILexer5 *plex, const std::vector<Edit> &edits, Sci_Position windowLines) {
+	std::vector<double> durations;
+	durations.reserve(edits.size());
+	for (const Edit &edit : edits) {
+		// Edits outside the document are clipped to it so a script can be run against any text
+		const Sci_Position position = std::min(edit.position, doc.Length());
+		if (edit.kind == Edit::Kind::insert) {
+			doc.InsertText(position, edit.text);
+		} else {
+			doc.DeleteText(position, std::min(edit.length, doc.Length() - position));
+		}
+		const Sci_Position lineEnd = doc.LineFromPosition(position) + windowLines;
+		const auto start = std::chrono::steady_clock::now();
+		doc.EnsureStyledTo(doc.LineStart(lineEnd), plex);
+		const std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start;
+		durations.push_back(duration.count());
+	}
+	return durations;
+}
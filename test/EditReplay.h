@@ -0,0 +1,29 @@
+// Lexilla lexer library
+/** @file EditReplay.h
+ ** Read a script of edits and replay it on a GapDocument, styling after each edit as an editor would.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef EDITREPLAY_H
+#define EDITREPLAY_H
+
+struct Edit {
+	enum class Kind { insert, remove };
+	Kind kind = Kind::insert;
+	Sci_Position position = 0;
+	std::string text;	// Inserted text
+	Sci_Position length = 0;	// Length removed
+};
+
+// A script has one edit per line:
+//   i <position> <text>	insert text, where \n \r \t \\ and \xHH are escapes
+//   d <position> <length>	delete length bytes
+// Empty lines and lines starting with '#' are ignored.
+// Returns false with a message in error when a line can not be read.
+bool ReadEdits(std::string_view script, std::vector<Edit> &edits, std::string &error);
+
+// Applies each edit then styles up to windowLines lines after the edit, as if that much of the
+// document was visible. Returns the time in microseconds taken to style after each edit.
+std::vector<double> ReplayEdits(GapDocument &doc, Scintilla::ILexer5 *plex, const std::vector<Edit> &edits, Sci_Position windowLines);
+
+#endif
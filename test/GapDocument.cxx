@@ -0,0 +1,418 @@
+// Lexilla lexer library
+/** @file GapDocument.cxx
+ ** Document for testing and benchmarking incremental lexing that behaves like an editor's.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cassert>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include "ILexer.h"
+
+#include "GapDocument.h"
+
+namespace {
+
+constexpr int foldLevelBase = 0x400;
+
+constexpr bool UTF8IsTrailByte(unsigned char ch) noexcept {
+	return (ch >= 0x80) && (ch < 0xc0);
+}
+
+constexpr int UTF8BytesOfLead(unsigned char ch) noexcept {
+	if (ch >= 0xF0 && ch <= 0xF4) {
+		return 4;
+	} else if (ch >= 0xE0) {
+		return (ch <= 0xEF) ? 3 : 1;
+	} else if (ch >= 0xC2) {
+		return 2;
+	}
+	return 1;
+}
+
+}
+
+Partitioning::Partitioning() {
+	// One empty partition: the start of the text and its end
+	body.InsertValue(0, 2, 0);
+}
+
+void Partitioning::ApplyStep(ptrdiff_t partitionUpTo) noexcept {
+	if (stepLength != 0) {
+		for (ptrdiff_t partition = stepPartition + 1; partition <= partitionUpTo; partition++) {
+			body.SetValueAt(partition, body.ValueAt(partition) + stepLength);
+		}
+	}
+	stepPartition = partitionUpTo;
+	if (stepPartition >= Partitions()) {
+		stepPartition = Partitions();
+		stepLength = 0;
+	}
+}
+
+void Partitioning::BackStep(ptrdiff_t partitionDownTo) noexcept {
+	if (stepLength != 0) {
+		for (ptrdiff_t partition = partitionDownTo + 1; partition <= stepPartition; partition++) {
+			body.SetValueAt(partition, body.ValueAt(partition) - stepLength);
+		}
+	}
+	stepPartition = partitionDownTo;
+}
+
+ptrdiff_t Partitioning::Partitions() const noexcept {
+	return body.Length() - 1;
+}
+
+void Partitioning::InsertPartition(ptrdiff_t partition, ptrdiff_t position) {
+	if (stepPartition < partition) {
+		ApplyStep(partition);
+	}
+	body.InsertValue(partition, 1, position);
+	stepPartition++;
+}
+
+void Partitioning::InsertText(ptrdiff_t partitionInsert, ptrdiff_t delta) noexcept {
+	// Partitions after partitionInsert move by delta
+	if (stepLength != 0) {
+		if (partitionInsert >= stepPartition) {
+			ApplyStep(partitionInsert);
+			stepLength += delta;
+		} else if (partitionInsert >= (stepPartition - Partitions() / 10)) {
+			// Near the step so move the step back to here
+			BackStep(partitionInsert);
+			stepLength += delta;
+		} else {
+			ApplyStep(Partitions());
+			stepPartition = partitionInsert;
+			stepLength = delta;
+		}
+	} else {
+		stepPartition = partitionInsert;
+		stepLength = delta;
+	}
+}
+
+void Partitioning::RemovePartition(ptrdiff_t partition) noexcept {
+	if (partition > stepPartition) {
+		ApplyStep(partition);
+	}
+	stepPartition--;
+	body.Delete(partition, 1);
+}
+
+ptrdiff_t Partitioning::PositionFromPartition(ptrdiff_t partition) const noexcept {
+	ptrdiff_t position = body.ValueAt(partition);
+	if (partition > stepPartition) {
+		position += stepLength;
+	}
+	return position;
+}
+
+ptrdiff_t Partitioning::PartitionFromPosition(ptrdiff_t position) const noexcept {
+	if (Partitions() < 1) {
+		return 0;
+	}
+	if (position >= PositionFromPartition(Partitions())) {
+		return Partitions() - 1;
+	}
+	ptrdiff_t lower = 0;
+	ptrdiff_t upper = Partitions();
+	do {
+		const ptrdiff_t middle = (upper + lower + 1) / 2;
+		if (position < PositionFromPartition(middle)) {
+			upper = middle - 1;
+		} else {
+			lower = middle;
+		}
+	} while (lower < upper);
+	return lower;
+}
+
+void GapDocument::ModifiedAt(Sci_Position position) noexcept {
+	if (endStyled > position) {
+		endStyled = position;
+	}
+}
+
+void GapDocument::Set(std::string_view sv) {
+	text.Delete(0, text.Length());
+	styles.Delete(0, styles.Length());
+	lineStarts = Partitioning();
+	lineStates.Delete(0, lineStates.Length());
+	lineLevels.Delete(0, lineLevels.Length());
+	lineStates.InsertValue(0, 1, 0);
+	lineLevels.InsertValue(0, 1, foldLevelBase);
+	endStyled = 0;
+	InsertText(0, sv);
+}
+
+void GapDocument::InsertText(Sci_Position position, std::string_view sv) {
+	if (sv.empty()) {
+		return;
+	}
+	const Sci_Position insertLength = sv.length();
+	Sci_Position line = LineFromPosition(position);
+	text.InsertFromArray(position, sv.data(), insertLength);
+	styles.InsertValue(position, insertLength, 0);
+	lineStarts.InsertText(line, insertLength);
+	for (Sci_Position i = 0; i < insertLength; i++) {
+		if (sv[i] == '\n') {
+			line++;
+			lineStarts.InsertPartition(line, position + i + 1);
+			// New lines take the state and level of the line they are inserted before, like Scintilla
+			lineStates.InsertValue(line, 1, (line < lineStates.Length()) ? lineStates.ValueAt(line) : 0);
+			lineLevels.InsertValue(line, 1, (line < lineLevels.Length()) ? lineLevels.ValueAt(line) : foldLevelBase);
+		}
+	}
+	ModifiedAt(position);
+}
+
+void GapDocument::DeleteText(Sci_Position position, Sci_Position deleteLength) {
+	if (deleteLength <= 0) {
+		return;
+	}
+	const Sci_Position line = LineFromPosition(position);
+	for (Sci_Position i = 0; i < deleteLength; i++) {
+		if (text.ValueAt(position + i) == '\n') {
+			lineStarts.RemovePartition(line + 1);
+			if (line + 1 < lineStates.Length()) {
+				lineStates.Delete(line + 1, 1);
+			}
+			if (line + 1 < lineLevels.Length()) {
+				lineLevels.Delete(line + 1, 1);
+			}
+		}
+	}
+	lineStarts.InsertText(line, -deleteLength);
+	text.Delete(position, deleteLength);
+	styles.Delete(position, deleteLength);
+	ModifiedAt(position);
+}
+
+Sci_Position GapDocument::GetEndStyled() const noexcept {
+	return endStyled;
+}
+
+void GapDocument::EnsureStyledTo(Sci_Position position, Scintilla::ILexer5 *plex) {
+	assert(plex);
+	position = std::min(position, Length());
+	if (endStyled >= position) {
+		return;
+	}
+	const Sci_Position start = LineStart(LineFromPosition(endStyled));
+	const int styleStart = (start > 0) ? StyleAt(start - 1) : 0;
+	plex->Lex(start, position - start, styleStart, this);
+	plex->Fold(start, position - start, styleStart, this);
+}
+
+std::string GapDocument::Text(Sci_Position position, Sci_Position lengthRetrieve) const {
+	std::string s(lengthRetrieve, '\0');
+	text.GetRange(s.data(), position, lengthRetrieve);
+	return s;
+}
+
+Sci_Position GapDocument::Lines() const noexcept {
+	return lineStarts.Partitions();
+}
+
+#if defined(_MSC_VER)
+// IDocument interface does not specify noexcept so best to not add it to implementation
+#pragma warning(disable: 26440)
+#endif
+
+int SCI_METHOD GapDocument::Version() const {
+	return Scintilla::dvRelease4;
+}
+
+void SCI_METHOD GapDocument::SetErrorStatus(int) {
+}
+
+Sci_Position SCI_METHOD GapDocument::Length() const {
+	return text.Length();
+}
+
+void SCI_METHOD GapDocument::GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
+	text.GetRange(buffer, position, lengthRetrieve);
+}
+
+char SCI_METHOD GapDocument::StyleAt(Sci_Position position) const {
+	if ((position < 0) || (position >= Length())) {
+		return 0;
+	}
+	return styles.ValueAt(position);
+}
+
+Sci_Position SCI_METHOD GapDocument::LineFromPosition(Sci_Position position) const {
+	return lineStarts.PartitionFromPosition(position);
+}
+
+Sci_Position SCI_METHOD GapDocument::LineStart(Sci_Position line) const {
+	if (line < 0) {
+		return 0;
+	}
+	if (line >= Lines()) {
+		return Length();
+	}
+	return lineStarts.PositionFromPartition(line);
+}
+
+int SCI_METHOD GapDocument::GetLevel(Sci_Position line) const {
+	if ((line < 0) || (line >= lineLevels.Length())) {
+		return foldLevelBase;
+	}
+	return lineLevels.ValueAt(line);
+}
+
+int SCI_METHOD GapDocument::SetLevel(Sci_Position line, int level) {
+	if ((line < 0) || (line >= lineLevels.Length())) {
+		return foldLevelBase;
+	}
+	const int previous = lineLevels.ValueAt(line);
+	lineLevels.SetValueAt(line, level);
+	return previous;
+}
+
+int SCI_METHOD GapDocument::GetLineState(Sci_Position line) const {
+	if ((line < 0) || (line >= lineStates.Length())) {
+		return 0;
+	}
+	return lineStates.ValueAt(line);
+}
+
+int SCI_METHOD GapDocument::SetLineState(Sci_Position line, int state) {
+	if (line < 0) {
+		return 0;
+	}
+	if (line >= lineStates.Length()) {
+		lineStates.InsertValue(lineStates.Length(), line + 1 - lineStates.Length(), 0);
+	}
+	const int previous = lineStates.ValueAt(line);
+	lineStates.SetValueAt(line, state);
+	return previous;
+}
+
+void SCI_METHOD GapDocument::StartStyling(Sci_Position position) {
+	endStyled = position;
+}
+
+bool SCI_METHOD GapDocument::SetStyleFor(Sci_Position length, char style) {
+	assert(endStyled + length <= Length());
+	for (Sci_Position i = 0; i < length; i++) {
+		styles.SetValueAt(endStyled, style);
+		endStyled++;
+	}
+	return true;
+}
+
+bool SCI_METHOD GapDocument::SetStyles(Sci_Position length, const char *styleValues) {
+	assert(styleValues);
+	assert(endStyled + length <= Length());
+	for (Sci_Position i = 0; i < length; i++) {
+		styles.SetValueAt(endStyled, styleValues[i]);
+		endStyled++;
+	}
+	return true;
+}
+
+void SCI_METHOD GapDocument::DecorationSetCurrentIndicator(int) {
+	// Not implemented as no way to read decorations
+}
+
+void SCI_METHOD GapDocument::DecorationFillRange(Sci_Position, int, Sci_Position) {
+	// Not implemented as no way to read decorations
+}
+
+void SCI_METHOD GapDocument::ChangeLexerState(Sci_Position start, Sci_Position) {
+	// The lexer found that state it relied on changed so text after start has to be styled again
+	ModifiedAt(start);
+}
+
+int SCI_METHOD GapDocument::CodePage() const {
+	return 65001;
+}
+
+bool SCI_METHOD GapDocument::IsDBCSLeadByte(char) const {
+	return false;
+}
+
+const char *SCI_METHOD GapDocument::BufferPointer() {
+	return text.BufferPointer();
+}
+
+int SCI_METHOD GapDocument::GetLineIndentation(Sci_Position) {
+	// Never actually called - lexers use Accessor::IndentAmount
+	return 0;
+}
+
+Sci_Position SCI_METHOD GapDocument::LineEnd(Sci_Position line) const {
+	if (line >= Lines() - 1) {
+		return Length();
+	}
+	Sci_Position position = LineStart(line + 1) - 1;	// Back over LF
+	if ((position > LineStart(line)) && (text.ValueAt(position - 1) == '\r')) {
+		position--;
+	}
+	return position;
+}
+
+Sci_Position SCI_METHOD GapDocument::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const {
+	Sci_Position pos = positionStart;
+	while (characterOffset < 0) {
+		if (pos <= 0) {
+			return -1;
+		}
+		pos--;
+		// Back over up to 3 trail bytes to the lead byte
+		for (int trail = 0; (trail < 3) && (pos > 0) && UTF8IsTrailByte(text.ValueAt(pos)); trail++) {
+			pos--;
+		}
+		characterOffset++;
+	}
+	while (characterOffset > 0) {
+		if (pos >= Length()) {
+			return -1;
+		}
+		Sci_Position width = 0;
+		GetCharacterAndWidth(pos, &width);
+		pos += width;
+		characterOffset--;
+	}
+	return pos;
+}
+
+int SCI_METHOD GapDocument::GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const {
+	if ((position < 0) || (position >= Length())) {
+		// Return NULs before document start and after document end
+		if (pWidth) {
+			*pWidth = 1;
+		}
+		return '\0';
+	}
+	const unsigned char leadByte = text.ValueAt(position);
+	int width = UTF8BytesOfLead(leadByte);
+	if (position + width > Length()) {
+		width = 1;
+	}
+	for (int b = 1; b < width; b++) {
+		if (!UTF8IsTrailByte(text.ValueAt(position + b))) {
+			// Invalid so treat the lead byte as a character of its own
+			width = 1;
+		}
+	}
+	int character = leadByte;
+	if (width > 1) {
+		character = leadByte & (0x7F >> width);
+		for (int b = 1; b < width; b++) {
+			character = (character << 6) | (static_cast<unsigned char>(text.ValueAt(position + b)) & 0x3F);
+		}
+	}
+	if (pWidth) {
+		*pWidth = width;
+	}
+	return character;
+}
@@ -0,0 +1,169 @@
+// Lexilla lexer library
+/** @file GapDocument.h
+ ** Document for testing and benchmarking incremental lexing that behaves like an editor's.
+ ** Text and styles are held in gap buffers and line starts in a partitioning with a pending step,
+ ** as Scintilla does, so edits are cheap, BufferPointer moves the gap and line starts after an
+ ** edit are only updated when needed.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef GAPDOCUMENT_H
+#define GAPDOCUMENT_H
+
+// A vector with a gap at the position of the last change so changes near each other don't move
+// the rest of the elements
+template <typename T>
+class SplitVector {
+	std::vector<T> body;
+	ptrdiff_t part1Length = 0;
+	ptrdiff_t gapLength = 0;
+
+	void GapTo(ptrdiff_t position) noexcept {
+		if (position < part1Length) {
+			std::move_backward(body.begin() + position, body.begin() + part1Length, body.begin() + part1Length + gapLength);
+		} else if (position > part1Length) {
+			std::move(body.begin() + part1Length + gapLength, body.begin() + gapLength + position, body.begin() + part1Length);
+		}
+		part1Length = position;
+	}
+	void RoomFor(ptrdiff_t insertionLength) {
+		if (gapLength < insertionLength) {
+			GapTo(Length());
+			const ptrdiff_t grow = std::max<ptrdiff_t>(insertionLength - gapLength, std::max<ptrdiff_t>(Length() / 8, 64));
+			body.resize(body.size() + grow);
+			gapLength += grow;
+		}
+	}
+public:
+	ptrdiff_t Length() const noexcept {
+		return static_cast<ptrdiff_t>(body.size()) - gapLength;
+	}
+	T ValueAt(ptrdiff_t position) const noexcept {
+		if (position < part1Length) {
+			return body[position];
+		}
+		return body[gapLength + position];
+	}
+	void SetValueAt(ptrdiff_t position, T value) noexcept {
+		if (position < part1Length) {
+			body[position] = value;
+		} else {
+			body[gapLength + position] = value;
+		}
+	}
+	void InsertValue(ptrdiff_t position, ptrdiff_t insertLength, T value) {
+		RoomFor(insertLength);
+		GapTo(position);
+		std::fill(body.begin() + part1Length, body.begin() + part1Length + insertLength, value);
+		part1Length += insertLength;
+		gapLength -= insertLength;
+	}
+	void InsertFromArray(ptrdiff_t position, const T *values, ptrdiff_t insertLength) {
+		RoomFor(insertLength);
+		GapTo(position);
+		std::copy(values, values + insertLength, body.begin() + part1Length);
+		part1Length += insertLength;
+		gapLength -= insertLength;
+	}
+	void Delete(ptrdiff_t position, ptrdiff_t deleteLength) noexcept {
+		if (position == 0 && deleteLength == Length()) {
+			body.clear();
+			part1Length = 0;
+			gapLength = 0;
+			return;
+		}
+		GapTo(position);
+		gapLength += deleteLength;
+	}
+	void GetRange(T *buffer, ptrdiff_t position, ptrdiff_t retrieveLength) const noexcept {
+		const ptrdiff_t range1Length = std::clamp<ptrdiff_t>(part1Length - position, 0, retrieveLength);
+		std::copy(body.begin() + position, body.begin() + position + range1Length, buffer);
+		std::copy(body.begin() + gapLength + position + range1Length, body.begin() + gapLength + position + retrieveLength,
+			buffer + range1Length);
+	}
+	// Contiguous elements followed by a default T, such as a NUL for text, moving the gap to the end
+	T *BufferPointer() {
+		RoomFor(1);
+		GapTo(Length());
+		body[part1Length] = T();
+		return body.data();
+	}
+};
+
+// Start positions of lines where a change in length is applied to the following lines lazily:
+// positions after stepPartition are stepLength less than their true value until the step is moved
+// over them, so typing in one place does not update every later line start.
+class Partitioning {
+	ptrdiff_t stepPartition = 0;
+	ptrdiff_t stepLength = 0;
+	SplitVector<ptrdiff_t> body;
+
+	void ApplyStep(ptrdiff_t partitionUpTo) noexcept;
+	void BackStep(ptrdiff_t partitionDownTo) noexcept;
+public:
+	Partitioning();
+	ptrdiff_t Partitions() const noexcept;
+	void InsertPartition(ptrdiff_t partition, ptrdiff_t position);
+	void InsertText(ptrdiff_t partitionInsert, ptrdiff_t delta) noexcept;
+	void RemovePartition(ptrdiff_t partition) noexcept;
+	ptrdiff_t PositionFromPartition(ptrdiff_t partition) const noexcept;
+	ptrdiff_t PartitionFromPosition(ptrdiff_t position) const noexcept;
+};
+
+// UTF-8 document with '\n' line ends that is edited with InsertText and DeleteText.
+// Styling takes place as in an editor: an edit sets the end of styled text back to the edit and
+// EnsureStyledTo lexes from the start of the first line that is not fully styled.
+class GapDocument : public Scintilla::IDocument {
+	SplitVector<char> text;
+	SplitVector<char> styles;
+	Partitioning lineStarts;
+	SplitVector<int> lineStates;
+	SplitVector<int> lineLevels;
+	Sci_Position endStyled = 0;
+	void ModifiedAt(Sci_Position position) noexcept;
+public:
+	GapDocument() = default;
+	// Deleted so GapDocument objects can not be copied.
+	GapDocument(const GapDocument&) = delete;
+	GapDocument(GapDocument&&) = delete;
+	GapDocument &operator=(const GapDocument&) = delete;
+	GapDocument &operator=(GapDocument&&) = delete;
+	virtual ~GapDocument() = default;
+
+	void Set(std::string_view sv);
+	void InsertText(Sci_Position position, std::string_view sv);
+	void DeleteText(Sci_Position position, Sci_Position deleteLength);
+	Sci_Position GetEndStyled() const noexcept;
+	// Lex and fold from the start of the line holding the end of styled text to position, as an editor does
+	// before showing the text up to position
+	void EnsureStyledTo(Sci_Position position, Scintilla::ILexer5 *plex);
+	std::string Text(Sci_Position position, Sci_Position lengthRetrieve) const;
+	Sci_Position Lines() const noexcept;
+
+	int SCI_METHOD Version() const override;
+	void SCI_METHOD SetErrorStatus(int status) override;
+	Sci_Position SCI_METHOD Length() const override;
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override;
+	char SCI_METHOD StyleAt(Sci_Position position) const override;
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override;
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override;
+	int SCI_METHOD GetLevel(Sci_Position line) const override;
+	int SCI_METHOD SetLevel(Sci_Position line, int level) override;
+	int SCI_METHOD GetLineState(Sci_Position line) const override;
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override;
+	void SCI_METHOD StartStyling(Sci_Position position) override;
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override;
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles) override;
+	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override;
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end) override;
+	int SCI_METHOD CodePage() const override;
+	bool SCI_METHOD IsDBCSLeadByte(char ch) const override;
+	const char *SCI_METHOD BufferPointer() override;
+	int SCI_METHOD GetLineIndentation(Sci_Position line) override;
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override;
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override;
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override;
+};
+
+#endif
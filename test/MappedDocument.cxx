@@ -0,0 +1,367 @@
+// Lexilla lexer library
+/** @file MappedDocument.cxx
+ ** Read only document over a memory mapped file for lexing logs too large to load into an editor.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ILexer.h"
+
+#include "ExtraLexers.h"
+#include "LexScan.h"
+
+#include "MappedDocument.h"
+
+namespace {
+
+constexpr int foldLevelBase = 0x400;
+
+constexpr bool UTF8IsTrailByte(unsigned char ch) noexcept {
+	return (ch >= 0x80) && (ch < 0xc0);
+}
+
+constexpr int UTF8BytesOfLead(unsigned char ch) noexcept {
+	if (ch >= 0xF0 && ch <= 0xF4) {
+		return 4;
+	} else if (ch >= 0xE0) {
+		return (ch <= 0xEF) ? 3 : 1;
+	} else if (ch >= 0xC2) {
+		return 2;
+	}
+	return 1;
+}
+
+}
+
+MappedDocument::~MappedDocument() {
+	Close();
+}
+
+bool MappedDocument::Open(const char *path) {
+	Close();
+#if defined(_WIN32)
+	HANDLE hFile = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size {};
+	if (!::GetFileSizeEx(hFile, &size)) {
+		::CloseHandle(hFile);
+		return false;
+	}
+	file = hFile;
+	if (size.QuadPart > 0) {
+		mapping = ::CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping) {
+			Close();
+			return false;
+		}
+		text = static_cast<const char *>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!text) {
+			Close();
+			return false;
+		}
+		length = static_cast<Sci_Position>(size.QuadPart);
+	}
+#else
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat status {};
+	if ((::fstat(fd, &status) != 0) || !S_ISREG(status.st_mode)) {
+		::close(fd);
+		return false;
+	}
+	if (status.st_size > 0) {
+		void *view = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (view == MAP_FAILED) {
+			::close(fd);
+			return false;
+		}
+		// Lexers read from the start to the end so let the kernel read ahead
+		::madvise(view, status.st_size, MADV_SEQUENTIAL);
+		text = static_cast<const char *>(view);
+		length = status.st_size;
+	}
+	// The mapping stays valid once the file is closed
+	::close(fd);
+#endif
+	return true;
+}
+
+void MappedDocument::Close() noexcept {
+#if defined(_WIN32)
+	if (text) {
+		::UnmapViewOfFile(text);
+	}
+	if (mapping) {
+		::CloseHandle(mapping);
+	}
+	if (file) {
+		::CloseHandle(file);
+	}
+	mapping = nullptr;
+	file = nullptr;
+#else
+	if (text) {
+		::munmap(const_cast<char *>(text), length);
+	}
+#endif
+	text = nullptr;
+	length = 0;
+	lineStarts.assign(1, 0);
+	indexed = 0;
+	styles.Clear();
+	lineStates.clear();
+	lineLevels.clear();
+	endStyled = 0;
+}
+
+void MappedDocument::IndexChunk() const {
+	const char *end = text + std::min(indexed + chunkSize, length);
+	const char *documentEnd = text + length;
+	const char *p = text + indexed;
+	while ((p = Lexilla::FindAny2(p, end, '\n', '\r')) < end) {
+		// A '\r' at the end of the chunk may start a "\r\n" so look at the byte after
+		if ((*p == '\r') && (p + 1 < documentEnd) && (p[1] == '\n')) {
+			p++;
+		}
+		p++;
+		lineStarts.push_back(p - text);
+	}
+	indexed = std::max<Sci_Position>(end - text, lineStarts.back());
+}
+
+void MappedDocument::IndexTo(Sci_Position position) const {
+	while ((indexed < position) && (indexed < length)) {
+		IndexChunk();
+	}
+}
+
+Sci_Position MappedDocument::Lines() const {
+	IndexTo(length);
+	return static_cast<Sci_Position>(lineStarts.size());
+}
+
+const RunLengthStyles &MappedDocument::Styles() const noexcept {
+	return styles;
+}
+
+size_t MappedDocument::MemoryUse() const noexcept {
+	return lineStarts.capacity() * sizeof(Sci_Position) + styles.MemoryUse() +
+		(lineStates.capacity() + lineLevels.capacity()) * sizeof(int);
+}
+
+#if defined(_MSC_VER)
+// IDocument interface does not specify noexcept so best to not add it to implementation
+#pragma warning(disable: 26440)
+#endif
+
+int SCI_METHOD MappedDocument::Version() const {
+	return Scintilla::dvRelease4;
+}
+
+void SCI_METHOD MappedDocument::SetErrorStatus(int) {
+}
+
+Sci_Position SCI_METHOD MappedDocument::Length() const {
+	return length;
+}
+
+void SCI_METHOD MappedDocument::GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
+	memcpy(buffer, text + position, lengthRetrieve);
+}
+
+char SCI_METHOD MappedDocument::StyleAt(Sci_Position position) const {
+	if (position < 0) {
+		return 0;
+	}
+	return static_cast<char>(styles.StyleAt(position));
+}
+
+Sci_Position SCI_METHOD MappedDocument::LineFromPosition(Sci_Position position) const {
+	IndexTo(position);
+	const std::vector<Sci_Position>::const_iterator it = std::upper_bound(lineStarts.begin(), lineStarts.end(), position);
+	return it - lineStarts.begin() - 1;
+}
+
+Sci_Position SCI_METHOD MappedDocument::LineStart(Sci_Position line) const {
+	if (line < 0) {
+		return 0;
+	}
+	while ((line >= static_cast<Sci_Position>(lineStarts.size())) && (indexed < length)) {
+		IndexChunk();
+	}
+	if (line >= static_cast<Sci_Position>(lineStarts.size())) {
+		return length;
+	}
+	return lineStarts[line];
+}
+
+int SCI_METHOD MappedDocument::GetLevel(Sci_Position line) const {
+	return (line < static_cast<Sci_Position>(lineLevels.size())) ? lineLevels[line] : foldLevelBase;
+}
+
+int SCI_METHOD MappedDocument::SetLevel(Sci_Position line, int level) {
+	if (line >= static_cast<Sci_Position>(lineLevels.size())) {
+		lineLevels.resize(line + 1, foldLevelBase);
+	}
+	return lineLevels[line] = level;
+}
+
+int SCI_METHOD MappedDocument::GetLineState(Sci_Position line) const {
+	return (line < static_cast<Sci_Position>(lineStates.size())) ? lineStates[line] : 0;
+}
+
+int SCI_METHOD MappedDocument::SetLineState(Sci_Position line, int state) {
+	if (line >= static_cast<Sci_Position>(lineStates.size())) {
+		lineStates.resize(line + 1);
+	}
+	return lineStates[line] = state;
+}
+
+void SCI_METHOD MappedDocument::StartStyling(Sci_Position position) {
+	endStyled = position;
+}
+
+bool SCI_METHOD MappedDocument::SetStyleFor(Sci_Position lengthStyle, char style) {
+	const StyleRun run { static_cast<size_t>(lengthStyle), static_cast<unsigned char>(style) };
+	styles.SetStyleRuns(endStyled, &run, 1);
+	endStyled += lengthStyle;
+	return true;
+}
+
+bool SCI_METHOD MappedDocument::SetStyles(Sci_Position lengthStyle, const char *styles_) {
+	assert(styles_);
+	// Set one run for each sequence of the same style
+	Sci_Position position = 0;
+	while (position < lengthStyle) {
+		const char style = styles_[position];
+		const Sci_Position start = position;
+		while ((position < lengthStyle) && (styles_[position] == style)) {
+			position++;
+		}
+		SetStyleFor(position - start, style);
+	}
+	return true;
+}
+
+void SCI_METHOD MappedDocument::DecorationSetCurrentIndicator(int) {
+	// Not implemented as no way to read decorations
+}
+
+void SCI_METHOD MappedDocument::DecorationFillRange(Sci_Position, int, Sci_Position) {
+	// Not implemented as no way to read decorations
+}
+
+void SCI_METHOD MappedDocument::ChangeLexerState(Sci_Position, Sci_Position) {
+	// Not implemented as no watcher to trigger
+}
+
+int SCI_METHOD MappedDocument::CodePage() const {
+	return 65001;
+}
+
+bool SCI_METHOD MappedDocument::IsDBCSLeadByte(char) const {
+	return false;
+}
+
+const char *SCI_METHOD MappedDocument::BufferPointer() {
+	return text;
+}
+
+int SCI_METHOD MappedDocument::GetLineIndentation(Sci_Position) {
+	// Never actually called - lexers use Accessor::IndentAmount
+	return 0;
+}
+
+Sci_Position SCI_METHOD MappedDocument::LineEnd(Sci_Position line) const {
+	const Sci_Position start = LineStart(line);
+	const Sci_Position next = LineStart(line + 1);
+	if (line + 1 >= static_cast<Sci_Position>(lineStarts.size())) {
+		// The last line has no line end
+		return length;
+	}
+	Sci_Position position = next - 1; // Back over CR or LF
+	if ((position > start) && (text[position] == '\n') && (text[position - 1] == '\r')) {
+		position--;
+	}
+	return position;
+}
+
+Sci_Position SCI_METHOD MappedDocument::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const {
+	Sci_Position pos = positionStart;
+	while (characterOffset < 0) {
+		if (pos <= 0) {
+			return -1;
+		}
+		pos--;
+		// Back over up to 3 trail bytes to the lead byte
+		for (int trail = 0; (trail < 3) && (pos > 0) && UTF8IsTrailByte(text[pos]); trail++) {
+			pos--;
+		}
+		characterOffset++;
+	}
+	while (characterOffset > 0) {
+		if (pos >= length) {
+			return -1;
+		}
+		Sci_Position width = 0;
+		GetCharacterAndWidth(pos, &width);
+		pos += width;
+		characterOffset--;
+	}
+	return pos;
+}
+
+int SCI_METHOD MappedDocument::GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const {
+	if ((position < 0) || (position >= length)) {
+		// Return NULs before document start and after document end
+		if (pWidth) {
+			*pWidth = 1;
+		}
+		return '\0';
+	}
+	const unsigned char leadByte = text[position];
+	int width = UTF8BytesOfLead(leadByte);
+	if (position + width > length) {
+		width = 1;
+	}
+	for (int b = 1; b < width; b++) {
+		if (!UTF8IsTrailByte(text[position + b])) {
+			// Invalid so treat the lead byte as a character of its own
+			width = 1;
+		}
+	}
+	int character = leadByte;
+	if (width > 1) {
+		character = leadByte & (0x7F >> width);
+		for (int b = 1; b < width; b++) {
+			character = (character << 6) | (static_cast<unsigned char>(text[position + b]) & 0x3F);
+		}
+	}
+	if (pWidth) {
+		*pWidth = width;
+	}
+	return character;
+}
@@ -0,0 +1,78 @@
+// Lexilla lexer library
+/** @file MappedDocument.h
+ ** Read only document over a memory mapped file for lexing logs too large to load into an editor.
+ ** The text is never copied: BufferPointer returns the mapping. Line starts are found lazily a chunk
+ ** at a time as lexers ask for lines, styles are held as runs and line states and fold levels only
+ ** for the lines set, so memory grows with the number of lines and style changes, not the file's size.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef MAPPEDDOCUMENT_H
+#define MAPPEDDOCUMENT_H
+
+// UTF-8 document with '\r', '\n' and "\r\n" line ends whose text is a file mapped into memory
+class MappedDocument : public Scintilla::IDocument {
+	const char *text = nullptr;
+	Sci_Position length = 0;
+#if defined(_WIN32)
+	void *file = nullptr;
+	void *mapping = nullptr;
+#endif
+	// Lines are indexed up to indexed: every line starting at or before it is in lineStarts
+	mutable std::vector<Sci_Position> lineStarts = { 0 };
+	mutable Sci_Position indexed = 0;
+	RunLengthStyles styles;
+	std::vector<int> lineStates;
+	std::vector<int> lineLevels;
+	Sci_Position endStyled = 0;
+	void IndexChunk() const;
+	void IndexTo(Sci_Position position) const;
+public:
+	// Bytes of text scanned for line ends each time more lines are needed
+	static constexpr Sci_Position chunkSize = 1024 * 1024;
+
+	MappedDocument() = default;
+	// Deleted so MappedDocument objects can not be copied.
+	MappedDocument(const MappedDocument&) = delete;
+	MappedDocument(MappedDocument&&) = delete;
+	MappedDocument &operator=(const MappedDocument&) = delete;
+	MappedDocument &operator=(MappedDocument&&) = delete;
+	virtual ~MappedDocument();
+
+	// Maps the file at path, returning false when it can not be opened or mapped
+	bool Open(const char *path);
+	void Close() noexcept;
+	// Lines in the document, indexing all of it
+	Sci_Position Lines() const;
+	const RunLengthStyles &Styles() const noexcept;
+	// Bytes held for the line index, styles, line states and levels
+	size_t MemoryUse() const noexcept;
+
+	int SCI_METHOD Version() const override;
+	void SCI_METHOD SetErrorStatus(int status) override;
+	Sci_Position SCI_METHOD Length() const override;
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override;
+	char SCI_METHOD StyleAt(Sci_Position position) const override;
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override;
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override;
+	int SCI_METHOD GetLevel(Sci_Position line) const override;
+	int SCI_METHOD SetLevel(Sci_Position line, int level) override;
+	int SCI_METHOD GetLineState(Sci_Position line) const override;
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override;
+	void SCI_METHOD StartStyling(Sci_Position position) override;
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override;
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles) override;
+	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) override;
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end) override;
+	int SCI_METHOD CodePage() const override;
+	bool SCI_METHOD IsDBCSLeadByte(char ch) const override;
+	// The mapping, which is not followed by a NUL
+	const char *SCI_METHOD BufferPointer() override;
+	int SCI_METHOD GetLineIndentation(Sci_Position line) override;
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override;
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override;
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override;
+};
+
+#endif
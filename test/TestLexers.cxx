@@ -13,6 +13,8 @@
 #include <map>
 #include <optional>
 #include <algorithm>
+#include <chrono>
+#include <limits>
 
 #include <iostream>
 #include <sstream>
@@ -250,6 +252,7 @@ bool PathMatch(std::string pattern, std::string relPath) {
 
 constexpr std::string_view suffixStyled = ".styled";
 constexpr std::string_view suffixFolded = ".folded";
+constexpr std::string_view suffixBench = ".bench";
 constexpr std::string_view lexerPrefix = "lexer.*";
 constexpr std::string_view prefixIf = "if ";
 constexpr std::string_view prefixMatch = "match ";
@@ -598,6 +601,211 @@ void StyleLineByLine(TestDocument &doc, Scintilla::ILexer5 *plex) {
 	}
 }
 
+// Timings of one example file, measured when run with --bench
+struct BenchResult {
+	std::string file;
+	size_t bytes = 0;
+	Sci_Position lines = 0;
+	// Lexing and folding the whole document, averaged over testlexers.bench.repeat runs
+	double lexMilliseconds = 0.0;
+	double foldMilliseconds = 0.0;
+	// Lexing and folding of a single line, as happens after each key press when typing
+	double lineP50Microseconds = 0.0;
+	double lineP99Microseconds = 0.0;
+};
+
+// Results for each lexer name
+using BenchResults = std::map<std::string, std::vector<BenchResult>>;
+
+double Percentile(std::vector<double> values, double fraction) {
+	if (values.empty()) {
+		return 0.0;
+	}
+	const size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size() - 1));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+BenchResult BenchFile(std::string_view text, Scintilla::ILexer5 *plex, int repeat) {
+	assert(plex);
+	using Clock = std::chrono::steady_clock;
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+	using Microseconds = std::chrono::duration<double, std::micro>;
+	TestDocument doc;
+	doc.Set(text);
+	Scintilla::IDocument *pdoc = &doc;
+	BenchResult result;
+	result.bytes = text.length();
+	result.lines = doc.LineFromPosition(doc.Length()) + 1;
+
+	Clock::duration lexTime {};
+	Clock::duration foldTime {};
+	for (int i = 0; i < repeat; i++) {
+		const Clock::time_point startLex = Clock::now();
+		plex->Lex(0, pdoc->Length(), 0, pdoc);
+		const Clock::time_point startFold = Clock::now();
+		plex->Fold(0, pdoc->Length(), 0, pdoc);
+		const Clock::time_point end = Clock::now();
+		lexTime += startFold - startLex;
+		foldTime += end - startFold;
+	}
+	result.lexMilliseconds = Milliseconds(lexTime).count() / repeat;
+	result.foldMilliseconds = Milliseconds(foldTime).count() / repeat;
+
+	// Restyle each line of the styled document on its own
+	std::vector<double> lineTimes;
+	for (Sci_Position line = 0; line < result.lines; line++) {
+		const Sci_Position startLine = doc.LineStart(line);
+		const Sci_Position endLine = doc.LineStart(line + 1);
+		const int styleStart = (startLine > 0) ? doc.StyleAt(startLine - 1) : 0;
+		const Clock::time_point start = Clock::now();
+		plex->Lex(startLine, endLine - startLine, styleStart, pdoc);
+		plex->Fold(startLine, endLine - startLine, styleStart, pdoc);
+		lineTimes.push_back(Microseconds(Clock::now() - start).count());
+	}
+	result.lineP50Microseconds = Percentile(lineTimes, 0.5);
+	result.lineP99Microseconds = Percentile(lineTimes, 0.99);
+	return result;
+}
+
+// Milliseconds taken by a fixed workload of table lookups, branches and stores like those of a lexer.
+// Baselines hold timings divided by this so they can be checked on faster or slower machines.
+double CalibrationMilliseconds() {
+	static const double calibration = []() {
+		std::string text;
+		unsigned int seed = 12345;
+		for (int i = 0; i < 1024 * 1024; i++) {
+			seed = seed * 1103515245 + 12345;
+			text.push_back(static_cast<char>(' ' + (seed >> 16) % 95));
+		}
+		std::vector<char> styles(text.length());
+		double best = std::numeric_limits<double>::max();
+		for (int run = 0; run < 5; run++) {
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			char state = 0;
+			for (size_t i = 0; i < text.length(); i++) {
+				const char ch = text[i];
+				if (IsSpaceOrTab(ch)) {
+					state = 0;
+				} else if (ch >= '0' && ch <= '9') {
+					state = (state == 1) ? 1 : 2;
+				} else if (ch == '"') {
+					state = (state == 3) ? 0 : 3;
+				} else if (state != 3) {
+					state = 1;
+				}
+				styles[i] = state;
+			}
+			const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+			best = std::min(best, duration.count());
+		}
+		// Uses styles so the loop can not be removed
+		[[maybe_unused]] volatile const auto strings = std::count(styles.begin(), styles.end(), 3);
+		return std::max(best, 0.001);
+	}();
+	return calibration;
+}
+
+// Timings of result relative to CalibrationMilliseconds, as stored in baselines
+std::map<std::string, double> RelativeTimings(const BenchResult &result) {
+	const double calibration = CalibrationMilliseconds();
+	return {
+		{ "lex", result.lexMilliseconds / calibration },
+		{ "fold", result.foldMilliseconds / calibration },
+		{ "line.p50", result.lineP50Microseconds / 1000.0 / calibration },
+		{ "line.p99", result.lineP99Microseconds / 1000.0 / calibration },
+	};
+}
+
+// Compares result with the baseline of path, path.bench. Returns false when a timing is slower than the baseline
+// by more than tolerance percent. When there is no baseline or it is exceeded, path.bench.new is written so it
+// can be promoted like .styled.new files.
+bool CheckBaseline(const std::filesystem::path &path, const BenchResult &result, int tolerance) {
+	std::filesystem::path pathBaseline = path;
+	pathBaseline += suffixBench;
+	std::map<std::string, double> baseline;
+	std::istringstream isBaseline(ReadFile(pathBaseline));
+	std::string line;
+	while (std::getline(isBaseline, line)) {
+		const size_t equals = line.find('=');
+		if (!line.starts_with(prefixComment) && (equals != std::string::npos)) {
+			baseline[line.substr(0, equals)] = std::atof(line.c_str() + equals + 1);
+		}
+	}
+
+	// Timings shorter than this vary too much from run to run to be compared
+	constexpr double minimumMilliseconds = 0.01;
+	const double calibration = CalibrationMilliseconds();
+	const std::map<std::string, double> timings = RelativeTimings(result);
+	bool withinBaseline = true;
+	for (const auto &[key, timing] : timings) {
+		const auto it = baseline.find(key);
+		if ((it == baseline.end()) || (it->second <= 0.0) || (timing * calibration < minimumMilliseconds)) {
+			continue;
+		}
+		const double ratio = timing / it->second;
+		if (ratio > 1.0 + tolerance / 100.0) {
+			std::cout << "\n" << path.string() << ":1: " << key << " is " << std::fixed << std::setprecision(2) <<
+				ratio << std::defaultfloat << " times its baseline\n\n";
+			withinBaseline = false;
+		}
+	}
+
+	if (baseline.empty() || !withinBaseline) {
+		std::filesystem::path pathNew = pathBaseline;
+		pathNew += ".new";
+		std::ofstream ofs(pathNew, std::ios::binary);
+		ofs << prefixComment << " Timings relative to the calibration loop of TestLexers --bench\n";
+		for (const auto &[key, timing] : timings) {
+			ofs << key << "=" << timing << "\n";
+		}
+	}
+	return withinBaseline;
+}
+
+std::string JSONString(std::string_view s) {
+	std::string quoted = "\"";
+	for (const char ch : s) {
+		if ((ch == '"') || (ch == '\\')) {
+			quoted.push_back('\\');
+		}
+		quoted.push_back(ch);
+	}
+	quoted.push_back('"');
+	return quoted;
+}
+
+bool WriteBenchResults(const std::filesystem::path &path, const BenchResults &results) {
+	std::ofstream ofs(path, std::ios::binary);
+	if (!ofs) {
+		std::cout << "Failed to write " << path.string() << "\n";
+		return false;
+	}
+	ofs << "{\n";
+	for (auto it = results.begin(); it != results.end(); ++it) {
+		ofs << "  " << JSONString(it->first) << ": [\n";
+		const std::vector<BenchResult> &files = it->second;
+		for (size_t i = 0; i < files.size(); i++) {
+			const BenchResult &result = files[i];
+			const double megabytesPerSecond = (result.lexMilliseconds > 0.0) ?
+				(static_cast<double>(result.bytes) / (1024.0 * 1024.0)) / (result.lexMilliseconds / 1000.0) : 0.0;
+			ofs << "    {\"file\": " << JSONString(result.file) <<
+				", \"bytes\": " << result.bytes <<
+				", \"lines\": " << result.lines <<
+				", \"lex_ms\": " << result.lexMilliseconds <<
+				", \"lex_mb_per_s\": " << megabytesPerSecond <<
+				", \"fold_ms\": " << result.foldMilliseconds <<
+				", \"line_p50_us\": " << result.lineP50Microseconds <<
+				", \"line_p99_us\": " << result.lineP99Microseconds <<
+				"}" << ((i + 1 < files.size()) ? "," : "") << "\n";
+		}
+		ofs << "  ]" << ((std::next(it) != results.end()) ? "," : "") << "\n";
+	}
+	ofs << "}\n";
+	std::cout << "Benchmark results written to " << path.string() << "\n";
+	return true;
+}
+
 bool TestCRLF(std::filesystem::path path, const std::string s, Scintilla::ILexer5 *plex, bool disablePerLineTests) {
 	assert(plex);
 	bool success = true;
@@ -828,7 +1036,7 @@ bool SetProperties(Scintilla::ILexer5 *plex, const std::string &language, const
 }
 
 
-bool TestFile(const std::filesystem::path &path, const PropertyMap &propertyMap) {
+bool TestFile(const std::filesystem::path &path, const std::filesystem::path &basePath, const PropertyMap &propertyMap, BenchResults *bench) {
 	// Find and create correct lexer
 	std::optional<std::string> language = propertyMap.GetPropertyForFile(lexerPrefix, path.filename().string());
 	if (!language) {
@@ -906,6 +1114,17 @@ bool TestFile(const std::filesystem::path &path, const PropertyMap &propertyMap)
 		success = success && CheckSame(foldedText, foldedTextNewPerLine, "per-line folds", suffixFolded, path);
 	}
 
+	if (bench) {
+		const int repeatBench = std::max(propertyMap.GetPropertyValue("testlexers.bench.repeat").value_or(10), 1);
+		BenchResult result = BenchFile(text, plex, repeatBench);
+		result.file = path.lexically_relative(basePath).generic_string();
+		(*bench)[*language].push_back(result);
+		const int tolerance = propertyMap.GetPropertyValue("testlexers.perf.tolerance").value_or(50);
+		if (!CheckBaseline(path, result, tolerance)) {
+			success = false;
+		}
+	}
+
 	plex->Release();
 
 	if (success) {
@@ -917,19 +1136,19 @@ bool TestFile(const std::filesystem::path &path, const PropertyMap &propertyMap)
 	return success;
 }
 
-bool TestDirectory(std::filesystem::path directory, std::filesystem::path basePath) {
+bool TestDirectory(std::filesystem::path directory, std::filesystem::path basePath, BenchResults *bench) {
 	bool success = true;
 	for (auto &p : std::filesystem::directory_iterator(directory)) {
 		if (!p.is_directory()) {
 			const std::string extension = p.path().extension().string();
 			if (extension != ".properties" && extension != suffixStyled && extension != ".new" &&
-				extension != suffixFolded) {
+				extension != suffixFolded && extension != suffixBench) {
 				const std::filesystem::path relativePath = p.path().lexically_relative(basePath);
 				std::cout << "Lexing " << relativePath.string() << '\n';
 				PropertyMap properties;
 				properties.properties["FileNameExt"] = p.path().filename().string();
 				properties.ReadFromFile(directory / "SciTE.properties");
-				if (!TestFile(p, properties)) {
+				if (!TestFile(p, basePath, properties, bench)) {
 					success = false;
 				}
 			}
@@ -938,7 +1157,7 @@ bool TestDirectory(std::filesystem::path directory, std::filesystem::path basePa
 	return success;
 }
 
-bool AccessLexilla(std::filesystem::path basePath) {
+bool AccessLexilla(std::filesystem::path basePath, BenchResults *bench) {
 	if (!std::filesystem::exists(basePath)) {
 		std::cout << "No examples at " << basePath.string() << "\n";
 		return false;
@@ -948,7 +1167,7 @@ bool AccessLexilla(std::filesystem::path basePath) {
 	for (auto &p : std::filesystem::recursive_directory_iterator(basePath)) {
 		if (p.is_directory()) {
 			//std::cout << p.path().string() << '\n';
-			if (!TestDirectory(p, basePath)) {
+			if (!TestDirectory(p, basePath, bench)) {
 				success = false;
 			}
 		}
@@ -999,12 +1218,23 @@ int main(int argc, char **argv) {
 		}
 #endif
 		std::filesystem::path examplesDirectory = baseDirectory / "test" / "examples";
+		// --bench or --bench=file also times each example and writes the results as JSON
+		std::optional<std::filesystem::path> benchPath;
 		for (int i = 1; i < argc; i++) {
-			if (argv[i][0] != '-') {
+			const std::string_view arg = argv[i];
+			if (arg == "--bench") {
+				benchPath = "TestLexers.bench.json";
+			} else if (arg.starts_with("--bench=")) {
+				benchPath = arg.substr(arg.find('=') + 1);
+			} else if (argv[i][0] != '-') {
 				examplesDirectory = argv[i];
 			}
 		}
-		success = AccessLexilla(examplesDirectory);
+		BenchResults bench;
+		success = AccessLexilla(examplesDirectory, benchPath ? &bench : nullptr);
+		if (benchPath && !WriteBenchResults(*benchPath, bench)) {
+			success = false;
+		}
 	}
 	return success ? 0 : 1;
 }
@@ -0,0 +1,887 @@
+// Lexilla lexer library
+/** @file lexbench.cxx
+ ** Throughput benchmark for the terminal lexer.
+ ** Styles synthetic build and test logs, and any files named on the command line, through both
+ ** LexerTerminalStyle with an in-memory AccessorInterface and the LexerSimple path with an IDocument,
+ ** then reports MB/s, lines/s and the number of allocations made per MB styled.
+ ** Styling headlessly into a RunLengthAccessor is measured too, with the memory its runs take compared
+ ** to one style byte for each byte of text.
+ ** Then replays a stream of edits on a GapDocument, styling the visible lines after each edit as an
+ ** editor does, and reports the time taken per edit.
+ ** Each corpus is also styled in 5 ms slices sized by the lexer's estimate of its cost, reporting the time
+ ** each slice took.
+ ** Finally feeds each corpus, or a session recorded by script(1), in pty sized chunks through
+ ** TerminalStyler as a terminal pane does and reports the time taken to style each chunk. One line of
+ ** several MB with no line end is fed the same way in 4 KB chunks, so restyling it as it grows shows.
+ ** When built with LEXILLA_COUNTERS, the share of lines found in the terminal lexer's classification
+ ** cache is reported for each corpus.
+ ** The memory held by each lexer instance, as reported by the lexer, is printed at the end.
+ ** With --mapped, the files named are instead styled straight from memory mappings through a MappedDocument
+ ** and a RunLengthAccessor, reporting throughput and the memory each holds.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <new>
+
+#include <fstream>
+#include <sstream>
+
+#include "ILexer.h"
+
+#include "ExtraLexers.h"
+
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexCost.h"
+
+#include "TestDocument.h"
+#include "GapDocument.h"
+#include "MappedDocument.h"
+#include "EditReplay.h"
+
+namespace {
+
+// Every allocation made by the process is counted so steady state allocations can be reported
+size_t allocations = 0;
+
+}
+
+void *operator new(size_t size) {
+	allocations++;
+	void *p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+
+// Deterministic so runs can be compared
+class Random {
+	unsigned int seed = 12345;
+public:
+	unsigned int Next(unsigned int range) noexcept {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) % range;
+	}
+};
+
+constexpr size_t corpusSize = 4 * 1024 * 1024;
+
+const char *const sgrColours[] = { "\033[0m", "\033[1m", "\033[31m", "\033[32m", "\033[1;33m", "\033[36m", "\033[38;5;208m", "\033[38;2;10;120;200m" };
+
+std::string Path(Random &random) {
+	static const char *const directories[] = { "src", "lib/core", "tests", "third_party/zlib" };
+	return std::string(directories[random.Next(4)]) + "/file" + std::to_string(random.Next(200)) + ".cpp";
+}
+
+std::string GccLog() {
+	Random random;
+	std::string log;
+	while (log.length() < corpusSize) {
+		const std::string path = Path(random);
+		const std::string position = std::to_string(random.Next(2000) + 1) + ":" + std::to_string(random.Next(80) + 1);
+		switch (random.Next(6)) {
+		case 0:
+			log += "In file included from " + Path(random) + ":" + std::to_string(random.Next(50) + 1) + ",\n";
+			log += "                 from " + path + ":3:\n";
+			break;
+		case 1:
+			log += path + ":" + position + ": error: 'value' was not declared in this scope\n";
+			log += "   42 |     return value + 1;\n";
+			log += "      |            ^~~~~\n";
+			break;
+		case 2:
+			log += path + ":" + position + ": warning: unused variable 'count' [-Wunused-variable]\n";
+			break;
+		case 3:
+			log += path + ":" + position + ": note: declared here\n";
+			break;
+		case 4:
+			log += "g++ -std=c++17 -O2 -Wall -c " + path + " -o " + path + ".o\n";
+			break;
+		default:
+			log += "[ " + std::to_string(random.Next(100)) + "%] Building CXX object CMakeFiles/app.dir/" + path + ".o\n";
+			break;
+		}
+	}
+	return log;
+}
+
+std::string ClangLog() {
+	Random random;
+	std::string log;
+	while (log.length() < corpusSize) {
+		const std::string path = Path(random);
+		const std::string position = std::to_string(random.Next(2000) + 1) + ":" + std::to_string(random.Next(80) + 1);
+		switch (random.Next(4)) {
+		case 0:
+			log += path + ":" + position + ": error: use of undeclared identifier 'value'\n";
+			log += "    return value + 1;\n";
+			log += "           ^\n";
+			break;
+		case 1:
+			log += path + ":" + position + ": warning: implicit conversion loses integer precision [-Wshorten-64-to-32]\n";
+			break;
+		case 2:
+			log += "1 warning and 1 error generated.\n";
+			break;
+		default:
+			log += "clang++ -std=c++17 -c " + path + "\n";
+			break;
+		}
+	}
+	return log;
+}
+
+std::string MsvcLog() {
+	Random random;
+	std::string log;
+	while (log.length() < corpusSize) {
+		std::string path = "C:\\build\\" + Path(random);
+		std::replace(path.begin(), path.end(), '/', '\\');
+		const std::string position = std::to_string(random.Next(2000) + 1) + "," + std::to_string(random.Next(80) + 1);
+		switch (random.Next(3)) {
+		case 0:
+			log += path + "(" + position + "): error C2065: 'value': undeclared identifier\n";
+			break;
+		case 1:
+			log += path + "(" + position + "): warning C4996: 'strcpy': This function or variable may be unsafe.\n";
+			break;
+		default:
+			log += "  " + path.substr(path.rfind('\\') + 1) + "\n";
+			break;
+		}
+	}
+	return log;
+}
+
+std::string CargoLog() {
+	Random random;
+	std::string log;
+	while (log.length() < corpusSize) {
+		const std::string crate = "crate" + std::to_string(random.Next(300));
+		switch (random.Next(4)) {
+		case 0:
+			log += "\033[0m\033[0m\033[1m\033[32m   Compiling\033[0m " + crate + " v0.1." + std::to_string(random.Next(10)) + "\n";
+			break;
+		case 1:
+			log += "\033[0m\033[1m\033[38;5;9merror[E0425]\033[0m\033[0m\033[1m: cannot find value `x` in this scope\033[0m\n";
+			log += "\033[0m \033[0m\033[0m\033[1m\033[38;5;12m--> \033[0m\033[0msrc/main.rs:" + std::to_string(random.Next(500) + 1) + ":5\033[0m\n";
+			break;
+		case 2:
+			log += "\033[0m\033[1m\033[33mwarning\033[0m\033[0m\033[1m: unused variable: `y`\033[0m\n";
+			break;
+		default:
+			log += "\033[0m\033[0m\033[1m\033[32m    Finished\033[0m dev [unoptimized + debuginfo] target(s) in 3.2s\n";
+			break;
+		}
+	}
+	return log;
+}
+
+std::string PytestLog() {
+	Random random;
+	std::string log;
+	while (log.length() < corpusSize) {
+		log += "tests/test_module" + std::to_string(random.Next(100)) + ".py ";
+		const unsigned int results = random.Next(60) + 1;
+		for (unsigned int result = 0; result < results; result++) {
+			log += (random.Next(20) == 0) ? "\033[31mF\033[0m" : "\033[32m.\033[0m";
+		}
+		log += "\033[32m                                      [ " + std::to_string(random.Next(100)) + "%]\033[0m\n";
+		if (random.Next(8) == 0) {
+			log += "\033[1m\033[31mE       assert 1 == 2\033[0m\n";
+		}
+	}
+	return log;
+}
+
+// 64 KB lines made mostly of escape sequences
+std::string EscapeLines() {
+	Random random;
+	std::string log;
+	while (log.length() < corpusSize) {
+		std::string line;
+		while (line.length() < 64 * 1024) {
+			line += sgrColours[random.Next(8)];
+			line += "text ";
+		}
+		log += line + "\n";
+	}
+	return log;
+}
+
+// One line of minified JSON with no line end, as when a tool prints a large blob, which is styled
+// while it is still a partial line
+std::string LongLineOutput() {
+	Random random;
+	std::string line = "{\"items\":[";
+	while (line.length() < 2 * corpusSize) {
+		line += "{\"id\":" + std::to_string(random.Next(100000)) + ",\"path\":\"" + Path(random) + "\",";
+		line += (random.Next(4) == 0) ? "\"status\":\"\033[31mfailed\033[0m\"}," : "\"status\":\"ok\"},";
+	}
+	return line;
+}
+
+std::string ReadFile(const char *path) {
+	std::ifstream ifs(path, std::ios::binary);
+	std::ostringstream oss;
+	oss << ifs.rdbuf();
+	return oss.str();
+}
+
+size_t CountLines(std::string_view text) noexcept {
+	size_t lines = std::count(text.begin(), text.end(), '\n');
+	if (!text.empty() && (text.back() != '\n')) {
+		lines++;
+	}
+	return lines;
+}
+
+// The properties given to both paths
+struct BenchProperties {
+	int escapeSequences = 1;
+	int threads = 1;
+	int utf8Validate = 0;
+};
+
+// AccessorInterface over text held in memory, as a host's output pane would implement it
+class MemoryAccessor : public AccessorInterface {
+	std::string text;
+	std::vector<unsigned char> styles;
+	std::vector<size_t> lineStarts;
+	std::map<std::string, int> properties;
+	std::vector<int> lineStates;
+	size_t segmentStart = 0;
+public:
+	MemoryAccessor(std::string_view text_, const BenchProperties &benchProperties) {
+		lineStarts.push_back(0);
+		Append(text_);
+		properties["lexer.terminal.escape.sequences"] = benchProperties.escapeSequences;
+		properties["lexer.terminal.threads"] = benchProperties.threads;
+		properties["lexer.terminal.utf8.validate"] = benchProperties.utf8Validate;
+	}
+	// Output arriving at the end of the pane
+	void Append(std::string_view output) {
+		const size_t start = text.length();
+		text.append(output);
+		styles.resize(text.length());
+		for (size_t position = start; position < text.length(); position++) {
+			if (text[position] == '\n') {
+				lineStarts.push_back(position + 1);
+			}
+		}
+		lineStates.resize(lineStarts.size() + 1);
+	}
+	size_t Length() const noexcept {
+		return text.length();
+	}
+	int StyleAt(size_t position) const noexcept {
+		return styles[position];
+	}
+	const char operator[](size_t index) const override {
+		return text[index];
+	}
+	char SafeGetCharAt(size_t index, char chDefault) const override {
+		return (index < text.length()) ? text[index] : chDefault;
+	}
+	void GetCharRange(char *buffer, size_t pos, size_t length) const override {
+		memcpy(buffer, text.data() + pos, length);
+	}
+	void ColourTo(size_t pos, int style) override {
+		const size_t end = std::min(pos + 1, text.length());
+		if (end > segmentStart) {
+			std::fill(styles.begin() + segmentStart, styles.begin() + end, static_cast<unsigned char>(style));
+			segmentStart = end;
+		}
+	}
+	void StartAt(size_t) override {
+	}
+	void StartSegment(size_t pos) override {
+		segmentStart = pos;
+	}
+	int GetPropertyInt(const std::string &name, int defaultVal) const override {
+		const auto it = properties.find(name);
+		return (it == properties.end()) ? defaultVal : it->second;
+	}
+	size_t GetLine(size_t pos) const override {
+		return std::upper_bound(lineStarts.begin(), lineStarts.end(), pos) - lineStarts.begin() - 1;
+	}
+	int GetLineState(size_t line) const override {
+		return (line < lineStates.size()) ? lineStates[line] : 0;
+	}
+	void SetLineState(size_t line, int state) override {
+		if (line < lineStates.size()) {
+			lineStates[line] = state;
+		}
+	}
+};
+
+struct Measurement {
+	double seconds = 0.0;
+	size_t allocations = 0;
+};
+
+// Styles the text repeat times after one untimed run that warms up caches and lazily allocated buffers
+template <typename Lex>
+Measurement Measure(int repeat, Lex lex) {
+	lex();
+	Measurement measurement;
+	const size_t allocationsBefore = allocations;
+	const auto start = std::chrono::steady_clock::now();
+	for (int run = 0; run < repeat; run++) {
+		lex();
+	}
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	measurement.seconds = duration.count();
+	measurement.allocations = allocations - allocationsBefore;
+	return measurement;
+}
+
+void Report(const std::string &corpus, const char *path, std::string_view text, int repeat, const Measurement &measurement) {
+	const double megabytes = static_cast<double>(text.length()) * repeat / (1024.0 * 1024.0);
+	const double lines = static_cast<double>(CountLines(text)) * repeat;
+	const double seconds = std::max(measurement.seconds, 1e-9);
+	printf("%-16s %-9s %9.2f %10.1f %12.0f %12.1f\n", corpus.c_str(), path, megabytes / repeat,
+		megabytes / seconds, lines / seconds, static_cast<double>(measurement.allocations) / megabytes);
+}
+
+// Headless host styling into runs, as a log viewer would
+RunLengthAccessor RunLengthHost(std::string_view text, const BenchProperties &properties) {
+	RunLengthAccessor runLength(text.data(), text.length());
+	runLength.SetProperty("lexer.terminal.escape.sequences", std::to_string(properties.escapeSequences));
+	runLength.SetProperty("lexer.terminal.threads", std::to_string(properties.threads));
+	runLength.SetProperty("lexer.terminal.utf8.validate", std::to_string(properties.utf8Validate));
+	return runLength;
+}
+
+Scintilla::ILexer5 *CreateLexer(const BenchProperties &properties) {
+	Scintilla::ILexer5 *lexer = static_cast<Scintilla::ILexer5 *>(CreateExtraLexerTerminal());
+	lexer->PropertySet("lexer.terminal.escape.sequences", std::to_string(properties.escapeSequences).c_str());
+	lexer->PropertySet("lexer.terminal.threads", std::to_string(properties.threads).c_str());
+	lexer->PropertySet("lexer.terminal.utf8.validate", std::to_string(properties.utf8Validate).c_str());
+	return lexer;
+}
+
+void Bench(const std::string &corpus, std::string_view text, int repeat, const BenchProperties &properties) {
+	if (text.empty()) {
+		return;
+	}
+
+	MemoryAccessor accessor(text, properties);
+	Report(corpus, "styler", text, repeat, Measure(repeat, [&]() {
+		LexerTerminalStyle(0, text.length(), accessor);
+	}));
+
+	RunLengthAccessor runLength = RunLengthHost(text, properties);
+	Report(corpus, "runs", text, repeat, Measure(repeat, [&]() {
+		LexerTerminalStyle(0, text.length(), runLength);
+	}));
+
+	TestDocument doc;
+	doc.Set(text);
+	Scintilla::ILexer5 *lexer = CreateLexer(properties);
+	Report(corpus, "document", text, repeat, Measure(repeat, [&]() {
+		lexer->Lex(0, doc.Length(), 0, &doc);
+	}));
+	FreeExtraLexer(lexer);
+}
+
+// The memory held by the styles of the text as runs and as one byte for each byte of text, marked flat when
+// RunLengthStyles holds them as bytes. The runs are checked against the bytes
+void RunLengthMemory(const std::string &corpus, std::string_view text, const BenchProperties &properties) {
+	MemoryAccessor accessor(text, properties);
+	LexerTerminalStyle(0, text.length(), accessor);
+	RunLengthAccessor runLength = RunLengthHost(text, properties);
+	LexerTerminalStyle(0, text.length(), runLength);
+	const RunLengthStyles &styles = runLength.Styles();
+	for (size_t position = 0; position < text.length(); position++) {
+		if (styles.StyleAt(position) != accessor.StyleAt(position)) {
+			fprintf(stderr, "%s: run length style differs at %zu\n", corpus.c_str(), position);
+			break;
+		}
+	}
+	const size_t bytes = styles.MemoryUse();
+	printf("%-16s %10zu %10zu %12zu %9.1f%%%s\n", corpus.c_str(), styles.Count(), text.length(), bytes,
+		text.empty() ? 0.0 : 100.0 * bytes / text.length(), styles.Flat() ? " flat" : "");
+}
+
+// Styles a file straight from a memory mapping without reading it into memory: through the LexerSimple path
+// with a MappedDocument, whose line index is built as lines are asked for, and by LexerTerminalStyle with a
+// RunLengthAccessor over the mapping. Reports throughput and the memory held by each host
+void Mapped(const std::string &corpus, const char *path, int repeat, const BenchProperties &properties) {
+	MappedDocument doc;
+	if (!doc.Open(path)) {
+		fprintf(stderr, "%s: can not be mapped\n", path);
+		return;
+	}
+	const std::string_view text(doc.BufferPointer(), doc.Length());
+	if (text.empty()) {
+		return;
+	}
+	Scintilla::ILexer5 *lexer = CreateLexer(properties);
+	Report(corpus, "mapped", text, repeat, Measure(repeat, [&]() {
+		lexer->Lex(0, doc.Length(), 0, &doc);
+	}));
+	FreeExtraLexer(lexer);
+
+	RunLengthAccessor runLength = RunLengthHost(text, properties);
+	Report(corpus, "map-runs", text, repeat, Measure(repeat, [&]() {
+		LexerTerminalStyle(0, text.length(), runLength);
+	}));
+	printf("%-16s %10zd lines, %zu bytes held by the document, %zu by the runs\n", corpus.c_str(), doc.Lines(),
+		doc.MemoryUse(), runLength.Styles().MemoryUse());
+}
+
+// Lines whose classification was found in the lexer's cache when styling the text once. The lexer runs on
+// a new thread so the cache, kept by each thread, starts empty. Returns false when counters are not built in
+bool Classification(const std::string &corpus, std::string_view text, const BenchProperties &properties) {
+	TestDocument doc;
+	doc.Set(text);
+	Scintilla::ILexer5 *lexer = CreateLexer(properties);
+	Lexilla::LexCounters counters;
+	void *result = nullptr;
+	std::thread([&]() {
+		lexer->Lex(0, doc.Length(), 0, &doc);
+		result = lexer->PrivateCall(Lexilla::privateCallLexCounters, &counters);
+	}).join();
+	FreeExtraLexer(lexer);
+	if (!result) {
+		return false;
+	}
+	const unsigned long long lookups = counters.classificationHits + counters.classificationMisses;
+	printf("%-16s %10llu %10llu %10llu %7.1f%%\n", corpus.c_str(), counters.lines, counters.classificationHits,
+		counters.classificationMisses, lookups ? 100.0 * counters.classificationHits / lookups : 0.0);
+	return true;
+}
+
+// Typing a diagnostic into the middle of the text one character at a time then backspacing over it,
+// followed by pasting a block of lines and undoing the paste.
+std::vector<Edit> TypingEdits(std::string_view text) {
+	std::vector<Edit> edits;
+	size_t middle = text.find('\n', text.length() / 2);
+	middle = (middle == std::string_view::npos) ? text.length() : middle + 1;
+	const std::string typed = "src/typed.cpp:12:5: error: expected ';' before '}' token\n";
+	for (size_t i = 0; i < typed.length(); i++) {
+		Edit edit;
+		edit.position = middle + i;
+		edit.text = typed.substr(i, 1);
+		edits.push_back(edit);
+	}
+	for (size_t i = typed.length(); i > 0; i--) {
+		Edit edit;
+		edit.kind = Edit::Kind::remove;
+		edit.position = middle + i - 1;
+		edit.length = 1;
+		edits.push_back(edit);
+	}
+	Edit paste;
+	paste.position = middle;
+	for (int line = 0; line < 50; line++) {
+		paste.text += "\033[1;31merror\033[0m: pasted line " + std::to_string(line) + "\n";
+	}
+	edits.push_back(paste);
+	Edit undo;
+	undo.kind = Edit::Kind::remove;
+	undo.position = middle;
+	undo.length = paste.text.length();
+	edits.push_back(undo);
+	return edits;
+}
+
+double Percentile(std::vector<double> values, double percentile) {
+	if (values.empty()) {
+		return 0.0;
+	}
+	std::sort(values.begin(), values.end());
+	const size_t index = std::min(static_cast<size_t>(percentile / 100.0 * values.size()), values.size() - 1);
+	return values[index];
+}
+
+// Styles the whole document, replays the edits timing the styling of the window after each one,
+// then checks that styling the rest of the document matches styling the final text from scratch.
+void Replay(const std::string &corpus, std::string_view text, const std::vector<Edit> &edits, Sci_Position windowLines,
+	const BenchProperties &properties) {
+	if (text.empty() || edits.empty()) {
+		return;
+	}
+	Scintilla::ILexer5 *lexer = CreateLexer(properties);
+	GapDocument doc;
+	doc.Set(text);
+	doc.EnsureStyledTo(doc.Length(), lexer);
+	const std::vector<double> durations = ReplayEdits(doc, lexer, edits, windowLines);
+	doc.EnsureStyledTo(doc.Length(), lexer);
+
+	Scintilla::ILexer5 *lexerFresh = CreateLexer(properties);
+	GapDocument docFresh;
+	docFresh.Set(doc.Text(0, doc.Length()));
+	docFresh.EnsureStyledTo(docFresh.Length(), lexerFresh);
+	Sci_Position mismatch = -1;
+	for (Sci_Position position = 0; position < doc.Length(); position++) {
+		if (doc.StyleAt(position) != docFresh.StyleAt(position)) {
+			mismatch = position;
+			break;
+		}
+	}
+	FreeExtraLexer(lexerFresh);
+	FreeExtraLexer(lexer);
+
+	double total = 0.0;
+	for (const double duration : durations) {
+		total += duration;
+	}
+	printf("%-16s %7zu %10.1f %10.1f %10.1f %10.2f  %s\n", corpus.c_str(), durations.size(),
+		Percentile(durations, 50.0), Percentile(durations, 99.0), Percentile(durations, 100.0), total / 1000.0,
+		(mismatch < 0) ? "same" : ("differs at " + std::to_string(mismatch)).c_str());
+}
+
+// Output read from a pty, with the time since the previous read
+struct Chunk {
+	double delay = 0.0;
+	std::string_view output;
+};
+
+// Splits text into reads of 4 to 64 KB arriving a 60 Hz frame apart
+std::vector<Chunk> PtyChunks(std::string_view text) {
+	Random random;
+	std::vector<Chunk> chunks;
+	while (!text.empty()) {
+		const size_t length = std::min<size_t>(4096 + random.Next(60 * 1024 + 1), text.length());
+		chunks.push_back({ 1.0 / 60.0, text.substr(0, length) });
+		text.remove_prefix(length);
+	}
+	return chunks;
+}
+
+// Splits text into reads of bytes each arriving a 60 Hz frame apart
+std::vector<Chunk> FixedChunks(std::string_view text, size_t bytes) {
+	std::vector<Chunk> chunks;
+	while (!text.empty()) {
+		const size_t length = std::min(bytes, text.length());
+		chunks.push_back({ 1.0 / 60.0, text.substr(0, length) });
+		text.remove_prefix(length);
+	}
+	return chunks;
+}
+
+// Reads a session recorded with script --log-timing or the older --timing. Timing lines are either
+// '<delay> <bytes>' or, in the advanced format, '<type> <delay> <bytes>' where only 'O' (output)
+// entries are replayed. The typescript's 'Script started' header line is skipped.
+bool ReadSession(std::string_view typescript, std::string_view timing, std::vector<Chunk> &chunks, std::string &error) {
+	if (typescript.substr(0, 15) == "Script started ") {
+		const size_t header = typescript.find('\n');
+		typescript.remove_prefix((header == std::string_view::npos) ? typescript.length() : header + 1);
+	}
+	std::istringstream iss{ std::string(timing) };
+	std::string line;
+	size_t lineNumber = 0;
+	double delay = 0.0;
+	while (std::getline(iss, line)) {
+		lineNumber++;
+		std::istringstream fields(line);
+		std::string first;
+		if (!(fields >> first)) {
+			continue;
+		}
+		std::string type = "O";
+		if (first.find_first_not_of("0123456789.") != std::string::npos) {
+			type = first;
+			if (!(fields >> first)) {
+				error = "can not read timing on line " + std::to_string(lineNumber);
+				return false;
+			}
+		}
+		delay += std::atof(first.c_str());
+		if (type != "O") {
+			// Input, signals and headers take time but add no output
+			continue;
+		}
+		size_t bytes = 0;
+		if (!(fields >> bytes)) {
+			error = "can not read timing on line " + std::to_string(lineNumber);
+			return false;
+		}
+		if (bytes > typescript.length()) {
+			error = "timing goes past the end of the typescript on line " + std::to_string(lineNumber);
+			return false;
+		}
+		chunks.push_back({ delay, typescript.substr(0, bytes) });
+		typescript.remove_prefix(bytes);
+		delay = 0.0;
+	}
+	return true;
+}
+
+// Appends each chunk and styles it with TerminalStyler, timing each call. Reports percentiles of
+// the time per chunk, the process CPU time and how many chunks took longer to style than the time
+// until the next one arrived.
+void Session(const std::string &corpus, const std::vector<Chunk> &chunks, const BenchProperties &properties) {
+	if (chunks.empty()) {
+		return;
+	}
+	MemoryAccessor accessor("", properties);
+	TerminalStyler styler;
+	std::vector<double> durations;
+	durations.reserve(chunks.size());
+	size_t late = 0;
+	const std::clock_t cpuStart = std::clock();
+	for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+		accessor.Append(chunks[chunk].output);
+		const auto start = std::chrono::steady_clock::now();
+		styler.StyleTo(accessor.Length(), accessor);
+		const std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start;
+		durations.push_back(duration.count());
+		if ((chunk + 1 < chunks.size()) && (duration.count() > chunks[chunk + 1].delay * 1e6)) {
+			late++;
+		}
+	}
+	const double cpu = static_cast<double>(std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+	printf("%-16s %7zu %10.1f %10.1f %10.1f %10.2f %7zu\n", corpus.c_str(), chunks.size(),
+		Percentile(durations, 50.0), Percentile(durations, 99.0), Percentile(durations, 100.0), cpu, late);
+}
+
+// Styles the whole text in idle slices sized by the lexer's estimate of its own cost for a budget of
+// milliseconds, as a host would, and reports the time each slice took
+void Slices(const std::string &corpus, std::string_view text, int milliseconds, const BenchProperties &properties) {
+	TestDocument doc;
+	doc.Set(text);
+	Scintilla::ILexer5 *lexer = CreateLexer(properties);
+	std::vector<double> durations;
+	Lexilla::LexCostQuery query;
+	query.document = &doc;
+	query.milliseconds = milliseconds;
+	while (query.start < doc.Length()) {
+		if (!lexer->PrivateCall(Lexilla::privateCallLexCost, &query)) {
+			printf("The lexer does not estimate its cost\n");
+			break;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		lexer->Lex(query.start, query.end - query.start, 0, &doc);
+		const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+		durations.push_back(duration.count());
+		query.start = query.end;
+	}
+	FreeExtraLexer(lexer);
+	if (!durations.empty()) {
+		printf("%-16s %7zu %10.2f %10.2f %10.2f %10.1f\n", corpus.c_str(), durations.size(), Percentile(durations, 50.0),
+			Percentile(durations, 99.0), Percentile(durations, 100.0), query.nanosecondsPerByte);
+	}
+}
+
+// Many lexers, as with one per open tab, each having styled some output, then the average memory
+// each reports with privateCallLexMemory
+void MemoryPerInstance(std::string_view text, const BenchProperties &properties) {
+	constexpr int instances = 100;
+	const std::string_view sample = text.substr(0, 64 * 1024);
+	GapDocument doc;
+	doc.Set(sample);
+	std::vector<Scintilla::ILexer5 *> lexers;
+	Lexilla::LexMemory sum;
+	bool reported = true;
+	for (int instance = 0; instance < instances; instance++) {
+		Scintilla::ILexer5 *lexer = CreateLexer(properties);
+		lexer->PropertySet("lexer.locations", "1");
+		lexer->Lex(0, doc.Length(), 0, &doc);
+		Lexilla::LexMemory memory;
+		if (!lexer->PrivateCall(Lexilla::privateCallLexMemory, &memory)) {
+			reported = false;
+		}
+		sum.lexer += memory.lexer;
+		sum.wordLists += memory.wordLists;
+		sum.properties += memory.properties;
+		sum.options += memory.options;
+		sum.subStyles += memory.subStyles;
+		sum.sparseStates += memory.sparseStates;
+		sum.characterCategories += memory.characterCategories;
+		sum.other += memory.other;
+		lexers.push_back(lexer);
+	}
+	for (Scintilla::ILexer5 *lexer : lexers) {
+		FreeExtraLexer(lexer);
+	}
+	if (!reported) {
+		printf("\nThe lexer does not report its memory\n");
+		return;
+	}
+	printf("\nBytes per lexer instance, average of %d after styling %zu bytes each\n", instances, sample.length());
+	const std::pair<const char *, size_t> parts[] = {
+		{ "lexer", sum.lexer }, { "word lists", sum.wordLists }, { "properties", sum.properties },
+		{ "options", sum.options }, { "substyles", sum.subStyles }, { "sparse states", sum.sparseStates },
+		{ "categories", sum.characterCategories }, { "other", sum.other }, { "total", sum.Total() },
+	};
+	for (const auto &[name, bytes] : parts) {
+		printf("%-16s %10zu\n", name, bytes / instances);
+	}
+}
+
+std::string BaseName(const char *path) {
+	std::string name = path;
+	const size_t separator = name.find_last_of("/\\");
+	if (separator != std::string::npos) {
+		name.erase(0, separator + 1);
+	}
+	return name;
+}
+
+void Usage() {
+	fprintf(stderr, "usage: lexbench [--repeat n] [--threads n] [--no-escapes] [--utf8] [--edits script]\n"
+		"                [--window lines] [--session typescript timing] [--mapped] [file...]\n"
+		"Styles synthetic logs, or the files given, and reports throughput and allocations per MB,\n"
+		"and the memory taken by the styles when kept as runs.\n"
+		"Then replays typing, or the edit script given, and reports the time to style after each edit.\n"
+		"Then styles each log in slices sized for 5 ms from the lexer's cost estimate and reports their times.\n"
+		"Then appends each log in pty sized chunks, or replays the session recorded by script(1),\n"
+		"and reports the time to style each chunk, then does the same for one line of several MB in 4 KB chunks.\n"
+		"Last, reports the memory held by each lexer instance.\n"
+		"With --mapped, only styles the files given straight from memory mappings and reports the memory held.\n");
+}
+
+}
+
+int main(int argc, char **argv) {
+	int repeat = 5;
+	BenchProperties properties;
+	std::vector<const char *> files;
+	const char *editsPath = nullptr;
+	Sci_Position windowLines = 60;
+	const char *typescriptPath = nullptr;
+	const char *timingPath = nullptr;
+	bool mapped = false;
+	for (int arg = 1; arg < argc; arg++) {
+		const std::string_view option = argv[arg];
+		if ((option == "--repeat") && (arg + 1 < argc)) {
+			repeat = std::max(std::atoi(argv[++arg]), 1);
+		} else if ((option == "--threads") && (arg + 1 < argc)) {
+			properties.threads = std::atoi(argv[++arg]);
+		} else if ((option == "--edits") && (arg + 1 < argc)) {
+			editsPath = argv[++arg];
+		} else if ((option == "--session") && (arg + 2 < argc)) {
+			typescriptPath = argv[++arg];
+			timingPath = argv[++arg];
+		} else if ((option == "--window") && (arg + 1 < argc)) {
+			windowLines = std::max(std::atoi(argv[++arg]), 1);
+		} else if (option == "--no-escapes") {
+			properties.escapeSequences = 0;
+		} else if (option == "--utf8") {
+			properties.utf8Validate = 1;
+		} else if (option == "--mapped") {
+			mapped = true;
+		} else if (option.substr(0, 1) == "-") {
+			Usage();
+			return 1;
+		} else {
+			files.push_back(argv[arg]);
+		}
+	}
+
+	std::vector<Edit> scriptEdits;
+	if (editsPath) {
+		std::string error;
+		if (!ReadEdits(ReadFile(editsPath), scriptEdits, error)) {
+			fprintf(stderr, "%s: %s\n", editsPath, error.c_str());
+			return 1;
+		}
+	}
+
+	const std::string typescript = typescriptPath ? ReadFile(typescriptPath) : std::string();
+	std::vector<Chunk> sessionChunks;
+	if (typescriptPath) {
+		std::string error;
+		if (!ReadSession(typescript, ReadFile(timingPath), sessionChunks, error)) {
+			fprintf(stderr, "%s: %s\n", timingPath, error.c_str());
+			return 1;
+		}
+	}
+
+	if (mapped) {
+		printf("%-16s %-9s %9s %10s %12s %12s\n", "corpus", "path", "MB", "MB/s", "lines/s", "allocs/MB");
+		for (const char *file : files) {
+			Mapped(BaseName(file), file, repeat, properties);
+		}
+		return 0;
+	}
+
+	std::vector<std::pair<std::string, std::string>> corpora;
+	if (files.empty()) {
+		corpora.emplace_back("gcc", GccLog());
+		corpora.emplace_back("clang", ClangLog());
+		corpora.emplace_back("msvc", MsvcLog());
+		corpora.emplace_back("cargo-ansi", CargoLog());
+		corpora.emplace_back("pytest-ansi", PytestLog());
+		corpora.emplace_back("escape-lines", EscapeLines());
+	}
+	for (const char *file : files) {
+		corpora.emplace_back(BaseName(file), ReadFile(file));
+	}
+
+	printf("%-16s %-9s %9s %10s %12s %12s\n", "corpus", "path", "MB", "MB/s", "lines/s", "allocs/MB");
+	for (const auto &[name, text] : corpora) {
+		Bench(name, text, repeat, properties);
+	}
+
+	printf("\n%-16s %10s %10s %12s %10s\n", "corpus", "runs", "bytes", "run bytes", "of bytes");
+	for (const auto &[name, text] : corpora) {
+		RunLengthMemory(name, text, properties);
+	}
+
+	printf("\n%-16s %10s %10s %10s %8s\n", "corpus", "lines", "cache hits", "misses", "hit rate");
+	for (const auto &[name, text] : corpora) {
+		if (!Classification(name, text, properties)) {
+			printf("Built without LEXILLA_COUNTERS\n");
+			break;
+		}
+	}
+
+	printf("\n%-16s %7s %10s %10s %10s %10s  %s\n", "corpus", "edits", "p50 us", "p99 us", "max us", "total ms", "final styles");
+	for (const auto &[name, text] : corpora) {
+		Replay(name, text, editsPath ? scriptEdits : TypingEdits(text), windowLines, properties);
+	}
+
+	constexpr int sliceMilliseconds = 5;
+	printf("\n%-16s %7s %10s %10s %10s %10s  in %d ms slices\n", "corpus", "slices", "p50 ms", "p99 ms", "max ms", "ns/byte",
+		sliceMilliseconds);
+	for (const auto &[name, text] : corpora) {
+		Slices(name, text, sliceMilliseconds, properties);
+	}
+
+	printf("\n%-16s %7s %10s %10s %10s %10s %7s\n", "corpus", "chunks", "p50 us", "p99 us", "max us", "cpu ms", "late");
+	if (typescriptPath) {
+		Session("session", sessionChunks, properties);
+	} else {
+		for (const auto &[name, text] : corpora) {
+			Session(name, PtyChunks(text), properties);
+		}
+	}
+	// Each chunk only extends the line, so the time per chunk stays flat when only what arrived is styled
+	const std::string longLine = LongLineOutput();
+	Session("long-line 4K", FixedChunks(longLine, 4096), properties);
+
+	if (!corpora.empty()) {
+		MemoryPerInstance(corpora.front().second, properties);
+	}
+	return 0;
+}
@@ -0,0 +1,513 @@
+// Lexilla lexer library
+/** @file lexlibbench.cxx
+ ** Micro-benchmarks for the lexlib primitives that lexers are built from.
+ ** Each benchmark is run until it has taken a minimum time and the results are written as JSON
+ ** so they can be tracked over time:
+ **   {"benchmarks": [{"name": "WordList.InList/100/short/hit", "iterations": 1000000, "ns_per_op": 12.3}, ...]}
+ ** An operation is one call of the primitive, or one byte for StyleContext.Forward and LexAccessor.ColourTo.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "WordList.h"
+#include "LexCharacterCategory.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "StyleContext.h"
+#include "SparseState.h"
+#include "LexScan.h"
+#include "OptionSet.h"
+
+#include "TestDocument.h"
+
+using namespace Lexilla;
+
+namespace {
+
+// Results are accumulated here so the compiler can not remove the work being measured
+volatile size_t sink = 0;
+
+struct Result {
+	std::string name;
+	size_t iterations = 0;
+	double nsPerOp = 0.0;
+};
+
+// Runs body, which performs iterations operations, with increasing iterations until it takes minSeconds
+Result Run(const std::string &name, double minSeconds, size_t opsPerIteration, const std::function<void(size_t)> &body) {
+	Result result;
+	result.name = name;
+	body(1);
+	for (size_t iterations = 1;; iterations *= 2) {
+		const auto start = std::chrono::steady_clock::now();
+		body(iterations);
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		if ((duration.count() >= minSeconds) || (iterations >= (size_t(1) << 40))) {
+			result.iterations = iterations;
+			result.nsPerOp = duration.count() * 1e9 / (static_cast<double>(iterations) * opsPerIteration);
+			return result;
+		}
+	}
+}
+
+// Deterministic so runs can be compared
+class Random {
+	unsigned int seed = 12345;
+public:
+	unsigned int Next(unsigned int range) noexcept {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) % range;
+	}
+};
+
+void AppendUTF8(std::string &s, int character) {
+	if (character < 0x80) {
+		s += static_cast<char>(character);
+	} else if (character < 0x800) {
+		s += static_cast<char>(0xC0 | (character >> 6));
+		s += static_cast<char>(0x80 | (character & 0x3F));
+	} else if (character < 0x10000) {
+		s += static_cast<char>(0xE0 | (character >> 12));
+		s += static_cast<char>(0x80 | ((character >> 6) & 0x3F));
+		s += static_cast<char>(0x80 | (character & 0x3F));
+	} else {
+		s += static_cast<char>(0xF0 | (character >> 18));
+		s += static_cast<char>(0x80 | ((character >> 12) & 0x3F));
+		s += static_cast<char>(0x80 | ((character >> 6) & 0x3F));
+		s += static_cast<char>(0x80 | (character & 0x3F));
+	}
+}
+
+// A TestDocument in another code page: 0 for single byte text or 932 for Shift-JIS
+class CodePageDocument : public TestDocument {
+	std::string text;
+	int codePage;
+	static bool IsLeadByte932(unsigned char ch) noexcept {
+		return ((ch >= 0x81) && (ch <= 0x9F)) || ((ch >= 0xE0) && (ch <= 0xFC));
+	}
+public:
+	CodePageDocument(std::string_view text_, int codePage_) : text(text_), codePage(codePage_) {
+		Set(text_);
+	}
+	int SCI_METHOD CodePage() const override {
+		return codePage;
+	}
+	bool SCI_METHOD IsDBCSLeadByte(char ch) const override {
+		return (codePage == 932) && IsLeadByte932(ch);
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		Sci_Position width = 1;
+		int character = 0;
+		if ((position >= 0) && (position < static_cast<Sci_Position>(text.length()))) {
+			character = static_cast<unsigned char>(text[position]);
+			if (IsDBCSLeadByte(text[position]) && (position + 1 < static_cast<Sci_Position>(text.length()))) {
+				character = (character << 8) | static_cast<unsigned char>(text[position + 1]);
+				width = 2;
+			}
+		}
+		if (pWidth) {
+			*pWidth = width;
+		}
+		return character;
+	}
+};
+
+constexpr size_t documentSize = 1024 * 1024;
+
+// Lines of words with some punctuation where a quarter of the letters are wide characters in UTF-8 and DBCS
+std::string DocumentText(int codePage) {
+	Random random;
+	std::string text;
+	while (text.length() < documentSize) {
+		const unsigned int words = random.Next(12) + 1;
+		for (unsigned int word = 0; word < words; word++) {
+			const unsigned int letters = random.Next(8) + 1;
+			for (unsigned int letter = 0; letter < letters; letter++) {
+				const bool wide = random.Next(4) == 0;
+				if (wide && (codePage == 65001)) {
+					AppendUTF8(text, (random.Next(2) == 0) ? 0xE0 + random.Next(32) : 0x4E00 + random.Next(0x5000));
+				} else if (wide && (codePage == 932)) {
+					text += static_cast<char>(0x88 + random.Next(8));
+					text += static_cast<char>(0x40 + random.Next(0x3F));
+				} else {
+					text += static_cast<char>('a' + random.Next(26));
+				}
+			}
+			text += (random.Next(6) == 0) ? "(); " : " ";
+		}
+		text += "\n";
+	}
+	return text;
+}
+
+std::vector<Result> BenchWordList(double minSeconds) {
+	std::vector<Result> results;
+	struct Shape {
+		const char *name;
+		std::string prefix;
+	};
+	const Shape shapes[] = {
+		{ "short", "kw" },
+		// Words sharing a first character and a long prefix, the worst case for the first character index
+		{ "prefixed", "kcommonprefix_" },
+	};
+	for (const int size : { 10, 100, 1000 }) {
+		for (const Shape &shape : shapes) {
+			std::string list;
+			std::vector<std::string> hits;
+			std::vector<std::string> misses;
+			for (int word = 0; word < size; word++) {
+				hits.push_back(shape.prefix + std::to_string(word));
+				misses.push_back(shape.prefix + std::to_string(word) + "x");
+				list += hits.back() + " ";
+			}
+			WordList wl;
+			wl.Set(list.c_str());
+			const std::string prefix = "WordList.InList/" + std::to_string(size) + "/" + shape.name;
+			for (const bool hit : { true, false }) {
+				const std::vector<std::string> &words = hit ? hits : misses;
+				results.push_back(Run(prefix + (hit ? "/hit" : "/miss"), minSeconds, words.size(), [&](size_t iterations) {
+					size_t found = 0;
+					for (size_t iteration = 0; iteration < iterations; iteration++) {
+						for (const std::string &word : words) {
+							found += wl.InList(word.c_str());
+						}
+					}
+					sink = sink + found;
+				}));
+			}
+		}
+	}
+	return results;
+}
+
+std::vector<Result> BenchCharacterCategory(double minSeconds) {
+	std::vector<Result> results;
+	struct Range {
+		const char *name;
+		int first;
+		int last;
+	};
+	const Range ranges[] = {
+		{ "ascii", 0x20, 0x7E },
+		{ "latin", 0xC0, 0x24F },
+		{ "cjk", 0x4E00, 0x9FFF },
+		{ "emoji", 0x1F300, 0x1FAFF },
+	};
+	const CharacterCategoryMap categories;
+	for (const Range &range : ranges) {
+		Random random;
+		std::vector<int> characters;
+		for (int i = 0; i < 4096; i++) {
+			characters.push_back(range.first + static_cast<int>(random.Next(range.last - range.first + 1)));
+		}
+		results.push_back(Run(std::string("CharacterCategoryMap.CategoryFor/") + range.name, minSeconds, characters.size(), [&](size_t iterations) {
+			size_t total = 0;
+			for (size_t iteration = 0; iteration < iterations; iteration++) {
+				for (const int character : characters) {
+					total += categories.CategoryFor(character);
+				}
+			}
+			sink = sink + total;
+		}));
+	}
+	return results;
+}
+
+std::vector<Result> BenchStyleContext(double minSeconds) {
+	std::vector<Result> results;
+	struct Encoding {
+		const char *name;
+		int codePage;
+	};
+	const Encoding encodings[] = {
+		{ "single-byte", 0 },
+		{ "utf-8", 65001 },
+		{ "dbcs", 932 },
+	};
+	for (const Encoding &encoding : encodings) {
+		const std::string text = DocumentText(encoding.codePage);
+		CodePageDocument doc(text, encoding.codePage);
+		results.push_back(Run(std::string("StyleContext.Forward/") + encoding.name, minSeconds, text.length(), [&](size_t iterations) {
+			size_t total = 0;
+			for (size_t iteration = 0; iteration < iterations; iteration++) {
+				LexAccessor styler(&doc);
+				StyleContext sc(0, text.length(), 0, styler);
+				for (; sc.More(); sc.Forward()) {
+					total += sc.ch;
+				}
+				sc.Complete();
+			}
+			sink = sink + total;
+		}));
+	}
+	return results;
+}
+
+std::vector<Result> BenchColourTo(double minSeconds) {
+	std::vector<Result> results;
+	const std::string text = DocumentText(0);
+	TestDocument doc;
+	doc.Set(text);
+	for (const Sci_PositionU run : { 1, 8, 4096 }) {
+		results.push_back(Run("LexAccessor.ColourTo/run=" + std::to_string(run), minSeconds, text.length(), [&](size_t iterations) {
+			for (size_t iteration = 0; iteration < iterations; iteration++) {
+				LexAccessor styler(&doc);
+				styler.StartAt(0);
+				styler.StartSegment(0);
+				int style = 0;
+				for (Sci_PositionU position = run - 1; position < text.length(); position += run) {
+					styler.ColourTo(position, style);
+					style = (style + 1) & 0x1F;
+				}
+				styler.ColourTo(text.length() - 1, 0);
+				styler.Flush();
+			}
+		}));
+	}
+	return results;
+}
+
+template <template <typename> class Storage>
+void BenchSparseStateStorage(std::vector<Result> &results, const std::string &storage, double minSeconds) {
+	// A document with state changes every 10 positions, relexed over the last 1000 positions
+	constexpr Sci_Position changes = 10000;
+	constexpr Sci_Position relexStart = changes * 10 - 1000;
+	SparseState<int, Storage> states;
+	for (Sci_Position position = 0; position < changes * 10; position += 10) {
+		states.Set(position, static_cast<int>(position / 10) % 7);
+	}
+	SparseState<int, Storage> same(relexStart);
+	SparseState<int, Storage> different(relexStart);
+	for (Sci_Position position = relexStart; position < changes * 10; position += 10) {
+		same.Set(position, static_cast<int>(position / 10) % 7);
+		different.Set(position, static_cast<int>(position / 10) % 5);
+	}
+	results.push_back(Run("SparseState.Merge/same" + storage, minSeconds, 1, [&](size_t iterations) {
+		size_t changed = 0;
+		for (size_t iteration = 0; iteration < iterations; iteration++) {
+			changed += states.Merge(same, changes * 10);
+		}
+		sink = sink + changed;
+	}));
+	results.push_back(Run("SparseState.Merge/changed" + storage, minSeconds, 2, [&](size_t iterations) {
+		size_t changed = 0;
+		for (size_t iteration = 0; iteration < iterations; iteration++) {
+			changed += states.Merge(different, changes * 10);
+			changed += states.Merge(same, changes * 10);
+		}
+		sink = sink + changed;
+	}));
+	results.push_back(Run("SparseState.ValueAt" + storage, minSeconds, 1000, [&](size_t iterations) {
+		int total = 0;
+		for (size_t iteration = 0; iteration < iterations; iteration++) {
+			for (Sci_Position position = 7; position < changes * 10; position += changes / 10) {
+				total += states.ValueAt(position);
+			}
+		}
+		sink = sink + total;
+	}));
+	// An edit near the top of a document with many string states, which are then all set again
+	results.push_back(Run("SparseState.Rebuild" + storage, minSeconds, changes, [&](size_t iterations) {
+		SparseState<std::string, Storage> strings;
+		for (size_t iteration = 0; iteration < iterations; iteration++) {
+			strings.Delete(100);
+			for (Sci_Position position = 100; position < changes * 10; position += 10) {
+				strings.Set(position, (position % 20) ? "<?php" : "<script>");
+			}
+		}
+		sink = sink + strings.size();
+	}));
+}
+
+std::vector<Result> BenchSparseState(double minSeconds) {
+	std::vector<Result> results;
+	BenchSparseStateStorage<VectorStates>(results, "", minSeconds);
+	BenchSparseStateStorage<ChunkedStates>(results, "/chunked", minSeconds);
+	return results;
+}
+
+std::vector<Result> BenchScan(double minSeconds) {
+	std::vector<Result> results;
+	// Finding line ends and the end of ASCII runs through the document, one operation per byte, at each level
+	const std::string text = DocumentText(0);
+	const char *begin = text.data();
+	const char *end = begin + text.length();
+	const std::pair<ScanLevel, const char *> levels[] = {
+		{ ScanLevel::scalar, "scalar" },
+		{ ScanLevel::sse2, "sse2" },
+		{ ScanLevel::ssse3, "ssse3" },
+		{ ScanLevel::avx2, "avx2" },
+		{ ScanLevel::neon, "neon" },
+	};
+	for (const auto &[level, levelName] : levels) {
+		if (!SetScanLevel(level)) {
+			continue;
+		}
+		results.push_back(Run(std::string("LexScan.FindAny2/") + levelName, minSeconds, text.length(),
+			[&](size_t iterations) {
+			size_t lines = 0;
+			for (size_t iteration = 0; iteration < iterations; iteration++) {
+				for (const char *p = FindAny2(begin, end, '\n', '\r'); p < end; p = FindAny2(p + 1, end, '\n', '\r')) {
+					lines++;
+				}
+			}
+			sink = sink + lines;
+		}));
+		results.push_back(Run(std::string("LexScan.FindNonASCII/") + levelName, minSeconds, text.length(),
+			[&](size_t iterations) {
+			size_t found = 0;
+			for (size_t iteration = 0; iteration < iterations; iteration++) {
+				found += FindNonASCII(begin, end) - begin;
+			}
+			sink = sink + found;
+		}));
+	}
+	SetScanLevel(BestScanLevel());
+	return results;
+}
+
+struct BenchOptions {
+	bool fold = false;
+	bool foldComment = false;
+	bool foldCompact = true;
+	bool foldAtElse = false;
+	bool trackPreprocessor = true;
+	int stylingWithinPreprocessor = 0;
+	int backslashContinuations = 1;
+	std::string identifiersAllowed;
+};
+
+const OptionSet<BenchOptions>::Table benchOptionTable({
+	{ "fold", &BenchOptions::fold },
+	{ "fold.comment", &BenchOptions::foldComment },
+	{ "fold.compact", &BenchOptions::foldCompact },
+	{ "fold.at.else", &BenchOptions::foldAtElse },
+	{ "lexer.cpp.track.preprocessor", &BenchOptions::trackPreprocessor },
+	{ "lexer.cpp.styling.within.preprocessor", &BenchOptions::stylingWithinPreprocessor },
+	{ "lexer.cpp.backslash.continuations", &BenchOptions::backslashContinuations },
+	{ "lexer.cpp.identifiers.allowed", &BenchOptions::identifiersAllowed },
+});
+
+std::vector<Result> BenchOptionSet(double minSeconds) {
+	std::vector<Result> results;
+	const std::pair<const char *, const char *> properties[] = {
+		{ "fold", "1" },
+		{ "fold.compact", "0" },
+		{ "lexer.cpp.styling.within.preprocessor", "1" },
+		{ "lexer.cpp.identifiers.allowed", "$@" },
+		{ "lexer.other.property", "1" },
+	};
+	OptionSet<BenchOptions> mapped;
+	mapped.DefineProperty("fold", &BenchOptions::fold);
+	mapped.DefineProperty("fold.comment", &BenchOptions::foldComment);
+	mapped.DefineProperty("fold.compact", &BenchOptions::foldCompact);
+	mapped.DefineProperty("fold.at.else", &BenchOptions::foldAtElse);
+	mapped.DefineProperty("lexer.cpp.track.preprocessor", &BenchOptions::trackPreprocessor);
+	mapped.DefineProperty("lexer.cpp.styling.within.preprocessor", &BenchOptions::stylingWithinPreprocessor);
+	mapped.DefineProperty("lexer.cpp.backslash.continuations", &BenchOptions::backslashContinuations);
+	mapped.DefineProperty("lexer.cpp.identifiers.allowed", &BenchOptions::identifiersAllowed);
+	OptionSet<BenchOptions> tabled(benchOptionTable);
+	for (OptionSet<BenchOptions> *options : { &mapped, &tabled }) {
+		BenchOptions target;
+		results.push_back(Run(std::string("OptionSet.PropertySet/") + ((options == &mapped) ? "map" : "table"),
+			minSeconds, std::size(properties), [&](size_t iterations) {
+			size_t changed = 0;
+			for (size_t iteration = 0; iteration < iterations; iteration++) {
+				for (const auto &[name, value] : properties) {
+					changed += options->PropertySet(&target, name, value);
+				}
+			}
+			sink = sink + changed;
+		}));
+	}
+	return results;
+}
+
+void WriteJSON(FILE *fp, const std::vector<Result> &results) {
+	fprintf(fp, "{\"benchmarks\": [\n");
+	for (size_t index = 0; index < results.size(); index++) {
+		const Result &result = results[index];
+		fprintf(fp, "  {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.3f}%s\n", result.name.c_str(),
+			result.iterations, result.nsPerOp, (index + 1 < results.size()) ? "," : "");
+	}
+	fprintf(fp, "]}\n");
+}
+
+void Usage() {
+	fprintf(stderr, "usage: lexlibbench [--min-time seconds] [--filter text] [--output file]\n"
+		"Runs the micro-benchmarks whose names contain text and writes the results as JSON.\n");
+}
+
+}
+
+int main(int argc, char **argv) {
+	double minSeconds = 0.2;
+	std::string filter;
+	const char *output = nullptr;
+	for (int arg = 1; arg < argc; arg++) {
+		const std::string_view option = argv[arg];
+		if ((option == "--min-time") && (arg + 1 < argc)) {
+			minSeconds = std::atof(argv[++arg]);
+		} else if ((option == "--filter") && (arg + 1 < argc)) {
+			filter = argv[++arg];
+		} else if ((option == "--output") && (arg + 1 < argc)) {
+			output = argv[++arg];
+		} else {
+			Usage();
+			return 1;
+		}
+	}
+
+	using Suite = std::vector<Result> (*)(double);
+	const std::pair<const char *, Suite> suites[] = {
+		{ "WordList.InList", BenchWordList },
+		{ "CharacterCategoryMap.CategoryFor", BenchCharacterCategory },
+		{ "StyleContext.Forward", BenchStyleContext },
+		{ "LexAccessor.ColourTo", BenchColourTo },
+		{ "SparseState.Merge", BenchSparseState },
+		{ "LexScan", BenchScan },
+		{ "OptionSet.PropertySet", BenchOptionSet },
+	};
+	std::vector<Result> results;
+	for (const auto &[name, suite] : suites) {
+		// Filtering is by suite so the setup of skipped suites is not paid for
+		if (filter.empty() || (std::string_view(name).find(filter) != std::string_view::npos) ||
+			(filter.find(name) != std::string::npos)) {
+			for (Result &result : suite(minSeconds)) {
+				if (result.name.find(filter) != std::string::npos) {
+					results.push_back(std::move(result));
+				}
+			}
+		}
+	}
+
+	FILE *fp = output ? fopen(output, "w") : stdout;
+	if (!fp) {
+		fprintf(stderr, "lexlibbench: can not write %s\n", output);
+		return 1;
+	}
+	WriteJSON(fp, results);
+	if (output) {
+		fclose(fp);
+	}
+	return 0;
+}
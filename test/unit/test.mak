@@ -4,7 +4,7 @@
 DEL = del /q
 EXE = unitTest.exe
 
-INCLUDEDIRS = /I../../include /I../../lexlib /I../../../scintilla/include
+INCLUDEDIRS = /I../../include /I../../lexlib /I../../../scintilla/include /I..
 
 CXXFLAGS = /EHsc /std:c++17 /D_HAS_AUTO_PTR_ETC=1 /wd 4805 $(INCLUDEDIRS)
 
@@ -13,13 +13,26 @@ TESTSRC=test*.cxx
 # Files being tested from scintilla/src directory
 TESTEDSRC=\
  ../../lexlib/Accessor.cxx \
+ ../../lexlib/BatchLexing.cxx \
  ../../lexlib/LexCharacterSet.cxx \
+ ../../lexlib/DocumentSnapshot.cxx \
+ ../../lexlib/EscapeSequenceParser.cxx \
  ../../lexlib/InList.cxx \
+ ../../lexlib/LexAccessor.cxx \
+ ../../lexlib/LexCharacterCategory.cxx \
  ../../lexlib/LexerBase.cxx \
  ../../lexlib/LexerModule.cxx \
  ../../lexlib/LexerSimple.cxx \
+ ../../lexlib/LexScan.cxx \
+ ../../lexlib/LexTrace.cxx \
+ ../../lexlib/LexUTF8.cxx \
+ ../../lexlib/LinePatterns.cxx \
  ../../lexlib/PropSetSimple.cxx \
- ../../lexlib/WordList.cxx
+ ../../lexlib/StyleCache.cxx \
+ ../../lexlib/StyleContext.cxx \
+ ../../lexlib/WordList.cxx \
+ ../../lexers/LexTerminal.cxx \
+ ../TestDocument.cxx
 
 TESTS=$(EXE)
 
@@ -0,0 +1,143 @@
+/** @file testAccessor.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <random>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "PropSetSimple.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "Accessor.h"
+
+#include "TestDocument.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test Accessor::IndentAmounts against IndentAmount.
+
+namespace {
+
+// Indentation of tabs and spaces in either order, so lines differ in how they are indented
+const char *const indents[] = {
+	"", " ", "  ", "    ", "        ", "\t", "\t\t", " \t", "\t ", "  \t  ", "\t    ",
+};
+
+// What follows the indentation: text, a comment, nothing or more whitespace
+const char *const bodies[] = {
+	"x = 1", "if y:", "# comment", "", " ", "\t", "\r",
+};
+
+bool IsHashComment(Accessor &styler, Sci_Position pos, Sci_Position len) {
+	return len > 0 && styler[pos] == '#';
+}
+
+std::string IndentedText(std::mt19937 &random, int lineCount, bool endLast) {
+	std::uniform_int_distribution<size_t> chooseIndent(0, std::size(indents) - 1);
+	std::uniform_int_distribution<size_t> chooseBody(0, std::size(bodies) - 1);
+	std::string text;
+	for (int line = 0; line < lineCount; line++) {
+		if (line > 0) {
+			text += (random() % 2) ? "\n" : "\r\n";
+		}
+		text += indents[chooseIndent(random)];
+		text += bodies[chooseBody(random)];
+	}
+	if (endLast) {
+		text += "\n";
+	}
+	return text;
+}
+
+// Each line from lineFirst has the level and flags IndentAmount gives it
+void RequireSameAsIndentAmount(Accessor &styler, Sci_Position lineFirst, Sci_Position lineLast,
+	PFNIsCommentLeader pfnIsCommentLeader) {
+	std::vector<int> levels(lineLast - lineFirst);
+	std::vector<int> flags(lineLast - lineFirst);
+	styler.IndentAmounts(lineFirst, lineLast, levels.data(), flags.data(), pfnIsCommentLeader);
+	for (Sci_Position line = lineFirst; line < lineLast; line++) {
+		int flagsLine = 0;
+		const int level = styler.IndentAmount(line, &flagsLine, pfnIsCommentLeader);
+		INFO("line " << line);
+		REQUIRE(levels[line - lineFirst] == level);
+		REQUIRE(flags[line - lineFirst] == flagsLine);
+	}
+}
+
+}
+
+TEST_CASE("AccessorIndentAmounts") {
+
+	std::mt19937 random(17);
+	PropSetSimple props;
+
+	SECTION("SameAsIndentAmount") {
+		for (const bool endLast : { false, true }) {
+			for (int repetition = 0; repetition < 20; repetition++) {
+				TestDocument doc;
+				doc.Set(IndentedText(random, 60, endLast));
+				Accessor styler(&doc, &props);
+				// The line at the end of the document is counted too
+				const Sci_Position lines = doc.MaxLine() + 1;
+				for (const PFNIsCommentLeader leader : { static_cast<PFNIsCommentLeader>(nullptr), IsHashComment }) {
+					RequireSameAsIndentAmount(styler, 0, lines, leader);
+					// Starting within the text compares with the line before the first
+					std::uniform_int_distribution<Sci_Position> chooseLine(1, lines - 1);
+					const Sci_Position lineFirst = chooseLine(random);
+					RequireSameAsIndentAmount(styler, lineFirst, lines, leader);
+					RequireSameAsIndentAmount(styler, lineFirst, lineFirst + 1, leader);
+				}
+			}
+		}
+	}
+
+	SECTION("Flags") {
+		TestDocument doc;
+		doc.Set("\tx\n \tx\n\t x\n  # c\n   \n\n        y");
+		Accessor styler(&doc, &props);
+		int levels[7]{};
+		int flags[7]{};
+		styler.IndentAmounts(0, 7, levels, flags, IsHashComment);
+		REQUIRE(levels[0] == SC_FOLDLEVELBASE + 8);
+		REQUIRE(flags[0] == wsTab);
+		// A space then a tab is 8 columns, in a different order to the line before
+		REQUIRE(levels[1] == SC_FOLDLEVELBASE + 8);
+		REQUIRE(flags[1] == (wsSpace | wsTab | wsSpaceTab | wsInconsistent));
+		REQUIRE(levels[2] == SC_FOLDLEVELBASE + 9);
+		REQUIRE(flags[2] == (wsTab | wsSpace | wsInconsistent));
+		// A comment, a line of spaces and an empty line are white
+		REQUIRE(levels[3] == (SC_FOLDLEVELBASE + 2 | SC_FOLDLEVELWHITEFLAG));
+		REQUIRE(levels[4] == (SC_FOLDLEVELBASE + 3 | SC_FOLDLEVELWHITEFLAG));
+		REQUIRE(levels[5] == (SC_FOLDLEVELBASE | SC_FOLDLEVELWHITEFLAG));
+		// The last line has no end
+		REQUIRE(levels[6] == SC_FOLDLEVELBASE + 8);
+		REQUIRE(flags[6] == wsSpace);
+	}
+
+	SECTION("WhitespaceAtEnd") {
+		// The last line is only whitespace and has no end so the scan stops at the end of the document. As
+		// with IndentAmount, it is not white as no line end follows the whitespace
+		TestDocument doc;
+		doc.Set("x\n\t \t");
+		Accessor styler(&doc, &props);
+		RequireSameAsIndentAmount(styler, 0, 2, nullptr);
+		int level = 0;
+		int flags = 0;
+		styler.IndentAmounts(1, 2, &level, &flags);
+		REQUIRE(level == SC_FOLDLEVELBASE + 16);
+	}
+}
@@ -0,0 +1,194 @@
+/** @file testBatchLexing.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <functional>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "PropSetSimple.h"
+#include "WordList.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "Accessor.h"
+#include "LexerModule.h"
+#include "BatchLexing.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test BatchLexing.
+
+namespace {
+
+// Just enough of a document for styling
+class Document : public Scintilla::IDocument {
+	std::string text;
+	std::vector<Sci_Position> lineStarts;
+public:
+	std::string styles;
+	std::vector<int> lineStates;
+	Sci_Position endStyled = 0;
+
+	explicit Document(std::string_view text_) : text(text_), styles(text.size(), '\0') {
+		lineStarts.push_back(0);
+		for (size_t i = 0; i < text.size(); i++) {
+			if (text[i] == '\n')
+				lineStarts.push_back(i + 1);
+		}
+		lineStates.resize(lineStarts.size());
+	}
+	int SCI_METHOD Version() const override { return Scintilla::dvRelease4; }
+	void SCI_METHOD SetErrorStatus(int) override {}
+	Sci_Position SCI_METHOD Length() const override { return text.size(); }
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		text.copy(buffer, lengthRetrieve, position);
+	}
+	char SCI_METHOD StyleAt(Sci_Position position) const override { return styles.at(position); }
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override {
+		Sci_Position line = 0;
+		while ((line + 1 < static_cast<Sci_Position>(lineStarts.size())) && (lineStarts[line + 1] <= position))
+			line++;
+		return line;
+	}
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override {
+		return (line < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line] : text.size();
+	}
+	int SCI_METHOD GetLevel(Sci_Position) const override { return 0x400; }
+	int SCI_METHOD SetLevel(Sci_Position, int level) override { return level; }
+	int SCI_METHOD GetLineState(Sci_Position line) const override { return lineStates.at(line); }
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override { return lineStates.at(line) = state; }
+	void SCI_METHOD StartStyling(Sci_Position position) override { endStyled = position; }
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override {
+		styles.replace(endStyled, length, length, style);
+		endStyled += length;
+		return true;
+	}
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_) override {
+		styles.replace(endStyled, length, styles_, length);
+		endStyled += length;
+		return true;
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int) override {}
+	void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) override {}
+	void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) override {}
+	int SCI_METHOD CodePage() const override { return 65001; }
+	bool SCI_METHOD IsDBCSLeadByte(char) const override { return false; }
+	const char *SCI_METHOD BufferPointer() override { return text.c_str(); }
+	int SCI_METHOD GetLineIndentation(Sci_Position) override { return 0; }
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override {
+		return (line + 1 < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line + 1] - 1 : text.size();
+	}
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override {
+		return positionStart + characterOffset;
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		if (pWidth)
+			*pWidth = 1;
+		return static_cast<unsigned char>(text.at(position));
+	}
+};
+
+// Digits get the style from the digits.style property, other characters 0
+void ColouriseDigits(Sci_PositionU startPos, Sci_Position length, int, WordList *[], Accessor &styler) {
+	const int styleDigit = styler.GetPropertyInt("digits.style", 1);
+	styler.StartAt(startPos);
+	styler.StartSegment(startPos);
+	for (Sci_PositionU position = startPos; position < startPos + length; position++) {
+		const char ch = styler[position];
+		styler.ColourTo(position, (ch >= '0' && ch <= '9') ? styleDigit : 0);
+	}
+	styler.Flush();
+}
+
+LexerModule lmDigits(123457, ColouriseDigits, "digits");
+
+std::atomic<int> lexersCreated{0};
+
+Scintilla::ILexer5 *CreateDigits(const char *name) {
+	if (std::string_view(name) != "digits") {
+		return nullptr;
+	}
+	lexersCreated++;
+	return lmDigits.Create();
+}
+
+}
+
+TEST_CASE("BatchLexing") {
+
+	lexersCreated = 0;
+
+	SECTION("StylesEachDocument") {
+		std::vector<Document> documents;
+		for (int i = 0; i < 20; i++) {
+			documents.emplace_back("a1b22\nc333" + std::string(i * 100, 'x'));
+		}
+		std::vector<LexJob> jobs;
+		for (Document &document : documents) {
+			LexJob job;
+			job.lexerName = "digits";
+			job.pAccess = &document;
+			jobs.push_back(job);
+		}
+		BatchOptions options;
+		options.threads = 4;
+		REQUIRE(LexDocuments(jobs, CreateDigits, options) == documents.size());
+		for (const Document &document : documents) {
+			REQUIRE(document.styles.substr(0, 10) == std::string("\0\1\0\1\1\0\0\1\1\1", 10));
+			REQUIRE(document.styles.find_first_not_of('\0', 10) == std::string::npos);
+		}
+		// At most one lexer for each thread
+		REQUIRE(lexersCreated > 0);
+		REQUIRE(lexersCreated <= 4);
+	}
+
+	SECTION("OneThreadOneLexer") {
+		Document first("1a");
+		Document second("b2");
+		const std::vector<LexJob> jobs = {
+			{ "digits", &first },
+			{ "digits", &second },
+		};
+		BatchOptions options;
+		options.threads = 1;
+		REQUIRE(LexDocuments(jobs, CreateDigits, options) == 2);
+		REQUIRE(lexersCreated == 1);
+		REQUIRE(first.styles == std::string("\1\0", 2));
+		REQUIRE(second.styles == std::string("\0\1", 2));
+	}
+
+	SECTION("RangesAndProperties") {
+		Document document("1111");
+		// Both jobs are for one document so run in order on one thread
+		const std::vector<LexJob> jobs = {
+			{ "digits", &document, 0, 2 },
+			{ "digits", &document, 2, 2 },
+		};
+		BatchOptions options;
+		options.properties.emplace_back("digits.style", "5");
+		REQUIRE(LexDocuments(jobs, CreateDigits, options) == 2);
+		REQUIRE(document.styles == "\5\5\5\5");
+	}
+
+	SECTION("UnknownLexer") {
+		Document document("11");
+		const std::vector<LexJob> jobs = {
+			{ "nosuchlexer", &document },
+			{ "digits", nullptr },
+		};
+		REQUIRE(LexDocuments(jobs, CreateDigits) == 0);
+		REQUIRE(document.styles == std::string(2, '\0'));
+		REQUIRE(LexDocuments({}, CreateDigits) == 0);
+	}
+}
@@ -0,0 +1,74 @@
+/** @file testCatalogueModules.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstring>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+
+#include "ILexer.h"
+
+#include "LexerModule.h"
+#include "CatalogueModules.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test CatalogueModules.
+
+namespace {
+
+void ColouriseDocument(Sci_PositionU, Sci_Position, int, WordList *[], Accessor &) {
+	// Do no styling
+}
+
+LexerModule lmZeta(30, ColouriseDocument, "zeta");
+LexerModule lmAlpha(10, ColouriseDocument, "alpha");
+LexerModule lmMiddle(20, ColouriseDocument, "middle");
+LexerModule lmAlphaAgain(10, ColouriseDocument, "alpha");
+LexerModule lmUnnamed(40, ColouriseDocument);
+
+}
+
+TEST_CASE("CatalogueModules") {
+
+	CatalogueModules catalogue;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(catalogue.Count() == 0);
+		REQUIRE(!catalogue.Find(10));
+		REQUIRE(!catalogue.Find("alpha"));
+	}
+
+	SECTION("Find") {
+		catalogue.AddLexerModules({ &lmZeta, &lmAlpha, &lmMiddle });
+		REQUIRE(catalogue.Count() == 3);
+		// Names stay in the order added
+		REQUIRE_THAT(catalogue.Name(0), Catch::Matchers::Equals("zeta"));
+		REQUIRE(catalogue.Find(10) == &lmAlpha);
+		REQUIRE(catalogue.Find(20) == &lmMiddle);
+		REQUIRE(catalogue.Find(30) == &lmZeta);
+		REQUIRE(!catalogue.Find(15));
+		REQUIRE(!catalogue.Find(99));
+		REQUIRE(catalogue.Find("alpha") == &lmAlpha);
+		REQUIRE(catalogue.Find("zeta") == &lmZeta);
+		REQUIRE(!catalogue.Find("alph"));
+		REQUIRE(!catalogue.Find("omega"));
+		REQUIRE(!catalogue.Find(static_cast<const char *>(nullptr)));
+	}
+
+	SECTION("FirstAddedWins") {
+		catalogue.AddLexerModules({ &lmZeta, &lmAlpha });
+		catalogue.AddLexerModule(&lmAlphaAgain);
+		catalogue.AddLexerModule(&lmUnnamed);
+		REQUIRE(catalogue.Count() == 4);
+		REQUIRE(catalogue.Find(10) == &lmAlpha);
+		REQUIRE(catalogue.Find("alpha") == &lmAlpha);
+		// Modules without names can still be found by language
+		REQUIRE(catalogue.Find(40) == &lmUnnamed);
+	}
+}
@@ -0,0 +1,80 @@
+/** @file testCharacterCategory.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include "LexCharacterCategory.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test CharacterCategory.
+
+TEST_CASE("CharacterCategory") {
+
+	SECTION("Categorise") {
+		REQUIRE(CategoriseCharacter('A') == ccLu);
+		REQUIRE(CategoriseCharacter('a') == ccLl);
+		REQUIRE(CategoriseCharacter('0') == ccNd);
+		REQUIRE(CategoriseCharacter(' ') == ccZs);
+		REQUIRE(CategoriseCharacter('\n') == ccCc);
+		REQUIRE(CategoriseCharacter(0x01C5) == ccLt);	// LATIN CAPITAL LETTER D WITH SMALL LETTER Z WITH CARON
+		REQUIRE(CategoriseCharacter(0x0301) == ccMn);	// COMBINING ACUTE ACCENT
+		REQUIRE(CategoriseCharacter(0x20AC) == ccSc);	// EURO SIGN
+		REQUIRE(CategoriseCharacter(0x4E00) == ccLo);	// CJK UNIFIED IDEOGRAPH-4E00
+		REQUIRE(CategoriseCharacter(0xD800) == ccCs);
+		REQUIRE(CategoriseCharacter(0xE000) == ccCo);
+		REQUIRE(CategoriseCharacter(0x1F600) == ccSo);	// GRINNING FACE
+		REQUIRE(CategoriseCharacter(0x10FFFF) == ccCn);
+		REQUIRE(CategoriseCharacter(-1) == ccCn);
+		REQUIRE(CategoriseCharacter(0x110000) == ccCn);
+	}
+
+	SECTION("Identifiers") {
+		REQUIRE(IsXidStart('a'));
+		REQUIRE(!IsXidStart('0'));
+		REQUIRE(IsXidContinue('0'));
+		REQUIRE(IsXidContinue('_'));
+		REQUIRE(!IsXidContinue(' '));
+		// In ID_Start but not XID_Start
+		REQUIRE(IsIdStart(0x309B));
+		REQUIRE(!IsXidStart(0x309B));
+		REQUIRE(IsIdStart(0x0E33));
+		REQUIRE(!IsXidStart(0x0E33));
+		REQUIRE(IsXidContinue(0x0E33));
+		// Other_ID_Start and Other_ID_Continue
+		REQUIRE(IsXidStart(0x2118));
+		REQUIRE(!IsXidStart(0x00B7));
+		REQUIRE(IsXidContinue(0x00B7));
+		// Pattern_Syntax
+		REQUIRE(!IsXidStart(0x2E2F));
+		REQUIRE(!IsXidContinue(-1));
+		REQUIRE(!IsXidStart(0x110000));
+	}
+
+	SECTION("XidSubsetOfId") {
+		int outside = 0;
+		for (int ch = 0; ch < 0x110000; ch++) {
+			if (IsXidStart(ch) && !(IsIdStart(ch) && IsXidContinue(ch)))
+				outside++;
+			if (IsXidContinue(ch) && !IsIdContinue(ch))
+				outside++;
+		}
+		REQUIRE(outside == 0);
+	}
+
+	SECTION("Map") {
+		CharacterCategoryMap ccm;
+		ccm.Optimize(0x3000);
+		REQUIRE(ccm.Size() == 0x110000);
+		int different = 0;
+		for (int ch = 0; ch < 0x110000; ch++) {
+			if (ccm.CategoryFor(ch) != CategoriseCharacter(ch))
+				different++;
+		}
+		REQUIRE(different == 0);
+		REQUIRE(ccm.CategoryFor(0x4E00) == ccLo);
+	}
+}
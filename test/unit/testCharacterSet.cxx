@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <cassert>
 
+#include <string>
 #include <string_view>
 
 #include "LexCharacterSet.h"
@@ -51,6 +52,62 @@ TEST_CASE("CharacterSet") {
 		CharacterSet cs2(CharacterSet::setNone, "", 0x80, true);
 		REQUIRE(cs2.Contains(0x100));
 	}
+
+	SECTION("Scan") {
+		const CharacterSet digits(CharacterSet::setDigits);
+		const std::string_view text("0123456789012345678901234567890123456789x1");
+		const char *begin = text.data();
+		const char *end = begin + text.length();
+		REQUIRE(digits.ScanWhile(begin, end) == begin + 40);
+		REQUIRE(digits.ScanUntil(begin + 40, end) == begin + 41);
+		REQUIRE(digits.ScanWhile(end, end) == end);
+		REQUIRE(digits.ScanUntil(begin, begin) == begin);
+		const std::string_view letters("abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz");
+		REQUIRE(digits.ScanUntil(letters.data(), letters.data() + letters.length()) ==
+			letters.data() + letters.length());
+	}
+
+	SECTION("ScanNonASCII") {
+		const CharacterSet wordAfter(CharacterSet::setAlpha, "_", 0x80, true);
+		const std::string_view text("abcdefghijklmnop\xc3\xa9qrstuvwxyzabcdef ghi");
+		const char *begin = text.data();
+		const char *end = begin + text.length();
+		REQUIRE(wordAfter.ScanWhile(begin, end) == begin + 34);
+		REQUIRE(wordAfter.ScanWhile(begin, end, true) == begin + 16);
+		const CharacterSet space(CharacterSet::setNone, " ");
+		REQUIRE(space.ScanUntil(begin, end) == begin + 34);
+		REQUIRE(space.ScanUntil(begin, end, true) == begin + 16);
+	}
+
+	SECTION("ScanMatchesContains") {
+		// Every byte value at every offset in a block of 16
+		const CharacterSet operators(CharacterSet::setNone, "+-*/=<>!&|^%~?:;,.()[]{}", 0x80, true);
+		CharacterSetArray<0x100> upper(CharacterSetArray<0x100>::setUpper, "\x80\xa0\xff");
+		std::string text;
+		for (int i = 0; i < 0x300; i++) {
+			text.push_back(static_cast<char>((i * 37 + (i >> 4)) & 0xff));
+		}
+		int different = 0;
+		for (size_t start = 0; start < text.length(); start++) {
+			for (const bool stopAtNonASCII : { false, true }) {
+				const char *begin = text.data() + start;
+				const char *end = text.data() + text.length();
+				const char *expectWhile = begin;
+				while ((expectWhile < end) && operators.Contains(*expectWhile) &&
+					!(stopAtNonASCII && (static_cast<unsigned char>(*expectWhile) >= 0x80)))
+					expectWhile++;
+				if (operators.ScanWhile(begin, end, stopAtNonASCII) != expectWhile)
+					different++;
+				const char *expectUntil = begin;
+				while ((expectUntil < end) && !upper.Contains(static_cast<unsigned char>(*expectUntil)) &&
+					!(stopAtNonASCII && (static_cast<unsigned char>(*expectUntil) >= 0x80)))
+					expectUntil++;
+				if (upper.ScanUntil(begin, end, stopAtNonASCII) != expectUntil)
+					different++;
+			}
+		}
+		REQUIRE(different == 0);
+	}
 }
 
 TEST_CASE("Functions") {
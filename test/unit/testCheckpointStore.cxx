@@ -0,0 +1,143 @@
+/** @file testCheckpointStore.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstdint>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include "Sci_Position.h"
+
+#include "SparseState.h"
+#include "CheckpointStore.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test CheckpointStore.
+
+TEST_CASE("CheckpointStore") {
+
+	CheckpointStore<std::string> cs(10);
+	Sci_Position line = -1;
+	std::string state;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(0u == cs.size());
+		REQUIRE(10 == cs.Interval());
+		REQUIRE(!cs.Before(100, line, state));
+	}
+
+	SECTION("NoteEveryInterval") {
+		for (Sci_Position l = 0; l < 35; l++) {
+			cs.Note(l, std::to_string(l));
+		}
+		REQUIRE(4u == cs.size());
+		REQUIRE(cs.Before(29, line, state));
+		REQUIRE(20 == line);
+		REQUIRE("20" == state);
+		REQUIRE(cs.Before(30, line, state));
+		REQUIRE(30 == line);
+		REQUIRE(cs.Before(1000, line, state));
+		REQUIRE(30 == line);
+		REQUIRE(cs.Before(0, line, state));
+		REQUIRE(0 == line);
+		REQUIRE(!cs.Before(-1, line, state));
+	}
+
+	SECTION("Invalidate") {
+		for (Sci_Position l = 0; l < 35; l++) {
+			cs.Note(l, std::to_string(l));
+		}
+		cs.Invalidate(20);
+		REQUIRE(2u == cs.size());
+		REQUIRE(cs.Before(25, line, state));
+		REQUIRE(10 == line);
+		cs.Invalidate(11);
+		REQUIRE(2u == cs.size());
+		cs.Invalidate(0);
+		REQUIRE(0u == cs.size());
+	}
+
+	SECTION("RelexUnchanged") {
+		for (Sci_Position l = 0; l < 35; l++) {
+			cs.Note(l, std::to_string(l));
+		}
+		// Lexing again from line 10 with the same state keeps the later snapshots
+		cs.Note(10, "10");
+		REQUIRE(4u == cs.size());
+		// A different state makes the later snapshots invalid
+		cs.Note(10, "ten");
+		REQUIRE(2u == cs.size());
+		REQUIRE(cs.Before(35, line, state));
+		REQUIRE(10 == line);
+		REQUIRE("ten" == state);
+	}
+
+	SECTION("SetBetween") {
+		cs.Set(0, "a");
+		cs.Set(20, "c");
+		cs.Set(10, "b");
+		REQUIRE(2u == cs.size());
+		REQUIRE(cs.Before(15, line, state));
+		REQUIRE(10 == line);
+		REQUIRE("b" == state);
+		cs.Clear();
+		REQUIRE(0u == cs.size());
+	}
+
+	SECTION("EqualStatesKept") {
+		// Unlike SparseState, equal snapshots are all kept so the nearest is found
+		for (Sci_Position l = 0; l < 35; l++) {
+			cs.Note(l, "same");
+		}
+		REQUIRE(4u == cs.size());
+		REQUIRE(cs.Before(25, line, state));
+		REQUIRE(20 == line);
+	}
+}
+
+TEST_CASE("CheckpointStoreChunked") {
+
+	CheckpointStore<int, ChunkedStates> cs(4);
+	Sci_Position line = -1;
+	int state = 0;
+
+	SECTION("ManyCheckpoints") {
+		for (Sci_Position l = 0; l < 40000; l++) {
+			cs.Note(l, static_cast<int>(l % 3));
+		}
+		REQUIRE(10000u == cs.size());
+		REQUIRE(cs.Before(39999, line, state));
+		REQUIRE(39996 == line);
+		REQUIRE(39996 % 3 == state);
+		REQUIRE(cs.Before(1027, line, state));
+		REQUIRE(1024 == line);
+
+		// An edit near the top drops the later snapshots and frees their memory
+		const size_t memoryFull = cs.MemoryUse();
+		cs.Invalidate(1025);
+		REQUIRE(257u == cs.size());
+		REQUIRE(cs.MemoryUse() < memoryFull / 5);
+		REQUIRE(cs.Before(39999, line, state));
+		REQUIRE(1024 == line);
+
+		// Relexing from an unchanged snapshot keeps those after it
+		cs.Note(1028, 1);
+		cs.Note(1032, 2);
+		cs.Note(1028, 1);
+		REQUIRE(259u == cs.size());
+		cs.Note(1028, 2);
+		REQUIRE(258u == cs.size());
+		REQUIRE(cs.Before(1040, line, state));
+		REQUIRE(1028 == line);
+		REQUIRE(2 == state);
+		cs.Clear();
+		REQUIRE(0u == cs.size());
+		REQUIRE(!cs.Before(1040, line, state));
+	}
+}
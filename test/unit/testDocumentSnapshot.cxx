@@ -0,0 +1,253 @@
+/** @file testDocumentSnapshot.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <thread>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "PropSetSimple.h"
+#include "WordList.h"
+#include "LexCounters.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "Accessor.h"
+#include "LexerModule.h"
+#include "DocumentSnapshot.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test DocumentSnapshot.
+
+namespace {
+
+// Just enough of a document for styling and folding
+class Document : public Scintilla::IDocument {
+	std::string text;
+	std::vector<Sci_Position> lineStarts;
+public:
+	std::string styles;
+	std::vector<int> lineStates;
+	std::vector<int> levels;
+	Sci_Position endStyled = 0;
+	int indicatorFills = 0;
+
+	explicit Document(std::string_view text_) : text(text_), styles(text.size(), '\0') {
+		lineStarts.push_back(0);
+		for (size_t i = 0; i < text.size(); i++) {
+			if (text[i] == '\n')
+				lineStarts.push_back(i + 1);
+		}
+		lineStates.resize(lineStarts.size());
+		levels.resize(lineStarts.size(), SC_FOLDLEVELBASE);
+	}
+	int SCI_METHOD Version() const override { return Scintilla::dvRelease4; }
+	void SCI_METHOD SetErrorStatus(int) override {}
+	Sci_Position SCI_METHOD Length() const override { return text.size(); }
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		text.copy(buffer, lengthRetrieve, position);
+	}
+	char SCI_METHOD StyleAt(Sci_Position position) const override { return styles.at(position); }
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override {
+		Sci_Position line = 0;
+		while ((line + 1 < static_cast<Sci_Position>(lineStarts.size())) && (lineStarts[line + 1] <= position))
+			line++;
+		return line;
+	}
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override {
+		return (line < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line] : text.size();
+	}
+	int SCI_METHOD GetLevel(Sci_Position line) const override { return levels.at(line); }
+	int SCI_METHOD SetLevel(Sci_Position line, int level) override { return levels.at(line) = level; }
+	int SCI_METHOD GetLineState(Sci_Position line) const override { return lineStates.at(line); }
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override { return lineStates.at(line) = state; }
+	void SCI_METHOD StartStyling(Sci_Position position) override { endStyled = position; }
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override {
+		styles.replace(endStyled, length, length, style);
+		endStyled += length;
+		return true;
+	}
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_) override {
+		styles.replace(endStyled, length, styles_, length);
+		endStyled += length;
+		return true;
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int) override {}
+	void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) override { indicatorFills++; }
+	void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) override {}
+	int SCI_METHOD CodePage() const override { return 65001; }
+	bool SCI_METHOD IsDBCSLeadByte(char) const override { return false; }
+	const char *SCI_METHOD BufferPointer() override { return text.c_str(); }
+	int SCI_METHOD GetLineIndentation(Sci_Position) override { return 0; }
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override {
+		return (line + 1 < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line + 1] - 1 : text.size();
+	}
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override {
+		return positionStart + characterOffset;
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		if (pWidth)
+			*pWidth = 1;
+		return static_cast<unsigned char>(text.at(position));
+	}
+};
+
+// Digits get style 1 and other characters 0. Each line's state is its number of digits and lines with
+// digits are fold headers. Digits after a '#' are filled with indicator 8.
+void ColouriseDigits(Sci_PositionU startPos, Sci_Position length, int, WordList *[], Accessor &styler) {
+	styler.StartAt(startPos);
+	styler.StartSegment(startPos);
+	Sci_Position line = styler.GetLine(startPos);
+	int digits = 0;
+	for (Sci_PositionU position = startPos; position < startPos + length; position++) {
+		const char ch = styler[position];
+		const bool digit = (ch >= '0') && (ch <= '9');
+		digits += digit;
+		styler.ColourTo(position, digit ? 1 : 0);
+		if (digit && (styler.SafeGetCharAt(position - 1) == '#')) {
+			styler.IndicatorFill(position, position + 1, 8, 1);
+		}
+		if (ch == '\n') {
+			styler.SetLineState(line, digits);
+			styler.SetLevel(line, SC_FOLDLEVELBASE | (digits ? SC_FOLDLEVELHEADERFLAG : 0));
+			line++;
+			digits = 0;
+		}
+	}
+	styler.Flush();
+}
+
+LexerModule lmSnapshotDigits(123459, ColouriseDigits, "snapshotdigits");
+
+constexpr std::string_view sample = "ab12\r\nc3\n\nd#45e\nlast";
+
+}
+
+TEST_CASE("DocumentSnapshot") {
+
+	Document document(sample);
+	document.styles.assign(document.styles.size(), '\x02');
+	document.lineStates[1] = 7;
+	const DocumentSnapshot snapshot(&document, 42);
+
+	SECTION("Copies") {
+		REQUIRE(snapshot.Version() == 42);
+		REQUIRE(snapshot.Text() == sample);
+		REQUIRE(snapshot.Lines() == 5);
+		REQUIRE(snapshot.LineStart(1) == 6);
+		REQUIRE(snapshot.LineStart(9) == static_cast<Sci_Position>(sample.length()));
+		REQUIRE(snapshot.LineEnd(0) == 4);
+		REQUIRE(snapshot.LineEnd(1) == 8);
+		REQUIRE(snapshot.LineEnd(2) == 9);
+		REQUIRE(snapshot.LineEnd(4) == static_cast<Sci_Position>(sample.length()));
+		REQUIRE(snapshot.LineFromPosition(0) == 0);
+		REQUIRE(snapshot.LineFromPosition(5) == 0);
+		REQUIRE(snapshot.LineFromPosition(6) == 1);
+		REQUIRE(snapshot.LineFromPosition(1000) == 4);
+		REQUIRE(snapshot.StyleAt(3) == 2);
+		REQUIRE(snapshot.LineState(1) == 7);
+		REQUIRE(snapshot.Level(0) == SC_FOLDLEVELBASE);
+		REQUIRE(snapshot.MemoryUse() >= 2 * sample.length());
+	}
+
+	SECTION("ReadsSeeWrites") {
+		SnapshotAccess access(snapshot);
+		REQUIRE(access.GetLineState(1) == 7);
+		REQUIRE(access.SetLineState(3, 5) == 0);
+		REQUIRE(access.GetLineState(3) == 5);
+		// The line between keeps the snapshot's state
+		access.SetLineState(1, 9);
+		REQUIRE(access.GetLineState(1) == 9);
+		REQUIRE(access.GetLineState(2) == 0);
+		access.StartStyling(6);
+		access.SetStyleFor(2, 3);
+		access.StartStyling(2);
+		access.SetStyles(2, "\x04\x04");
+		REQUIRE(access.StyleAt(2) == 4);
+		REQUIRE(access.StyleAt(4) == 2);
+		REQUIRE(access.StyleAt(7) == 3);
+		REQUIRE(access.StyleAt(8) == 2);
+		char range[12] {};
+		access.GetStyleRange(range, 0, 10);
+		REQUIRE(std::string(range, 10) == std::string("\x02\x02\x04\x04\x02\x02\x03\x03\x02\x02", 10));
+		const SnapshotOutput output = access.TakeOutput();
+		REQUIRE(output.stylesStart == 2);
+		REQUIRE(output.styles == std::string("\x04\x04\x02\x02\x03\x03", 6));
+		REQUIRE(output.lineStatesStart == 1);
+		REQUIRE(output.lineStates == std::vector<int>{ 9, 0, 5 });
+		REQUIRE(access.TakeOutput().styles.empty());
+	}
+
+	SECTION("Backwards") {
+		// Setting from the end of the document towards its start adds to the front of each range
+		SnapshotAccess access(snapshot);
+		for (Sci_Position position = sample.length() - 1; position >= 0; position--) {
+			access.StartStyling(position);
+			access.SetStyleFor(1, static_cast<char>(position % 8));
+		}
+		for (Sci_Position line = snapshot.Lines() - 1; line >= 0; line--) {
+			access.SetLevel(line, SC_FOLDLEVELBASE + static_cast<int>(line));
+		}
+		const SnapshotOutput output = access.TakeOutput();
+		REQUIRE(output.stylesStart == 0);
+		REQUIRE(output.styles.length() == sample.length());
+		for (size_t position = 0; position < sample.length(); position++) {
+			REQUIRE(output.styles[position] == static_cast<char>(position % 8));
+		}
+		REQUIRE(output.levelsStart == 0);
+		REQUIRE(output.levels == std::vector<int>{ SC_FOLDLEVELBASE, SC_FOLDLEVELBASE + 1, SC_FOLDLEVELBASE + 2,
+			SC_FOLDLEVELBASE + 3, SC_FOLDLEVELBASE + 4 });
+	}
+
+	SECTION("LexOnThreadAndApply") {
+		Scintilla::ILexer5 *lexer = lmSnapshotDigits.Create();
+		SnapshotOutput output;
+		std::thread worker([&]() {
+			output = LexSnapshot(lexer, snapshot, 0, sample.length(), 0, false);
+		});
+		worker.join();
+		lexer->Release();
+		REQUIRE(output.version == 42);
+		// Nothing in the document changes until the output is applied
+		REQUIRE(document.styles[2] == 2);
+
+		Document lexedDirectly(sample);
+		Scintilla::ILexer5 *lexerDirect = lmSnapshotDigits.Create();
+		lexerDirect->Lex(0, sample.length(), 0, &lexedDirectly);
+		lexerDirect->Release();
+
+		REQUIRE(!output.Apply(&document, 43));
+		REQUIRE(document.styles[2] == 2);
+		REQUIRE(output.Apply(&document, 42));
+		REQUIRE(document.styles == lexedDirectly.styles);
+		REQUIRE(document.lineStates == lexedDirectly.lineStates);
+		REQUIRE(document.levels == lexedDirectly.levels);
+		REQUIRE(document.indicatorFills == 1);
+	}
+
+	SECTION("Characters") {
+		Document utf8("a\xC3\xA9\xE4\xB8\x80\xFF" "b");
+		const DocumentSnapshot snapshotUTF8(&utf8, 1);
+		Sci_Position width = 0;
+		REQUIRE(snapshotUTF8.CharacterAndWidth(1, &width) == 0xE9);
+		REQUIRE(width == 2);
+		REQUIRE(snapshotUTF8.CharacterAndWidth(3, &width) == 0x4E00);
+		REQUIRE(width == 3);
+		REQUIRE(snapshotUTF8.CharacterAndWidth(6, &width) == 0xDC80 + 0xFF);
+		REQUIRE(width == 1);
+		REQUIRE(snapshotUTF8.RelativePosition(0, 3) == 6);
+		REQUIRE(snapshotUTF8.RelativePosition(6, -2) == 1);
+		REQUIRE(snapshotUTF8.RelativePosition(8, 1) == -1);
+		REQUIRE(snapshotUTF8.RelativePosition(1, -2) == -1);
+	}
+}
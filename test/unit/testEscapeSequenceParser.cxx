@@ -0,0 +1,135 @@
+/** @file testEscapeSequenceParser.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include <string_view>
+#include <vector>
+
+#include "EscapeSequenceParser.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+namespace {
+
+std::vector<EscapeSequence> Parse(std::string_view text) {
+	std::vector<EscapeSequence> sequences;
+	EscapeSequenceParser parser(text);
+	EscapeSequence sequence;
+	while (parser.Next(sequence)) {
+		sequences.push_back(sequence);
+	}
+	return sequences;
+}
+
+}
+
+// Test EscapeSequenceParser.
+
+TEST_CASE("EscapeSequenceParser") {
+
+	SECTION("Text") {
+		const std::vector<EscapeSequence> sequences = Parse("plain\ttext\r\n");
+		REQUIRE(sequences.size() == 1);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::text);
+		REQUIRE(sequences[0].start == 0);
+		REQUIRE(sequences[0].length == 12);
+		REQUIRE(Parse("").empty());
+	}
+
+	SECTION("CSI") {
+		const std::vector<EscapeSequence> sequences = Parse("a\x1b[1;31mb\x1b[38:2::1:2:3m\x1b[?25l\x1b[ q");
+		REQUIRE(sequences.size() == 6);
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::csi);
+		REQUIRE(sequences[1].start == 1);
+		REQUIRE(sequences[1].length == 7);
+		REQUIRE(sequences[1].final == 'm');
+		REQUIRE(sequences[1].parameters == "1;31");
+		REQUIRE(sequences[1].intermediates.empty());
+		REQUIRE(sequences[2].kind == EscapeSequenceKind::text);
+		REQUIRE(sequences[2].length == 1);
+		REQUIRE(sequences[3].parameters == "38:2::1:2:3");
+		REQUIRE(sequences[4].parameters == "?25");
+		REQUIRE(sequences[4].final == 'l');
+		REQUIRE(sequences[5].kind == EscapeSequenceKind::csi);
+		REQUIRE(sequences[5].intermediates == " ");
+		REQUIRE(sequences[5].final == 'q');
+	}
+
+	SECTION("Escape") {
+		const std::vector<EscapeSequence> sequences = Parse("\x1b(B\x1b" "7");
+		REQUIRE(sequences.size() == 2);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::escape);
+		REQUIRE(sequences[0].intermediates == "(");
+		REQUIRE(sequences[0].final == 'B');
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::escape);
+		REQUIRE(sequences[1].final == '7');
+	}
+
+	SECTION("OSC") {
+		const std::vector<EscapeSequence> sequences =
+			Parse("\x1b]8;;http://example.com\x1b\\link\x1b]8;;\a\x1b]0;title\a");
+		REQUIRE(sequences.size() == 4);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::osc);
+		REQUIRE(sequences[0].data == "8;;http://example.com");
+		REQUIRE(sequences[0].length == 25);
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::text);
+		REQUIRE(sequences[1].length == 4);
+		REQUIRE(sequences[2].kind == EscapeSequenceKind::osc);
+		REQUIRE(sequences[2].data == "8;;");
+		REQUIRE(sequences[3].data == "0;title");
+	}
+
+	SECTION("DCS") {
+		const std::vector<EscapeSequence> sequences = Parse("\x1bP1$rdata\x1b\\\x1b_apc\x1b\\");
+		REQUIRE(sequences.size() == 2);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::dcs);
+		REQUIRE(sequences[0].parameters == "1");
+		REQUIRE(sequences[0].intermediates == "$");
+		REQUIRE(sequences[0].final == 'r');
+		REQUIRE(sequences[0].data == "data");
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::controlString);
+		REQUIRE(sequences[1].data == "apc");
+	}
+
+	SECTION("Malformed") {
+		// Cut short by the end of the text
+		std::vector<EscapeSequence> sequences = Parse("a\x1b[31");
+		REQUIRE(sequences.size() == 2);
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::malformed);
+		REQUIRE(sequences[1].length == 4);
+
+		// CAN ends the sequence and is part of it
+		sequences = Parse("\x1b[3\x18x");
+		REQUIRE(sequences.size() == 2);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::malformed);
+		REQUIRE(sequences[0].length == 4);
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::text);
+
+		// ESC starts a new sequence
+		sequences = Parse("\x1b[3\x1b[m");
+		REQUIRE(sequences.size() == 2);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::malformed);
+		REQUIRE(sequences[0].length == 3);
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::csi);
+
+		// A line end is not part of a sequence
+		sequences = Parse("\x1b]0;title\r\n");
+		REQUIRE(sequences.size() == 2);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::malformed);
+		REQUIRE(sequences[0].length == 9);
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::text);
+		REQUIRE(sequences[1].length == 2);
+
+		// UTF-8 is not C1
+		sequences = Parse("\x1b[\xc3\xa9");
+		REQUIRE(sequences.size() == 2);
+		REQUIRE(sequences[0].kind == EscapeSequenceKind::malformed);
+		REQUIRE(sequences[0].length == 2);
+		REQUIRE(sequences[1].kind == EscapeSequenceKind::text);
+		REQUIRE(sequences[1].length == 2);
+	}
+}
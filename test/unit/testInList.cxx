@@ -4,7 +4,9 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <cstddef>
 
+#include <string>
 #include <string_view>
 #include <initializer_list>
 
@@ -25,4 +27,38 @@ TEST_CASE("InList") {
 		REQUIRE(InListCaseInsensitive("DOG", {"cat", "dog", "frog"}));
 		REQUIRE(!InListCaseInsensitive("fly", {"cat", "dog", "frog"}));
 	}
+
+	SECTION("String") {
+		const std::string dog = "dog";
+		REQUIRE(InList(dog, {"cat", "dog", "frog"}));
+		REQUIRE(InListCaseInsensitive(std::string_view("FROG"), {"cat", "dog", "frog"}));
+		REQUIRE(!InListCaseInsensitive("FRO", {"cat", "dog", "frog"}));
+	}
+}
+
+TEST_CASE("KeywordSet") {
+
+	static constexpr KeywordSet animals { "frog", "Cat", "dog", "ant", "cat" };
+	static_assert(animals.size() == 5);
+	static_assert(animals.Contains("dog"));
+	static_assert(!animals.Contains("DOG"));
+
+	SECTION("Contains") {
+		REQUIRE(animals.Contains("ant"));
+		REQUIRE(animals.Contains("cat"));
+		REQUIRE(animals.Contains("Cat"));
+		REQUIRE(animals.Contains("frog"));
+		REQUIRE(!animals.Contains("CAT"));
+		REQUIRE(!animals.Contains("fro"));
+		REQUIRE(!animals.Contains("frogs"));
+		REQUIRE(!animals.Contains(""));
+	}
+
+	SECTION("ContainsCaseInsensitive") {
+		REQUIRE(animals.ContainsCaseInsensitive("ANT"));
+		REQUIRE(animals.ContainsCaseInsensitive("cAt"));
+		REQUIRE(animals.ContainsCaseInsensitive("Frog"));
+		REQUIRE(!animals.ContainsCaseInsensitive("zebra"));
+		REQUIRE(!animals.ContainsCaseInsensitive("a"));
+	}
 }
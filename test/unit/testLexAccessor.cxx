@@ -0,0 +1,370 @@
+/** @file testLexAccessor.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "LexCounters.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "LexArena.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test the line cache and the style comparison of LexAccessor.
+
+namespace {
+
+// Just enough of a document to read lines and styles from, counting the calls made for them. Lines end with
+// CR, LF or CR+LF and, when lineSeparators is set, also with U+2028 as Scintilla's UTF-8 documents may.
+class Document : public IDocumentStyleRange {
+	std::string text;
+	std::vector<Sci_Position> lineStarts;
+	std::vector<Sci_Position> lineEnds;
+	Sci_Position positionStyling = 0;
+	void Write(Sci_Position length) {
+		writtenStart = std::min(writtenStart, positionStyling);
+		writtenEnd = std::max(writtenEnd, positionStyling + length);
+		positionStyling += length;
+	}
+public:
+	std::string styles;
+	mutable int lineCalls = 0;
+	mutable int styleAtCalls = 0;
+	mutable int styleRangeCalls = 0;
+	// The smallest range holding every style written since it was last reset
+	Sci_Position writtenStart = INTPTR_MAX;
+	Sci_Position writtenEnd = 0;
+	explicit Document(std::string_view text_, bool lineSeparators=false) {
+		Set(text_, lineSeparators);
+	}
+	void Set(std::string_view text_, bool lineSeparators=false) {
+		text = text_;
+		styles.assign(text.size(), '\0');
+		lineStarts = { 0 };
+		lineEnds.clear();
+		for (size_t i = 0; i < text.size(); i++) {
+			if (text[i] == '\r' || text[i] == '\n') {
+				lineEnds.push_back(i);
+				if (text[i] == '\r' && i + 1 < text.size() && text[i + 1] == '\n')
+					i++;
+				lineStarts.push_back(i + 1);
+			} else if (lineSeparators && text.compare(i, 3, "\xe2\x80\xa8") == 0) {
+				lineEnds.push_back(i);
+				i += 2;
+				lineStarts.push_back(i + 1);
+			}
+		}
+		lineEnds.push_back(text.size());
+	}
+	Sci_Position Lines() const noexcept {
+		return lineStarts.size();
+	}
+	int SCI_METHOD Version() const override { return Scintilla::dvRelease4; }
+	void SCI_METHOD SetErrorStatus(int) override {}
+	Sci_Position SCI_METHOD Length() const override { return text.size(); }
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		text.copy(buffer, lengthRetrieve, position);
+	}
+	char SCI_METHOD StyleAt(Sci_Position position) const override {
+		styleAtCalls++;
+		return styles.at(position);
+	}
+	void SCI_METHOD GetStyleRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		styleRangeCalls++;
+		styles.copy(buffer, lengthRetrieve, position);
+	}
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override {
+		lineCalls++;
+		return std::upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin() - 1;
+	}
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override {
+		lineCalls++;
+		return (line < Lines()) ? lineStarts[line] : text.size();
+	}
+	int SCI_METHOD GetLevel(Sci_Position) const override { return SC_FOLDLEVELBASE; }
+	int SCI_METHOD SetLevel(Sci_Position, int) override { return SC_FOLDLEVELBASE; }
+	int SCI_METHOD GetLineState(Sci_Position) const override { return 0; }
+	int SCI_METHOD SetLineState(Sci_Position, int) override { return 0; }
+	void SCI_METHOD StartStyling(Sci_Position position) override { positionStyling = position; }
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override {
+		styles.replace(positionStyling, length, length, style);
+		Write(length);
+		return true;
+	}
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_) override {
+		styles.replace(positionStyling, length, styles_, length);
+		Write(length);
+		return true;
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int) override {}
+	void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) override {}
+	void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) override {}
+	int SCI_METHOD CodePage() const override { return 65001; }
+	bool SCI_METHOD IsDBCSLeadByte(char) const override { return false; }
+	const char *SCI_METHOD BufferPointer() override { return text.c_str(); }
+	int SCI_METHOD GetLineIndentation(Sci_Position) override { return 0; }
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override {
+		lineCalls++;
+		return (line < Lines()) ? lineEnds[line] : text.size();
+	}
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override {
+		return positionStart + characterOffset;
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		if (pWidth)
+			*pWidth = 1;
+		return static_cast<unsigned char>(text.at(position));
+	}
+};
+
+// The answers of the accessor for lines [lineFirst, lineLast] and their positions are the document's
+void RequireLines(const LexAccessor &styler, const Document &doc, Sci_Position lineFirst, Sci_Position lineLast) {
+	Document reference = doc;
+	for (Sci_Position line = lineFirst; line <= lineLast; line++) {
+		REQUIRE(styler.LineStart(line) == reference.LineStart(line));
+		REQUIRE(styler.LineEnd(line) == reference.LineEnd(line));
+		for (Sci_Position position = reference.LineStart(line); position < reference.LineStart(line + 1); position++) {
+			REQUIRE(styler.GetLine(position) == line);
+		}
+	}
+}
+
+// Styles doc from start to its end as a lexer would, each 'x' 1 and everything else 0
+void StyleX(LexAccessor &styler, Sci_Position start) {
+	styler.StartAt(start);
+	styler.StartSegment(start);
+	for (Sci_Position position = start; position < styler.Length(); position++) {
+		styler.ColourTo(position, (styler[position] == 'x') ? 1 : 0);
+	}
+	styler.Flush();
+}
+
+// Text with every kind of line end, an empty line and a line that is not terminated
+constexpr std::string_view mixedText = "one\r\ntwo\nthree\rfour\n\n\r\n\rsix\r\nlast";
+
+}
+
+TEST_CASE("LexAccessorLineCache") {
+
+	SECTION("Cached") {
+		Document doc(mixedText);
+		LexAccessor styler(&doc);
+		styler.CacheLines(0, doc.Length());
+		doc.lineCalls = 0;
+		RequireLines(styler, doc, 0, doc.Lines() - 1);
+		// The start of the line after the last is cached
+		REQUIRE(styler.LineStart(doc.Lines()) == doc.Length());
+		REQUIRE(doc.lineCalls == 0);
+	}
+
+	SECTION("TerminatedLast") {
+		Document doc("a\r\nb\r\n");
+		LexAccessor styler(&doc);
+		styler.CacheLines(0, doc.Length());
+		doc.lineCalls = 0;
+		RequireLines(styler, doc, 0, 1);
+		REQUIRE(styler.LineStart(2) == 6);
+		REQUIRE(styler.LineEnd(1) == 4);
+		REQUIRE(doc.lineCalls == 0);
+	}
+
+	SECTION("Partial") {
+		// Lines outside the range cached are asked of the document
+		Document doc(mixedText);
+		LexAccessor styler(&doc);
+		styler.CacheLines(doc.LineStart(2) + 1, doc.LineStart(5));
+		RequireLines(styler, doc, 0, doc.Lines() - 1);
+		const Sci_Position startThree = doc.LineStart(3);
+		const Sci_Position endTwo = doc.LineEnd(2);
+		doc.lineCalls = 0;
+		REQUIRE(styler.GetLine(startThree) == 3);
+		REQUIRE(styler.LineEnd(2) == endTwo);
+		REQUIRE(doc.lineCalls == 0);
+		REQUIRE(styler.GetLine(0) == 0);
+		REQUIRE(styler.LineEnd(doc.Lines() - 1) == doc.Length());
+		REQUIRE(doc.lineCalls == 2);
+	}
+
+	SECTION("Growing") {
+		// Short lines outgrow the arrays first allocated for lines of 64 bytes
+		std::string text;
+		for (int line = 0; line < 3000; line++) {
+			text += (line % 3) ? "x\n" : "\r\n";
+		}
+		Document doc(text);
+		const Document reference = doc;
+		LexAccessor styler(&doc);
+		styler.CacheLines(0, doc.Length());
+		doc.lineCalls = 0;
+		// Visited backwards so the line after the last found is not the one wanted
+		for (Sci_Position position = doc.Length() - 1; position >= 0; position--) {
+			REQUIRE(styler.GetLine(position) == reference.LineFromPosition(position));
+		}
+		// The last line is empty and starts after the text so only its start is cached
+		RequireLines(styler, doc, 0, doc.Lines() - 2);
+		REQUIRE(styler.LineStart(doc.Lines() - 1) == doc.Length());
+		REQUIRE(doc.lineCalls == 0);
+	}
+
+	SECTION("LineSeparators") {
+		// The document counts lines the cache does not know of so it is not used
+		Document doc("one\ntwo\xe2\x80\xa8three\nfour", true);
+		LexAccessor styler(&doc);
+		styler.CacheLines(0, doc.Length());
+		RequireLines(styler, doc, 0, doc.Lines() - 1);
+		doc.lineCalls = 0;
+		REQUIRE(styler.GetLine(11) == 2);
+		REQUIRE(doc.lineCalls == 1);
+	}
+
+	SECTION("AfterArenaReset") {
+		Document doc(mixedText);
+		LexAccessor styler(&doc);
+		styler.CacheLines(0, doc.Length());
+		// Caching again once the arena is reset reuses its memory for the new lines
+		styler.Arena().Reset();
+		const Sci_Position lineFirst = 4;
+		styler.CacheLines(doc.LineStart(lineFirst), doc.Length());
+		doc.lineCalls = 0;
+		RequireLines(styler, doc, lineFirst, doc.Lines() - 1);
+		REQUIRE(doc.lineCalls == 0);
+		RequireLines(styler, doc, 0, doc.Lines() - 1);
+
+		// Lending an arena drops the cache in the one used before
+		LexArena first;
+		styler.SetArena(&first);
+		styler.CacheLines(0, doc.Length());
+		LexArena arena;
+		styler.SetArena(&arena);
+		doc.lineCalls = 0;
+		REQUIRE(styler.GetLine(doc.Length() - 1) == doc.Lines() - 1);
+		REQUIRE(doc.lineCalls == 1);
+		styler.CacheLines(0, doc.Length());
+		REQUIRE(arena.Capacity() > 0);
+		arena.Reset();
+		styler.SetArena(&arena);
+		RequireLines(styler, doc, 0, doc.Lines() - 1);
+		styler.CacheLines(0, doc.Length());
+		doc.lineCalls = 0;
+		RequireLines(styler, doc, 0, doc.Lines() - 1);
+		REQUIRE(doc.lineCalls == 0);
+	}
+}
+
+TEST_CASE("LexAccessorCompareStyles") {
+
+	// Longer than the blocks compared at once, with changes in different blocks
+	std::string text(5000, 'a');
+	text[10] = 'x';
+	text[1500] = 'x';
+	text[3999] = 'x';
+
+	SECTION("OnlyChangesWritten") {
+		for (const bool lend : { false, true }) {
+			Document doc(text);
+			doc.styles[1500] = 1;
+			LexAccessor styler(&doc);
+			styler.SetCompareStyles(true);
+			styler.SetStyleRange(lend ? &doc : nullptr);
+			StyleX(styler, 0);
+			Sci_Position start = 0;
+			Sci_Position end = 0;
+			REQUIRE(styler.GetChangedRange(start, end));
+			REQUIRE(start == 10);
+			REQUIRE(end == 4000);
+			REQUIRE(doc.writtenStart == 10);
+			REQUIRE(doc.writtenEnd == 4000);
+			std::string expected(5000, '\0');
+			expected[10] = 1;
+			expected[1500] = 1;
+			expected[3999] = 1;
+			REQUIRE(doc.styles == expected);
+			// The document lent is read a block at a time, others a position at a time
+			if (lend) {
+				REQUIRE(doc.styleAtCalls == 0);
+				REQUIRE(doc.styleRangeCalls > 0);
+				REQUIRE(doc.styleRangeCalls < 10);
+			} else {
+				REQUIRE(doc.styleRangeCalls == 0);
+				REQUIRE(doc.styleAtCalls > 1000);
+			}
+		}
+	}
+
+	SECTION("NothingChanged") {
+		Document doc(text);
+		LexAccessor first(&doc);
+		StyleX(first, 0);
+		doc.writtenStart = INTPTR_MAX;
+		doc.writtenEnd = 0;
+		LexAccessor styler(&doc);
+		styler.SetCompareStyles(true);
+		styler.SetStyleRange(&doc);
+		StyleX(styler, 0);
+		Sci_Position start = 0;
+		Sci_Position end = 0;
+		REQUIRE(!styler.GetChangedRange(start, end));
+		REQUIRE(doc.writtenEnd == 0);
+	}
+
+	SECTION("ChangeAtEnd") {
+		Document doc(text);
+		LexAccessor first(&doc);
+		StyleX(first, 0);
+		doc.Set(text.substr(0, 4999) + "x");
+		LexAccessor styler(&doc);
+		styler.SetCompareStyles(true);
+		styler.SetStyleRange(&doc);
+		StyleX(styler, 4000);
+		Sci_Position start = 0;
+		Sci_Position end = 0;
+		REQUIRE(styler.GetChangedRange(start, end));
+		REQUIRE(start == 4999);
+		REQUIRE(end == 5000);
+		REQUIRE(doc.styles[4999] == 1);
+		REQUIRE(doc.styles[3999] == 0);
+	}
+
+	SECTION("NotCompared") {
+		// Everything is written and no range is reported
+		Document doc(text);
+		LexAccessor styler(&doc);
+		StyleX(styler, 0);
+		Sci_Position start = 0;
+		Sci_Position end = 0;
+		REQUIRE(!styler.GetChangedRange(start, end));
+		REQUIRE(doc.writtenStart == 0);
+		REQUIRE(doc.writtenEnd == 5000);
+		REQUIRE(doc.styleAtCalls == 0);
+	}
+
+	SECTION("OtherDocumentLent") {
+		// Styles are only read through the document the accessor reads
+		Document doc(text);
+		Document other(text);
+		LexAccessor styler(&doc);
+		styler.SetCompareStyles(true);
+		styler.SetStyleRange(&other);
+		StyleX(styler, 0);
+		REQUIRE(other.styleRangeCalls == 0);
+		REQUIRE(doc.styleRangeCalls == 0);
+		REQUIRE(doc.styleAtCalls > 0);
+		REQUIRE(doc.styles[10] == 1);
+	}
+}
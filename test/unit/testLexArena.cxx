@@ -0,0 +1,102 @@
+/** @file testLexArena.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+#include "LexArena.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test LexArena.
+
+TEST_CASE("LexArena") {
+
+	LexArena arena;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(arena.Capacity() == 0);
+	}
+
+	SECTION("Allocate") {
+		char *a = arena.AllocateArray<char>(3);
+		double *d = arena.AllocateArray<double>(2);
+		REQUIRE(a);
+		REQUIRE(d);
+		REQUIRE(reinterpret_cast<std::uintptr_t>(d) % alignof(double) == 0);
+		REQUIRE(static_cast<void *>(d) != static_cast<void *>(a));
+		d[0] = 1.5;
+		d[1] = 2.5;
+		REQUIRE(d[0] + d[1] == 4.0);
+		REQUIRE(arena.Capacity() > 0);
+	}
+
+	SECTION("Copy") {
+		const std::string_view copy = arena.Copy("abc");
+		REQUIRE(copy == "abc");
+		REQUIRE(copy.data()[3] == '\0');
+		REQUIRE(arena.Copy("").empty());
+	}
+
+	SECTION("LargerThanBlock") {
+		const std::string large(100000, 'x');
+		const std::string_view copy = arena.Copy(large);
+		REQUIRE(copy == large);
+		REQUIRE(arena.AllocateArray<int>(10));
+	}
+
+	SECTION("ResetKeepsOneBlock") {
+		// Fill several blocks then check they are merged into one after Reset
+		for (int i = 0; i < 100; i++) {
+			arena.AllocateArray<char>(1000);
+		}
+		const size_t capacity = arena.Capacity();
+		arena.Reset();
+		arena.AllocateArray<char>(1);
+		REQUIRE(arena.Capacity() >= capacity);
+		for (int i = 0; i < 99; i++) {
+			arena.AllocateArray<char>(1000);
+		}
+		// Everything fits in the merged block
+		REQUIRE(arena.Capacity() == capacity);
+	}
+
+	SECTION("Trim") {
+		for (int i = 0; i < 100; i++) {
+			arena.AllocateArray<char>(1000);
+		}
+		// Small enough to keep
+		arena.Trim(1000000);
+		REQUIRE(arena.Capacity() == 0);
+		arena.AllocateArray<char>(1);
+		const size_t merged = arena.Capacity();
+		REQUIRE(merged >= 100000);
+		arena.Trim(1000000);
+		REQUIRE(arena.Capacity() == merged);
+		// Too large so freed and the next block is small again
+		arena.Trim(0x2000);
+		REQUIRE(arena.Capacity() == 0);
+		arena.AllocateArray<char>(1);
+		REQUIRE(arena.Capacity() <= 0x2000);
+	}
+
+	SECTION("ArenaString") {
+		ArenaString text{ ArenaAllocator<char>(arena) };
+		for (int i = 0; i < 1000; i++) {
+			text.append("ab");
+		}
+		REQUIRE(text.length() == 2000);
+		REQUIRE(std::string_view(text).substr(1998) == "ab");
+		REQUIRE(text.get_allocator() == ArenaAllocator<char>(arena));
+	}
+}
@@ -0,0 +1,184 @@
+/** @file testLexCost.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "PropSetSimple.h"
+#include "WordList.h"
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexCost.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "Accessor.h"
+#include "LexerModule.h"
+#include "LexerBase.h"
+#include "LexerSimple.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test LexCost.
+
+namespace {
+
+// Just enough of a document for styling
+class Document : public Scintilla::IDocument {
+	std::string text;
+	std::vector<Sci_Position> lineStarts;
+	Sci_Position endStyled = 0;
+public:
+	explicit Document(std::string_view text_) : text(text_) {
+		lineStarts.push_back(0);
+		for (size_t i = 0; i < text.size(); i++) {
+			if (text[i] == '\n')
+				lineStarts.push_back(i + 1);
+		}
+	}
+	int SCI_METHOD Version() const override { return Scintilla::dvRelease4; }
+	void SCI_METHOD SetErrorStatus(int) override {}
+	Sci_Position SCI_METHOD Length() const override { return text.size(); }
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		text.copy(buffer, lengthRetrieve, position);
+	}
+	char SCI_METHOD StyleAt(Sci_Position) const override { return 0; }
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override {
+		return std::upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin() - 1;
+	}
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override {
+		return (line < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line] : text.size();
+	}
+	int SCI_METHOD GetLevel(Sci_Position) const override { return SC_FOLDLEVELBASE; }
+	int SCI_METHOD SetLevel(Sci_Position, int) override { return SC_FOLDLEVELBASE; }
+	int SCI_METHOD GetLineState(Sci_Position) const override { return 0; }
+	int SCI_METHOD SetLineState(Sci_Position, int) override { return 0; }
+	void SCI_METHOD StartStyling(Sci_Position position) override { endStyled = position; }
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char) override {
+		endStyled += length;
+		return true;
+	}
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *) override {
+		endStyled += length;
+		return true;
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int) override {}
+	void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) override {}
+	void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) override {}
+	int SCI_METHOD CodePage() const override { return 65001; }
+	bool SCI_METHOD IsDBCSLeadByte(char) const override { return false; }
+	const char *SCI_METHOD BufferPointer() override { return text.c_str(); }
+	int SCI_METHOD GetLineIndentation(Sci_Position) override { return 0; }
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override {
+		return (line + 1 < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line + 1] - 1 : text.size();
+	}
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override {
+		return positionStart + characterOffset;
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		if (pWidth)
+			*pWidth = 1;
+		return static_cast<unsigned char>(text.at(position));
+	}
+};
+
+void ColouriseAll(Sci_PositionU startPos, Sci_Position length, int, WordList *[], Accessor &styler) {
+	styler.StartAt(startPos);
+	styler.StartSegment(startPos);
+	styler.ColourTo(startPos + length - 1, 1);
+	styler.Flush();
+}
+
+LexerModule lmCostExample(123460, ColouriseAll, "costexample");
+
+}
+
+TEST_CASE("LexCost") {
+
+	SECTION("Default") {
+		const LexCost cost;
+		REQUIRE(cost.Samples() == 0);
+		REQUIRE(cost.NanosecondsPerByte() == LexCost::defaultNanosecondsPerByte);
+		REQUIRE(cost.NanosecondsPerLine() == 0.0);
+		REQUIRE(cost.BytesFor(5) == 250000);
+		REQUIRE(cost.LinesFor(5) == -1);
+	}
+
+	SECTION("Estimate") {
+		LexCost cost;
+		// 10 ns a byte with lines of 50 bytes
+		cost.Add(1000000, 100000, 2000);
+		REQUIRE(cost.Samples() == 1);
+		REQUIRE(cost.NanosecondsPerByte() == Approx(10.0));
+		REQUIRE(cost.NanosecondsPerLine() == Approx(500.0));
+		REQUIRE(cost.BytesFor(5) == 500000);
+		REQUIRE(cost.LinesFor(5) == 10000);
+		// Nothing styled is not a sample
+		cost.Add(1000, 0, 0);
+		REQUIRE(cost.Samples() == 1);
+		// Recent calls weigh more so the estimate moves towards a slower lexer
+		for (int call = 0; call < 20; call++) {
+			cost.Add(10000000, 100000, 2000);
+		}
+		REQUIRE(cost.NanosecondsPerByte() == Approx(100.0).epsilon(0.01));
+		REQUIRE(cost.BytesFor(0) == 1);
+		cost.Clear();
+		REQUIRE(cost.Samples() == 0);
+	}
+
+	SECTION("Untimed") {
+		LexCost cost;
+		cost.Add(0, 1000, 10);
+		REQUIRE(cost.BytesFor(5) == 1000000000);
+		REQUIRE(cost.LinesFor(5) == 1000000000);
+	}
+
+	SECTION("Query") {
+		std::string text;
+		for (int line = 0; line < 1000; line++) {
+			text += "line of text " + std::to_string(line) + "\n";
+		}
+		Document document(text);
+		LexerSimple lexer(&lmCostExample);
+		LexCostQuery query;
+		query.start = 100;
+		REQUIRE(lexer.PrivateCall(privateCallLexCost, nullptr) == nullptr);
+		REQUIRE(lexer.PrivateCall(privateCallLexCost, &query) == &query);
+		// Nothing lexed so the default estimate is used without a document to end at
+		REQUIRE(query.samples == 0);
+		REQUIRE(query.end == 100 + LexCost().BytesFor(5));
+
+		lexer.Lex(0, document.Length(), 0, &document);
+		query.document = &document;
+		query.milliseconds = 5;
+		lexer.PrivateCall(privateCallLexCost, &query);
+		REQUIRE(query.samples == 1);
+		REQUIRE(query.nanosecondsPerByte > 0.0);
+		REQUIRE(query.end > query.start);
+		REQUIRE(query.end <= document.Length());
+		REQUIRE(document.LineStart(document.LineFromPosition(query.end)) == query.end);
+
+		query.start = document.Length();
+		lexer.PrivateCall(privateCallLexCost, &query);
+		REQUIRE(query.end == document.Length());
+
+		// Another document starts a new estimate
+		Document other("a\nb\n");
+		lexer.Lex(0, other.Length(), 0, &other);
+		lexer.PrivateCall(privateCallLexCost, &query);
+		REQUIRE(query.samples == 1);
+		lexer.Reset();
+		lexer.PrivateCall(privateCallLexCost, &query);
+		REQUIRE(query.samples == 0);
+	}
+}
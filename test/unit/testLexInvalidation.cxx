@@ -0,0 +1,88 @@
+/** @file testLexInvalidation.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstring>
+
+#include "ILexer.h"
+
+#include "LexInvalidation.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+namespace {
+
+const PropertyScope scopes[] = {
+	{ "example.value.separate", -1, Restyle::dependent, 1 },
+	{ "example.display", -1, Restyle::none, 0 },
+	{ nullptr, 2, Restyle::dependent, 3 },
+	{ nullptr, -1, Restyle::all, 0 },
+};
+
+}
+
+// Test LexInvalidation.
+
+TEST_CASE("LexInvalidation") {
+
+	LexInvalidation invalidation;
+
+	SECTION("IsEmptyInitially") {
+		for (int dependency = 0; dependency < LexInvalidation::maxDependencies; dependency++) {
+			REQUIRE(invalidation.First(dependency) == -1);
+		}
+		REQUIRE(invalidation.First(-1) == -1);
+		REQUIRE(invalidation.First(LexInvalidation::maxDependencies) == -1);
+	}
+
+	SECTION("Mark") {
+		invalidation.Mark(1, 200);
+		invalidation.Mark(1, 100);
+		invalidation.Mark(1, 300);
+		invalidation.Mark(LexInvalidation::maxDependencies, 10);
+		REQUIRE(invalidation.First(1) == 100);
+		REQUIRE(invalidation.First(0) == -1);
+	}
+
+	SECTION("Start") {
+		invalidation.Mark(1, 100);
+		invalidation.Mark(2, 500);
+		// Restyling from 300 keeps the earlier mark and forgets the later one
+		invalidation.Start(300);
+		REQUIRE(invalidation.First(1) == 100);
+		REQUIRE(invalidation.First(2) == -1);
+		invalidation.Mark(2, 400);
+		REQUIRE(invalidation.First(2) == 400);
+		invalidation.Start(0);
+		REQUIRE(invalidation.First(1) == -1);
+	}
+
+	SECTION("Merge") {
+		LexInvalidation part;
+		invalidation.Mark(1, 100);
+		part.Mark(1, 50);
+		part.Mark(3, 70);
+		invalidation.Merge(part);
+		REQUIRE(invalidation.First(1) == 50);
+		REQUIRE(invalidation.First(3) == 70);
+		invalidation.Clear();
+		REQUIRE(invalidation.First(3) == -1);
+	}
+
+	SECTION("Scopes") {
+		REQUIRE(FindScope(nullptr, "example.display", -1) == nullptr);
+		REQUIRE(FindScope(scopes, "example.other", -1) == nullptr);
+		REQUIRE(FindScope(scopes, "example.display", -1) == &scopes[1]);
+		REQUIRE(FindScope(scopes, nullptr, 2) == &scopes[2]);
+		REQUIRE(FindScope(scopes, nullptr, 0) == nullptr);
+		// Undeclared restyles all, display only nothing, dependent from the first mark
+		REQUIRE(invalidation.FirstInvalidated(nullptr) == 0);
+		REQUIRE(invalidation.FirstInvalidated(&scopes[1]) == -1);
+		REQUIRE(invalidation.FirstInvalidated(&scopes[0]) == -1);
+		invalidation.Mark(1, 42);
+		REQUIRE(invalidation.FirstInvalidated(&scopes[0]) == 42);
+	}
+}
@@ -0,0 +1,100 @@
+/** @file testLexLocations.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstdint>
+
+#include <vector>
+#include <algorithm>
+
+#include "ILexer.h"
+
+#include "LexLocations.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+namespace {
+
+LexLocation Location(Sci_Position line, int lineNumber) {
+	LexLocation location;
+	location.line = line;
+	location.lineNumber = lineNumber;
+	return location;
+}
+
+}
+
+// Test LexLocations.
+
+TEST_CASE("LexLocations") {
+
+	LexLocations locations;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(locations.Count() == 0);
+		REQUIRE(locations.Find(0) == 0);
+	}
+
+	SECTION("Commit") {
+		locations.Add(Location(1, 10));
+		locations.Add(Location(4, 40));
+		REQUIRE(locations.Count() == 0);
+		locations.Commit(0, 5);
+		REQUIRE(locations.Count() == 2);
+		REQUIRE(locations.Get(0).line == 1);
+		REQUIRE(locations.Get(1).lineNumber == 40);
+		REQUIRE_THROWS(locations.Get(2));
+	}
+
+	SECTION("Append") {
+		locations.Add(Location(1, 10));
+		locations.Commit(0, 2);
+		locations.Add(Location(3, 30));
+		locations.Commit(3, 3);
+		REQUIRE(locations.Count() == 2);
+		REQUIRE(locations.Get(1).line == 3);
+	}
+
+	SECTION("ReplaceMiddle") {
+		locations.Add(Location(1, 10));
+		locations.Add(Location(2, 20));
+		locations.Add(Location(3, 30));
+		locations.Add(Location(5, 50));
+		locations.Commit(0, 5);
+		// Relexing lines 2 to 3 finds one location on line 3 where there were two
+		locations.Add(Location(3, 31));
+		locations.Commit(2, 3);
+		REQUIRE(locations.Count() == 3);
+		REQUIRE(locations.Get(0).lineNumber == 10);
+		REQUIRE(locations.Get(1).lineNumber == 31);
+		REQUIRE(locations.Get(2).lineNumber == 50);
+		// Relexing with no locations removes those lines' locations
+		locations.Commit(0, 3);
+		REQUIRE(locations.Count() == 1);
+		REQUIRE(locations.Get(0).line == 5);
+	}
+
+	SECTION("Find") {
+		locations.Add(Location(2, 20));
+		locations.Add(Location(2, 21));
+		locations.Add(Location(6, 60));
+		locations.Commit(0, 6);
+		REQUIRE(locations.Find(0) == 0);
+		REQUIRE(locations.Find(2) == 0);
+		REQUIRE(locations.Find(3) == 2);
+		REQUIRE(locations.Find(6) == 2);
+		REQUIRE(locations.Find(7) == 3);
+	}
+
+	SECTION("Clear") {
+		locations.Add(Location(2, 20));
+		locations.Commit(0, 2);
+		locations.Add(Location(3, 30));
+		locations.Clear();
+		REQUIRE(locations.Count() == 0);
+		locations.Commit(0, 5);
+		REQUIRE(locations.Count() == 0);
+	}
+}
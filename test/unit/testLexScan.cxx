@@ -0,0 +1,154 @@
+/** @file testLexScan.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstring>
+
+#include <string>
+#include <vector>
+#include <random>
+
+#include "LexScan.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test LexScan.
+
+namespace {
+
+constexpr ScanLevel levels[] = {
+	ScanLevel::scalar, ScanLevel::sse2, ScanLevel::ssse3, ScanLevel::avx2, ScanLevel::neon
+};
+
+// Bytes from a small alphabet so that matches and misses both occur in every block
+std::string RandomText(size_t length, unsigned int seed) {
+	static constexpr char alphabet[] = "ab\n\r \x80\xC3\xFF";
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<size_t> distribution(0, sizeof(alphabet) - 2);
+	std::string text(length, ' ');
+	for (char &ch : text) {
+		// Mostly 'a' so runs are long enough for whole blocks to be skipped
+		ch = (generator() % 4) ? 'a' : alphabet[distribution(generator)];
+	}
+	return text;
+}
+
+void AddToNibbles(ScanNibbles &nibbles, unsigned char uch) noexcept {
+	nibbles[uch >> 7][uch & 0xf] |= static_cast<unsigned char>(1 << ((uch >> 4) & 7));
+}
+
+// Runs check over many starts and ends of text at each supported level, checking against scalar
+template <typename Check>
+void CompareLevels(const std::string &text, Check check) {
+	const char *begin = text.data();
+	const char *end = begin + text.length();
+	std::vector<const char *> expected;
+	REQUIRE(SetScanLevel(ScanLevel::scalar));
+	for (size_t start = 0; start < 70; start++) {
+		for (size_t length = 0; start + length <= text.length(); length += (length < 70) ? 1 : 61) {
+			expected.push_back(check(begin + start, begin + start + length));
+		}
+	}
+	expected.push_back(check(begin, end));
+	for (const ScanLevel level : levels) {
+		if (SetScanLevel(level)) {
+			REQUIRE(CurrentScanLevel() == level);
+			size_t index = 0;
+			for (size_t start = 0; start < 70; start++) {
+				for (size_t length = 0; start + length <= text.length(); length += (length < 70) ? 1 : 61) {
+					REQUIRE(check(begin + start, begin + start + length) == expected[index++]);
+				}
+			}
+			REQUIRE(check(begin, end) == expected[index]);
+		}
+	}
+	REQUIRE(SetScanLevel(BestScanLevel()));
+}
+
+}
+
+TEST_CASE("LexScan") {
+
+	SECTION("Levels") {
+		REQUIRE(CurrentScanLevel() == BestScanLevel());
+		REQUIRE(SetScanLevel(ScanLevel::scalar));
+		REQUIRE(CurrentScanLevel() == ScanLevel::scalar);
+		REQUIRE(SetScanLevel(BestScanLevel()));
+		REQUIRE(CurrentScanLevel() == BestScanLevel());
+	}
+
+	SECTION("Find") {
+		const std::string text = "abc\r\ndef\n\xC3\xA9";
+		const char *begin = text.data();
+		const char *end = begin + text.length();
+		REQUIRE(FindAny2(begin, end, '\n', '\r') == begin + 3);
+		REQUIRE(FindAny2(begin + 5, end, '\n', '\r') == begin + 8);
+		REQUIRE(FindAny2(begin, end, 'x', 'y') == end);
+		REQUIRE(FindAny3(begin, end, 'x', 'e', 'f') == begin + 6);
+		REQUIRE(FindNonASCII(begin, end) == begin + 9);
+		REQUIRE(FindNonASCII(begin, begin + 9) == begin + 9);
+		REQUIRE(FindAny2(begin, begin, 'a', 'b') == begin);
+	}
+
+	SECTION("ScanSet") {
+		ScanNibbles digits = {};
+		for (const char *digit = "0123456789"; *digit; digit++) {
+			AddToNibbles(digits, *digit);
+		}
+		const std::string text = "2026-10\xC3\xA9";
+		const char *begin = text.data();
+		const char *end = begin + text.length();
+		REQUIRE(ScanSet(begin, end, digits, true, false) == begin + 4);
+		REQUIRE(ScanSet(begin, end, digits, false, false) == begin);
+		REQUIRE(ScanSet(begin + 4, end, digits, false, false) == begin + 5);
+		REQUIRE(ScanSet(begin + 7, end, digits, false, false) == end);
+		REQUIRE(ScanSet(begin + 7, end, digits, false, true) == begin + 7);
+	}
+
+	SECTION("CompareN") {
+		const std::string a = "terminal output line";
+		const std::string b = "terminal outpost";
+		REQUIRE(CompareN(a.data(), b.data(), b.length()) == 13);
+		REQUIRE(CompareN(a.data(), a.data(), a.length()) == a.length());
+		REQUIRE(CompareN(a.data(), b.data(), 4) == 4);
+		REQUIRE(CompareN(a.data(), b.data(), 0) == 0);
+	}
+
+	SECTION("LevelsAgree") {
+		const std::string text = RandomText(400, 1234);
+		CompareLevels(text, [](const char *begin, const char *end) {
+			return FindAny2(begin, end, '\n', '\r');
+		});
+		CompareLevels(text, [](const char *begin, const char *end) {
+			return FindAny3(begin, end, '\n', '\r', ' ');
+		});
+		CompareLevels(text, [](const char *begin, const char *end) {
+			return FindNonASCII(begin, end);
+		});
+		// A set with members in both halves
+		ScanNibbles nibbles = {};
+		for (const char ch : std::string("ab \xC3")) {
+			AddToNibbles(nibbles, ch);
+		}
+		for (const bool inSet : { false, true }) {
+			for (const bool stopAtNonASCII : { false, true }) {
+				CompareLevels(text, [&](const char *begin, const char *end) {
+					return ScanSet(begin, end, nibbles, inSet, stopAtNonASCII);
+				});
+			}
+		}
+		// Compare text with a copy that differs at one position
+		for (const size_t position : { 0, 15, 16, 31, 32, 33, 200 }) {
+			std::string other = text;
+			other[position] = '!';
+			const char *base = text.data();
+			const char *otherBase = other.data();
+			CompareLevels(text, [&](const char *begin, const char *end) {
+				return begin + CompareN(begin, otherBase + (begin - base), end - begin);
+			});
+		}
+	}
+}
@@ -0,0 +1,65 @@
+/** @file testLexStyleTable.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include <vector>
+#include <algorithm>
+
+#include "LexStyleTable.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test LexStyleTable.
+
+TEST_CASE("LexStyleTable") {
+
+	LexStyleTable table;
+
+	SECTION("NoRange") {
+		REQUIRE(table.StyleFor(1) == -1);
+		REQUIRE(table.Allocated() == 0);
+	}
+
+	SECTION("Intern") {
+		table.SetRange(64, 3);
+		REQUIRE(table.StyleFor(0x401) == 64);
+		REQUIRE(table.StyleFor(0x22) == 65);
+		// Keys seen before keep their style
+		REQUIRE(table.StyleFor(0x401) == 64);
+		REQUIRE(table.StyleFor(7) == 66);
+		REQUIRE(table.Allocated() == 3);
+		// Full
+		REQUIRE(table.StyleFor(8) == -1);
+		REQUIRE(table.StyleFor(0x22) == 65);
+		REQUIRE(table.KeyOf(65) == 0x22);
+		REQUIRE(table.KeyOf(63) == -1);
+		REQUIRE(table.KeyOf(67) == -1);
+	}
+
+	SECTION("Range") {
+		table.SetRange(64, 10);
+		table.StyleFor(5);
+		// The same range keeps the styles allocated
+		table.SetRange(64, 10);
+		REQUIRE(table.Allocated() == 1);
+		table.SetRange(100, 10);
+		REQUIRE(table.Allocated() == 0);
+		REQUIRE(table.First() == 100);
+		REQUIRE(table.StyleFor(6) == 100);
+	}
+
+	SECTION("Clear") {
+		table.SetRange(64, 192);
+		for (int key = 0; key < 192; key++) {
+			REQUIRE(table.StyleFor(key * 37) == 64 + key);
+		}
+		REQUIRE(table.StyleFor(1) == -1);
+		table.Clear();
+		REQUIRE(table.Allocated() == 0);
+		REQUIRE(table.StyleFor(1) == 64);
+	}
+}
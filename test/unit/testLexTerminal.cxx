@@ -0,0 +1,918 @@
+/** @file testLexTerminal.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include <random>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "ExtraLexers.h"
+
+#include "TestDocument.h"
+
+#include "catch.hpp"
+
+// Test the ways of styling terminal output against LexerTerminalStyle.
+
+namespace {
+
+// A document as an editor holds it: lines end with CR, LF or CR+LF and each has a line state
+class Document : public AccessorInterface {
+	std::string text;
+	std::string styles;
+	std::vector<size_t> lineStarts{ 0 };
+	std::vector<int> lineStates{ 0 };
+	std::map<std::string, int> properties;
+	std::vector<std::pair<size_t, size_t>> overwritten;
+	size_t segmentStart = 0;
+public:
+	void Append(std::string_view appended) {
+		text += appended;
+		styles.resize(text.length(), '\0');
+		lineStarts = { 0 };
+		for (size_t i = 0; i < text.length(); i++) {
+			if ((text[i] == '\n') || ((text[i] == '\r') && ((i + 1 == text.length()) || (text[i + 1] != '\n')))) {
+				lineStarts.push_back(i + 1);
+			}
+		}
+		lineStates.resize(lineStarts.size());
+	}
+	void SetProperty(const std::string &name, int value) {
+		properties[name] = value;
+	}
+	// Marks the styles from position on as not styled
+	void ClearStyles(size_t position) {
+		std::fill(styles.begin() + position, styles.end(), '\xff');
+	}
+	size_t Length() const noexcept {
+		return text.length();
+	}
+	const std::string &Styles() const noexcept {
+		return styles;
+	}
+	const std::vector<int> &LineStates() const noexcept {
+		return lineStates;
+	}
+	// The ranges of the lines reported as overwritten, in the order they were reported
+	const std::vector<std::pair<size_t, size_t>> &Overwritten() const noexcept {
+		return overwritten;
+	}
+	size_t LineStart(size_t line) const {
+		return (line < lineStarts.size()) ? lineStarts[line] : text.length();
+	}
+
+	const char operator[](size_t index) const override {
+		return text[index];
+	}
+	char SafeGetCharAt(size_t index, char chDefault) const override {
+		return (index < text.length()) ? text[index] : chDefault;
+	}
+	void ColourTo(size_t pos, int style) override {
+		if (pos >= segmentStart) {
+			std::fill(styles.begin() + segmentStart, styles.begin() + std::min(pos + 1, text.length()),
+				static_cast<char>(style));
+			segmentStart = pos + 1;
+		}
+	}
+	void StartAt(size_t /*start*/) override {}
+	void StartSegment(size_t pos) override {
+		segmentStart = pos;
+	}
+	int GetPropertyInt(const std::string &name, int defaultVal) const override {
+		const auto it = properties.find(name);
+		return (it != properties.end()) ? it->second : defaultVal;
+	}
+	void GetCharRange(char *buffer, size_t pos, size_t length) const override {
+		text.copy(buffer, length, pos);
+	}
+	size_t GetLine(size_t pos) const override {
+		return std::upper_bound(lineStarts.begin(), lineStarts.end(), pos) - lineStarts.begin() - 1;
+	}
+	int GetLineState(size_t line) const override {
+		return lineStates[line];
+	}
+	void SetLineState(size_t line, int state) override {
+		lineStates[line] = state;
+	}
+	void AddOverwritten(size_t start, size_t end) override {
+		overwritten.emplace_back(start, end);
+	}
+	int StyleForAttributes(int key) override {
+		// The same style for a key whatever order the keys are seen in
+		return wxSTC_TERMINAL_SGR_FIRST + key % (wxSTC_TERMINAL_SGR_LAST - wxSTC_TERMINAL_SGR_FIRST + 1);
+	}
+};
+
+// The host of a TerminalTokenizer, which only gives it properties and styles for attributes as Document does
+class Host : public AccessorInterfaceV2 {
+	std::map<std::string, int> properties;
+public:
+	void SetProperty(const std::string &name, int value) {
+		properties[name] = value;
+	}
+	size_t Length() const override {
+		return 0;
+	}
+	void GetRange(size_t /*start*/, size_t /*length*/, char * /*buffer*/) const override {}
+	void SetStyleRuns(size_t /*start*/, const StyleRun * /*runs*/, size_t /*count*/) override {}
+	int GetPropertyInt(const std::string &name, int defaultVal) const override {
+		const auto it = properties.find(name);
+		return (it != properties.end()) ? it->second : defaultVal;
+	}
+	int StyleForAttributes(int key) override {
+		return wxSTC_TERMINAL_SGR_FIRST + key % (wxSTC_TERMINAL_SGR_LAST - wxSTC_TERMINAL_SGR_FIRST + 1);
+	}
+};
+
+template <typename Target>
+void SetProperties(Target &doc) {
+	doc.SetProperty("lexer.terminal.escape.sequences", 1);
+	doc.SetProperty("lexer.terminal.sgr.attributes", 1);
+	doc.SetProperty("lexer.terminal.value.separate", 1);
+	doc.SetProperty("lexer.terminal.overwritten.lines", 1);
+	doc.SetProperty("lexer.terminal.threads", 1);
+}
+
+// Lines of tool output, colours that carry on to the lines after them and escape sequences that are cut
+// short, interrupted by UTF-8 or a line end, or left open
+const std::string_view lines[] = {
+	"plain text",
+	"main.c:12:5: error: expected ';' before '}' token",
+	"main.c:14:1: warning: unused variable 'x'",
+	"  File \"tool.py\", line 3, in <module>",
+	"@@ -1,2 +1,3 @@", "+added", "-deleted",
+	"\x1b[31mred\x1b[0m then plain",
+	"\x1b[1;32mgreen and bold carried on",
+	"\x1b[38;5;208morange \x1b[48;2;10;20;30mon blue",
+	"\x1b[0m",
+	"\x1b[3\xc3\xa9 interrupted",
+	"cut at the end \x1b[31",
+	"lone \x1b",
+	"\x1b]8;;https://example.com\x07link\x1b]8;;\x07 after",
+	"\x1b(B\x1b[?25l cursor \x1b[2K\x1b[1G",
+	"progress 10%",
+	"\xc3\xa9t\xc3\xa9 \xe4\xbd\xa0",
+};
+
+std::string OutputText(std::mt19937 &random, int lineCount) {
+	const std::string_view lineEnds[] = { "\n", "\r\n", "\r" };
+	std::uniform_int_distribution<size_t> chooseLine(0, std::size(lines) - 1);
+	std::uniform_int_distribution<size_t> chooseEnd(0, std::size(lineEnds) - 1);
+	std::string text;
+	for (int line = 0; line < lineCount; line++) {
+		text += lines[chooseLine(random)];
+		text += lineEnds[chooseEnd(random)];
+	}
+	// The styles of a line are only final once its line end is known
+	text += "\n";
+	return text;
+}
+
+// One line of at least length bytes made of the lines of tool output, so longer than the lexer holds whole
+std::string LongLine(std::mt19937 &random, size_t length) {
+	std::uniform_int_distribution<size_t> chooseLine(0, std::size(lines) - 1);
+	std::string text;
+	while (text.length() < length) {
+		text += lines[chooseLine(random)];
+		text += ' ';
+	}
+	return text;
+}
+
+// Styled by LexerTerminalStyle in one call
+void StyleWhole(Document &doc, std::string_view text) {
+	SetProperties(doc);
+	doc.Append(text);
+	LexerTerminalStyle(0, doc.Length(), doc);
+}
+
+// Appends the style of each byte of runs to styles
+void AppendRuns(std::string &styles, const std::vector<StyleRun> &runs) {
+	for (const StyleRun &run : runs) {
+		styles.append(run.length, static_cast<char>(run.style));
+	}
+}
+
+// Where two sequences of the same length first differ, their length when they do not
+template <typename Sequence>
+size_t FirstDifference(const Sequence &a, const Sequence &b) {
+	REQUIRE(a.size() == b.size());
+	return std::mismatch(a.begin(), a.end(), b.begin()).first - a.begin();
+}
+
+void RequireSame(const Document &doc, const Document &reference) {
+	REQUIRE(FirstDifference(doc.Styles(), reference.Styles()) == reference.Styles().size());
+	REQUIRE(FirstDifference(doc.LineStates(), reference.LineStates()) == reference.LineStates().size());
+}
+
+// A line of start then count repetitions of repeated, ended by end, with the styles a line short enough to be
+// styled whole gives it. Those are worked out from a line of three repetitions whose last two are styled alike
+struct RepeatedLine {
+	std::string text;
+	std::string styles;
+};
+
+RepeatedLine Repeated(std::string_view start, std::string_view repeated, size_t count, std::string_view end) {
+	// A lone '\r' or no end at all is styled as the start of "\r\n" or before a '\n'
+	std::string endReference(end);
+	if (endReference.empty() || (endReference.back() != '\n')) {
+		endReference += '\n';
+	}
+	std::string shortLine(start);
+	for (int repetition = 0; repetition < 3; repetition++) {
+		shortLine += repeated;
+	}
+	shortLine += endReference;
+	Document reference;
+	StyleWhole(reference, shortLine);
+	const std::string &styles = reference.Styles();
+	const std::string unit = styles.substr(start.length() + repeated.length(), repeated.length());
+	REQUIRE(styles.substr(start.length() + 2 * repeated.length(), repeated.length()) == unit);
+
+	RepeatedLine line{ std::string(start), styles.substr(0, start.length()) };
+	line.text += repeated;
+	line.styles += styles.substr(start.length(), repeated.length());
+	for (size_t repetition = 1; repetition < count; repetition++) {
+		line.text += repeated;
+		line.styles += unit;
+	}
+	line.text += end;
+	line.styles += styles.substr(styles.length() - endReference.length(), end.length());
+	return line;
+}
+
+// Appends line to text and its styles to styles
+void AppendLine(std::string &text, std::string &styles, const RepeatedLine &line) {
+	text += line.text;
+	styles += line.styles;
+}
+
+// What LexerTerminalStrip writes for text, given room for as many runs as bytes
+struct Stripped {
+	std::string text;
+	std::vector<StrippedRun> runs;
+	size_t runsCounted = 0;
+};
+
+Stripped Strip(std::string_view text, AccessorInterfaceV2 *host = nullptr) {
+	Stripped stripped;
+	stripped.text.resize(text.length());
+	stripped.runs.resize(text.length());
+	const StrippedText result = LexerTerminalStrip(text.data(), text.length(), stripped.text.data(),
+		stripped.runs.data(), stripped.runs.size(), host);
+	stripped.text.resize(result.length);
+	stripped.runs.resize(result.runs);
+	stripped.runsCounted = result.runs;
+	return stripped;
+}
+
+bool SameRun(const StrippedRun &a, const StrippedRun &b) noexcept {
+	return (a.offset == b.offset) && (a.length == b.length) && (a.style == b.style);
+}
+
+void RequireRuns(const std::vector<StrippedRun> &runs, const std::vector<StrippedRun> &expected) {
+	REQUIRE(runs.size() == expected.size());
+	for (size_t i = 0; i < runs.size(); i++) {
+		INFO("run " << i << " at " << runs[i].offset << " length " << runs[i].length << " style " << runs[i].style);
+		REQUIRE(SameRun(runs[i], expected[i]));
+	}
+}
+
+// The terminal lexer as an editor uses it, through ILexer5 with folding on
+class FoldingLexer {
+	Scintilla::ILexer5 *lexer;
+public:
+	FoldingLexer() : lexer(static_cast<Scintilla::ILexer5 *>(CreateExtraLexerTerminal())) {
+		lexer->PropertySet("fold", "1");
+	}
+	FoldingLexer(const FoldingLexer &) = delete;
+	FoldingLexer &operator=(const FoldingLexer &) = delete;
+	~FoldingLexer() {
+		FreeExtraLexer(lexer);
+	}
+	// Styles and folds from start, a line start, to the end of doc
+	void LexFold(TestDocument &doc, Sci_Position start) {
+		lexer->Lex(start, doc.Length() - start, 0, &doc);
+		Fold(doc, start, doc.Length() - start);
+	}
+	void Fold(TestDocument &doc, Sci_Position start, Sci_Position length) {
+		lexer->Fold(start, length, 0, &doc);
+	}
+};
+
+int Depth(const TestDocument &doc, Sci_Position line) {
+	return (doc.GetLevel(line) & SC_FOLDLEVELNUMBERMASK) - SC_FOLDLEVELBASE;
+}
+
+bool IsHeader(const TestDocument &doc, Sci_Position line) {
+	return (doc.GetLevel(line) & SC_FOLDLEVELHEADERFLAG) != 0;
+}
+
+std::vector<int> Levels(const TestDocument &doc) {
+	std::vector<int> levels;
+	for (Sci_Position line = 0; line <= doc.MaxLine(); line++) {
+		levels.push_back(doc.GetLevel(line));
+	}
+	return levels;
+}
+
+// Lines that start, continue and end folds
+const std::string_view foldLines[] = {
+	"> make",
+	"> make test",
+	"gcc -c main.c",
+	"In file included from util.h:2,",
+	"                 from main.c:1:",
+	"util.h:3:5: error: unknown type name 'foo'",
+	"main.c:14:1: warning: unused variable 'x'",
+	"    3 |     foo x;",
+	"      |     ^~~",
+	"plain text",
+	"",
+};
+
+}
+
+TEST_CASE("TerminalStyler") {
+
+	std::mt19937 random(4);
+
+	SECTION("Chunks") {
+		// Appended in chunks that split lines and escape sequences anywhere
+		for (const size_t chunkMax : { 1, 3, 17, 200 }) {
+			const std::string text = OutputText(random, 400);
+			Document reference;
+			StyleWhole(reference, text);
+			Document doc;
+			SetProperties(doc);
+			TerminalStyler styler;
+			std::uniform_int_distribution<size_t> chooseLength(1, chunkMax);
+			for (size_t position = 0; position < text.length();) {
+				const size_t length = std::min(chooseLength(random), text.length() - position);
+				doc.Append(std::string_view(text).substr(position, length));
+				position += length;
+				styler.StyleTo(doc.Length(), doc);
+				// The complete lines are styled as they are in the whole text
+				const size_t lineStart = styler.GetLineStart();
+				REQUIRE(doc.Styles().compare(0, lineStart, reference.Styles(), 0, lineStart) == 0);
+			}
+			REQUIRE(styler.GetLineStart() == text.length());
+			RequireSame(doc, reference);
+		}
+	}
+
+	SECTION("LongLines") {
+		// Lines longer than the lexer holds whole, a diagnostic's among them, styled as they arrive in pieces
+		const std::string text = "main.c:3:1: error: " + LongLine(random, 200000) + "\r\n" + OutputText(random, 20) +
+			LongLine(random, 100000) + "\r" + OutputText(random, 20) + "\x1b[32m" + LongLine(random, 150000) + "\n";
+		Document reference;
+		StyleWhole(reference, text);
+		for (const size_t chunkMax : { 4096, 5000, 70000 }) {
+			Document doc;
+			SetProperties(doc);
+			TerminalStyler styler;
+			std::uniform_int_distribution<size_t> chooseLength(chunkMax / 2, chunkMax);
+			for (size_t position = 0; position < text.length();) {
+				const size_t length = std::min(chooseLength(random), text.length() - position);
+				doc.Append(std::string_view(text).substr(position, length));
+				position += length;
+				styler.StyleTo(doc.Length(), doc);
+				const size_t lineStart = styler.GetLineStart();
+				REQUIRE(doc.Styles().compare(0, lineStart, reference.Styles(), 0, lineStart) == 0);
+			}
+			REQUIRE(styler.GetLineStart() == text.length());
+			RequireSame(doc, reference);
+		}
+	}
+
+	SECTION("Restart") {
+		// Reset at a line takes the colour at its start from the line state before it
+		const std::string text = OutputText(random, 400);
+		Document reference;
+		StyleWhole(reference, text);
+		Document doc;
+		StyleWhole(doc, text);
+		TerminalStyler styler;
+		styler.StyleTo(doc.Length(), doc);
+		RequireSame(doc, reference);
+		int restartsWithColour = 0;
+		for (size_t line = 1; line < reference.LineStates().size(); line += 7) {
+			restartsWithColour += reference.LineStates()[line - 1] != 0;
+			doc.ClearStyles(doc.LineStart(line));
+			styler.Reset(doc.LineStart(line));
+			styler.StyleTo(doc.Length(), doc);
+			RequireSame(doc, reference);
+		}
+		REQUIRE(restartsWithColour > 0);
+	}
+
+	SECTION("EscapeRecovery") {
+		// A sequence interrupted by UTF-8 or a line end is unknown up to there and the text after it styled
+		// normally, though it arrives a byte at a time
+		const std::string_view text = "\x1b[3\xc3\xa9 x\x1b[32mgreen\x1b[0m\ncut \x1b[31\nplain\n";
+		Document reference;
+		StyleWhole(reference, text);
+		Document doc;
+		SetProperties(doc);
+		TerminalStyler styler;
+		for (const char ch : text) {
+			doc.Append(std::string_view(&ch, 1));
+			styler.StyleTo(doc.Length(), doc);
+		}
+		RequireSame(doc, reference);
+		const std::string &styles = doc.Styles();
+		REQUIRE(styles.substr(0, 3) == std::string(3, wxSTC_TERMINAL_ESCSEQ_UNKNOWN));
+		REQUIRE(styles[3] != wxSTC_TERMINAL_ESCSEQ_UNKNOWN);
+		const size_t green = text.find("green");
+		REQUIRE(styles.substr(green - 5, 5) == std::string(5, wxSTC_TERMINAL_ESCSEQ));
+		REQUIRE(styles.substr(green, 5) == std::string(5, wxSTC_TERMINAL_ES_GREEN));
+		const size_t cut = text.find("\x1b[31");
+		REQUIRE(styles.substr(cut, 4) == std::string(4, wxSTC_TERMINAL_ESCSEQ_UNKNOWN));
+		const size_t plain = text.find("plain");
+		REQUIRE(styles.substr(plain, 5) == std::string(5, wxSTC_TERMINAL_DEFAULT));
+		// The sequence cut by the line end sets no colour
+		REQUIRE(doc.LineStates()[1] == 0);
+	}
+}
+
+TEST_CASE("TerminalTokenizer") {
+
+	std::mt19937 random(5);
+	Host host;
+	SetProperties(host);
+
+	SECTION("Feed") {
+		// The runs of each line are the styles of the whole text, however the bytes are fed
+		for (const size_t chunkMax : { 1, 3, 17, 200 }) {
+			const std::string text = OutputText(random, 400);
+			Document reference;
+			StyleWhole(reference, text);
+			TerminalTokenizer tokenizer(&host);
+			std::vector<StyleRun> runs;
+			std::string styles;
+			std::uniform_int_distribution<size_t> chooseLength(1, chunkMax);
+			for (size_t position = 0; position < text.length();) {
+				const size_t length = std::min(chooseLength(random), text.length() - position);
+				tokenizer.Feed(text.data() + position, length, runs);
+				position += length;
+				AppendRuns(styles, runs);
+				runs.clear();
+				REQUIRE(styles.length() == tokenizer.Styled());
+				REQUIRE(tokenizer.Styled() + tokenizer.Pending() == position);
+				REQUIRE(reference.Styles().compare(0, styles.length(), styles) == 0);
+			}
+			REQUIRE(styles == reference.Styles());
+		}
+	}
+
+	SECTION("Flush") {
+		// Output pausing without a line end is styled as the last line of the text so far
+		const std::string text = OutputText(random, 100) + "\x1b[31mno line end\x1b[0";
+		Document reference;
+		StyleWhole(reference, text);
+		TerminalTokenizer tokenizer(&host);
+		std::vector<StyleRun> runs;
+		tokenizer.Feed(text.data(), text.length(), runs);
+		REQUIRE(tokenizer.Pending() > 0);
+		tokenizer.Flush(runs);
+		REQUIRE(tokenizer.Pending() == 0);
+		std::string styles;
+		AppendRuns(styles, runs);
+		REQUIRE(styles == reference.Styles());
+
+		// Reset starts again at offset 0 with no colour
+		tokenizer.Reset();
+		REQUIRE(tokenizer.Styled() == 0);
+		runs.clear();
+		tokenizer.Feed(text.data(), text.length(), runs);
+		tokenizer.Flush(runs);
+		styles.clear();
+		AppendRuns(styles, runs);
+		REQUIRE(styles == reference.Styles());
+	}
+}
+
+TEST_CASE("TerminalParallel") {
+
+	// Ranges of at least two parts of 0x100000 bytes are styled on worker threads
+	constexpr size_t partSize = 0x100000;
+	std::mt19937 random(6);
+
+	SECTION("SameAsOneThread") {
+		// Before each multiple of partSize a colour is set that lasts past the end of the part, so the next
+		// part starts with a colour it can not know and its lines are restyled up to the reset
+		std::string text;
+		for (size_t split = partSize; split < 5 * partSize; split += partSize) {
+			while (text.length() < split - 2000) {
+				text += OutputText(random, 10);
+			}
+			text += "\x1b[1;35mmagenta carried\n";
+			while (text.length() < split + 1000) {
+				text += "plain text\n";
+			}
+			text += "\x1b[0mreset\n";
+		}
+		text += OutputText(random, 100);
+		Document reference;
+		StyleWhole(reference, text);
+		for (size_t split = partSize; split < 5 * partSize; split += partSize) {
+			REQUIRE(reference.GetLineState(reference.GetLine(split)) != 0);
+		}
+		for (const int threads : { 2, 3, 8 }) {
+			Document doc;
+			SetProperties(doc);
+			doc.SetProperty("lexer.terminal.threads", threads);
+			doc.Append(text);
+			LexerTerminalStyle(0, doc.Length(), doc);
+			RequireSame(doc, reference);
+		}
+	}
+}
+
+TEST_CASE("TerminalLongLines") {
+
+	// Lines longer than longLineLimit, 0x10000, are read in chunks of that size from the start of the range and
+	// styled a piece at a time, which gives the styles of a line short enough to be styled whole
+	constexpr size_t chunkSize = 0x10000;
+	const std::string_view sequences = "\x1b[31mred\x1b[0m and \x1b[1;32mgreen\x1b[0m ";
+	const std::string_view value = "abcdefghij";
+
+	SECTION("SplitAcrossChunks") {
+		// Moving the lines by each offset up to the length of what is repeated puts the ends of chunks at every
+		// place in it, cutting each escape sequence
+		for (size_t shift = 1; shift <= sequences.length() + 1; shift++) {
+			INFO("shift " << shift);
+			std::string text;
+			std::string styles;
+			AppendLine(text, styles, Repeated(std::string(shift - 1, 'f'), "", 0, "\n"));
+			AppendLine(text, styles, Repeated("plain ", sequences, 200000 / sequences.length(), "\n"));
+			AppendLine(text, styles, Repeated("main.c:3:1: error: ", value, 15000, "\r\n"));
+			Document doc;
+			StyleWhole(doc, text);
+			REQUIRE(FirstDifference(doc.Styles(), styles) == styles.length());
+
+			// Styling again from the start of a long line puts the chunk ends elsewhere in it
+			const size_t lineStart = shift;
+			doc.ClearStyles(lineStart);
+			LexerTerminalStyle(lineStart, doc.Length() - lineStart, doc);
+			REQUIRE(FirstDifference(doc.Styles(), styles) == styles.length());
+		}
+	}
+
+	SECTION("CarriageReturnAtChunkEnd") {
+		// The '\r' of a "\r\n" and a lone '\r' each end a chunk, so whether the line ends there is only known
+		// from the next chunk
+		std::string text;
+		std::string styles;
+		// Short lines up to position
+		auto fillTo = [&](size_t position) {
+			while (text.length() < position) {
+				const size_t length = std::min<size_t>(position - text.length(), 1000);
+				AppendLine(text, styles, Repeated(std::string(length - 1, 'f'), "", 0, "\n"));
+			}
+		};
+		const RepeatedLine first = Repeated("plain ", sequences, (3 * chunkSize) / sequences.length(), "\r\n");
+		fillTo(4 * chunkSize - first.text.length() + 1);
+		AppendLine(text, styles, first);
+		REQUIRE(text[4 * chunkSize - 1] == '\r');
+		REQUIRE(text[4 * chunkSize] == '\n');
+		const RepeatedLine second = Repeated("", value, (3 * chunkSize) / value.length(), "\r");
+		fillTo(8 * chunkSize - second.text.length());
+		AppendLine(text, styles, second);
+		// Styled as a diagnostic only when the '\r' before it ended the long line
+		AppendLine(text, styles, Repeated("main.c:3:1: error: after", "", 0, "\n"));
+		REQUIRE(text[8 * chunkSize - 1] == '\r');
+		REQUIRE(text[8 * chunkSize] == 'm');
+		Document doc;
+		StyleWhole(doc, text);
+		REQUIRE(FirstDifference(doc.Styles(), styles) == styles.length());
+		// Each '\r' ends its line
+		REQUIRE(doc.GetLine(4 * chunkSize) == doc.GetLine(4 * chunkSize - 1));
+		REQUIRE(doc.GetLine(8 * chunkSize) == doc.GetLine(8 * chunkSize - 1) + 1);
+	}
+
+	SECTION("FinalLineWithoutEnd") {
+		for (const size_t length : { chunkSize + 1, 2 * chunkSize, 5 * chunkSize / 2 }) {
+			INFO("length " << length);
+			std::string text;
+			std::string styles;
+			AppendLine(text, styles, Repeated("plain", "", 0, "\n"));
+			// Ending with an escape sequence that is cut short
+			AppendLine(text, styles, Repeated("plain ", sequences, length / sequences.length(), "\x1b[3"));
+			Document doc;
+			StyleWhole(doc, text);
+			REQUIRE(FirstDifference(doc.Styles(), styles) == styles.length());
+		}
+	}
+}
+
+TEST_CASE("TerminalOverwritten") {
+
+	using Ranges = std::vector<std::pair<size_t, size_t>>;
+
+	SECTION("LoneCarriageReturn") {
+		// A line ended by '\r' alone is overwritten by the next, one ended by "\r\n" is not
+		const std::string text = "progress 10%\r\x1b[31mprogress 20%\rdone\r\nmain.c:3:1: error: x\n";
+		Document doc;
+		StyleWhole(doc, text);
+		REQUIRE(doc.Overwritten() == Ranges{ { 0, 13 }, { 13, 31 } });
+		REQUIRE(doc.Styles().substr(0, 31) == std::string(31, wxSTC_TERMINAL_OVERWRITTEN));
+		REQUIRE(doc.Styles()[31] != wxSTC_TERMINAL_OVERWRITTEN);
+		REQUIRE(doc.Styles()[text.find("\r\n")] != wxSTC_TERMINAL_OVERWRITTEN);
+		// Escape sequences of an overwritten line still set the colour of the lines after it
+		REQUIRE(doc.LineStates()[1] != 0);
+		REQUIRE(doc.LineStates()[2] == doc.LineStates()[1]);
+		const size_t diagnostic = text.find("main.c");
+		REQUIRE(doc.Styles().substr(diagnostic, 6) != std::string(6, wxSTC_TERMINAL_OVERWRITTEN));
+	}
+
+	SECTION("ChunkEnd") {
+		// Text is read in chunks of 0x10000 bytes so a '\r' ending one may be the first half of "\r\n"
+		constexpr size_t chunkSize = 0x10000;
+		for (const bool crlf : { false, true }) {
+			INFO("crlf " << crlf);
+			std::string text;
+			while (text.length() + 1000 < chunkSize) {
+				text += std::string(999, 'f') + "\n";
+			}
+			text += std::string(chunkSize - 1 - text.length(), 'p') + (crlf ? "\r\n" : "\rnext\n");
+			REQUIRE(text[chunkSize - 1] == '\r');
+			Document doc;
+			StyleWhole(doc, text);
+			const size_t lineStart = doc.LineStart(doc.GetLine(chunkSize - 1));
+			if (crlf) {
+				REQUIRE(doc.Overwritten().empty());
+				REQUIRE(doc.Styles()[chunkSize - 1] != wxSTC_TERMINAL_OVERWRITTEN);
+			} else {
+				REQUIRE(doc.Overwritten() == Ranges{ { lineStart, chunkSize } });
+				REQUIRE(doc.Styles()[chunkSize - 1] == wxSTC_TERMINAL_OVERWRITTEN);
+				REQUIRE(doc.Styles()[chunkSize] != wxSTC_TERMINAL_OVERWRITTEN);
+			}
+		}
+
+		// Output arriving in pieces that end with a '\r' is only overwritten once the next byte is not '\n'
+		Document doc;
+		SetProperties(doc);
+		TerminalStyler styler;
+		doc.Append("progress 50%\r");
+		styler.StyleTo(doc.Length(), doc);
+		REQUIRE(doc.Overwritten().empty());
+		REQUIRE(doc.Styles().back() != wxSTC_TERMINAL_OVERWRITTEN);
+		doc.Append("\nprogress 60%\r");
+		styler.StyleTo(doc.Length(), doc);
+		REQUIRE(doc.Overwritten().empty());
+		doc.Append("done\n");
+		styler.StyleTo(doc.Length(), doc);
+		REQUIRE(doc.Overwritten() == Ranges{ { 14, 27 } });
+	}
+
+	SECTION("Threads") {
+		// Lines styled on worker threads are reported in document order as on one thread
+		std::mt19937 random(50);
+		std::string text;
+		while (text.length() < 0x300000) {
+			text += OutputText(random, 1000);
+		}
+		Document reference;
+		StyleWhole(reference, text);
+		REQUIRE(reference.Overwritten().size() > 1000);
+		Document doc;
+		SetProperties(doc);
+		doc.SetProperty("lexer.terminal.threads", 3);
+		doc.Append(text);
+		LexerTerminalStyle(0, doc.Length(), doc);
+		REQUIRE(doc.Overwritten() == reference.Overwritten());
+		RequireSame(doc, reference);
+	}
+
+	SECTION("OffByDefault") {
+		const std::string text = "progress 10%\rprogress 20%\rdone\n";
+		Document doc;
+		doc.Append(text);
+		LexerTerminalStyle(0, doc.Length(), doc);
+		REQUIRE(doc.Overwritten().empty());
+		REQUIRE(doc.Styles().find(static_cast<char>(wxSTC_TERMINAL_OVERWRITTEN)) == std::string::npos);
+
+		// Through the lexer as an editor uses it
+		Scintilla::ILexer5 *lexer = static_cast<Scintilla::ILexer5 *>(CreateExtraLexerTerminal());
+		TestDocument document;
+		document.Set(text);
+		lexer->Lex(0, document.Length(), 0, &document);
+		for (Sci_Position position = 0; position < document.Length(); position++) {
+			REQUIRE(document.StyleAt(position) != wxSTC_TERMINAL_OVERWRITTEN);
+		}
+		lexer->PropertySet("lexer.terminal.overwritten.lines", "1");
+		lexer->Lex(0, document.Length(), 0, &document);
+		REQUIRE(document.StyleAt(0) == wxSTC_TERMINAL_OVERWRITTEN);
+		FreeExtraLexer(lexer);
+	}
+}
+
+TEST_CASE("TerminalStrip") {
+
+	SECTION("Sequences") {
+		// SGR sequences set the style of what follows them and are removed with OSC and incomplete sequences
+		Stripped stripped = Strip("\x1b[31mred\x1b[0m plain\n");
+		REQUIRE(stripped.text == "red plain\n");
+		RequireRuns(stripped.runs, { { 0, 3, wxSTC_TERMINAL_ES_RED }, { 3, 7, wxSTC_TERMINAL_DEFAULT } });
+
+		stripped = Strip("\x1b]0;title\x07text \x1b]8;;https://example.com\x07link\x1b]8;;\x07\n");
+		REQUIRE(stripped.text == "text link\n");
+		RequireRuns(stripped.runs, { { 0, 10, wxSTC_TERMINAL_DEFAULT } });
+
+		stripped = Strip("lone \x1b\nrest \x1b[3\xc3\xa9\ncut \x1b[31");
+		REQUIRE(stripped.text == "lone \nrest \xc3\xa9\ncut ");
+		RequireRuns(stripped.runs, { { 0, 18, wxSTC_TERMINAL_DEFAULT } });
+
+		stripped = Strip("");
+		REQUIRE(stripped.text.empty());
+		REQUIRE(stripped.runs.empty());
+	}
+
+	SECTION("Merge") {
+		// Runs made adjacent by removing a sequence are merged when their styles are the same
+		Stripped stripped = Strip("a\x1b[0mb\x1b[0mc\n");
+		REQUIRE(stripped.text == "abc\n");
+		RequireRuns(stripped.runs, { { 0, 4, wxSTC_TERMINAL_DEFAULT } });
+
+		stripped = Strip("\x1b[31mred\x1b[1m\x1b[31m more red\x1b[32mgreen\x1b[0m\n");
+		REQUIRE(stripped.text == "red more redgreen\n");
+		RequireRuns(stripped.runs, { { 0, 12, wxSTC_TERMINAL_ES_RED }, { 12, 5, wxSTC_TERMINAL_ES_GREEN },
+			{ 17, 1, wxSTC_TERMINAL_DEFAULT } });
+	}
+
+	SECTION("Capacity") {
+		// Runs past the capacity are counted but not written and the runs written are the first of all the runs
+		const std::string_view merged = "\x1b[31mred\x1b[1m\x1b[31m more red\x1b[32mgreen\n";
+		std::string mergedText(merged.length(), '\0');
+		StrippedRun run{};
+		const StrippedText result = LexerTerminalStrip(merged.data(), merged.length(), mergedText.data(), &run, 1);
+		REQUIRE(result.runs == 2);
+		// The last run written still grows when what follows it is merged into it
+		REQUIRE(SameRun(run, { 0, 12, wxSTC_TERMINAL_ES_RED }));
+
+		std::mt19937 random(54);
+		const std::string text = OutputText(random, 200);
+		const Stripped all = Strip(text);
+		REQUIRE(all.runs.size() > 10);
+		for (const size_t capacity : { size_t(0), size_t(1), size_t(2), size_t(7), all.runs.size() - 1 }) {
+			INFO("capacity " << capacity);
+			std::string strippedText(text.length(), '\0');
+			std::vector<StrippedRun> runs(capacity + 1, StrippedRun{ 999, 999, 999 });
+			const StrippedText result = LexerTerminalStrip(text.data(), text.length(), strippedText.data(),
+				runs.data(), capacity);
+			REQUIRE(result.runs == all.runsCounted);
+			REQUIRE(result.length == all.text.length());
+			REQUIRE(strippedText.substr(0, result.length) == all.text);
+			runs.pop_back();
+			RequireRuns(runs, std::vector<StrippedRun>(all.runs.begin(), all.runs.begin() + capacity));
+		}
+	}
+
+	SECTION("SameAsStyle") {
+		// The text left is what LexerTerminalStyle does not style as escape sequences, in runs of its styles
+		std::mt19937 random(55);
+		Host host;
+		SetProperties(host);
+		for (int repetition = 0; repetition < 20; repetition++) {
+			const std::string text = OutputText(random, 100);
+			Document reference;
+			StyleWhole(reference, text);
+			std::string expectedText;
+			std::vector<StrippedRun> expectedRuns;
+			for (size_t position = 0; position < text.length(); position++) {
+				const int style = static_cast<unsigned char>(reference.Styles()[position]);
+				if ((style == wxSTC_TERMINAL_ESCSEQ) || (style == wxSTC_TERMINAL_ESCSEQ_UNKNOWN)) {
+					continue;
+				}
+				if (!expectedRuns.empty() && (expectedRuns.back().style == style)) {
+					expectedRuns.back().length++;
+				} else {
+					expectedRuns.push_back({ expectedText.length(), 1, style });
+				}
+				expectedText += text[position];
+			}
+			const Stripped stripped = Strip(text, &host);
+			REQUIRE(stripped.text == expectedText);
+			RequireRuns(stripped.runs, expectedRuns);
+		}
+	}
+}
+
+TEST_CASE("TerminalFold") {
+
+	FoldingLexer lexer;
+	TestDocument doc;
+
+	SECTION("CommandOutput") {
+		// Output is folded under the command before it and output before any command is not folded
+		doc.Set("plain text\n> make\ngcc -c main.c\nlinking\n");
+		lexer.LexFold(doc, 0);
+		REQUIRE(Depth(doc, 0) == 0);
+		REQUIRE(!IsHeader(doc, 0));
+		REQUIRE(Depth(doc, 1) == 0);
+		REQUIRE(IsHeader(doc, 1));
+		REQUIRE(Depth(doc, 2) == 1);
+		REQUIRE(!IsHeader(doc, 2));
+		REQUIRE(Depth(doc, 3) == 1);
+		REQUIRE(!IsHeader(doc, 3));
+	}
+
+	SECTION("Diagnostic") {
+		// The include path, message and excerpt of a diagnostic are folded under its first line
+		doc.Set("> make\n"
+			"In file included from util.h:2,\n"
+			"                 from main.c:1:\n"
+			"util.h:3:5: error: unknown type name 'foo'\n"
+			"    3 |     foo x;\n"
+			"      |     ^~~\n"
+			"main.c:14:1: warning: unused variable 'x'\n"
+			"done\n");
+		lexer.LexFold(doc, 0);
+		REQUIRE(IsHeader(doc, 0));
+		REQUIRE(Depth(doc, 1) == 1);
+		REQUIRE(IsHeader(doc, 1));
+		for (Sci_Position line = 2; line <= 5; line++) {
+			INFO("line " << line);
+			REQUIRE(Depth(doc, line) == 2);
+			REQUIRE(!IsHeader(doc, line));
+		}
+		// A diagnostic with nothing under it starts no fold
+		REQUIRE(Depth(doc, 6) == 1);
+		REQUIRE(!IsHeader(doc, 6));
+		REQUIRE(Depth(doc, 7) == 1);
+
+		// Without an include path the message is the header of its excerpt
+		doc.Set("util.h:3:5: error: unknown type name 'foo'\n    3 |     foo x;\n      |     ^~~\nplain text\n");
+		lexer.LexFold(doc, 0);
+		REQUIRE(Depth(doc, 0) == 0);
+		REQUIRE(IsHeader(doc, 0));
+		REQUIRE(Depth(doc, 1) == 1);
+		REQUIRE(Depth(doc, 2) == 1);
+		REQUIRE(Depth(doc, 3) == 0);
+	}
+
+	SECTION("SecondCommand") {
+		// A command closes the fold of the command before it
+		doc.Set("> make\nbuilt\n> make test\npassed\n> true\n> make\n");
+		lexer.LexFold(doc, 0);
+		REQUIRE(IsHeader(doc, 0));
+		REQUIRE(Depth(doc, 1) == 1);
+		REQUIRE(!IsHeader(doc, 1));
+		REQUIRE(Depth(doc, 2) == 0);
+		REQUIRE(IsHeader(doc, 2));
+		REQUIRE(Depth(doc, 3) == 1);
+		// A command without output is not a header
+		REQUIRE(Depth(doc, 4) == 0);
+		REQUIRE(!IsHeader(doc, 4));
+		REQUIRE(Depth(doc, 5) == 0);
+	}
+
+	SECTION("Appended") {
+		// Folding only the lines appended since the last fold gives the levels and state of folding all of it
+		std::mt19937 random(39);
+		std::uniform_int_distribution<size_t> chooseLine(0, std::size(foldLines) - 1);
+		std::uniform_int_distribution<int> chooseLines(1, 5);
+		for (int repetition = 0; repetition < 20; repetition++) {
+			std::vector<size_t> lineEnds;
+			std::string text;
+			for (int line = 0; line < 80; line++) {
+				text += foldLines[chooseLine(random)];
+				text += "\n";
+				lineEnds.push_back(text.length());
+			}
+			TestDocument whole;
+			whole.Set(text);
+			lexer.LexFold(whole, 0);
+			const std::vector<int> levels = Levels(whole);
+
+			// Folding again some lines within already folded text changes nothing
+			std::uniform_int_distribution<size_t> chooseStart(0, lineEnds.size() - 2);
+			const size_t lineStart = chooseStart(random);
+			const size_t lineEnd = std::min(lineStart + chooseLines(random), lineEnds.size() - 1);
+			const Sci_Position refoldStart = whole.LineStart(lineStart);
+			lexer.Fold(whole, refoldStart, lineEnds[lineEnd - 1] - refoldStart);
+			REQUIRE(Levels(whole) == levels);
+
+			FoldingLexer lexerAppended;
+			Sci_Position start = 0;
+			for (size_t line = 0; line < lineEnds.size();) {
+				line = std::min(line + chooseLines(random), lineEnds.size());
+				doc.Set(std::string_view(text).substr(0, lineEnds[line - 1]));
+				lexerAppended.LexFold(doc, start);
+				start = doc.Length();
+			}
+			REQUIRE(Levels(doc) == levels);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+/** @file testLexTrace.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <string>
+#include <vector>
+
+#include "Sci_Position.h"
+
+#include "LexTrace.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+namespace {
+
+class RecordingSink : public TraceSink {
+public:
+	std::vector<std::string> events;
+	void Begin(const char *name, const char *detail, Sci_Position start, Sci_Position end) noexcept override {
+		events.push_back(std::string("+") + name + (detail ? std::string(":") + detail : std::string()) +
+			" " + std::to_string(start) + "-" + std::to_string(end));
+	}
+	void End(const char *name) noexcept override {
+		events.push_back(std::string("-") + name);
+	}
+};
+
+}
+
+// Test TraceScope and SetTraceSink.
+
+TEST_CASE("LexTrace") {
+
+	RecordingSink sink;
+
+	SECTION("NoSink") {
+		REQUIRE(CurrentTraceSink() == nullptr);
+		{
+			const TraceScope scope("Lex", "cpp", 0, 10);
+		}
+		REQUIRE(sink.events.empty());
+	}
+
+	SECTION("Nested") {
+		SetTraceSink(&sink);
+		REQUIRE(CurrentTraceSink() == &sink);
+		{
+			const TraceScope scopeLex("Lex", "cpp", 0, 10);
+			{
+				const TraceScope scopeFill("Fill", nullptr, 2, 8);
+			}
+		}
+		SetTraceSink(nullptr);
+		REQUIRE(sink.events == std::vector<std::string> { "+Lex:cpp 0-10", "+Fill 2-8", "-Fill", "-Lex" });
+	}
+
+	SECTION("RemovedDuringScope") {
+		SetTraceSink(&sink);
+		{
+			const TraceScope scope("Fold", "cpp", 5, 6);
+			SetTraceSink(nullptr);
+		}
+		// The scope still ends on the sink it began on
+		REQUIRE(sink.events == std::vector<std::string> { "+Fold:cpp 5-6", "-Fold" });
+	}
+}
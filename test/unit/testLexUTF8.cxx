@@ -0,0 +1,121 @@
+/** @file testLexUTF8.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "LexUTF8.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+namespace {
+
+int Width(std::string_view sv) {
+	return UTF8CharacterWidth(reinterpret_cast<const unsigned char *>(sv.data()), sv.length());
+}
+
+using Ranges = std::vector<std::pair<size_t, size_t>>;
+
+// Checks text split into pieces of pieceLength, returning the invalid runs found
+Ranges Invalid(std::string_view text, size_t pieceLength, UTF8Validator &validator) {
+	Ranges ranges;
+	for (size_t start = 0; start < text.length(); start += pieceLength) {
+		const std::string_view piece = text.substr(start, pieceLength);
+		const bool more = start + piece.length() < text.length();
+		validator.Check(piece, start, more, [&ranges](size_t s, size_t e) {
+			if (!ranges.empty() && (ranges.back().second == s)) {
+				ranges.back().second = e;
+			} else {
+				ranges.push_back({ s, e });
+			}
+		});
+	}
+	return ranges;
+}
+
+}
+
+// Test LexUTF8.
+
+TEST_CASE("LexUTF8") {
+
+	SECTION("SkipASCII") {
+		std::string text(100, 'a');
+		REQUIRE(SkipASCII(text.data(), text.data() + text.length()) == text.data() + text.length());
+		for (size_t position = 0; position < text.length(); position++) {
+			text[position] = '\xC3';
+			REQUIRE(SkipASCII(text.data(), text.data() + text.length()) == text.data() + position);
+			REQUIRE(SkipASCII(text.data() + position, text.data() + text.length()) == text.data() + position);
+			text[position] = 'a';
+		}
+		REQUIRE(SkipASCII(text.data(), text.data()) == text.data());
+	}
+
+	SECTION("Width") {
+		REQUIRE(Width("a") == 1);
+		REQUIRE(Width("\xC3\xA9") == 2);
+		REQUIRE(Width("\xE2\x82\xAC") == 3);
+		REQUIRE(Width("\xF0\x9F\x98\x80") == 4);
+		// Cut short
+		REQUIRE(Width("") == -1);
+		REQUIRE(Width("\xC3") == -1);
+		REQUIRE(Width("\xE2\x82") == -1);
+		REQUIRE(Width("\xF0\x9F\x98") == -1);
+		// Invalid
+		REQUIRE(Width("\x80") == 0);
+		REQUIRE(Width("\xC0\x80") == 0);
+		REQUIRE(Width("\xC3" "a") == 0);
+		REQUIRE(Width("\xE0\x80") == 0);		// Overlong, known from 2 bytes
+		REQUIRE(Width("\xED\xA0\x80") == 0);	// Surrogate
+		REQUIRE(Width("\xEF\xBF\xBE") == 0);	// U+FFFE
+		REQUIRE(Width("\xF0\x8F\xBF\xBF") == 0);	// Overlong
+		REQUIRE(Width("\xF4\x90\x80\x80") == 0);	// Beyond U+10FFFF
+		REQUIRE(Width("\xF0\x9F\xBF\xBF") == 0);	// U+1FFFF
+		REQUIRE(Width("\xF5\x80\x80\x80") == 0);
+	}
+
+	SECTION("Validator") {
+		const std::string text = "ascii \xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 bad \xC3\xC3 \x80\x80\x80 cut \xE2\x82";
+		const Ranges expected = { { 22, 24 }, { 25, 28 }, { 33, 35 } };
+		UTF8Validator whole;
+		REQUIRE(Invalid(text, text.length(), whole) == expected);
+		REQUIRE(!whole.ASCII());
+		REQUIRE(!whole.Valid());
+		REQUIRE(whole.Pending() == 0);
+		// The same runs whatever the pieces, with characters split between them
+		for (size_t pieceLength = 1; pieceLength < 20; pieceLength++) {
+			UTF8Validator validator;
+			REQUIRE(Invalid(text, pieceLength, validator) == expected);
+		}
+	}
+
+	SECTION("Pending") {
+		UTF8Validator validator;
+		size_t invalid = 0;
+		auto count = [&invalid](size_t start, size_t end) {
+			invalid += end - start;
+		};
+		validator.Check("x\xF0\x9F", 0, true, count);
+		REQUIRE(validator.Pending() == 2);
+		validator.Check("\x98", 3, true, count);
+		REQUIRE(validator.Pending() == 3);
+		validator.Check("\x80y", 4, false, count);
+		REQUIRE(validator.Pending() == 0);
+		REQUIRE(invalid == 0);
+		REQUIRE(validator.Valid());
+		REQUIRE(!validator.ASCII());
+		validator.Reset();
+		REQUIRE(validator.ASCII());
+		validator.Check("ab", 0, true, count);
+		REQUIRE(validator.ASCII());
+		REQUIRE(validator.Valid());
+	}
+}
@@ -3,14 +3,25 @@
  **/
 
 #include <cassert>
+#include <cstring>
 
 #include <string>
 #include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include "ILexer.h"
 #include "Scintilla.h"
 
 #include "PropSetSimple.h"
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexTrace.h"
+#include "LexInvalidation.h"
+#include "LexAccessor.h"
+#include "Accessor.h"
 #include "LexerModule.h"
 #include "LexerBase.h"
 #include "LexerSimple.h"
@@ -32,6 +43,171 @@ void ColouriseDocument(Sci_PositionU, Sci_Position, int, WordList *[], Accessor
 
 LexerModule lmSimpleExample(123456, ColouriseDocument, "simpleexample");
 
+const PropertyScope exampleScopes[] = {
+	{ "example.display", -1, Restyle::none, 0 },
+	{ "example.value", -1, Restyle::dependent, 0 },
+	{ nullptr, 0, Restyle::none, 0 },
+	{ nullptr, -1, Restyle::all, 0 },
+};
+
+LexerModule lmScopedExample(123458, ColouriseDocument, "scopedexample", nullptr, nullptr, nullptr, 0, exampleScopes);
+
+// Just enough of a document for lexing, whose text can be changed in place. It can be lent to the lexer
+// to read styles a range at a time and counts the calls made to read them
+class Document : public IDocumentStyleRange {
+	std::vector<Sci_Position> lineStarts;
+	Sci_Position endStyled = 0;
+public:
+	std::string text;
+	std::string styles;
+	std::vector<int> lineStates;
+	mutable int styleAtCalls = 0;
+	mutable int styleRangeCalls = 0;
+	explicit Document(std::string_view text_) : text(text_), styles(text.size(), '\0') {
+		lineStarts.push_back(0);
+		for (size_t i = 0; i < text.size(); i++) {
+			if (text[i] == '\n')
+				lineStarts.push_back(i + 1);
+		}
+		lineStates.resize(lineStarts.size());
+	}
+	int SCI_METHOD Version() const override { return Scintilla::dvRelease4; }
+	void SCI_METHOD SetErrorStatus(int) override {}
+	Sci_Position SCI_METHOD Length() const override { return text.size(); }
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		text.copy(buffer, lengthRetrieve, position);
+	}
+	char SCI_METHOD StyleAt(Sci_Position position) const override {
+		styleAtCalls++;
+		return styles.at(position);
+	}
+	void SCI_METHOD GetStyleRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		styleRangeCalls++;
+		styles.copy(buffer, lengthRetrieve, position);
+	}
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override {
+		return std::upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin() - 1;
+	}
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override {
+		return (line < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line] : text.size();
+	}
+	int SCI_METHOD GetLevel(Sci_Position) const override { return SC_FOLDLEVELBASE; }
+	int SCI_METHOD SetLevel(Sci_Position, int) override { return SC_FOLDLEVELBASE; }
+	int SCI_METHOD GetLineState(Sci_Position line) const override {
+		return (line < static_cast<Sci_Position>(lineStates.size())) ? lineStates[line] : 0;
+	}
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override {
+		if (line < static_cast<Sci_Position>(lineStates.size()))
+			lineStates[line] = state;
+		return 0;
+	}
+	void SCI_METHOD StartStyling(Sci_Position position) override { endStyled = position; }
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override {
+		styles.replace(endStyled, length, length, style);
+		endStyled += length;
+		return true;
+	}
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_) override {
+		styles.replace(endStyled, length, styles_, length);
+		endStyled += length;
+		return true;
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int) override {}
+	void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) override {}
+	void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) override {}
+	int SCI_METHOD CodePage() const override { return 65001; }
+	bool SCI_METHOD IsDBCSLeadByte(char) const override { return false; }
+	const char *SCI_METHOD BufferPointer() override { return text.c_str(); }
+	int SCI_METHOD GetLineIndentation(Sci_Position) override { return 0; }
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override {
+		return (line + 1 < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line + 1] - 1 : text.size();
+	}
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override {
+		return positionStart + characterOffset;
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		if (pWidth)
+			*pWidth = 1;
+		return static_cast<unsigned char>(text.at(position));
+	}
+};
+
+// The text from the start of the document to the end of the range, as the lexer saw it
+std::string textSeen;
+
+void ColouriseLookBehind(Sci_PositionU startPos, Sci_Position length, int, WordList *[], Accessor &styler) {
+	textSeen.clear();
+	for (Sci_Position position = 0; position < static_cast<Sci_Position>(startPos) + length; position++) {
+		textSeen.push_back(styler[position]);
+	}
+}
+
+LexerModule lmLookBehindExample(123462, ColouriseLookBehind, "lookbehindexample");
+
+// Styles each 'x' 1 and everything else 0
+void ColouriseX(Sci_PositionU startPos, Sci_Position length, int, WordList *[], Accessor &styler) {
+	styler.StartAt(startPos);
+	styler.StartSegment(startPos);
+	for (Sci_PositionU position = startPos; position < startPos + length; position++) {
+		styler.ColourTo(position, (styler[position] == 'x') ? 1 : 0);
+	}
+	styler.Flush();
+}
+
+LexerModule lmXExample(123463, ColouriseX, "xexample");
+
+// Where the last ColouriseLines stopped for its budget, and how long it waits before its first line
+Sci_Position stoppedAtSeen = -1;
+int delayMilliseconds = 0;
+
+// Styles each line 1 to 7 from the count of 'x' up to its end, carried in the line states, as lexers that
+// resume at any line start do, and stops once the budget is spent
+void ColouriseLines(Sci_PositionU startPos, Sci_Position length, int, WordList *[], Accessor &styler) {
+	const Sci_Position end = startPos + length;
+	Sci_Position line = styler.GetLine(startPos);
+	int count = (line > 0) ? styler.GetLineState(line - 1) : 0;
+	if (delayMilliseconds)
+		std::this_thread::sleep_for(std::chrono::milliseconds(delayMilliseconds));
+	styler.StartAt(startPos);
+	styler.StartSegment(startPos);
+	for (Sci_Position lineStart = startPos; lineStart < end; lineStart = styler.LineStart(++line)) {
+		if (styler.BudgetSpent(lineStart))
+			break;
+		const Sci_Position lineEnd = std::min(styler.LineStart(line + 1), end);
+		for (Sci_Position position = lineStart; position < lineEnd; position++) {
+			if (styler[position] == 'x')
+				count++;
+		}
+		styler.ColourTo(lineEnd - 1, 1 + count % 7);
+		styler.SetLineState(line, count);
+	}
+	styler.Flush();
+	stoppedAtSeen = styler.StoppedAt();
+}
+
+LexerModule lmLinesExample(123464, ColouriseLines, "linesexample");
+
+// Lines of different lengths and counts of 'x' up to at least length bytes
+std::string LinesText(size_t length) {
+	std::string text;
+	for (size_t line = 0; text.length() < length; line++) {
+		text += std::string(line % 13, 'a') + std::string(line % 5, 'x') + "\n";
+	}
+	return text;
+}
+
+// The first line start at or after position, where a budget ending at position stops
+Sci_Position LineStartAtOrAfter(const Document &document, Sci_Position position) {
+	const Sci_Position line = document.LineFromPosition(position);
+	return (document.LineStart(line) == position) ? position : document.LineStart(line + 1);
+}
+
+// The part of the text that has been styled, as the document starts unstyled and lines are styled 1 to 7
+Sci_Position StyledLength(const Document &document) {
+	const size_t unstyled = document.styles.find('\0');
+	return (unstyled == std::string::npos) ? document.Length() : unstyled;
+}
+
 }
 
 TEST_CASE("LexerNoExceptions") {
@@ -63,4 +239,285 @@ TEST_CASE("LexerNoExceptions") {
 		REQUIRE_THAT(propertyValue, Catch::Matchers::Equals(value));
 	}
 
+	SECTION("Scopes") {
+		LexerSimple lexSimple(&lmScopedExample);
+		// Undeclared properties restyle everything
+		REQUIRE(lexSimple.PropertySet(propertyName, propertyValue) == 0);
+		REQUIRE(lexSimple.PropertySet("example.display", "1") == -1);
+		// Nothing lexed depends on the value
+		REQUIRE(lexSimple.PropertySet("example.value", "1") == -1);
+		// Properties read by lexlib that do not change styles
+		REQUIRE(lexSimple.PropertySet("lexer.budget.bytes", "1000") == -1);
+		REQUIRE(lexSimple.PropertySet("lexer.locations", "1") == 0);
+		REQUIRE(lexSimple.WordListSet(0, "if else") == -1);
+		REQUIRE(lexSimple.WordListSet(1, "int") == 0);
+		REQUIRE(LexerSimple(&lmSimpleExample).WordListSet(0, "if") == 0);
+	}
+
+	SECTION("Counters") {
+		LexerSimple lexSimple(&lmSimpleExample);
+		LexCounters counters;
+		void *result = lexSimple.PrivateCall(privateCallLexCounters, &counters);
+#if defined(LEXILLA_COUNTERS)
+		REQUIRE(result == &counters);
+#else
+		REQUIRE(result == nullptr);
+#endif
+		REQUIRE(counters.fills == 0);
+		REQUIRE(lexSimple.PrivateCall(0, nullptr) == nullptr);
+	}
+
+	SECTION("Memory") {
+		LexerSimple lexSimple(&lmSimpleExample);
+		REQUIRE(lexSimple.PrivateCall(privateCallLexMemory, nullptr) == nullptr);
+		LexMemory memory;
+		REQUIRE(lexSimple.PrivateCall(privateCallLexMemory, &memory) == &memory);
+		REQUIRE(memory.lexer >= sizeof(LexerSimple));
+		REQUIRE(memory.wordLists > 0);
+		const size_t total = memory.Total();
+		lexSimple.PropertySet(propertyName, propertyValue);
+		lexSimple.PrivateCall(privateCallLexMemory, &memory);
+		REQUIRE(memory.properties > 0);
+		REQUIRE(memory.Total() > total);
+	}
+
+	SECTION("EditBeforeStart") {
+		LexerSimple lexSimple(&lmLookBehindExample);
+		// Not read from the buffer directly so the accessor buffers the text
+		lexSimple.PropertySet("lexer.buffer.direct", "0");
+		Document document("abcd\nefgh\nijkl\n");
+		lexSimple.Lex(0, document.Length(), 0, &document);
+		REQUIRE(textSeen == document.text);
+		// Edit the first line then lex only from the second, as after an edit that was not lexed
+		document.text[1] = 'X';
+		lexSimple.Lex(5, document.Length() - 5, 0, &document);
+		REQUIRE(textSeen == document.text);
+		// Text inserted before the start changes the length and moves everything after it
+		document.text.insert(2, "inserted ");
+		lexSimple.Lex(5, document.Length() - 5, 0, &document);
+		REQUIRE(textSeen == document.text);
+		document.text.erase(0, 12);
+		lexSimple.Lex(2, document.Length() - 2, 0, &document);
+		REQUIRE(textSeen == document.text);
+		// Another document at the same address with different text
+		document.text = "mnop\nqrst\nuvwx\n";
+		lexSimple.Lex(10, document.Length() - 10, 0, &document);
+		REQUIRE(textSeen == document.text);
+	}
+
+	SECTION("StylesCompare") {
+		for (const bool lend : { false, true }) {
+			LexerSimple lexSimple(&lmXExample);
+			lexSimple.PropertySet("lexer.styles.compare", "1");
+			// Longer than the blocks compared at once
+			std::string text(5000, 'a');
+			text[10] = 'x';
+			Document document(text);
+			// The document is lent again for each Lex as it only applies to the next one
+			auto lex = [&](Sci_PositionU start, Sci_Position length) {
+				if (lend) {
+					REQUIRE(lexSimple.PrivateCall(privateCallStyleRange, static_cast<IDocumentStyleRange *>(&document)));
+				}
+				lexSimple.Lex(start, length, 0, &document);
+			};
+			lex(0, document.Length());
+			Sci_Position start = 0;
+			Sci_Position end = 0;
+			REQUIRE(lexSimple.LastChangedRange(start, end));
+			REQUIRE(start == 10);
+			REQUIRE(end == 11);
+			REQUIRE(document.styles[10] == 1);
+			// Nothing changed
+			lex(0, document.Length());
+			REQUIRE(!lexSimple.LastChangedRange(start, end));
+			// Changes in different blocks
+			document.text[1500] = 'x';
+			document.text[3999] = 'x';
+			document.text[10] = 'a';
+			lex(0, document.Length());
+			REQUIRE(lexSimple.LastChangedRange(start, end));
+			REQUIRE(start == 10);
+			REQUIRE(end == 4000);
+			std::string expected(5000, '\0');
+			expected[1500] = 1;
+			expected[3999] = 1;
+			REQUIRE(document.styles == expected);
+			// A change at the very end
+			document.text[4999] = 'x';
+			lex(4000, 1000);
+			REQUIRE(lexSimple.LastChangedRange(start, end));
+			REQUIRE(start == 4999);
+			REQUIRE(end == 5000);
+			// The styles were read through the document lent, a block at a time
+			if (lend) {
+				REQUIRE(document.styleAtCalls == 0);
+				REQUIRE(document.styleRangeCalls > 0);
+			} else {
+				REQUIRE(document.styleRangeCalls == 0);
+				REQUIRE(document.styleAtCalls > 0);
+			}
+		}
+	}
+
+	SECTION("StyleRangeLent") {
+		LexerSimple lexSimple(&lmXExample);
+		lexSimple.PropertySet("lexer.styles.compare", "1");
+		Document document("axa\naax\n");
+		Document other("xxx\n");
+		REQUIRE(lexSimple.PrivateCall(privateCallStyleRange, static_cast<IDocumentStyleRange *>(&document)));
+		lexSimple.Lex(0, document.Length(), 0, &document);
+		REQUIRE(document.styleRangeCalls > 0);
+		REQUIRE(document.styleAtCalls == 0);
+		// Only lent for one Lex
+		document.styleRangeCalls = 0;
+		lexSimple.Lex(0, document.Length(), 0, &document);
+		REQUIRE(document.styleRangeCalls == 0);
+		REQUIRE(document.styleAtCalls > 0);
+		// Not used for a different document
+		REQUIRE(lexSimple.PrivateCall(privateCallStyleRange, static_cast<IDocumentStyleRange *>(&document)));
+		lexSimple.Lex(0, other.Length(), 0, &other);
+		REQUIRE(document.styleRangeCalls == 0);
+		REQUIRE(other.styleRangeCalls == 0);
+		REQUIRE(other.styles == std::string(3, '\1') + '\0');
+		// Without lexer.styles.compare everything is written and no range is reported
+		lexSimple.PropertySet("lexer.styles.compare", "0");
+		document.text[0] = 'x';
+		lexSimple.Lex(0, document.Length(), 0, &document);
+		Sci_Position start = 0;
+		Sci_Position end = 0;
+		REQUIRE(!lexSimple.LastChangedRange(start, end));
+		REQUIRE(document.styles[0] == 1);
+	}
+
+	SECTION("Reset") {
+		LexerSimple lexSimple(&lmSimpleExample);
+		lexSimple.PropertySet(propertyName, propertyValue);
+		lexSimple.Reset();
+		REQUIRE_THAT(lexSimple.PropertyGet(propertyName), Catch::Matchers::Equals(""));
+		REQUIRE(lexSimple.PropertySet(propertyName, "8") == 0);
+	}
+
+	SECTION("Pool") {
+		Scintilla::ILexer5 *lexer = lmSimpleExample.Create();
+		REQUIRE(lexer->GetIdentifier() == 123456);
+		lexer->PropertySet(propertyName, propertyValue);
+		lexer->Release();
+		// The released lexer is handed out again without its settings
+		Scintilla::ILexer5 *lexerAgain = lmSimpleExample.Create();
+		REQUIRE(lexerAgain == lexer);
+		REQUIRE_THAT(lexerAgain->PropertyGet(propertyName), Catch::Matchers::Equals(""));
+		Scintilla::ILexer5 *lexerOther = lmSimpleExample.Create();
+		REQUIRE(lexerOther != lexerAgain);
+		lexerOther->Release();
+		lexerAgain->Release();
+	}
+
+	SECTION("PoolMemory") {
+		// A lexer holding long property values is not kept idle in the pool
+		Scintilla::ILexer5 *lexer = lmSimpleExample.Create();
+		lexer->PropertySet(propertyName, std::string(200000, '1').c_str());
+		lexer->Release();
+		Scintilla::ILexer5 *lexerAgain = lmSimpleExample.Create();
+		LexMemory memory;
+		REQUIRE(lexerAgain->PrivateCall(privateCallLexMemory, &memory) == &memory);
+		REQUIRE(memory.Total() < 200000);
+		lexerAgain->Release();
+	}
+
+}
+
+TEST_CASE("LexerBudget") {
+
+	const std::string text = LinesText(2000);
+	delayMilliseconds = 0;
+
+	SECTION("BytesStopAtLineStart") {
+		for (const Sci_Position bytes : { 2, 10, 99, 100, 700 }) {
+			INFO("bytes " << bytes);
+			LexerSimple lexSimple(&lmLinesExample);
+			Document document(text);
+			const Sci_Position end = lexSimple.LexBudgeted(0, document.Length(), 0, &document, bytes, 0);
+			REQUIRE(end == LineStartAtOrAfter(document, bytes));
+			REQUIRE(end < document.Length());
+			REQUIRE(stoppedAtSeen == end);
+			REQUIRE(StyledLength(document) == end);
+		}
+		// The budget is counted from the start of the range
+		LexerSimple lexSimple(&lmLinesExample);
+		Document document(text);
+		const Sci_Position start = document.LineStart(20);
+		const Sci_Position end = lexSimple.LexBudgeted(start, document.Length() - start, 0, &document, 50, 0);
+		REQUIRE(end == LineStartAtOrAfter(document, start + 50));
+		REQUIRE(stoppedAtSeen == end);
+	}
+
+	SECTION("AtLeastOneLine") {
+		// A budget smaller than the first line still styles that line
+		LexerSimple lexSimple(&lmLinesExample);
+		Document document(text);
+		const Sci_Position start = document.LineStart(12);
+		REQUIRE(lexSimple.LexBudgeted(start, document.Length() - start, 0, &document, 1, 0) == document.LineStart(13));
+		REQUIRE(stoppedAtSeen == document.LineStart(13));
+		// No budget styles everything
+		REQUIRE(lexSimple.LexBudgeted(0, document.Length(), 0, &document, 0, 0) == document.Length());
+		REQUIRE(stoppedAtSeen == -1);
+		REQUIRE(StyledLength(document) == document.Length());
+	}
+
+	SECTION("Resume") {
+		// Resuming from where each call stopped gives the styles and line states of styling in one call
+		LexerSimple lexSimple(&lmLinesExample);
+		Document whole(text);
+		lexSimple.Lex(0, whole.Length(), 0, &whole);
+		REQUIRE(StyledLength(whole) == whole.Length());
+		for (const Sci_Position bytes : { 1, 37, 300 }) {
+			INFO("bytes " << bytes);
+			Document document(text);
+			Sci_Position position = 0;
+			while (position < document.Length()) {
+				const Sci_Position end = lexSimple.LexBudgeted(position, document.Length() - position, 0, &document, bytes, 0);
+				REQUIRE(end > position);
+				REQUIRE(StyledLength(document) == end);
+				position = end;
+			}
+			REQUIRE(document.styles == whole.styles);
+			REQUIRE(document.lineStates == whole.lineStates);
+		}
+	}
+
+	SECTION("Milliseconds") {
+		// Time is checked every 64K bytes so a lexer slower than the budget stops at the first check
+		const std::string textLong = LinesText(0x30000);
+		LexerSimple lexSimple(&lmLinesExample);
+		Document document(textLong);
+		delayMilliseconds = 5;
+		const Sci_Position end = lexSimple.LexBudgeted(0, document.Length(), 0, &document, 0, 1);
+		delayMilliseconds = 0;
+		REQUIRE(end == LineStartAtOrAfter(document, 0x10000));
+		REQUIRE(stoppedAtSeen == end);
+		REQUIRE(lexSimple.LexBudgeted(end, document.Length() - end, 0, &document, 0, 1000) == document.Length());
+	}
+
+	SECTION("Properties") {
+		// Lex takes its budget from lexer.budget.bytes and lexer.budget.milliseconds
+		LexerSimple lexSimple(&lmLinesExample);
+		Document document(LinesText(0x30000));
+		REQUIRE(lexSimple.PropertySet("lexer.budget.bytes", "100") == -1);
+		lexSimple.Lex(0, document.Length(), 0, &document);
+		REQUIRE(stoppedAtSeen == LineStartAtOrAfter(document, 100));
+		REQUIRE(StyledLength(document) == stoppedAtSeen);
+
+		lexSimple.PropertySet("lexer.budget.bytes", "0");
+		lexSimple.PropertySet("lexer.budget.milliseconds", "1");
+		Document documentTimed(LinesText(0x30000));
+		delayMilliseconds = 5;
+		lexSimple.Lex(0, documentTimed.Length(), 0, &documentTimed);
+		delayMilliseconds = 0;
+		REQUIRE(stoppedAtSeen == LineStartAtOrAfter(documentTimed, 0x10000));
+
+		lexSimple.PropertySet("lexer.budget.milliseconds", "0");
+		lexSimple.Lex(0, documentTimed.Length(), 0, &documentTimed);
+		REQUIRE(stoppedAtSeen == -1);
+		REQUIRE(StyledLength(documentTimed) == documentTimed.Length());
+	}
 }
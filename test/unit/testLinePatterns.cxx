@@ -0,0 +1,108 @@
+/** @file testLinePatterns.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LinePatterns.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test LinePatterns.
+
+TEST_CASE("LinePatterns") {
+
+	LinePatterns patterns;
+	LinePatternMatch match;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(patterns.Empty());
+		REQUIRE(!patterns.Match("src/a.c:1: error", match));
+	}
+
+	SECTION("Invalid") {
+		REQUIRE(!patterns.Add(""));
+		REQUIRE(!patterns.Add("2"));
+		REQUIRE(!patterns.Add("2 "));
+		REQUIRE(!patterns.Add("x %f:%l"));
+		REQUIRE(!patterns.Add("256 %f:%l"));
+		REQUIRE(!patterns.Add("2 %f%l"));
+		REQUIRE(!patterns.Add("2 %*%m"));
+		REQUIRE(!patterns.Add("2 %m:"));
+		REQUIRE(!patterns.Add("2 %q"));
+		REQUIRE(!patterns.Add("2 100%"));
+		REQUIRE(patterns.Empty());
+	}
+
+	SECTION("Captures") {
+		REQUIRE(patterns.Add("2 E %f(%l,%c): %m"));
+		const std::string_view line = "E ../x/y.cpp(42,7): something broke\n";
+		REQUIRE(patterns.Match(line, match));
+		REQUIRE(match.style == 2);
+		REQUIRE(line.substr(match.pathStart, match.pathEnd - match.pathStart) == "../x/y.cpp");
+		REQUIRE(match.lineNumber == 42);
+		REQUIRE(match.column == 7);
+		REQUIRE(line.substr(match.messageStart) == "something broke\n");
+		// Anchored at the start of the line
+		REQUIRE(!patterns.Match("> E a.cpp(1,1): x", match));
+		REQUIRE(!patterns.Match("E a.cpp(x,1): x", match));
+	}
+
+	SECTION("Backtrack") {
+		REQUIRE(patterns.Add("56 %f:%l: %m"));
+		// The shortest path "C" is not followed by a line number, so a longer one is tried
+		const std::string_view line = "C:\\src\\a.c:12: warning: unused";
+		REQUIRE(patterns.Match(line, match));
+		REQUIRE(line.substr(match.pathStart, match.pathEnd - match.pathStart) == "C:\\src\\a.c");
+		REQUIRE(match.lineNumber == 12);
+		REQUIRE(match.column == 0);
+	}
+
+	SECTION("PathToLineEnd") {
+		REQUIRE(patterns.Add("3 Compiling %f"));
+		const std::string_view line = "Compiling src/main.rs\r\n";
+		REQUIRE(patterns.Match(line, match));
+		REQUIRE(line.substr(match.pathStart, match.pathEnd - match.pathStart) == "src/main.rs");
+		REQUIRE(match.messageStart == -1);
+		REQUIRE(!patterns.Match("Compiling \n", match));
+	}
+
+	SECTION("Order") {
+		REQUIRE(patterns.Add("2 %*: error %m"));
+		REQUIRE(patterns.Add("56 %*: %m"));
+		REQUIRE(patterns.Add("9 100%% %m"));
+		REQUIRE(patterns.Count() == 3);
+		REQUIRE(patterns.Match("tool: error bad", match));
+		REQUIRE(match.style == 2);
+		REQUIRE(patterns.Match("tool: fine", match));
+		REQUIRE(match.style == 56);
+		REQUIRE(patterns.Match("100% done", match));
+		REQUIRE(match.style == 9);
+		REQUIRE(!patterns.Match("100 done", match));
+	}
+
+	SECTION("Clear") {
+		REQUIRE(patterns.Add("2 x%m"));
+		patterns.Clear();
+		REQUIRE(patterns.Empty());
+		REQUIRE(!patterns.Match("xyz", match));
+	}
+
+	SECTION("Limit") {
+		for (size_t i = 0; i < LinePatterns::maxPatterns; i++) {
+			REQUIRE(patterns.Add("1 " + std::to_string(i) + ":%m"));
+		}
+		REQUIRE(!patterns.Add("1 z%m"));
+		REQUIRE(patterns.Match("31:x", match));
+		// Many places a path could end are not all tried
+		LinePatterns slow;
+		REQUIRE(slow.Add("2 %f:%f:%f:%l"));
+		REQUIRE(!slow.Match(std::string(2000, ':'), match));
+	}
+}
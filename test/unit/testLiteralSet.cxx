@@ -0,0 +1,55 @@
+/** @file testLiteralSet.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+
+#include "LiteralSet.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test LiteralSet.
+
+TEST_CASE("LiteralSet") {
+
+	const LiteralSet literals({"<", "<<", "<<=", "=", "==", "!=", "\xc3\xa9t\xc3\xa9"});
+
+	SECTION("Properties") {
+		REQUIRE(literals.MaxLength() == 5);
+		REQUIRE(literals.Length(2) == 3);
+		REQUIRE(literals.Literal(5) == "!=");
+	}
+
+	SECTION("Longest") {
+		REQUIRE(literals.Match("<<= 1", 5) == 2);
+		REQUIRE(literals.Match("<< 1", 4) == 1);
+		REQUIRE(literals.Match("< 1", 3) == 0);
+		REQUIRE(literals.Match("==", 2) == 4);
+		REQUIRE(literals.Match("=!", 2) == 3);
+	}
+
+	SECTION("Length") {
+		// Only length bytes are examined
+		REQUIRE(literals.Match("<<=", 2) == 1);
+		REQUIRE(literals.Match("!=", 1) == -1);
+		REQUIRE(literals.Match("<", 0) == -1);
+	}
+
+	SECTION("None") {
+		REQUIRE(literals.Match("abc", 3) == -1);
+		REQUIRE(literals.Match("!", 1) == -1);
+	}
+
+	SECTION("HighBytes") {
+		REQUIRE(literals.Match("\xc3\xa9t\xc3\xa9 ", 6) == 6);
+		REQUIRE(literals.Match("\xc3\xa9t", 3) == -1);
+	}
+}
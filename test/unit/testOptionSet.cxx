@@ -3,10 +3,14 @@
  ** Tests OptionSet.
  **/
 
+#include <cassert>
+#include <cstring>
+
 #include <string>
 #include <string_view>
 #include <vector>
 #include <map>
+#include <algorithm>
 
 #include "Scintilla.h"
 
@@ -21,10 +25,13 @@ using namespace Lexilla;
 namespace {
 
 // Simple example options structure with each type: string, bool, int
+enum class Mode { none, some, all };
+
 struct Options {
 	std::string so;
 	bool bo = false;
 	int io = 0;
+	Mode mo = Mode::none;
 };
 
 const char *const denseWordLists[] = {
@@ -124,3 +131,56 @@ TEST_CASE("OptionSet") {
 			Equals("\n\nKeywords 1\n\nKeywords 2"));
 	}
 }
+
+TEST_CASE("OptionSetTable") {
+
+	static const OptionSet<Options>::Table table({
+		{ "string.option", &Options::so, "StringOption" },
+		{ "bool.option", &Options::bo, "BoolOption" },
+		{ "int.option", &Options::io, "IntOption" },
+		{ "enum.option", &Options::mo, "EnumOption" },
+	}, denseWordLists);
+
+	OptionSet<Options> os(table);
+	Options options;
+
+	SECTION("Define") {
+		REQUIRE_THAT(os.PropertyNames(), Equals("string.option\nbool.option\nint.option\nenum.option"));
+		REQUIRE(SC_TYPE_STRING == os.PropertyType("string.option"));
+		REQUIRE(SC_TYPE_BOOLEAN == os.PropertyType("bool.option"));
+		REQUIRE(SC_TYPE_INTEGER == os.PropertyType("int.option"));
+		REQUIRE(SC_TYPE_INTEGER == os.PropertyType("enum.option"));
+		REQUIRE_THAT(os.DescribeProperty("int.option"), Equals("IntOption"));
+		REQUIRE_THAT(os.DescribeProperty("missing"), Equals(""));
+		REQUIRE_THAT(os.PropertyGet("bool.option"), Equals(""));
+		REQUIRE_FALSE(os.PropertyGet("missing"));
+		REQUIRE_THAT(os.DescribeWordListSets(),
+			Equals("Keywords 1\nKeywords 2\nKeywords 3\nKeywords 4"));
+	}
+
+	SECTION("Set") {
+		REQUIRE_FALSE(os.PropertySet(&options, "missing", "1"));
+		REQUIRE(os.PropertySet(&options, "string.option", "string"));
+		REQUIRE(options.so == "string");
+		REQUIRE_FALSE(os.PropertySet(&options, "string.option", "string"));
+		REQUIRE(os.PropertySet(&options, "bool.option", "1"));
+		REQUIRE(options.bo);
+		REQUIRE(os.PropertySet(&options, "int.option", "3"));
+		REQUIRE(options.io == 3);
+		REQUIRE(os.PropertySet(&options, "enum.option", "2"));
+		REQUIRE(options.mo == Mode::all);
+		REQUIRE_THAT(os.PropertyGet("int.option"), Equals("3"));
+		REQUIRE_THAT(os.PropertyGet("bool.option"), Equals("1"));
+
+		// Values are held by each OptionSet, not the table
+		OptionSet<Options> os2(table);
+		REQUIRE_THAT(os2.PropertyGet("int.option"), Equals(""));
+	}
+
+	SECTION("MemoryUse") {
+		// Nothing is allocated for an instance until an option is set
+		REQUIRE(os.MemoryUse() == 0);
+		os.PropertySet(&options, "int.option", "3");
+		REQUIRE(os.MemoryUse() >= 4 * sizeof(std::string));
+	}
+}
@@ -46,4 +46,60 @@ TEST_CASE("PropSetSimple") {
 		REQUIRE(1 == value);
 	}
 
+	SECTION("GetIntFromKey") {
+		const PropertyKey key(propertyName);
+		const PropertyKey keyOther("fold");
+		REQUIRE(key.Index() != keyOther.Index());
+		PropSetSimple pss;
+		const size_t empty = pss.MemoryUse();
+		REQUIRE(0 == pss.GetInt(key));
+		REQUIRE(3 == pss.GetInt(key, 3));
+		// Reading a key that is not set does not make it visible or add to the set
+		REQUIRE_THAT(pss.Get(propertyName), Catch::Matchers::Equals(""));
+		REQUIRE(pss.MemoryUse() == empty);
+		pss.Set(propertyName, propertyValue);
+		REQUIRE(1 == pss.GetInt(key));
+		REQUIRE(1 == pss.GetInt(propertyName));
+		pss.Set(propertyName, "12");
+		REQUIRE(12 == pss.GetInt(key));
+		REQUIRE(12 == pss.GetInt(propertyName));
+		pss.Set(propertyName, "");
+		REQUIRE(5 == pss.GetInt(key, 5));
+		// The same key is independent in each set
+		PropSetSimple pssOther;
+		pssOther.Set(propertyName, "7");
+		REQUIRE(7 == pssOther.GetInt(key));
+		REQUIRE(0 == pss.GetInt(key));
+		REQUIRE(0 == pss.GetInt(keyOther));
+		// A key declared after its property was set
+		pssOther.Set("lexer.declared.late", "8");
+		const PropertyKey keyLate("lexer.declared.late");
+		REQUIRE(8 == pssOther.GetInt(keyLate));
+		pssOther.Set("lexer.declared.late", "9");
+		REQUIRE(9 == pssOther.GetInt(keyLate));
+	}
+
+	SECTION("Clear") {
+		const PropertyKey key(propertyName);
+		PropSetSimple pss;
+		pss.Set(propertyName, "4");
+		REQUIRE(4 == pss.GetInt(key));
+		pss.Clear();
+		REQUIRE_THAT(pss.Get(propertyName), Catch::Matchers::Equals(""));
+		REQUIRE(0 == pss.GetInt(propertyName));
+		REQUIRE(2 == pss.GetInt(key, 2));
+		pss.Set(propertyName, "9");
+		REQUIRE(9 == pss.GetInt(key));
+	}
+
+	SECTION("MemoryUse") {
+		PropSetSimple pss;
+		const size_t empty = pss.MemoryUse();
+		pss.Set(propertyName, propertyValue);
+		const size_t one = pss.MemoryUse();
+		REQUIRE(one > empty);
+		pss.Set("lexer.some.other.property.long.enough.to.need.the.heap", propertyValue);
+		REQUIRE(pss.MemoryUse() > one);
+	}
+
 }
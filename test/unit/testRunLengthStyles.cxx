@@ -0,0 +1,155 @@
+/** @file testRunLengthStyles.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "ExtraLexers.h"
+
+#include "catch.hpp"
+
+// Test RunLengthStyles.
+
+namespace {
+
+// Styles [start, start + length) of styles with style, as RunLengthStyles does
+void SetStyles(std::string &styles, size_t start, const StyleRun *runs, size_t count) {
+	styles.resize(start, '\0');
+	for (size_t i = 0; i < count; i++) {
+		styles.append(runs[i].length, static_cast<char>(runs[i].style));
+	}
+}
+
+void RequireSame(const RunLengthStyles &runs, const std::string &styles) {
+	REQUIRE(runs.Length() == styles.length());
+	for (size_t position = 0; position < styles.length(); position++) {
+		REQUIRE(runs.StyleAt(position) == static_cast<unsigned char>(styles[position]));
+	}
+	REQUIRE(runs.StyleAt(styles.length()) == 0);
+	// The runs cover the styles, each differing from the one before it
+	size_t start = 0;
+	for (size_t index = 0; index < runs.Count(); index++) {
+		const RunLengthStyles::Run run = runs.At(index);
+		REQUIRE(run.end > start);
+		REQUIRE(runs.RunIndex(start) == index);
+		REQUIRE(runs.RunIndex(run.end - 1) == index);
+		REQUIRE(run.style == static_cast<unsigned char>(styles[start]));
+		if (index > 0) {
+			REQUIRE(run.style != static_cast<unsigned char>(styles[start - 1]));
+		}
+		start = run.end;
+	}
+	REQUIRE(start == styles.length());
+}
+
+}
+
+TEST_CASE("RunLengthStyles") {
+
+	RunLengthStyles runs;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(runs.Count() == 0);
+		REQUIRE(runs.Length() == 0);
+		REQUIRE(runs.StyleAt(0) == 0);
+		REQUIRE(runs.RunIndex(0) == 0);
+	}
+
+	SECTION("Merge") {
+		const StyleRun styled[] = { { 3, 1 }, { 2, 1 }, { 4, 2 } };
+		runs.SetStyleRuns(0, styled, 3);
+		REQUIRE(runs.Count() == 2);
+		REQUIRE(runs.At(0).end == 5);
+		REQUIRE(runs.At(1).end == 9);
+		// A gap is styled 0
+		const StyleRun more[] = { { 1, 2 } };
+		runs.SetStyleRuns(12, more, 1);
+		REQUIRE(runs.Count() == 4);
+		REQUIRE(runs.StyleAt(10) == 0);
+		REQUIRE(runs.StyleAt(12) == 2);
+	}
+
+	SECTION("LongRuns") {
+		// Lengths taking several bytes, growing as runs of the same style are appended
+		std::string styles;
+		for (size_t i = 0; i < 40; i++) {
+			const StyleRun run[] = { { 1000 + i * 997, static_cast<int>(i % 3) }, { 1, 7 } };
+			const size_t start = (i % 5 == 0) ? styles.length() + 2 : styles.length();
+			runs.SetStyleRuns(start, run, 2);
+			SetStyles(styles, start, run, 2);
+		}
+		const StyleRun big[] = { { 0x300000, 7 } };
+		runs.SetStyleRuns(styles.length(), big, 1);
+		SetStyles(styles, styles.length(), big, 1);
+		RequireSame(runs, styles);
+		REQUIRE(!runs.Flat());
+		REQUIRE(runs.MemoryUse() < styles.length() / 100);
+	}
+
+	SECTION("Truncate") {
+		std::string styles;
+		for (size_t i = 0; i < 500; i++) {
+			const StyleRun run[] = { { 1 + i % 7, static_cast<int>(i % 4) } };
+			runs.SetStyleRuns(styles.length(), run, 1);
+			SetStyles(styles, styles.length(), run, 1);
+		}
+		RequireSame(runs, styles);
+		// Within a run, at the start of one and where the styles end
+		for (const size_t position : { styles.length() - 1, styles.length() / 2, size_t(700), size_t(64), size_t(1) }) {
+			runs.Truncate(position);
+			styles.resize(position);
+			RequireSame(runs, styles);
+			const StyleRun run[] = { { 5, 3 }, { 5, 1 } };
+			runs.SetStyleRuns(position - 1, run, 2);
+			SetStyles(styles, position - 1, run, 2);
+			RequireSame(runs, styles);
+		}
+		runs.Truncate(0);
+		REQUIRE(runs.Count() == 0);
+		REQUIRE(runs.Length() == 0);
+	}
+
+	SECTION("Flat") {
+		// A style change at every byte takes more memory as runs than the bytes so they are held flat
+		std::string styles;
+		std::vector<StyleRun> styled;
+		for (size_t i = 0; i < 0x11000; i++) {
+			styled.push_back({ 1, static_cast<int>(i % 2) + 1 });
+		}
+		runs.SetStyleRuns(0, styled.data(), styled.size());
+		SetStyles(styles, 0, styled.data(), styled.size());
+		REQUIRE(runs.Flat());
+		REQUIRE(runs.MemoryUse() <= styles.length() * 2);
+		REQUIRE(runs.Count() == styles.length());
+		REQUIRE(runs.StyleAt(0) == 1);
+		REQUIRE(runs.StyleAt(0x10001) == 2);
+		REQUIRE(runs.RunIndex(0x100) == 0x100);
+		REQUIRE(runs.At(7).end == 8);
+		REQUIRE(runs.At(7).style == 2);
+
+		// Long runs appended stay as bytes
+		const StyleRun run[] = { { 100, 5 }, { 100, 5 }, { 3, 1 } };
+		runs.SetStyleRuns(styles.length(), run, 3);
+		SetStyles(styles, styles.length(), run, 3);
+		REQUIRE(runs.Count() == 0x11002);
+		REQUIRE(runs.At(0x11000).end == styles.length() - 3);
+
+		runs.Truncate(0x10000);
+		styles.resize(0x10000);
+		REQUIRE(runs.Flat());
+		REQUIRE(runs.Count() == 0x10000);
+		REQUIRE(runs.StyleAt(0xffff) == 2);
+
+		// Cleared styles start as runs
+		runs.Clear();
+		REQUIRE(!runs.Flat());
+		REQUIRE(runs.Count() == 0);
+		runs.SetStyleRuns(0, run, 3);
+		REQUIRE(!runs.Flat());
+		REQUIRE(runs.Count() == 2);
+	}
+}
@@ -2,6 +2,8 @@
  ** Unit Tests for Lexilla internal data structures
  **/
 
+#include <cstdint>
+
 #include <string>
 #include <string_view>
 #include <vector>
@@ -118,6 +120,29 @@ TEST_CASE("SparseState") {
 		REQUIRE(44 == ss.ValueAt(4));
 	}
 
+	SECTION("MergeKeepsEqualStates") {
+		ss.Set(0, 30);
+		ss.Set(2, 32);
+		ss.Set(4, 34);
+		ss.Set(6, 36);
+
+		SparseState<int> ssAdditions(1);
+		ssAdditions.Set(2, 32);
+		ssAdditions.Set(4, 34);
+		ssAdditions.Set(5, 35);
+		bool mergeChanged = ss.Merge(ssAdditions,10);
+		REQUIRE(true == mergeChanged);
+		REQUIRE(4u == ss.size());
+		REQUIRE(34 == ss.ValueAt(4));
+		REQUIRE(35 == ss.ValueAt(5));
+		REQUIRE(35 == ss.ValueAt(6));
+
+		// Merging the same states again is not a change
+		mergeChanged = ss.Merge(ssAdditions,10);
+		REQUIRE(false == mergeChanged);
+		REQUIRE(4u == ss.size());
+	}
+
 	SECTION("MergeAtExisting") {
 		ss.Set(0, 30);
 		ss.Set(2, 32);
@@ -197,6 +222,13 @@ TEST_CASE("SparseState") {
 		REQUIRE(34 == ss.ValueAt(4));
 	}
 
+	SECTION("MemoryUse") {
+		REQUIRE(0u == ss.MemoryUse());
+		ss.Set(0, 30);
+		ss.Set(2, 32);
+		REQUIRE(ss.MemoryUse() >= 2 * (sizeof(Sci_Position) + sizeof(int)));
+	}
+
 }
 
 TEST_CASE("SparseStateString") {
@@ -232,3 +264,160 @@ TEST_CASE("SparseStateString") {
 	}
 
 }
+
+TEST_CASE("SparseStateChunked") {
+
+	SparseState<int, ChunkedStates> ss;
+
+	SECTION("IsEmptyInitially") {
+		REQUIRE(0u == ss.size());
+		REQUIRE(0 == ss.ValueAt(0));
+		REQUIRE(0u == ss.MemoryUse());
+	}
+
+	SECTION("AcrossChunks") {
+		// Enough states to fill several chunks
+		for (int state = 0; state < 1000; state++) {
+			ss.Set(state * 10, state + 1);
+		}
+		REQUIRE(1000u == ss.size());
+		REQUIRE(0 == ss.ValueAt(-1));
+		for (int state = 0; state < 1000; state++) {
+			REQUIRE(state + 1 == ss.ValueAt(state * 10));
+			REQUIRE(state + 1 == ss.ValueAt(state * 10 + 9));
+		}
+		const size_t memoryFull = ss.MemoryUse();
+		REQUIRE(memoryFull >= 1000 * (sizeof(std::uint32_t) + sizeof(int)));
+
+		// Deleting at a chunk boundary and within a chunk
+		REQUIRE(ss.Delete(5120));
+		REQUIRE(512u == ss.size());
+		REQUIRE(512 == ss.ValueAt(100000));
+		REQUIRE(ss.Delete(2565));
+		REQUIRE(257u == ss.size());
+		REQUIRE(257 == ss.ValueAt(2565));
+		REQUIRE(ss.MemoryUse() < memoryFull);
+		REQUIRE(!ss.Delete(2565));
+
+		// Growing again after truncation
+		ss.Set(3000, 7);
+		REQUIRE(258u == ss.size());
+		REQUIRE(257 == ss.ValueAt(2999));
+		REQUIRE(7 == ss.ValueAt(3000));
+		ss.Delete(0);
+		REQUIRE(0u == ss.size());
+		REQUIRE(0 == ss.ValueAt(3000));
+	}
+
+	SECTION("Deltas") {
+		// Positions held as deltas take less memory than entries
+		SparseState<int> reference;
+		for (int state = 0; state < 10000; state++) {
+			ss.Set(state * 100, state + 1);
+			reference.Set(state * 100, state + 1);
+		}
+		REQUIRE(ss.MemoryUse() < reference.MemoryUse() * 3 / 4);
+		REQUIRE(10000 == ss.ValueAt(2000000));
+		REQUIRE(5000 == ss.ValueAt(499999));
+	}
+
+	SECTION("FarApart") {
+		if constexpr (sizeof(Sci_Position) > 4) {
+			// States more than 4 GB apart in one chunk are held as full positions
+			const Sci_Position gap = Sci_Position(1) << 33;
+			for (int state = 0; state < 300; state++) {
+				const Sci_Position base = (state < 10) ? 0 : ((state < 280) ? gap * 10 : gap * 280);
+				ss.Set(base + state, state + 1);
+			}
+			REQUIRE(300u == ss.size());
+			REQUIRE(1 == ss.ValueAt(0));
+			REQUIRE(10 == ss.ValueAt(gap * 10 + 9));
+			REQUIRE(11 == ss.ValueAt(gap * 10 + 10));
+			REQUIRE(12 == ss.ValueAt(gap * 10 + 11));
+			REQUIRE(280 == ss.ValueAt(gap * 280 + 279));
+			REQUIRE(281 == ss.ValueAt(gap * 280 + 280));
+			REQUIRE(300 == ss.ValueAt(gap * 300));
+			REQUIRE(ss.Delete(gap * 10 + 11));
+			REQUIRE(11u == ss.size());
+			ss.Set(gap * 10 + 20, 5);
+			REQUIRE(11 == ss.ValueAt(gap * 10 + 19));
+			REQUIRE(5 == ss.ValueAt(gap * 10 + 20));
+		}
+	}
+
+	SECTION("Merge") {
+		for (int state = 0; state < 600; state++) {
+			ss.Set(state * 10, state % 7);
+		}
+		SparseState<int, ChunkedStates> ssAdditions(3000);
+		for (int state = 300; state < 600; state++) {
+			ssAdditions.Set(state * 10, state % 7);
+		}
+		REQUIRE(false == ss.Merge(ssAdditions, 10000));
+		REQUIRE(600u == ss.size());
+		ssAdditions.Set(5000, 9);
+		REQUIRE(true == ss.Merge(ssAdditions, 10000));
+		REQUIRE(501u == ss.size());
+		REQUIRE(9 == ss.ValueAt(5000));
+	}
+
+	SECTION("SameAsVector") {
+		// Random sets, deletes and merges give the same values with either storage
+		SparseState<int> reference;
+		unsigned int seed = 12345;
+		auto next = [&seed](unsigned int range) noexcept {
+			seed = seed * 1103515245 + 12345;
+			return (seed >> 8) % range;
+		};
+		Sci_Position end = 0;
+		for (int operation = 0; operation < 5000; operation++) {
+			const unsigned int kind = next(20);
+			if (kind == 0) {
+				const Sci_Position position = next(static_cast<unsigned int>(end) + 1);
+				REQUIRE(ss.Delete(position) == reference.Delete(position));
+				end = position;
+			} else if (kind == 1) {
+				const Sci_Position start = next(static_cast<unsigned int>(end) + 1);
+				SparseState<int, ChunkedStates> additions(start);
+				SparseState<int> referenceAdditions(start);
+				Sci_Position position = start;
+				for (unsigned int state = next(400); state > 0; state--) {
+					const int value = next(4);
+					additions.Set(position, value);
+					referenceAdditions.Set(position, value);
+					position += next(5) + 1;
+				}
+				const Sci_Position ignoreAfter = next(static_cast<unsigned int>(position) + 1);
+				REQUIRE(ss.Merge(additions, ignoreAfter) == reference.Merge(referenceAdditions, ignoreAfter));
+				end = std::min(std::max(end, position), ignoreAfter + 1);
+			} else {
+				const int value = next(4);
+				ss.Set(end, value);
+				reference.Set(end, value);
+				end += next(5) + 1;
+			}
+			REQUIRE(ss.size() == reference.size());
+		}
+		for (Sci_Position position = -1; position <= end; position++) {
+			REQUIRE(ss.ValueAt(position) == reference.ValueAt(position));
+		}
+	}
+
+}
+
+TEST_CASE("SparseStateChunkedString") {
+
+	SparseState<std::string, ChunkedStates> ss;
+
+	SECTION("SetAndDelete") {
+		for (int state = 0; state < 300; state++) {
+			ss.Set(state, std::to_string(state));
+		}
+		REQUIRE(300u == ss.size());
+		REQUIRE("299" == ss.ValueAt(1000));
+		ss.Delete(256);
+		REQUIRE("255" == ss.ValueAt(1000));
+		REQUIRE("" == ss.ValueAt(-1));
+	}
+
+}
@@ -0,0 +1,210 @@
+/** @file testStyleCache.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "PropSetSimple.h"
+#include "WordList.h"
+#include "LexCounters.h"
+#include "LexMemory.h"
+#include "LexTrace.h"
+#include "LexerModule.h"
+#include "StyleCache.h"
+#include "LexerBase.h"
+#include "LexerSimple.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test StyleCache.
+
+namespace {
+
+// Just enough of a document for saving and restoring styles
+class Document : public Scintilla::IDocument {
+	std::string text;
+	std::vector<Sci_Position> lineStarts;
+public:
+	std::string styles;
+	std::vector<int> lineStates;
+	std::vector<int> levels;
+	Sci_Position endStyled = 0;
+
+	explicit Document(std::string_view text_) : text(text_), styles(text.size(), '\0') {
+		lineStarts.push_back(0);
+		for (size_t i = 0; i < text.size(); i++) {
+			if (text[i] == '\n')
+				lineStarts.push_back(i + 1);
+		}
+		lineStates.resize(lineStarts.size());
+		levels.resize(lineStarts.size(), 0x400);
+	}
+	int SCI_METHOD Version() const override { return Scintilla::dvRelease4; }
+	void SCI_METHOD SetErrorStatus(int) override {}
+	Sci_Position SCI_METHOD Length() const override { return text.size(); }
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const override {
+		text.copy(buffer, lengthRetrieve, position);
+	}
+	char SCI_METHOD StyleAt(Sci_Position position) const override { return styles.at(position); }
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const override {
+		Sci_Position line = 0;
+		while ((line + 1 < static_cast<Sci_Position>(lineStarts.size())) && (lineStarts[line + 1] <= position))
+			line++;
+		return line;
+	}
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const override { return lineStarts.at(line); }
+	int SCI_METHOD GetLevel(Sci_Position line) const override { return levels.at(line); }
+	int SCI_METHOD SetLevel(Sci_Position line, int level) override { return levels.at(line) = level; }
+	int SCI_METHOD GetLineState(Sci_Position line) const override { return lineStates.at(line); }
+	int SCI_METHOD SetLineState(Sci_Position line, int state) override { return lineStates.at(line) = state; }
+	void SCI_METHOD StartStyling(Sci_Position position) override { endStyled = position; }
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style) override {
+		styles.replace(endStyled, length, length, style);
+		endStyled += length;
+		return true;
+	}
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_) override {
+		styles.replace(endStyled, length, styles_, length);
+		endStyled += length;
+		return true;
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int) override {}
+	void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) override {}
+	void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) override {}
+	int SCI_METHOD CodePage() const override { return 65001; }
+	bool SCI_METHOD IsDBCSLeadByte(char) const override { return false; }
+	const char *SCI_METHOD BufferPointer() override { return text.c_str(); }
+	int SCI_METHOD GetLineIndentation(Sci_Position) override { return 0; }
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const override {
+		return (line + 1 < static_cast<Sci_Position>(lineStarts.size())) ? lineStarts[line + 1] - 1 : text.size();
+	}
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const override {
+		return positionStart + characterOffset;
+	}
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const override {
+		if (pWidth)
+			*pWidth = 1;
+		return static_cast<unsigned char>(text.at(position));
+	}
+};
+
+void ColouriseDocument(Sci_PositionU, Sci_Position, int, WordList *[], Accessor &) {
+	// Do no styling
+}
+
+const char *const exampleWordLists[] = { "Keywords", nullptr };
+
+LexerModule lmCacheExample(123461, ColouriseDocument, "cacheexample", nullptr, exampleWordLists);
+
+constexpr const char *cachePath = "testStyleCache.tmp";
+constexpr std::string_view sample = "int x;\n// comment\n\nreturn 0;\n";
+
+}
+
+TEST_CASE("StyleCache") {
+
+	SECTION("HashText") {
+		Document doc(sample);
+		Document same(sample);
+		Document changed("int y;\n// comment\n\nreturn 0;\n");
+		Document empty("");
+		REQUIRE(HashDocumentText(&doc) == HashDocumentText(&same));
+		REQUIRE(HashDocumentText(&doc) != HashDocumentText(&changed));
+		REQUIRE(HashDocumentText(&doc) != HashDocumentText(&empty));
+		// Longer than a block
+		const std::string large(200000, 'a');
+		std::string largeChanged = large;
+		largeChanged[150000] = 'b';
+		Document docLarge(large);
+		Document docLargeChanged(largeChanged);
+		REQUIRE(HashDocumentText(&docLarge) != HashDocumentText(&docLargeChanged));
+	}
+
+	SECTION("SaveAndRestore") {
+		Document doc(sample);
+		doc.StartStyling(0);
+		doc.SetStyleFor(3, 5);
+		doc.SetStyleFor(3, 0);
+		doc.SetStyleFor(11, 1);
+		doc.SetStyleFor(11, 0);
+		doc.SetLineState(1, 7);
+		doc.SetLevel(1, 0x2401);
+		const std::uint64_t key = HashDocumentText(&doc);
+		REQUIRE(StyleCacheSave(cachePath, &doc, key));
+
+		Document reopened(sample);
+		REQUIRE(StyleCacheRestore(cachePath, &reopened, key));
+		REQUIRE(reopened.styles == doc.styles);
+		REQUIRE(reopened.lineStates == doc.lineStates);
+		REQUIRE(reopened.levels == doc.levels);
+		std::remove(cachePath);
+	}
+
+	SECTION("Mismatch") {
+		Document doc(sample);
+		doc.StartStyling(0);
+		doc.SetStyleFor(sample.size(), 3);
+		REQUIRE(StyleCacheSave(cachePath, &doc, 1));
+
+		Document reopened(sample);
+		// Different key
+		REQUIRE(!StyleCacheRestore(cachePath, &reopened, 2));
+		// Different length
+		Document longer("int x;\n// comment\n\nreturn 10;\n");
+		REQUIRE(!StyleCacheRestore(cachePath, &longer, 1));
+		REQUIRE(longer.styles == std::string(longer.Length(), '\0'));
+		std::remove(cachePath);
+		// No file
+		REQUIRE(!StyleCacheRestore(cachePath, &reopened, 1));
+		REQUIRE(reopened.styles == std::string(sample.size(), '\0'));
+	}
+
+	SECTION("LexerSettings") {
+		LexerSimple lexer(&lmCacheExample);
+		const std::uint64_t initial = HashLexerSettings(&lexer);
+		// Properties not listed in PropertyNames change the key
+		lexer.PropertySet("lexer.terminal.escape.sequences", "1");
+		const std::uint64_t escapes = HashLexerSettings(&lexer);
+		REQUIRE(escapes != initial);
+		lexer.PropertySet("lexer.terminal.escape.sequences", "0");
+		REQUIRE(HashLexerSettings(&lexer) != escapes);
+		// An empty value is the same as not set
+		lexer.PropertySet("lexer.terminal.escape.sequences", "");
+		REQUIRE(HashLexerSettings(&lexer) == initial);
+		// Word lists change the key but not the order of their words
+		lexer.WordListSet(0, "int char");
+		const std::uint64_t words = HashLexerSettings(&lexer);
+		REQUIRE(words != initial);
+		lexer.WordListSet(0, "char int");
+		REQUIRE(HashLexerSettings(&lexer) == words);
+		lexer.WordListSet(0, "char int long");
+		REQUIRE(HashLexerSettings(&lexer) != words);
+
+		// Styles saved with one setting are not restored with another
+		Document doc(sample);
+		doc.StartStyling(0);
+		doc.SetStyleFor(sample.size(), 3);
+		REQUIRE(StyleCacheSave(cachePath, &doc, StyleCacheKey(&doc, &lexer)));
+		Document reopened(sample);
+		lexer.PropertySet("lexer.terminal.escape.sequences", "1");
+		REQUIRE(!StyleCacheRestore(cachePath, &reopened, StyleCacheKey(&reopened, &lexer)));
+		lexer.PropertySet("lexer.terminal.escape.sequences", "");
+		lexer.WordListSet(0, "char");
+		REQUIRE(!StyleCacheRestore(cachePath, &reopened, StyleCacheKey(&reopened, &lexer)));
+		REQUIRE(reopened.styles == std::string(sample.size(), '\0'));
+		lexer.WordListSet(0, "char int long");
+		REQUIRE(StyleCacheRestore(cachePath, &reopened, StyleCacheKey(&reopened, &lexer)));
+		REQUIRE(reopened.styles == doc.styles);
+		std::remove(cachePath);
+	}
+}
@@ -0,0 +1,319 @@
+/** @file testStyleContext.cxx
+ ** Unit Tests for Lexilla internal data structures
+ **/
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <random>
+#include <type_traits>
+
+#include "ILexer.h"
+
+#include "LexCounters.h"
+#include "LexTrace.h"
+#include "LexAccessor.h"
+#include "StyleContext.h"
+#include "LexCharacterSet.h"
+#include "LiteralSet.h"
+
+#include "TestDocument.h"
+
+#include "catch.hpp"
+
+using namespace Lexilla;
+
+// Test StyleContext over TestDocument.
+
+namespace {
+
+// ASCII, line ends and valid UTF-8 of each width, including the highest characters decoded
+const char *const pieces[] = {
+	"a", "Z", " ", "\t", "\n", "\r\n",
+	"\xc2\x80", "\xc3\xa9", "\xd0\xb6", "\xdf\xbf",
+	"\xe0\xa0\x80", "\xe2\x82\xac", "\xe4\xbd\xa0", "\xef\xbf\xbd",
+	"\xf0\x90\x80\x80", "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbd",
+};
+
+// A TestDocument in an 8-bit encoding so each byte of a multi-byte character is a character
+class EightBitDocument : public TestDocument {
+public:
+	int SCI_METHOD CodePage() const override {
+		return 0;
+	}
+};
+
+// Words, spaces, operators, multi-byte characters and every kind of line end
+const std::string_view wordPieces[] = {
+	"word", "x", "_9", "12", " ", "  ", "\t", "=", "==", "+",
+	"\xc3\xa9", "\xe4\xbd\xa0", "\xf0\x9f\x98\x80",
+	"\n", "\r\n", "\r",
+};
+
+// Text of pieceCount wordPieces with a run longer than the accessor's buffer every 500
+std::string WordText(std::mt19937 &random, int pieceCount, bool endWithLine) {
+	std::uniform_int_distribution<size_t> choose(0, std::size(wordPieces) - 1);
+	std::string text;
+	for (int piece = 0; piece < pieceCount; piece++) {
+		if (piece % 500 == 250) {
+			text.append(5000, (piece % 1000 == 250) ? 'w' : ' ');
+		}
+		text += wordPieces[choose(random)];
+	}
+	if (endWithLine) {
+		text += "\n";
+	}
+	return text;
+}
+
+void RequireSame(const StyleContext &sc, const StyleContext &reference) {
+	REQUIRE(sc.currentPos == reference.currentPos);
+	REQUIRE(sc.currentLine == reference.currentLine);
+	REQUIRE(sc.lineEnd == reference.lineEnd);
+	REQUIRE(sc.lineStartNext == reference.lineStartNext);
+	REQUIRE(sc.atLineStart == reference.atLineStart);
+	REQUIRE(sc.atLineEnd == reference.atLineEnd);
+	REQUIRE(sc.state == reference.state);
+	REQUIRE(sc.chPrev == reference.chPrev);
+	REQUIRE(sc.ch == reference.ch);
+	REQUIRE(sc.width == reference.width);
+	REQUIRE(sc.chNext == reference.chNext);
+	REQUIRE(sc.widthNext == reference.widthNext);
+}
+
+// What the bulk moves do, one Forward at a time up to the end of the line or of [0, end)
+template <typename Predicate>
+void ForwardEach(StyleContext &sc, Sci_PositionU end, Predicate predicate) {
+	while ((sc.currentPos < end) && (static_cast<Sci_Position>(sc.currentPos) < sc.lineEnd) && predicate(sc.ch)) {
+		sc.Forward();
+	}
+}
+
+// From random starts in doc, each bulk move must leave sc where Forward calls leave reference
+void RequireForwardsSame(TestDocument &doc, const std::vector<Sci_Position> &starts, std::mt19937 &random) {
+	const CharacterSet setWord(CharacterSet::setAlphaNum, "_", true);
+	const CharacterSet setOperator(CharacterSet::setNone, "=+");
+	const CharacterSetArray<0x100> setHigh(CharacterSetArray<0x100>::setLower, "\xa9\xbd\x80");
+	const auto isNotSpace = [](int ch) noexcept {
+		return ch != ' ' && ch != '\t';
+	};
+	const Sci_Position length = doc.Length();
+	LexAccessor styler(&doc);
+	LexAccessor stylerReference(&doc);
+	std::uniform_int_distribution<int> chooseMove(0, 5);
+	for (size_t i = 0; i < starts.size(); i++) {
+		const Sci_Position start = starts[i];
+		// Ranges ending at the document end, where StyleContext goes one past it, and before it
+		const Sci_Position rangeLength = (i % 3 == 0) ? length - start : std::min<Sci_Position>(length - start, 300);
+		const Sci_PositionU end = (start + rangeLength < length) ? start + rangeLength : length + 1;
+		StyleContext sc(start, rangeLength, 0, styler);
+		StyleContext reference(start, rangeLength, 0, stylerReference);
+		for (int move = 0; move < 4; move++) {
+			switch (chooseMove(random)) {
+			case 0:
+				sc.ForwardWhile(setWord);
+				ForwardEach(reference, end, [&setWord](int ch) { return setWord.Contains(ch); });
+				break;
+			case 1:
+				sc.ForwardUntil(setOperator);
+				ForwardEach(reference, end, [&setOperator](int ch) { return !setOperator.Contains(ch); });
+				break;
+			case 2:
+				sc.ForwardWhile(setHigh);
+				ForwardEach(reference, end, [&setHigh](int ch) { return setHigh.Contains(ch); });
+				break;
+			case 3:
+				sc.ForwardUntil(setHigh);
+				ForwardEach(reference, end, [&setHigh](int ch) { return !setHigh.Contains(ch); });
+				break;
+			case 4:
+				sc.ForwardWhile(isNotSpace);
+				ForwardEach(reference, end, isNotSpace);
+				break;
+			default:
+				sc.ForwardToLineEnd();
+				ForwardEach(reference, end, [](int) { return true; });
+				break;
+			}
+			RequireSame(sc, reference);
+			sc.Forward();
+			reference.Forward();
+			RequireSame(sc, reference);
+		}
+	}
+}
+
+// Random starts at character boundaries of doc, with the last few characters always included
+std::vector<Sci_Position> StartsOf(TestDocument &doc, std::mt19937 &random, size_t count) {
+	std::vector<Sci_Position> characters;
+	for (Sci_Position position = 0; position < doc.Length(); position = doc.GetRelativePosition(position, 1)) {
+		characters.push_back(position);
+	}
+	std::vector<Sci_Position> starts(characters.end() - 5, characters.end());
+	std::uniform_int_distribution<size_t> choose(0, characters.size() - 1);
+	while (starts.size() < count) {
+		starts.push_back(characters[choose(random)]);
+	}
+	return starts;
+}
+
+}
+
+TEST_CASE("StyleContextDecodeUTF8") {
+
+	SECTION("RandomPieces") {
+		// Long enough to cross many of the accessor's buffers
+		std::mt19937 random(1);
+		std::uniform_int_distribution<size_t> choose(0, std::size(pieces) - 1);
+		std::string text;
+		for (int piece = 0; piece < 200000; piece++) {
+			text += pieces[choose(random)];
+		}
+		TestDocument doc;
+		doc.Set(text);
+		LexAccessor styler(&doc);
+		StyleContext sc(0, doc.Length(), 0, styler);
+		Sci_Position position = 0;
+		for (; position < doc.Length(); sc.Forward()) {
+			REQUIRE(sc.currentPos == static_cast<Sci_PositionU>(position));
+			Sci_Position width = 0;
+			REQUIRE(sc.ch == doc.GetCharacterAndWidth(position, &width));
+			REQUIRE(sc.width == width);
+			for (Sci_Position n = -1; n <= 4; n++) {
+				const Sci_Position positionRelative = doc.GetRelativePosition(position, n);
+				REQUIRE(sc.GetRelativeCharacter(n) == doc.GetCharacterAndWidth(positionRelative, nullptr));
+			}
+			position += width;
+		}
+		REQUIRE(position == doc.Length());
+	}
+
+	SECTION("Invalid") {
+		// Bad leads, overlongs, surrogates, non-characters, beyond U+10FFFF and a truncated end are
+		// each returned a byte at a time as 0xDC80 + byte
+		const std::string_view invalid = "\x80z\xc0\xaf\xe0\x80\x80\xed\xa0\x80\xef\xbf\xbe"
+			"\xf0\x80\x80\x80\xf4\x90\x80\x80\xf7\xbf\xbf\xbf\xf5";
+		TestDocument doc;
+		doc.Set(std::string(invalid) + "\xe2\x82\xac\xc3");
+		LexAccessor styler(&doc);
+		StyleContext sc(0, doc.Length(), 0, styler);
+		for (const char chInvalid : invalid) {
+			const unsigned char uch = chInvalid;
+			REQUIRE(sc.ch == ((uch < 0x80) ? uch : 0xDC80 + uch));
+			REQUIRE(sc.width == 1);
+			sc.Forward();
+		}
+		REQUIRE(sc.ch == 0x20AC);
+		REQUIRE(sc.width == 3);
+		REQUIRE(sc.chNext == 0xDC80 + 0xc3);
+		sc.Forward();
+		REQUIRE(sc.ch == 0xDC80 + 0xc3);
+		REQUIRE(sc.width == 1);
+		REQUIRE(sc.chNext == 0);
+	}
+}
+
+TEST_CASE("StyleContextForward") {
+
+	// ForwardWhile, ForwardUntil and ForwardToLineEnd scan runs of bytes with ForwardScanning and move with
+	// SkipTo so are compared with Forward calls
+	std::mt19937 random(2);
+
+	SECTION("UTF8") {
+		for (const bool endWithLine : { false, true }) {
+			TestDocument doc;
+			doc.Set(WordText(random, 4000, endWithLine));
+			RequireForwardsSame(doc, StartsOf(doc, random, 2000), random);
+		}
+	}
+
+	SECTION("EightBit") {
+		for (const bool endWithLine : { false, true }) {
+			EightBitDocument doc;
+			doc.Set(WordText(random, 4000, endWithLine));
+			RequireForwardsSame(doc, StartsOf(doc, random, 2000), random);
+		}
+	}
+
+	SECTION("LineEnd") {
+		// Stops at the line end, before CR+LF, and at the end of a document ending with a line end
+		TestDocument doc;
+		doc.Set("ab\xc3\xa9" "cd\r\nef\n");
+		LexAccessor styler(&doc);
+		StyleContext sc(0, doc.Length(), 0, styler);
+		sc.ForwardToLineEnd();
+		REQUIRE(sc.currentPos == 6);
+		REQUIRE(sc.MatchLineEnd());
+		REQUIRE(sc.chPrev == 'd');
+		REQUIRE(sc.ch == '\r');
+		sc.ForwardToLineEnd();
+		REQUIRE(sc.currentPos == 6);
+		sc.Forward(2);
+		REQUIRE(sc.atLineStart);
+		sc.ForwardWhile(CharacterSet(CharacterSet::setLower));
+		REQUIRE(sc.currentPos == 10);
+		REQUIRE(sc.atLineEnd);
+		sc.Forward();
+		REQUIRE(sc.currentPos == 11);
+		REQUIRE(sc.currentLine == 2);
+		REQUIRE(sc.More());
+		sc.ForwardToLineEnd();
+		REQUIRE(sc.currentPos == 11);
+		REQUIRE(sc.ch == 0);
+	}
+}
+
+TEST_CASE("StyleContextMatchAny") {
+
+	const LiteralSet operators({ "=", "==", "===", "!=", "<", "<<", "<<=", "=>", "\xc3\xa9", "\xc3\xa9t\xc3\xa9" });
+
+	SECTION("RandomPieces") {
+		// Literals cut by the end of the accessor's buffer are matched from the document
+		const std::string_view operatorPieces[] = { "=", "!", "<", ">", "a", " ", "\xc3\xa9", "t", "\n" };
+		std::mt19937 random(3);
+		std::uniform_int_distribution<size_t> choose(0, std::size(operatorPieces) - 1);
+		std::string text;
+		for (int piece = 0; piece < 30000; piece++) {
+			text += operatorPieces[choose(random)];
+		}
+		TestDocument doc;
+		doc.Set(text);
+		LexAccessor styler(&doc);
+		StyleContext sc(0, doc.Length(), 0, styler);
+		for (; sc.currentPos < text.length(); sc.Forward()) {
+			const char *rest = text.data() + sc.currentPos;
+			const size_t lengthRest = text.length() - sc.currentPos;
+			REQUIRE(sc.MatchAny(operators) == operators.Match(rest, lengthRest));
+			REQUIRE(sc.Match("<<=") == (std::string_view(rest, lengthRest).substr(0, 3) == "<<="));
+		}
+	}
+
+	SECTION("DocumentEnd") {
+		// Only the bytes left in the document can match
+		TestDocument doc;
+		doc.Set("a<<=\n<<\xc3\xa9t\xc3\xa9=");
+		LexAccessor styler(&doc);
+		StyleContext sc(0, doc.Length(), 0, styler);
+		REQUIRE(sc.MatchAny(operators) == -1);
+		sc.Forward();
+		REQUIRE(sc.MatchAny(operators) == 6);
+		sc.Forward(4);
+		REQUIRE(sc.MatchAny(operators) == 5);
+		sc.Forward(2);
+		REQUIRE(sc.MatchAny(operators) == 9);
+		sc.Forward(3);
+		REQUIRE(sc.MatchAny(operators) == 0);
+		sc.Forward();
+		REQUIRE(sc.currentPos == static_cast<Sci_PositionU>(doc.Length()));
+		REQUIRE(sc.MatchAny(operators) == -1);
+	}
+}
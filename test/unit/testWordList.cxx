@@ -3,10 +3,14 @@
  ** Tests WordList, WordClassifier, and SubStyles
  **/
 
+#include <cstring>
+
 #include <string>
 #include <string_view>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <chrono>
 
 #include "WordList.h"
 #include "SubStyles.h"
@@ -41,6 +45,30 @@ TEST_CASE("WordList") {
 		REQUIRE(!wl.InList(sClass));
 	}
 
+	SECTION("StringViewInList") {
+		wl.Set("else struct ^GTK_");
+		const std::string_view text = "struct else class GTK_WIDGET";
+		REQUIRE(wl.InList(text.substr(0, 6)));
+		REQUIRE(wl.InList(text.substr(7, 4)));
+		REQUIRE(!wl.InList(text.substr(0, 5)));
+		REQUIRE(!wl.InList(text.substr(12, 5)));
+		REQUIRE(wl.InList(text.substr(18, 10)));
+		REQUIRE(wl.InList(text.substr(18, 4)));
+		REQUIRE(!wl.InList(text.substr(18, 3)));
+		REQUIRE(!wl.InList(std::string_view()));
+	}
+
+	SECTION("InListLowered") {
+		wl.Set("else struct ^gtk_");
+		REQUIRE(wl.InListLowered("STRUCT"));
+		REQUIRE(wl.InListLowered("Else"));
+		REQUIRE(wl.InListLowered("struct"));
+		REQUIRE(!wl.InListLowered("STRUCTS"));
+		REQUIRE(wl.InListLowered("GTK_WIDGET"));
+		REQUIRE(!wl.InListLowered("GTK"));
+		REQUIRE(!wl.InList("GTK_WIDGET"));
+	}
+
 	SECTION("InListUnicode") {
 		// "cheese" in English
 		// "kase" ('k', 'a with diaeresis', 's', 'e') in German
@@ -118,6 +146,145 @@ TEST_CASE("WordList") {
 	}
 }
 
+namespace {
+
+// Words sharing their first letters, as in SQL or CMake keyword lists
+std::vector<std::string> SimilarWords(size_t count) {
+	std::vector<std::string> words;
+	for (size_t i = 0; i < count; i++) {
+		words.push_back("set_" + std::to_string(i * 7919 % 100003));
+	}
+	return words;
+}
+
+std::string Joined(const std::vector<std::string> &words) {
+	std::string joined;
+	for (const std::string &word : words) {
+		joined += word + " ";
+	}
+	return joined;
+}
+
+// The lookup used before the hash table: compare with each word with the same first character
+bool InListLinear(const std::vector<std::string> &sorted, const char *s) {
+	const auto first = std::lower_bound(sorted.begin(), sorted.end(), std::string(1, s[0]));
+	for (auto it = first; (it != sorted.end()) && ((*it)[0] == s[0]); ++it) {
+		if (strcmp(it->c_str(), s) == 0)
+			return true;
+	}
+	return false;
+}
+
+}
+
+TEST_CASE("WordListLarge") {
+
+	for (const size_t count : {50, 500, 5000}) {
+		const std::vector<std::string> words = SimilarWords(count);
+		WordList wl;
+		wl.Set(Joined(words).c_str());
+		REQUIRE(static_cast<int>(count) == wl.Length());
+		for (const std::string &word : words) {
+			REQUIRE(wl.InList(word.c_str()));
+			REQUIRE(!wl.InList((word + "x").c_str()));
+			REQUIRE(!wl.InList(("#" + word).c_str()));
+		}
+		REQUIRE(!wl.InList(""));
+		REQUIRE(!wl.InList("set"));
+	}
+}
+
+TEST_CASE("WordListShared") {
+
+	SECTION("SameText") {
+		WordList wl1;
+		WordList wl2;
+		wl1.Set("else struct if");
+		REQUIRE(wl2.Set("else struct if"));
+		// The words are parsed once and shared
+		REQUIRE(wl1.WordAt(0) == wl2.WordAt(0));
+		REQUIRE(wl2.InList("struct"));
+		REQUIRE(!(wl1 != wl2));
+	}
+
+	SECTION("Independent") {
+		WordList wl1;
+		WordList wl2(true);
+		wl1.Set("else struct");
+		wl2.Set("else struct");
+		// Separated differently so not shared
+		REQUIRE(wl1.WordAt(0) != wl2.WordAt(0));
+		REQUIRE(wl2.InList("else struct"));
+		REQUIRE(!wl1.InList("else struct"));
+		{
+			WordList wl3;
+			wl3.Set("else struct");
+			wl3.Set("other");
+			REQUIRE(wl3.InList("other"));
+			REQUIRE(!wl3.InList("else"));
+		}
+		// Changing or destroying one list does not affect the others sharing its words
+		wl2.Clear();
+		REQUIRE(wl1.InList("else"));
+		REQUIRE(!wl2.InList("else"));
+		wl1.Clear();
+		WordList wl4;
+		wl4.Set("else struct");
+		REQUIRE(wl4.InList("struct"));
+	}
+
+	SECTION("MemoryUse") {
+		WordList wl1;
+		REQUIRE(wl1.MemoryUse() == 0);
+		wl1.Set("else struct if while");
+		const size_t alone = wl1.MemoryUse();
+		REQUIRE(alone > 0);
+		{
+			// Shared words are divided between the lists using them
+			WordList wl2;
+			wl2.Set("else struct if while");
+			REQUIRE(wl1.MemoryUse() == alone / 2);
+			REQUIRE(wl2.MemoryUse() == alone / 2);
+		}
+		REQUIRE(wl1.MemoryUse() == alone);
+	}
+}
+
+// Timing of InList against the first character scan, run with: unitTest [benchmark]
+TEST_CASE("WordListBenchmark", "[.benchmark]") {
+
+	for (const size_t count : {50, 500, 5000}) {
+		std::vector<std::string> words = SimilarWords(count);
+		WordList wl;
+		wl.Set(Joined(words).c_str());
+		std::sort(words.begin(), words.end());
+		std::vector<std::string> probes = SimilarWords(count * 2);
+		constexpr int repeats = 20;
+
+		size_t foundHash = 0;
+		const auto startHash = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++) {
+			for (const std::string &probe : probes) {
+				foundHash += wl.InList(probe.c_str());
+			}
+		}
+		const auto endHash = std::chrono::steady_clock::now();
+		size_t foundLinear = 0;
+		for (int r = 0; r < repeats; r++) {
+			for (const std::string &probe : probes) {
+				foundLinear += InListLinear(words, probe.c_str());
+			}
+		}
+		const auto endLinear = std::chrono::steady_clock::now();
+		REQUIRE(foundHash == foundLinear);
+
+		const double lookups = static_cast<double>(probes.size() * repeats);
+		const double nsHash = std::chrono::duration<double, std::nano>(endHash - startHash).count() / lookups;
+		const double nsLinear = std::chrono::duration<double, std::nano>(endLinear - endHash).count() / lookups;
+		WARN(count << " words: InList " << nsHash << " ns, first character scan " << nsLinear << " ns");
+	}
+}
+
 // Test WordClassifier.
 
 TEST_CASE("WordClassifier") {
@@ -157,6 +324,38 @@ TEST_CASE("WordClassifier") {
 		REQUIRE(wc.ValueFor("double") < 0);
 	}
 
+	SECTION("Reassign") {
+		wc.Allocate(key, 2);
+		REQUIRE(wc.ValueFor("if") < 0);
+		wc.SetIdentifiers(key, "else if then if");
+		wc.SetIdentifiers(type, "int then");
+		// A word set for a second style moves to it
+		REQUIRE(wc.ValueFor("then") == type);
+		REQUIRE(wc.ValueFor("if") == key);
+		wc.SetIdentifiers(key, "");
+		REQUIRE(wc.ValueFor("if") < 0);
+		REQUIRE(wc.ValueFor("then") == type);
+		const std::string_view view("int then", 3);
+		REQUIRE(wc.ValueFor(view) == type);
+	}
+
+	SECTION("Many") {
+		wc.Allocate(key, 2);
+		std::string identifiers;
+		for (int i = 0; i < 5000; i++) {
+			identifiers += "api" + std::to_string(i) + " ";
+		}
+		wc.SetIdentifiers(key, identifiers.c_str());
+		int found = 0;
+		for (int i = 0; i < 5000; i++) {
+			if (wc.ValueFor("api" + std::to_string(i)) == key)
+				found++;
+		}
+		REQUIRE(found == 5000);
+		REQUIRE(wc.ValueFor("api5000") < 0);
+		REQUIRE(wc.ValueFor("api") < 0);
+	}
+
 }
 
 // Test SubStyles.